@@ -129,6 +129,7 @@ HEADERS += ../libinsight/include/insight/altreftype.h \
     ../libinsight/include/insight/shellutil.h \
     ../libinsight/include/insight/slubobjects.h \
     ../libinsight/include/insight/sourceref.h \
+    ../libinsight/include/insight/stringatoms.h \
     ../libinsight/include/insight/structured.h \
     ../libinsight/include/insight/structuredmember.h \
     ../libinsight/include/insight/symbol.h \
@@ -142,6 +143,7 @@ HEADERS += ../libinsight/include/insight/altreftype.h \
     ../libinsight/include/insight/typerule.h \
     ../libinsight/include/insight/typeruleparser.h \
     ../libinsight/include/insight/typerulereader.h \
+    ../libinsight/include/insight/typeusagelog.h \
     ../libinsight/include/insight/variable.h \
     ../libinsight/include/insight/varsetter.h \
     ../libinsight/include/insight/virtualmemoryexception.h \
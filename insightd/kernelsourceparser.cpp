@@ -21,8 +21,16 @@
 #include <insight/filenotfoundexception.h>
 #include "expressionevalexception.h"
 #include <insight/multithreading.h>
+#include <insight/typeusagelog.h>
+#include <insight/kernelsymbolconsts.h>
+#include <insight/variable.h>
+#include <insight/constdefs.h>
 
 #include <QDirIterator>
+#include <QCryptographicHash>
+
+/// Identifies a file of the source cache ("ISRC")
+static const quint32 sourceCacheMagic = 0x49535243;
 
 
 #define sourceParserError(x) do { throw SourceParserException((x), __FILE__, __LINE__); } while (0)
@@ -60,7 +68,9 @@ public:
 KernelSourceParser::KernelSourceParser(SymFactory* factory,
         const QString& srcPath)
     : _factory(factory), _srcPath(srcPath), _srcDir(srcPath), _filesIndex(0),
-      _bytesRead(0), _bytesTotal(0), _durationLastFileFinished(0)
+      _bytesRead(0), _bytesTotal(0), _durationLastFileFinished(0),
+      _cacheDir(QDir::home().absoluteFilePath(mt_source_cache_dir)),
+      _cacheEnabled(false), _filesCached(0)
 {
     assert(_factory);
 }
@@ -134,6 +144,16 @@ void KernelSourceParser::parse()
     cleanUpThreads();
     _factory->seenMagicNumbers.clear();
 
+    // Prepare the cache of type evaluation results
+    _filesCached = 0;
+    _cacheEnabled = _cacheDir.exists() ||
+            QDir::home().mkpath(mt_source_cache_dir);
+    if (_cacheEnabled)
+        _symbolsHash = symbolsHash();
+    else
+        shellErr(QString("Cannot create cache directory \"%1\", results will "
+                         "not be cached.").arg(_cacheDir.absolutePath()));
+
     operationStarted();
     _durationLastFileFinished = _duration;
 
@@ -193,10 +213,11 @@ void KernelSourceParser::parse()
 
     operationStopped();
 
-    QString s = QString("\rParsed %1/%2 files in %3.")
+    QString s = QString("\rParsed %1/%2 files in %3, %4 results from cache.")
             .arg(_filesIndex)
             .arg(_fileNames.size())
-            .arg(elapsedTimeVerbose());
+            .arg(elapsedTimeVerbose())
+            .arg(_filesCached);
     shellOut(s, true);
 
     _factory->sourceParcingFinished();
@@ -280,27 +301,123 @@ void KernelSourceParser::WorkerThread::run()
             _parser->checkOperationProgress();
         lock.unlock();
 
-        parseFile(currentFile);
+        bool cached = parseFile(currentFile);
 
         lock.relock();
+        if (cached)
+            ++_parser->_filesCached;
         _parser->_bytesRead += QFileInfo(_parser->_srcDir, currentFile).size();
         _parser->_durationLastFileFinished = _parser->_duration;
     }
 }
 
 
-void KernelSourceParser::WorkerThread::parseFile(const QString &fileName)
+QByteArray KernelSourceParser::symbolsHash() const
+{
+    // The fingerprint covers all types and variables the evaluation results
+    // refer to by ID
+    QByteArray buf;
+    QDataStream out(&buf, QIODevice::WriteOnly);
+    out << (qint16) kSym::fileVersion;
+    foreach (const BaseType* t, _factory->types())
+        out << (qint32) t->id() << (quint32) t->hash();
+    foreach (const Variable* v, _factory->vars())
+        out << (qint32) v->id() << (qint32) v->refTypeId() << v->name();
+
+    return QCryptographicHash::hash(buf, QCryptographicHash::Sha1);
+}
+
+
+QString KernelSourceParser::cacheFileName(const QString &file) const
+{
+    // Identify the file by its path, size and modification time, so that it
+    // is not read at all if the cached results can be used
+    QFileInfo info(file);
+    if (!info.isFile())
+        return QString();
+
+    QByteArray buf;
+    QDataStream out(&buf, QIODevice::WriteOnly);
+    out << info.absoluteFilePath() << (qint64) info.size()
+        << (quint32) info.lastModified().toTime_t();
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(buf);
+    hash.addData(_symbolsHash);
+
+    return _cacheDir.absoluteFilePath(hash.result().toHex());
+}
+
+
+bool KernelSourceParser::loadCachedUsage(const QString &cacheFile,
+                                         TypeUsageLog *log) const
+{
+    QFile f(cacheFile);
+    if (!f.open(QIODevice::ReadOnly))
+        return false;
+
+    KernelSymbolStream in(&f);
+    quint32 magic;
+    qint16 version;
+    qint32 count;
+    QByteArray data;
+
+    in >> magic >> version >> count >> data;
+    if (in.status() != QDataStream::Ok || magic != sourceCacheMagic ||
+        version != kSym::fileVersion || count < 0)
+        return false;
+
+    log->setData(data, count);
+    return true;
+}
+
+
+void KernelSourceParser::storeCachedUsage(const QString &cacheFile,
+                                          const TypeUsageLog &log) const
+{
+    // Write to a temporary file first so that no other process ever sees a
+    // partially written cache file
+    QString tmpFile = cacheFile + ".tmp";
+    QFile f(tmpFile);
+    if (!f.open(QIODevice::WriteOnly|QIODevice::Truncate))
+        return;
+
+    KernelSymbolStream out(&f);
+    out << sourceCacheMagic << (qint16) kSym::fileVersion
+        << (qint32) log.count() << log.data();
+    f.close();
+
+    if (out.status() != QDataStream::Ok || f.error() != QFile::NoError ||
+        (QFile::exists(cacheFile) && !QFile::remove(cacheFile)) ||
+        !QFile::rename(tmpFile, cacheFile))
+        QFile::remove(tmpFile);
+}
+
+
+bool KernelSourceParser::WorkerThread::parseFile(const QString &fileName)
 {
     QString file = _parser->_srcDir.absoluteFilePath(fileName);
 
     if (!_parser->_srcDir.exists(fileName)) {
         _parser->shellErr(QString("File not found: %1").arg(file));
-        return;
+        return false;
+    }
+
+    // Try to replay the results from the cache
+    TypeUsageLog log;
+    QString cacheFile;
+    if (_parser->_cacheEnabled) {
+        cacheFile = _parser->cacheFileName(file);
+        if (!cacheFile.isEmpty() && _parser->loadCachedUsage(cacheFile, &log) &&
+            _parser->_factory->replayTypeUsage(log) >= 0)
+            return true;
+        log.clear();
     }
 
     AbstractSyntaxTree ast;
     ASTBuilder builder(&ast);
     KernelSourceTypeEvaluator eval(&ast, _parser->_factory);
+    eval.setUsageLog(&log);
 
     try {
         // Parse the file
@@ -309,7 +426,7 @@ void KernelSourceParser::WorkerThread::parseFile(const QString &fileName)
                                          "while parsing file:\n%2")
                                  .arg(ast.errorCount())
                                  .arg(file));
-            return;
+            return false;
         }
 
         // Evaluate types
@@ -318,7 +435,14 @@ void KernelSourceParser::WorkerThread::parseFile(const QString &fileName)
             if (!_stopExecution && !eval.walkingStopped())
                 BugReport::reportErr(QString("Error evaluating types in %1")
                                      .arg(file));
+            return false;
         }
+
+        // Cache the results only if the file was evaluated completely and
+        // without any errors
+        if (!_stopExecution && !eval.walkingStopped() && !eval.errorCount() &&
+            log.isValid() && !cacheFile.isEmpty())
+            _parser->storeCachedUsage(cacheFile, log);
     }
     catch (TypeEvaluatorException& e) {
         // Print the source of the embedding external declaration
@@ -339,5 +463,7 @@ void KernelSourceParser::WorkerThread::parseFile(const QString &fileName)
     catch (GenericException& e) {
         eval.reportErr(e, 0, 0);
     }
+
+    return false;
 }
 
@@ -16,10 +16,17 @@
 
 // forward declaration
 class SymFactory;
+class TypeUsageLog;
 
 /**
  * This class parses the pre-processed kernel source files and extracts
  * additional type information from it.
+ *
+ * The changes that the evaluation of each file applies to the SymFactory are
+ * cached in the directory mt_source_cache_dir. The cache is keyed by the
+ * content of each file and a fingerprint of the loaded symbols, so repeated
+ * runs only parse and evaluate the files that have changed.
+ * \sa TypeUsageLog
  */
 class KernelSourceParser: public LongOperation
 {
@@ -35,7 +42,7 @@ class KernelSourceParser: public LongOperation
         void run();
 
     private:
-        void parseFile(const QString& fileName);
+        bool parseFile(const QString& fileName);
         KernelSourceParser* _parser;
         bool _stopExecution;
     };
@@ -69,6 +76,11 @@ protected:
 
 private:
     void cleanUpThreads();
+    QByteArray symbolsHash() const;
+    QString cacheFileName(const QString& file) const;
+    bool loadCachedUsage(const QString& cacheFile, TypeUsageLog* log) const;
+    void storeCachedUsage(const QString& cacheFile,
+                          const TypeUsageLog& log) const;
 
     SymFactory* _factory;
     QString _srcPath;
@@ -82,6 +94,10 @@ private:
     QMutex _filesMutex;
     QMutex _progressMutex;
     int _durationLastFileFinished;
+    QDir _cacheDir;
+    bool _cacheEnabled;
+    QByteArray _symbolsHash;
+    int _filesCached;
 };
 
 #endif /* KERNELSOURCEPARSER_H_ */
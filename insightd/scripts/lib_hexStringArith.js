@@ -1,3 +1,8 @@
+/**
+ * Note: New scripts should prefer the native Address objects, e.g.,
+ * inst.AddressValue().Add(off), which avoid the string conversions below.
+ */
+
 /**
  * add two hex strings a and b of arbitrary length
  * no hex prefix like 0x is expected
@@ -35,6 +35,7 @@
 #include <insight/varsetter.h>
 #include <insight/basetype.h>
 #include <insight/scriptengine.h>
+#include <insight/scriptbatch.h>
 #include "kernelsourceparser.h"
 #include <insight/function.h>
 #include <insight/memspecparser.h>
@@ -190,7 +191,13 @@ Shell::Shell(bool listenOnSocket)
 				"                              reverse mapping for dump <index>\n"
                 "  memory detect [index] code\n"
                 "                              Detect hidden code within the dump with \n"
-                "                              index <index>"
+                "                              index <index>\n"
+                "  memory detect [index] monitor\n"
+                "                              Like \"code\", but only verify the pages\n"
+                "                              that changed since the last monitor run\n"
+                "  memory detect [index] reset\n"
+                "                              Forget the pages of the last monitor run\n"
+                "                              on dump <index>\n"
 #ifdef CONFIG_WITH_X_SUPPORT
                 "  memory revmap [index] visualize\n"
                 "                              Visualize the reverse mapping for dump <index>\n"
@@ -221,6 +228,8 @@ Shell::Shell(bool listenOnSocket)
                  "  rules reset              Resets the usage counters for all rules\n"
                  "  rules verbose [<level>]  Set the verbose level when evaluating\n"
                  "                           rules, may be between 0 (off) and 4 (on)\n"
+                 "  rules cache [<size>|off] Cache up to <size> results of rules\n"
+                 "                           with pure actions, or show statistics\n"
                  "  rules flush              Removes all rules"));
 
     _commands.insert("script",
@@ -230,7 +239,16 @@ Shell::Shell(bool listenOnSocket)
                 "This command executes a given QtScript script file in the current "
                 "shell's context. All output is printed to the screen.\n"
                 "  script [-v] <file_name>   Evaluates the script in <file_name>\n"
-                "  script [-v] eval <code>   Evaluates <code> directly"));
+                "  script [-v] eval <code>   Evaluates <code> directly\n"
+                "  script [-v] -b <dumps> <file_name>\n"
+                "                            Evaluates the script in <file_name>\n"
+                "                            concurrently for each of the memory\n"
+                "                            dumps in <dumps> and prints the output\n"
+                "                            per dump. <dumps> is \"all\", a list of\n"
+                "                            indices like \"0,2-4\", or a wildcard\n"
+                "                            expression matching the dump file names.\n"
+                "                            Returns error code -11 if the script\n"
+                "                            failed for any of the dumps"));
 
     _commands.insert("show",
             Command(
@@ -1153,10 +1171,7 @@ int Shell::printFilterHelp(const KeyValueStore& help)
 
 int Shell::printTypeList(const TypeFilter *filter)
 {
-    const BaseTypeList* types = &_sym.factory().types();
-    CompileUnit* unit = 0;
-
-    if (types->isEmpty()) {
+    if (_sym.factory().types().isEmpty()) {
         Console::out() << "There are no type references." << endl;
         return ecOk;
     }
@@ -1177,13 +1192,13 @@ int Shell::printTypeList(const TypeFilter *filter)
     int typeCount = 0;
 
     QString src, srcLine, name;
+    CompileUnit* unit = 0;
 
-    for (int i = 0; i < types->size() && !Console::interrupted(); i++) {
-        BaseType* type = types->at(i);
+    // Apply the filter to all types in parallel
+    const BaseTypeList types(_sym.factory().typesMatching(filter));
 
-        // Skip all types not matching the filter
-        if (filter && filter->filters() && !filter->matchType(type))
-            continue;
+    for (int i = 0; i < types.size() && !Console::interrupted(); i++) {
+        BaseType* type = types.at(i);
 
         // Print header if not yet done
         if (!headerPrinted) {
@@ -1281,7 +1296,7 @@ int Shell::cmdListTypesUsing(QStringList args)
     }
     // No ID given, so try to find the type by name
     else {
-        QList<BaseType*> tmp = _sym.factory().typesByName().values(s);
+        QList<BaseType*> tmp = _sym.factory().typesByName().values(StringAtoms::find(s));
         if (tmp.isEmpty()) {
             Console::errMsg("No type found with that name.");
             return ecInvalidId;
@@ -1418,7 +1433,9 @@ int Shell::cmdListTypesById(QStringList /*args*/)
 
 int Shell::cmdListTypesByName(QStringList /*args*/)
 {
-    QList<QString> names = _sym.factory()._typesByName.keys();
+    QList<QString> names;
+    foreach (StringAtom a, _sym.factory()._typesByName.keys())
+        names += StringAtoms::string(a);
 
     if (names.isEmpty()) {
         Console::out() << "There are no type references.\n";
@@ -1448,7 +1465,8 @@ int Shell::cmdListTypesByName(QStringList /*args*/)
     hline(w_total);
 
     for (int i = 0; i < names.size() && !Console::interrupted(); i++) {
-        BaseType* type = _sym.factory()._typesByName.value(names[i]);
+        BaseType* type = _sym.factory()._typesByName.value(
+                    StringAtoms::find(names[i]));
         // Construct name and line of the source file
         Console::out() << qSetFieldWidth(0) << Console::color(ctTypeId)
              << qSetFieldWidth(w_id)  << right << hex << (uint)type->id()
@@ -1595,18 +1613,18 @@ int Shell::cmdListVars(QStringList args)
 
 int Shell::printVarList(const VariableFilter *filter)
 {
-    const VariableList& vars = _sym.factory().vars();
+    const VariableList& allVars = _sym.factory().vars();
     CompileUnit* unit = 0;
 
 
-    if (vars.isEmpty()) {
+    if (allVars.isEmpty()) {
         Console::out() << "There were no variable references.\n";
         return ecOk;
     }
 
     // Find out required field width (the types are sorted by ascending ID)
     QSize tsize = ShellUtil::termSize();
-    const int w_id = ShellUtil::getFieldWidth(vars.last()->id());
+    const int w_id = ShellUtil::getFieldWidth(allVars.last()->id());
     const int w_datatype = 12;
     const int w_size = 5;
     const int w_src = 20;
@@ -1622,13 +1640,12 @@ int Shell::printVarList(const VariableFilter *filter)
     bool headerPrinted = false;
     int varCount = 0;
 
+    // Apply the filter to all variables in parallel
+    const VariableList vars(_sym.factory().varsMatching(filter));
+
     for (int i = 0; i < vars.size() && !Console::interrupted(); i++) {
         Variable* var = vars[i];
 
-        // Apply filter
-        if (filter && filter->filters() && !filter->matchVar(var))
-            continue;
-
         // Print header if not yet done
         if (!headerPrinted) {
             Console::out() << Console::color(ctBold)
@@ -1800,7 +1817,7 @@ BaseTypeList Shell::typeIdOrName(QString s) const
     }
     // No ID given, so try to find the type by name
     else
-        types = _sym.factory().typesByName().values(s);
+        types = _sym.factory().typesByName().values(StringAtoms::find(s));
 
     return types;
 }
@@ -1870,7 +1887,7 @@ int Shell::cmdListVarsUsing(QStringList args)
     }
     // No ID given, so try to find the type by name
     else {
-        types = _sym.factory().typesByName().values(s);
+        types = _sym.factory().typesByName().values(StringAtoms::find(s));
         if (types.isEmpty()) {
             Console::errMsg("No type found with that name.");
             return ecInvalidId;
@@ -3117,6 +3134,10 @@ int Shell::cmdMemoryDetect(QStringList args)
 
     if (type == "code")
         d.hiddenCode(index);
+    else if (type == "monitor")
+        d.hiddenCode(index, true);
+    else if (type == "reset")
+        Detect::resetMonitor(_sym.memDumps().at(index));
 
     return ecOk;
 }
@@ -3179,6 +3200,8 @@ int Shell::cmdRules(QStringList args)
         return cmdRulesShow(args);
     else if (QString("verbose").startsWith(cmd))
         return cmdRulesVerbose(args);
+    else if (QString("cache").startsWith(cmd))
+        return cmdRulesCache(args);
     else
         cmdHelp(QStringList("rules"));
 
@@ -3294,10 +3317,25 @@ int Shell::cmdRulesActive(QStringList args)
         return ecOk;
     }
 
-    return printRulesList(_sym.ruleEngine().activeRules(),
-                          "Total active rules: ",
-                          getActiveRule, getActiveRuleIndex, getActiveRuleUsage,
-                          true);
+    int ret = printRulesList(_sym.ruleEngine().activeRules(),
+                             "Total active rules: ",
+                             getActiveRule, getActiveRuleIndex,
+                             getActiveRuleUsage, true);
+
+    TypeRuleEngine::MatchStatistics stats =
+            _sym.ruleEngine().matchStatistics();
+    if (ret == ecOk && stats.lookups > 0 && !Console::interrupted()) {
+        Console::out() << "Rule lookups: " << Console::color(ctBold)
+                       << stats.lookups << Console::color(ctReset)
+                       << ", matched: " << Console::color(ctBold)
+                       << stats.matches << Console::color(ctReset)
+                       << QString(" (%1%), rules tested per lookup: %2")
+                          .arg(stats.matches * 100.0 / stats.lookups, 0, 'f', 1)
+                          .arg(stats.candidates / (double)stats.lookups, 0, 'f', 2)
+                       << endl;
+    }
+
+    return ret;
 }
 
 
@@ -3456,6 +3494,9 @@ int Shell::printRulesList(const list_t& rules,
         case TypeRuleAction::atExpression: Console::out() << "expr.";  break;
         case TypeRuleAction::atFunction:   Console::out() << "func.";  break;
         case TypeRuleAction::atInlineCode: Console::out() << "inline"; break;
+        case TypeRuleAction::atListEntry:
+        case TypeRuleAction::atHListEntry:
+        case TypeRuleAction::atDiscriminant: Console::out() << "native"; break;
         case TypeRuleAction::atNone:       Console::out() << "none";   break;
         }
 
@@ -3546,6 +3587,53 @@ int Shell::cmdRulesShow(QStringList args)
 }
 
 
+int Shell::cmdRulesCache(QStringList args)
+{
+    TypeRuleEngine& engine = _sym.ruleEngine();
+
+    if (args.isEmpty()) {
+        if (!engine.resultCacheSize()) {
+            Console::out() << "The result cache is disabled." << endl;
+            return ecOk;
+        }
+        TypeRuleEngine::MatchStatistics stats = engine.matchStatistics();
+        int lookups = stats.cacheHits + stats.cacheMisses;
+        Console::out() << "Result cache size: " << Console::color(ctBold)
+                       << engine.resultCacheSize() << Console::color(ctReset)
+                       << ", hits: " << Console::color(ctBold)
+                       << stats.cacheHits << Console::color(ctReset)
+                       << ", misses: " << Console::color(ctBold)
+                       << stats.cacheMisses << Console::color(ctReset);
+        if (lookups > 0)
+            Console::out() << QString(" (%1% hit rate)")
+                              .arg(stats.cacheHits * 100.0 / lookups, 0, 'f', 1);
+        Console::out() << endl;
+        return ecOk;
+    }
+    else if (args.size() != 1) {
+        cmdHelp(QStringList("rules"));
+        return ecInvalidArguments;
+    }
+
+    bool ok;
+    int size = args[0].toUInt(&ok);
+    if (args[0].toLower() == "off")
+        size = 0;
+    else if (!ok) {
+        Console::err() << "Illegal cache size: " << args[0] << endl;
+        return ecInvalidArguments;
+    }
+
+    engine.setResultCacheSize(size);
+    if (size)
+        Console::out() << "Caching up to " << size << " rule results." << endl;
+    else
+        Console::out() << "The result cache is disabled." << endl;
+
+    return ecOk;
+}
+
+
 int Shell::cmdRulesVerbose(QStringList args)
 {
     if (args.isEmpty()) {
@@ -3642,6 +3730,12 @@ int Shell::cmdScript(QStringList args)
         args.pop_front();
     }
 
+    // Batch mode for several memory dumps
+    if (!args.isEmpty() && args.first() == "-b") {
+        args.pop_front();
+        return cmdScriptBatch(args, timing);
+    }
+
     QString fileName = args.isEmpty() ? QString() : args[0];
     QFile file(fileName);
     QStringList includePaths(QDir::cleanPath(QFileInfo(file).absolutePath()));
@@ -3711,6 +3805,118 @@ int Shell::cmdScript(QStringList args)
 }
 
 
+QList<int> Shell::parseMemDumpList(const QString &dumps) const
+{
+    QList<int> indices;
+    const MemDumpArray& memDumps = _sym.memDumps();
+
+    if (dumps == "all") {
+        for (int i = 0; i < memDumps.size(); ++i)
+            if (memDumps[i])
+                indices.append(i);
+        return indices;
+    }
+
+    // Try a list of indices or index ranges
+    QRegExp rxRange("^(\\d+)(?:-(\\d+))?$");
+    QStringList parts = dumps.split(',', QString::SkipEmptyParts);
+    bool isList = !parts.isEmpty();
+    for (int i = 0; isList && i < parts.size(); ++i) {
+        if (rxRange.exactMatch(parts[i].trimmed())) {
+            int from = rxRange.cap(1).toInt();
+            int to = rxRange.cap(2).isEmpty() ? from : rxRange.cap(2).toInt();
+            for (int j = from; j <= to; ++j) {
+                if (j < memDumps.size() && memDumps[j]) {
+                    if (!indices.contains(j))
+                        indices.append(j);
+                }
+                else {
+                    Console::errMsg(QString("Memory dump index %1 does not "
+                                            "exist.").arg(j));
+                    return QList<int>();
+                }
+            }
+        }
+        else
+            isList = false;
+    }
+    if (isList)
+        return indices;
+
+    // Match the file names of the loaded dumps against a wildcard expression
+    indices.clear();
+    QRegExp rxFile(dumps, Qt::CaseSensitive, QRegExp::Wildcard);
+    for (int i = 0; i < memDumps.size(); ++i) {
+        if (memDumps[i] &&
+            (rxFile.exactMatch(memDumps[i]->fileName()) ||
+             rxFile.exactMatch(QFileInfo(memDumps[i]->fileName()).fileName())))
+            indices.append(i);
+    }
+    if (indices.isEmpty())
+        Console::errMsg(QString("No loaded memory dump matches \"%1\".")
+                        .arg(dumps));
+
+    return indices;
+}
+
+
+int Shell::cmdScriptBatch(QStringList args, bool timing)
+{
+    if (args.size() < 2) {
+        cmdHelp(QStringList("script"));
+        return ecInvalidArguments;
+    }
+
+    QList<int> indices = parseMemDumpList(args.takeFirst());
+    if (indices.isEmpty())
+        return ecNoMemoryDumpsLoaded;
+
+    QString fileName = args[0];
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        Console::errMsg(QString("Cannot open file \"%1\" for reading.")
+                        .arg(fileName));
+        return ecFileNotFound;
+    }
+    QString scriptCode = QTextStream(&file).readAll();
+    file.close();
+    QStringList includePaths(QDir::cleanPath(QFileInfo(file).absolutePath()));
+
+    QTime timer;
+    timer.start();
+    ScriptBatch batch(&_sym);
+    ScriptBatchResultList results =
+            batch.run(scriptCode, args, includePaths, indices);
+    int elapsed = timer.elapsed();
+
+    int failed = 0;
+    for (int i = 0; i < results.size(); ++i) {
+        const ScriptBatchResult& res = results[i];
+        Console::out() << Console::color(ctBold) << "==> [" << res.memDumpIndex
+                       << "] " << ShellUtil::shortFileName(res.fileName)
+                       << " <==" << Console::color(ctReset) << endl
+                       << res.output;
+        if (!res.output.isEmpty() && !res.output.endsWith('\n'))
+            Console::out() << endl;
+        if (res.failed) {
+            ++failed;
+            Console::errMsg(res.error);
+        }
+        if (timing)
+            Console::out() << "Execution time: " << (res.duration / 1000) << "."
+                           << QString("%1").arg(res.duration % 1000, 3, 10, QChar('0'))
+                           << " seconds" << endl;
+    }
+
+    if (timing)
+        Console::out() << "Total execution time: " << (elapsed / 1000) << "."
+                       << QString("%1").arg(elapsed % 1000, 3, 10, QChar('0'))
+                       << " seconds" << endl;
+
+    return failed ? ecScriptFailed : ecOk;
+}
+
+
 int Shell::cmdShow(QStringList args)
 {
     // Show cmdHelp, of no argument is given
@@ -3755,8 +3961,9 @@ int Shell::cmdShow(QStringList args)
     if (!var && !bt) {
         // Reset s
         s = expr.front();
-    	QList<BaseType*> types = _sym.factory().typesByName().values(s);
-    	QList<Variable*> vars = _sym.factory().varsByName().values(s);
+    	StringAtom atom = StringAtoms::find(s);
+    	QList<BaseType*> types = _sym.factory().typesByName().values(atom);
+    	QList<Variable*> vars = _sym.factory().varsByName().values(atom);
         enums = _sym.factory().enumsByName().values(s);
         if (types.size() + vars.size() > 1) {
             Console::out() << "The name \"" << Console::color(ctBold) << s << Console::color(ctReset)
@@ -4664,6 +4871,8 @@ int Shell::cmdBinary(QStringList args)
     switch (type) {
     case bdMemDumpList:
         return cmdBinaryMemDumpList(args);
+    case bdScriptBatch:
+        return cmdBinaryScriptBatch(args);
 //    case bdInstance:
 //        return cmdBinaryInstance(args);
     default:
@@ -4689,6 +4898,31 @@ int Shell::cmdBinaryMemDumpList(QStringList /*args*/)
 }
 
 
+int Shell::cmdBinaryScriptBatch(QStringList args)
+{
+    if (args.size() < 2)
+        return ecInvalidArguments;
+
+    QList<int> indices = parseMemDumpList(args.takeFirst());
+    if (indices.isEmpty())
+        return ecNoMemoryDumpsLoaded;
+
+    QFile file(args[0]);
+    if (!file.open(QIODevice::ReadOnly)) {
+        Console::errMsg(QString("Cannot open file \"%1\" for reading.")
+                        .arg(args[0]));
+        return ecFileNotFound;
+    }
+    QString scriptCode = QTextStream(&file).readAll();
+    file.close();
+    QStringList includePaths(QDir::cleanPath(QFileInfo(file).absolutePath()));
+
+    ScriptBatch batch(&_sym);
+    _bin << batch.run(scriptCode, args, includePaths, indices);
+    return ecOk;
+}
+
+
 UserResponse Shell::yesNoQuestion(const QString &title, const QString &question)
 {
     Q_UNUSED(title);
@@ -280,10 +280,13 @@ private:
     int cmdRulesFlush(QStringList args);
     int cmdRulesShow(QStringList args);
     int cmdRulesVerbose(QStringList args);
+    int cmdRulesCache(QStringList args);
     int cmdListTypesMatching(QStringList args);
     int cmdListVarsMatching(QStringList args);
 
     int cmdScript(QStringList args);
+    int cmdScriptBatch(QStringList args, bool timing);
+    QList<int> parseMemDumpList(const QString& dumps) const;
 
     int cmdShow(QStringList args);
     int cmdShowBaseType(const BaseType* t, const QString& name = QString(),
@@ -314,6 +317,7 @@ private:
 
     int cmdBinary(QStringList args);
     int cmdBinaryMemDumpList(QStringList args);
+    int cmdBinaryScriptBatch(QStringList args);
 //    int cmdBinaryInstance(QStringList args);
 };
 
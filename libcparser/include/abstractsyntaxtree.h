@@ -12,16 +12,14 @@
 #include <QString>
 #include <QHash>
 #include <astnode.h>
+#include <astarena.h>
 
 // forward declarations
 struct CParser_Ctx_struct;
 struct CLexer_Ctx_struct;
 
 class ASTScopeManager;
-
-typedef QList<pASTNode> ASTNodeQList;
-typedef QList<pASTNodeList> ASTNodeListQList;
-typedef QList<pASTTokenList> ASTTokenListQList;
+class QFile;
 
 class ASTBuilder;
 
@@ -97,6 +95,14 @@ public:
      */
     inline ASTScopeManager* scopeMgr() { return _scopeMgr; }
 
+    /**
+     * Returns the memory arena that holds all nodes, lists and tokens of this
+     * tree. Objects that should live as long as the tree, e.g. the ASTType
+     * objects of an ASTTypeEvaluator, can be allocated there as well. All
+     * memory is released at once by clear().
+     */
+    inline ASTArena* arena() { return &_arena; }
+
 private:
     /**
      * Parses the source code from file \a fileName and builds the AST.
@@ -131,13 +137,23 @@ private:
      */
     int parsePhase2(ASTBuilder* builder);
 
+    /**
+     * Creates the ANTLR input stream for the \a size bytes at \a data
+     * without copying them. The data must remain valid until clear() is
+     * called.
+     * @param data the source code
+     * @param size the size of \a data, in bytes
+     * @return \c true on success, \c false otherwise
+     */
+    bool setInPlaceInput(const char* data, qint64 size);
+
     QString _fileName;
     ASTScopeManager* _scopeMgr;
-    ASTNodeQList _nodes;
-    ASTNodeListQList _nodeLists;
-    ASTTokenListQList _tokenLists;
+    ASTArena _arena;
     pASTNodeList _rootNodes;
     pANTLR3_INPUT_STREAM _input;
+    QFile* _inputFile;
+    QByteArray _inputBuf;
     struct CLexer_Ctx_struct* _lxr;
     pANTLR3_COMMON_TOKEN_STREAM _tstream;
     struct CParser_Ctx_struct* _psr;
@@ -0,0 +1,139 @@
+#ifndef ASTARENA_H_
+#define ASTARENA_H_
+
+#include <QtGlobal>
+#include <new>
+#include <string.h>
+
+/**
+ * This class implements a bump-pointer memory arena for the structures of an
+ * AbstractSyntaxTree. Memory is allocated in large blocks and handed out
+ * sequentially, and it is only released as a whole by clear() or when the
+ * arena is destroyed.
+ *
+ * Plain C structures such as ASTNode are allocated with alloc() and never
+ * destructed. Objects with a non-trivial destructor are created with
+ * create(), which records the destructor so that clear() can call it.
+ */
+class ASTArena
+{
+public:
+    /**
+     * Constructor
+     * @param blockSize the size of one memory block in bytes
+     */
+    explicit ASTArena(size_t blockSize = 64 * 1024);
+
+    /**
+     * Destructor, releases all memory
+     */
+    ~ASTArena();
+
+    /**
+     * Allocates \a size bytes of zero-initialized memory.
+     * @param size no. of bytes to allocate
+     * @return pointer to the memory, suitably aligned for any structure
+     */
+    void* alloc(size_t size);
+
+    /**
+     * Allocates a zero-initialized plain C structure of type \a T.
+     */
+    template<class T>
+    inline T* alloc()
+    {
+        return static_cast<T*>(alloc(sizeof(T)));
+    }
+
+    /**
+     * Creates a copy of \a src within the arena. The destructor of the copy
+     * is called by clear().
+     * @param src the object to copy
+     * @return the copy of \a src
+     */
+    template<class T>
+    T* create(const T& src)
+    {
+        DtorEntry* e = static_cast<DtorEntry*>(
+                    alloc(dtorEntrySize() + sizeof(T)));
+        T* obj = new (reinterpret_cast<char*>(e) + dtorEntrySize()) T(src);
+        e->dtor = &destroy<T>;
+        e->next = _dtors;
+        _dtors = e;
+        return obj;
+    }
+
+    /**
+     * Calls the destructors of all objects created by create() and releases
+     * all memory blocks.
+     */
+    void clear();
+
+    /**
+     * Returns the total no. of bytes handed out by this arena.
+     */
+    inline qint64 bytesUsed() const { return _bytesUsed; }
+
+    /**
+     * Returns the total no. of bytes allocated from the system.
+     */
+    inline qint64 bytesReserved() const { return _bytesReserved; }
+
+private:
+    struct Block
+    {
+        Block* next;
+    };
+
+    struct DtorEntry
+    {
+        void (*dtor)(void*);
+        DtorEntry* next;
+    };
+
+    template<class T>
+    static void destroy(void* obj)
+    {
+        static_cast<T*>(obj)->~T();
+    }
+
+    static inline size_t align(size_t size)
+    {
+        const size_t a = 2 * sizeof(void*);
+        return (size + a - 1) & ~(a - 1);
+    }
+
+    static inline size_t dtorEntrySize()
+    {
+        return align(sizeof(DtorEntry));
+    }
+
+    void* allocBlock(size_t size);
+
+    // Not copyable
+    ASTArena(const ASTArena&);
+    ASTArena& operator=(const ASTArena&);
+
+    const size_t _blockSize;
+    Block* _blocks;
+    char* _pos;
+    char* _end;
+    DtorEntry* _dtors;
+    qint64 _bytesUsed;
+    qint64 _bytesReserved;
+};
+
+
+inline void* ASTArena::alloc(size_t size)
+{
+    size = align(size);
+    if ((size_t)(_end - _pos) < size)
+        return allocBlock(size);
+    void* ret = _pos;
+    _pos += size;
+    _bytesUsed += size;
+    memset(ret, 0, size);
+    return ret;
+}
+
+#endif /* ASTARENA_H_ */
@@ -14,6 +14,7 @@
 #include <astsymbol.h>
 #include <QMultiHash>
 #include <QStack>
+#include <QSet>
 #include <QStringList>
 #include <genericexception.h>
 #include <typeinfooracle.h>
@@ -30,6 +31,18 @@ public:
 };
 
 
+template <class Set>
+class SetAutoRemover
+{
+    Set* _set;
+    typename Set::value_type _value;
+public:
+    explicit SetAutoRemover(Set* s, const typename Set::value_type& value)
+        : _set(s), _value(value) { _set->insert(_value); }
+    ~SetAutoRemover() { _set->remove(_value); }
+};
+
+
 class ASTType
 {
     enum Flags {
@@ -134,7 +147,38 @@ typedef QSet<const ASTSymbol*> ASTSymbolSet;
 typedef QHash<const ASTNode*, const ASTSymbol*> ASTNodeSymHash;
 typedef QHash<const ASTNode*, QMultiHash<const ASTSymbol*, TransformedSymbol> >
     ASTNodeTransSymHash;
-typedef QStack<TransformedSymbol> TransformedSymStack;
+typedef QSet<TransformedSymbol> TransformedSymSet;
+typedef QSet<const ASTNode*> ASTNodeSet;
+
+
+/**
+ * Key for memoizing dead ends of the points-to analysis: following the link
+ * to node \a target with link transformations \a linkTrans from the transformed
+ * symbol \a sym does not yield any new assignments.
+ */
+struct PointsToDeadEnd
+{
+    PointsToDeadEnd(const TransformedSymbol& sym, const AssignedNode& link)
+        : sym(sym), target(link.node), linkTrans(link.transformations) {}
+
+    bool operator==(const PointsToDeadEnd& other) const
+    {
+        return target == other.target && sym == other.sym &&
+                linkTrans == other.linkTrans;
+    }
+
+    TransformedSymbol sym;
+    const ASTNode* target;
+    SymbolTransformations linkTrans;
+};
+
+inline uint qHash(const PointsToDeadEnd& de)
+{
+    uint h = qHash(de.target) ^ qHash(de.linkTrans);
+    return qHash(de.sym) ^ ((h << 16) | (h >> 16));
+}
+
+typedef QSet<PointsToDeadEnd> PointsToDeadEndSet;
 
 
 struct PointsToEvalState
@@ -152,8 +196,8 @@ struct PointsToEvalState
     SymbolTransformations lastLinkTrans;
     bool validLvalue;
     ASTNodeNodeHash interLinks;
-    TransformedSymStack followedSymStack;
-    ASTNodeStack evalNodeStack;
+    TransformedSymSet followedSyms;
+    ASTNodeSet evalNodes;
     QString debugPrefix;
 };
 
@@ -251,6 +295,11 @@ public:
     void reportErr(const GenericException& e,  const ASTNode* node,
                    const TypeEvalDetails* ed) const;
 
+    /**
+     * @return the number of errors reported by reportErr() so far
+     */
+    int errorCount() const;
+
 protected:
     enum EvalPhase {
         epFindSymbols  = (1 << 0),
@@ -379,12 +428,18 @@ private:
     int _pointsToRound;
     int _assignments;
     int _assignmentsTotal;
-    QMultiHash<uint, uint> _pointsToDeadEnds;
+    PointsToDeadEndSet _pointsToDeadEnds;
     int _pointsToDeadEndHits;
     const TypeInfoOracle* _oracle;
+    mutable int _errorCount;
 };
 
 
+inline int ASTTypeEvaluator::errorCount() const
+{
+    return _errorCount;
+}
+
 inline int ASTTypeEvaluator::sizeofLong() const
 {
     return _sizeofLong;
@@ -7,6 +7,16 @@ class Gzip
 {
 public:
     static QByteArray gUncompress(const QByteArray &data);
+
+    /**
+     * Uncompresses the \a size bytes of gzip data at \a data. The output
+     * buffer is allocated only once if the size stored in the gzip trailer
+     * is plausible.
+     * @param data the compressed data
+     * @param size the size of \a data, in bytes
+     * @return the uncompressed data, or an empty array in case of an error
+     */
+    static QByteArray gUncompress(const char* data, qint64 size);
 };
 
 #endif // GZIP_H
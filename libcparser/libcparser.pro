@@ -31,7 +31,8 @@ HEADERS += include/ast_interface.h \
     include/bitop.h \
     include/astnodefinder.h \
     include/typeinfooracle.h \
-    include/gzip.h
+    include/gzip.h \
+    include/astarena.h
 SOURCES += \
     antlr_generated/CLexer.c \
     antlr_generated/CParser.c \
@@ -48,7 +49,8 @@ SOURCES += \
     src/astwalker.cpp \
     src/genericexception.cpp \
     src/realtypes.cpp \
-    src/gzip.cpp
+    src/gzip.cpp \
+    src/astarena.cpp
 
 LIBS += -L../libantlr3c$$BUILD_DIR \
     -l$$ANTLR_LIB \
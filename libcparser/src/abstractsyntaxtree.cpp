@@ -14,7 +14,8 @@
 #include <QFile>
 
 AbstractSyntaxTree::AbstractSyntaxTree()
-    : _scopeMgr(0), _rootNodes(0), _input(0), _lxr(0), _tstream(0), _psr(0)
+    : _scopeMgr(0), _rootNodes(0), _input(0), _inputFile(0), _lxr(0),
+      _tstream(0), _psr(0)
 {
     _scopeMgr = new ASTScopeManager(this);
 }
@@ -30,29 +31,8 @@ AbstractSyntaxTree::~AbstractSyntaxTree()
 
 void AbstractSyntaxTree::clear()
 {
-    for (ASTNodeQList::iterator it = _nodes.begin();
-            it != _nodes.end(); ++it)
-    {
-        pASTNode p = *it;
-        delete p;
-    }
-    _nodes.clear();
-
-    for (ASTNodeListQList::iterator it = _nodeLists.begin();
-            it != _nodeLists.end(); ++it)
-    {
-        pASTNodeList p = *it;
-        delete p;
-    }
-    _nodeLists.clear();
-
-    for (ASTTokenListQList::iterator it = _tokenLists.begin();
-            it != _tokenLists.end(); ++it)
-    {
-        pASTTokenList p = *it;
-        delete p;
-    }
-    _tokenLists.clear();
+    // Releases all nodes, lists and tokens at once
+    _arena.clear();
 
     _scopeMgr->clear();
     _rootNodes = 0;
@@ -73,9 +53,16 @@ void AbstractSyntaxTree::clear()
     }
 
     if (_input) {
-        _input->close(_input); // also frees the data
+        _input->close(_input); // frees the data only if it was copied
         _input = 0;
     }
+
+    // The in-place input data must be released after the input stream
+    if (_inputFile) {
+        delete _inputFile; // also unmaps the file
+        _inputFile = 0;
+    }
+    _inputBuf.clear();
 }
 
 
@@ -103,37 +90,62 @@ int AbstractSyntaxTree::parse(const QString& fileName, ASTBuilder* builder)
         return ANTLR3_ERR_NOFILE;
     }
 
-    // Deflate compressed input files
-    if (fileName.endsWith(".gz")) {
-        QFile in(fileName);
-        if (!in.open(QFile::ReadOnly)) {
-            debugerr("Error opening file \"" << fileName << "\" for reading.");
-            return ANTLR3_ERR_NOFILE;
-        }
+    _fileName = fileName;
+    _inputFile = new QFile(fileName);
+    if (!_inputFile->open(QFile::ReadOnly)) {
+        debugerr("Error opening file \"" << fileName << "\" for reading.");
+        return ANTLR3_ERR_NOFILE;
+    }
 
-        QByteArray deflated = Gzip::gUncompress(in.readAll());
+    // Map the file into memory instead of reading it. Parallel parsers then
+    // share the page cache, and ANTLR reads the source right where it is.
+    const qint64 size = _inputFile->size();
+    const char* data = 0;
+    if (size > 0 && !(data = (const char*)_inputFile->map(0, size))) {
+        // Fall back to reading the file if it cannot be mapped
+        _inputBuf = _inputFile->readAll();
+        data = _inputBuf.constData();
+    }
+
+    // Deflate compressed input files directly into the ANTLR input buffer
+    if (fileName.endsWith(".gz")) {
+        QByteArray deflated = Gzip::gUncompress(data, size);
         if (deflated.isEmpty()) {
             debugerr("Error deflating file \"" << fileName << "\".");
             return ANTLR3_ERR_NOFILE;
         }
 
-        return parse(deflated, builder, fileName);
+        // The compressed data is not needed anymore
+        delete _inputFile;
+        _inputFile = 0;
+        _inputBuf = deflated;
+        data = _inputBuf.constData();
+        if (!setInPlaceInput(data, _inputBuf.size()))
+            return ANTLR3_ERR_NOMEM;
     }
+    else if (!setInPlaceInput(data ? data : "", size))
+        return ANTLR3_ERR_NOMEM;
 
-    // Otherwise use the ANTLR file input stream
-    _fileName = fileName;
-    QByteArray s = fileName.toAscii();
-    _input = antlr3AsciiFileStreamNew((pANTLR3_UINT8) s.constData());
-
-    // The input will be created successfully, providing that there is enough
-    // memory and the file exists etc
-    //
-    if (!_input) {
-        debugerr("Failed to open file " << fileName);
-        return ANTLR3_ERR_NOFILE;
+    return parsePhase2(builder);
+}
+
+
+bool AbstractSyntaxTree::setInPlaceInput(const char *data, qint64 size)
+{
+    QByteArray s = _fileName.toAscii();
+    _input = antlr3NewAsciiStringInPlaceStream(
+                (pANTLR3_UINT8)data, size, (pANTLR3_UINT8)s.constData());
+
+    if (!_input || (void*)_input == ANTLR3_FUNC_PTR(ANTLR3_ERR_NOMEM)) {
+        _input = 0;
+        debugerr("Failed to create input stream for " << _fileName);
+        return false;
     }
 
-    return parsePhase2(builder);
+    // The in-place stream does not initialize this flag, but we own the data
+    _input->isAllocated = ANTLR3_FALSE;
+
+    return true;
 }
 
 
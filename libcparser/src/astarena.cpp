@@ -0,0 +1,60 @@
+#include <astarena.h>
+#include <stdlib.h>
+
+
+ASTArena::ASTArena(size_t blockSize)
+    : _blockSize(align(blockSize)), _blocks(0), _pos(0), _end(0), _dtors(0),
+      _bytesUsed(0), _bytesReserved(0)
+{
+}
+
+
+ASTArena::~ASTArena()
+{
+    clear();
+}
+
+
+void* ASTArena::allocBlock(size_t size)
+{
+    const size_t header = align(sizeof(Block));
+    // Large requests get a block of their own, so the remainder of the
+    // current block is not wasted
+    bool ownBlock = size > _blockSize / 4;
+    size_t blockSize = header + (ownBlock ? size : _blockSize);
+
+    Block* b = static_cast<Block*>(malloc(blockSize));
+    if (!b)
+        throw std::bad_alloc();
+    b->next = _blocks;
+    _blocks = b;
+    _bytesReserved += blockSize;
+
+    char* ret = reinterpret_cast<char*>(b) + header;
+    if (!ownBlock) {
+        _pos = ret + size;
+        _end = reinterpret_cast<char*>(b) + blockSize;
+    }
+    _bytesUsed += size;
+    memset(ret, 0, size);
+
+    return ret;
+}
+
+
+void ASTArena::clear()
+{
+    // Destruct all objects that require it
+    for (DtorEntry* e = _dtors; e; e = e->next)
+        e->dtor(reinterpret_cast<char*>(e) + dtorEntrySize());
+    _dtors = 0;
+
+    // Release all blocks at once
+    while (_blocks) {
+        Block* b = _blocks;
+        _blocks = b->next;
+        free(b);
+    }
+    _pos = _end = 0;
+    _bytesUsed = _bytesReserved = 0;
+}
@@ -172,10 +172,8 @@ ASTScope* ASTBuilder::currentScope() const
 
 pASTNode ASTBuilder::newASTNode()
 {
-    pASTNode ret = new struct ASTNode;
-    _ast->_nodes.append(ret);
-    // Initialize
-    memset(ret, 0, sizeof(struct ASTNode));
+    // Memory is zero-initialized by the arena
+    pASTNode ret = _ast->_arena.alloc<struct ASTNode>();
     ret->type = nt_undefined;
 
     return ret;
@@ -237,10 +235,7 @@ pASTNode ASTBuilder::pushdownBinaryExpression(pANTLR3_COMMON_TOKEN op,
 
 pASTNodeList ASTBuilder::newASTNodeList(pASTNode item, pASTNodeList tail)
 {
-    pASTNodeList ret = new struct ASTNodeList;
-    _ast->_nodeLists.append(ret);
-    // Init list node
-    memset(ret, 0, sizeof(struct ASTNodeList));
+    pASTNodeList ret = _ast->_arena.alloc<struct ASTNodeList>();
     ret->item = item;
     // Append list node to end of list
     if (tail)
@@ -253,10 +248,7 @@ pASTNodeList ASTBuilder::newASTNodeList(pASTNode item, pASTNodeList tail)
 pASTTokenList ASTBuilder::newASTTokenList(pANTLR3_COMMON_TOKEN item,
         pASTTokenList tail)
 {
-    pASTTokenList ret = new struct ASTTokenList;
-    _ast->_tokenLists.append(ret);
-    // Init list node
-    memset(ret, 0, sizeof(struct ASTTokenList));
+    pASTTokenList ret = _ast->_arena.alloc<struct ASTTokenList>();
     ret->item = item;
     // Append list node to end of list
     if (tail)
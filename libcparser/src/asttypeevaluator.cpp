@@ -77,7 +77,8 @@ ASTTypeEvaluator::ASTTypeEvaluator(AbstractSyntaxTree* ast, int sizeofLong,
                                    int sizeofPointer, const TypeInfoOracle *oracle)
     : ASTWalker(ast), _sizeofLong(sizeofLong), _sizeofPointer(sizeofPointer),
       _phase(epFindSymbols), _pointsToRound(0), _assignments(0),
-      _assignmentsTotal(0), _pointsToDeadEndHits(0), _oracle(oracle)
+      _assignmentsTotal(0), _pointsToDeadEndHits(0), _oracle(oracle),
+      _errorCount(0)
 {
 }
 
@@ -122,7 +123,9 @@ bool ASTTypeEvaluator::evaluateTypes()
 		if (_pointsToRound == 1)
 			std::cout << std::endl;
 		debugmsg("********** Round " << _pointsToRound << ": " << _assignments
-				 << " assignments, " << _assignmentsTotal << " total **********");
+				 << " assignments, " << _assignmentsTotal << " total, "
+				 << _pointsToDeadEnds.size() << " dead ends, "
+				 << _pointsToDeadEndHits << " hits **********");
 #endif
 	} while (!_stopWalking && _assignments > 0 && !interrupted());
 
@@ -154,6 +157,10 @@ bool ASTTypeEvaluator::hasValidType(const ASTNode *node) const
 
 ASTType* ASTTypeEvaluator::copyASTType(const ASTType* src)
 {
+    // Types live in the arena of the AST, if we have one
+    if (_ast)
+        return _ast->arena()->create(*src);
+
     ASTType* t = new ASTType(*src);
     _allTypes.append(t);
     return t;
@@ -162,9 +169,8 @@ ASTType* ASTTypeEvaluator::copyASTType(const ASTType* src)
 
 ASTType* ASTTypeEvaluator::createASTType(RealType type, ASTType* next)
 {
-    ASTType* t = new ASTType(type, next);
-    _allTypes.append(t);
-    return t;
+    ASTType t(type, next);
+    return copyASTType(&t);
 }
 
 
@@ -2705,6 +2711,7 @@ void ASTTypeEvaluator::reportErr(const GenericException& e, const ASTNode* node,
                 .arg(printer.toString(node, true));
     }
     // Write report
+    ++_errorCount;
     BugReport::reportErr(msg, e.file, e.line);
 }
 
@@ -2869,7 +2876,7 @@ void ASTTypeEvaluator::evaluateIdentifierPointsTo(const ASTNode *node)
     if ((type->type() & NumericTypes) && !canHoldPointerValue(type->type()))
         return;
 
-    es.followedSymStack.push(TransformedSymbol(es.sym, this));
+    es.followedSyms.insert(TransformedSymbol(es.sym, this));
 
     evaluateIdentifierPointsToRek(&es);
 }
@@ -2878,11 +2885,11 @@ void ASTTypeEvaluator::evaluateIdentifierPointsTo(const ASTNode *node)
 int ASTTypeEvaluator::evaluateIdentifierPointsToRek(PointsToEvalState *es)
 {
     // Check for loop in recursion
-    if (es->evalNodeStack.contains(es->root))
+    if (es->evalNodes.contains(es->root))
         return 0;
 
-    // Push current root on the recursion tracking stack, gets auto-popped later
-    StackAutoPopper<ASTNodeStack> autoPopper(&es->evalNodeStack, es->root);
+    // Add current root to the recursion tracking set, gets auto-removed later
+    SetAutoRemover<ASTNodeSet> autoRemover(&es->evalNodes, es->root);
 
 #ifdef DEBUG_POINTS_TO
     QString s;
@@ -2960,18 +2967,17 @@ int ASTTypeEvaluator::evaluateIdentifierPointsToRek(PointsToEvalState *es)
 
                     // Do not follow any symbol twice
                     ts = TransformedSymbol(it->sym, it->transformations);
-                    if (es->followedSymStack.contains(ts))
+                    if (es->followedSyms.contains(ts))
                         continue;
 
                     curSym = TransformedSymbol(es->sym, combinedTrans);
-                    const uint symHash = qHash(curSym);
-                    const uint linkTargetHash =
-                            qHash(it->node) ^  qHash(it->transformations);
+                    const PointsToDeadEnd deadEnd(curSym, it.value());
 
                     // Check if the current transformed symbol leads to a dead
-                    // end when following this inter-link.
+                    // end when following this inter-link. The dead ends are
+                    // shared by all identifiers of the translation unit.
                     if (_pointsToRound > 1 &&
-                        _pointsToDeadEnds.contains(symHash, linkTargetHash))
+                        _pointsToDeadEnds.contains(deadEnd))
                     {
                         ++_pointsToDeadEndHits;
 #ifdef DEBUG_POINTS_TO
@@ -2983,7 +2989,7 @@ int ASTTypeEvaluator::evaluateIdentifierPointsToRek(PointsToEvalState *es)
 
                     // Recurive points-to analysis
                     rek_es = *es;
-                    rek_es.followedSymStack.push(ts);
+                    rek_es.followedSyms.insert(ts);
                     rek_es.root = it->node;
                     rek_es.lastLinkTrans = it->transformations;
                     rek_es.transformations = combinedTrans;
@@ -2999,7 +3005,7 @@ int ASTTypeEvaluator::evaluateIdentifierPointsToRek(PointsToEvalState *es)
                     // It only depends on the current, transformed symbol as
                     // well as the target node and its link transformations.
                     if (!ret && _pointsToRound > 1)
-                        _pointsToDeadEnds.insert(symHash, linkTargetHash);
+                        _pointsToDeadEnds.insert(deadEnd);
                 }
             }
 #ifdef DEBUG_POINTS_TO
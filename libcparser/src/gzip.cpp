@@ -1,41 +1,58 @@
 #include <gzip.h>
 #include <zlib.h>
 #include <debug.h>
+#include <QtEndian>
+
+
+QByteArray Gzip::gUncompress(const QByteArray &data)
+{
+    return gUncompress(data.constData(), data.size());
+}
 
 
 /*
  * Shamelessly stolen from:
  * http://stackoverflow.com/questions/2690328/qt-quncompress-gzip-data#7351507
  */
-QByteArray Gzip::gUncompress(const QByteArray &data)
+QByteArray Gzip::gUncompress(const char *data, qint64 size)
 {
-    if (data.size() <= 4) {
+    if (size <= 4) {
         debugmsg("gUncompress: Input data is truncated");
         return QByteArray();
     }
 
+    // The last four bytes of a gzip file hold the uncompressed size modulo
+    // 2^32. Deflate cannot compress better than about 1:1032, so ignore
+    // values that are obviously wrong.
+    static const int CHUNK_SIZE = 64*1024;
+    const quint32 isize = qFromLittleEndian<quint32>((const uchar*)data + size - 4);
+    qint64 bufSize = CHUNK_SIZE;
+    if (isize > 0 && isize <= size * 1032)
+        bufSize = isize;
+
     QByteArray result;
+    result.resize(bufSize);
 
     int ret;
     z_stream strm;
-    static const int CHUNK_SIZE = 1024;
-    char out[CHUNK_SIZE];
 
     /* allocate inflate state */
     strm.zalloc = Z_NULL;
     strm.zfree = Z_NULL;
     strm.opaque = Z_NULL;
-    strm.avail_in = data.size();
-    strm.next_in = (Bytef*)(data.data());
+    strm.avail_in = size;
+    strm.next_in = (Bytef*)(data);
 
     ret = inflateInit2(&strm, 15 +  32); // gzip decoding
     if (ret != Z_OK)
         return QByteArray();
 
-    // run inflate()
+    // run inflate() directly into the result buffer
     do {
-        strm.avail_out = CHUNK_SIZE;
-        strm.next_out = (Bytef*)(out);
+        if (strm.total_out >= (uLong)result.size())
+            result.resize(result.size() + qMax(result.size(), CHUNK_SIZE));
+        strm.avail_out = result.size() - strm.total_out;
+        strm.next_out = (Bytef*)(result.data() + strm.total_out);
 
         ret = inflate(&strm, Z_NO_FLUSH);
         Q_ASSERT(ret != Z_STREAM_ERROR);  // state not clobbered
@@ -48,11 +65,10 @@ QByteArray Gzip::gUncompress(const QByteArray &data)
             (void)inflateEnd(&strm);
             return QByteArray();
         }
-
-        result.append(out, CHUNK_SIZE - strm.avail_out);
-    } while (strm.avail_out == 0);
+    } while (ret != Z_STREAM_END && strm.avail_out == 0);
 
     // clean up and return
+    result.resize(strm.total_out);
     inflateEnd(&strm);
 
     return result;
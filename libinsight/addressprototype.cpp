@@ -0,0 +1,190 @@
+#include <insight/addressprototype.h>
+#include <QScriptEngine>
+#include <QScriptContext>
+
+namespace js
+{
+const char* address = "Address";
+}
+
+#define INT32MASK 0xFFFFFFFFULL
+
+
+AddressPrototype::AddressPrototype(QObject *parent)
+    : QObject(parent)
+{
+}
+
+
+QScriptValue AddressPrototype::registerWith(QScriptEngine *eng)
+{
+    QScriptValue proto = eng->newQObject(this,
+                               QScriptEngine::QtOwnership,
+                               QScriptEngine::SkipMethodsInEnumeration
+                               | QScriptEngine::ExcludeSuperClassMethods
+                               | QScriptEngine::ExcludeSuperClassProperties);
+    proto.setPrototype(eng->globalObject().property("Object").property("prototype"));
+
+    qScriptRegisterMetaType<ScriptAddress>(eng, toScriptValue, fromScriptValue,
+                                           proto);
+
+    return eng->newFunction(construct, proto);
+}
+
+
+quint64 AddressPrototype::valueFromScriptValue(const QScriptValue &val, bool *ok)
+{
+    if (ok)
+        *ok = true;
+
+    if (val.isVariant() &&
+        val.toVariant().userType() == qMetaTypeId<ScriptAddress>())
+        return qvariant_cast<ScriptAddress>(val.toVariant()).value;
+    else if (val.isNumber()) {
+        // Sign-extend negative numbers, such as ~0xfff
+        double d = val.toNumber();
+        return d < 0 ? (quint64)(qint64) d : (quint64) d;
+    }
+    else if (val.isString()) {
+        QString s = val.toString();
+        if (s.startsWith("0x"))
+            s.remove(0, 2);
+        return s.toULongLong(ok, 16);
+    }
+
+    if (ok)
+        *ok = false;
+    return 0;
+}
+
+
+QScriptValue AddressPrototype::toScriptValue(QScriptEngine *eng,
+                                             const ScriptAddress &addr)
+{
+    // The default prototype for ScriptAddress is used automatically
+    return eng->newVariant(qVariantFromValue(addr));
+}
+
+
+void AddressPrototype::fromScriptValue(const QScriptValue &obj,
+                                       ScriptAddress &addr)
+{
+    addr.value = valueFromScriptValue(obj);
+}
+
+
+QScriptValue AddressPrototype::construct(QScriptContext *ctx, QScriptEngine *eng)
+{
+    quint64 value = 0;
+    if (ctx->argumentCount() >= 2) {
+        value = (((quint64) ctx->argument(0).toUInt32()) << 32) |
+                ctx->argument(1).toUInt32();
+    }
+    else if (ctx->argumentCount() == 1) {
+        bool ok;
+        value = valueFromScriptValue(ctx->argument(0), &ok);
+        if (!ok)
+            return ctx->throwError(QString("Illegal address: %1")
+                                   .arg(ctx->argument(0).toString()));
+    }
+
+    return toScriptValue(eng, ScriptAddress(value));
+}
+
+
+quint64 AddressPrototype::thisValue() const
+{
+    QScriptValue obj = thisObject();
+    if (!obj.isVariant() ||
+        obj.toVariant().userType() != qMetaTypeId<ScriptAddress>())
+    {
+        if (context())
+            context()->throwError("Called an Address member function on a "
+                                  "non-Address object");
+        return 0;
+    }
+    return qvariant_cast<ScriptAddress>(obj.toVariant()).value;
+}
+
+
+quint64 AddressPrototype::argValue(const QScriptValue &val) const
+{
+    bool ok;
+    quint64 ret = valueFromScriptValue(val, &ok);
+    if (!ok && context())
+        context()->throwError(QString("Illegal address: %1").arg(val.toString()));
+    return ret;
+}
+
+
+ScriptAddress AddressPrototype::Add(const QScriptValue &offset) const
+{
+    return ScriptAddress(thisValue() + argValue(offset));
+}
+
+
+ScriptAddress AddressPrototype::Sub(const QScriptValue &offset) const
+{
+    return ScriptAddress(thisValue() - argValue(offset));
+}
+
+
+ScriptAddress AddressPrototype::And(const QScriptValue &mask) const
+{
+    return ScriptAddress(thisValue() & argValue(mask));
+}
+
+
+ScriptAddress AddressPrototype::Or(const QScriptValue &mask) const
+{
+    return ScriptAddress(thisValue() | argValue(mask));
+}
+
+
+double AddressPrototype::Diff(const QScriptValue &other) const
+{
+    return (double)(qint64)(thisValue() - argValue(other));
+}
+
+
+int AddressPrototype::Compare(const QScriptValue &other) const
+{
+    quint64 a = thisValue(), b = argValue(other);
+    return a < b ? -1 : (a > b ? 1 : 0);
+}
+
+
+bool AddressPrototype::Equals(const QScriptValue &other) const
+{
+    return thisValue() == argValue(other);
+}
+
+
+bool AddressPrototype::IsNull() const
+{
+    return thisValue() == 0;
+}
+
+
+quint32 AddressPrototype::High() const
+{
+    return thisValue() >> 32;
+}
+
+
+quint32 AddressPrototype::Low() const
+{
+    return thisValue() & INT32MASK;
+}
+
+
+double AddressPrototype::toNumber() const
+{
+    return (double) thisValue();
+}
+
+
+QString AddressPrototype::toString(int base) const
+{
+    return QString::number(thisValue(), base);
+}
@@ -6,7 +6,7 @@
 AltRefType::AltRefType(int id, const ASTExpression *expr)
     : _id(id), _expr(expr)
 {
-    updateVarExpr();
+    updateExpr();
 }
 
 
@@ -29,7 +29,7 @@ Instance AltRefType::toInstance(VirtualMemory *vmem, const Instance *inst,
                                 const QStringList& parentNames) const
 {
     // Evaluate pointer arithmetic for new address
-    ExpressionResult result = _expr->result(inst);
+    ExpressionResult result = _program.result(inst);
     if (!result.isValid())
         return Instance(Instance::orCandidate);
 
@@ -61,7 +61,7 @@ void AltRefType::readFrom(KernelSymbolStream &in, SymFactory* factory)
     in >> id;
     _id = id;
     _expr = ASTExpression::fromStream(in, factory);
-    updateVarExpr();
+    updateExpr();
 }
 
 
@@ -72,9 +72,10 @@ void AltRefType::writeTo(KernelSymbolStream &out) const
 }
 
 
-void AltRefType::updateVarExpr()
+void AltRefType::updateExpr()
 {
     _varExpr.clear();
+    _program.compile(_expr);
     if (!_expr)
         return;
     ASTConstExpressionList list = _expr->findExpressions(etVariable);
@@ -465,8 +465,14 @@ ExpressionResult ASTBinaryExpression::result(const Instance *inst) const
     if (!_left || !_right)
         return ExpressionResult();
 
-    ExpressionResult lr = _left->result(inst);
-    ExpressionResult rr = _right->result(inst);
+    return evaluate(_type, _left->result(inst), _right->result(inst));
+}
+
+
+ExpressionResult ASTBinaryExpression::evaluate(ExpressionType type,
+                                               const ExpressionResult &lr,
+                                               const ExpressionResult &rr)
+{
     ExpressionResult ret(lr.resultType | rr.resultType);
     ExprResultSizes target = ret.size = binaryExprSize(lr, rr);
     // Is the expression decidable?
@@ -595,7 +601,7 @@ ExpressionResult ASTBinaryExpression::result(const Instance *inst) const
     } while (0)
 
 
-    switch (_type) {
+    switch (type) {
     case etLogicalOr:
         LOGICAL_OP(||);
         break;
@@ -840,7 +846,14 @@ ExpressionResult ASTUnaryExpression::result(const Instance *inst) const
     if (!_child)
         return ExpressionResult();
 
-    ExpressionResult res = _child->result(inst);
+    return evaluate(_type, _child->result(inst), inst);
+}
+
+
+ExpressionResult ASTUnaryExpression::evaluate(ExpressionType type,
+                                              ExpressionResult res,
+                                              const Instance *inst)
+{
     // Is the expression decidable?
     if (res.resultType & (erUndefined|erRuntime)) {
         /// @todo constants cannot be incremented, that makes no sense at all!
@@ -868,7 +881,7 @@ ExpressionResult ASTUnaryExpression::result(const Instance *inst) const
     } while (0)
 
 
-    switch (_type) {
+    switch (type) {
     case etUnaryInc:
         UNARY_PREFIX(++);
         break;
@@ -941,7 +954,7 @@ ExpressionResult ASTUnaryExpression::result(const Instance *inst) const
 
     default:
         exprEvalError(QString("Unhandled unary expression: %1")
-                      .arg(expressionTypeToString(_type)));
+                      .arg(expressionTypeToString(type)));
     }
 
     return res;
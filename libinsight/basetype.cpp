@@ -98,8 +98,8 @@ uint BaseType::hash(bool* isValid) const
         // types unnoticed
         _hash = type();
         // Ignore the name for numeric types
-        if (!_name.isEmpty() && !(type() & (IntegerTypes & ~rtEnum)))
-            _hash ^= qHash(_name);
+        if (!name().isEmpty() && !(type() & (IntegerTypes & ~rtEnum)))
+            _hash ^= qHash(name());
         if (_size > 0) {
             qsrand(_hash ^ _size);
             _hash ^= qHash(qrand());
@@ -11,3 +11,5 @@ const char* mt_history_file = ".insight/history";
 const char* mt_lock_file = ".insight/insight.lock";
 const char* mt_log_file = ".insight/insight.log";
 const char* mt_sock_file = ".insight/insight.sock";
+const char* mt_source_cache_dir = ".insight/sourcecache";
+const char* mt_refhash_cache_dir = ".insight/refhashcache";
@@ -1,7 +1,13 @@
 #include <insight/detect.h>
 #include <insight/function.h>
 #include <insight/variable.h>
+#include <insight/structured.h>
+#include <insight/structuredmember.h>
+#include <insight/array.h>
 #include <insight/console.h>
+#include <insight/multithreading.h>
+#include <insight/constdefs.h>
+#include <insight/pagedigest.h>
 
 #include <insight/memorymap.h>
 #include <insight/memorymapheuristics.h>
@@ -11,8 +17,10 @@
 #include <QProcess>
 
 #include <QHash>
+#include <QSet>
 #include <QDir>
 #include <QDirIterator>
+#include <QTime>
 
 #include <errno.h>
 
@@ -30,12 +38,17 @@
 #define KERNEL_IMAGE "/local-home/kittel/projekte/insight/images/symbols/ubuntu-13.04-64-server/linux-3.8.0/vmlinux"
 #define MEM_SAVE_DIR "/local-home/kittel/projekte/insight/memdump/"
 
-QMultiHash<quint64, Detect::ExecutablePage> *Detect::ExecutablePages = 0;
+/// Identifies a file of the reference hash cache ("IRHC")
+static const quint32 refHashCacheMagic = 0x49524843;
+/// Version of the reference hash cache file format
+static const qint16 refHashCacheVersion = 2;
+
+QHash<const MemoryDump*, Detect::MonitorState> *Detect::MonitorStates = 0;
 
 Detect::Detect(KernelSymbols &sym) :
     _kernel_code_begin(0), _kernel_code_end(0), _kernel_data_exec_end(0),
-    _vsyscall_page(0), Functions(0),
-    _sym(sym), _current_index(0)
+    _vsyscall_page(0), _functionsBuilt(false),
+    _sym(sym), _current_index(0), _previousRun(0), _modulesUnchanged(false)
 {
     // Get data from System.map
     _kernel_code_begin = _sym.memSpecs().systemMap.value("_text").address;
@@ -55,7 +68,6 @@ Detect::Detect(KernelSymbols &sym) :
 }
 
 Detect::~Detect(){
-    delete Functions;
 }
 
 QString Detect::FunctionInfo::no_function = QString("");
@@ -188,11 +200,19 @@ QHash<quint64, qint32> PageVerifier::_jumpEntries;
 QList<quint64> PageVerifier::_paravirtJump;
 QList<quint64> PageVerifier::_paravirtCall;
 
-PageVerifier::PageVerifier(const KernelSymbols &sym) :
-    _sym(sym), _current_index(0)
+QHash<QString, QString> PageVerifier::_moduleFiles;
+QHash<QString, PageVerifier::ModuleFileDigest> PageVerifier::_moduleFileDigests;
+
+PageVerifier::PageVerifier(const KernelSymbols &sym, int index,
+                           const ModuleIndex *modules) :
+    _sym(sym), _modules(modules),
+    _refCacheDir(QDir::home().absoluteFilePath(mt_refhash_cache_dir)),
+    _current_index(index)
     //_symTable(), _funcTable(),
     //_jumpEntries(), _paravirtJump(), _paravirtCall()
 {
+    _refCacheEnabled = _refCacheDir.exists() ||
+            QDir::home().mkpath(mt_refhash_cache_dir);
     if(PageVerifier::ParsedExecutables == NULL){
         PageVerifier::ParsedExecutables = new QMultiHash<QString, elfParseData>();
     }
@@ -211,13 +231,20 @@ PageVerifier::elfParseData::~elfParseData(){
 }
 
 /**
- * Find the file containing the module in elf format
+ * Find the file containing the module in elf format. Found files are
+ * remembered for the rest of the session.
  */
 
 QString PageVerifier::findModuleFile(QString moduleName)
 {
     moduleName = moduleName.trimmed();
 
+    QHash<QString, QString>::const_iterator cached =
+            _moduleFiles.constFind(moduleName);
+    if (cached != _moduleFiles.constEnd() && QFile::exists(cached.value()))
+        return cached.value();
+    const QString key = moduleName;
+
 //    //Some Filenames are not exactly the modulename. This is currently cheating but ok :-)
 //    if (moduleName == "kvm_intel") moduleName = QString("kvm-intel");
 //    else if (moduleName == "i2c_piix4") moduleName = QString("i2c-piix4");
@@ -242,6 +269,7 @@ QString PageVerifier::findModuleFile(QString moduleName)
                      QFileInfo(dirIt.filePath()).baseName() == moduleName.replace(QString("-"), QString("_"))))
             {
                 //Console::out() << moduleName << ": " << QFileInfo(dirIt.filePath()).baseName() << "\n" << endl;
+                _moduleFiles.insert(key, dirIt.filePath());
                 return dirIt.filePath();
             }
         }
@@ -251,6 +279,228 @@ QString PageVerifier::findModuleFile(QString moduleName)
     return QString("");
 }
 
+QByteArray PageVerifier::jumpLabelState(const Instance &module)
+{
+    // One character per jump entry of the module, as applyJumpEntries() sees
+    // them
+    QByteArray state;
+    const BaseType *keyType = _sym.factory().findBaseTypeByName("static_key");
+    quint32 count = module.member("num_jump_entries").toUInt32();
+    Instance entries = module.member("jump_entries");
+
+    for (quint32 i = 0; i < count; ++i) {
+        Instance key((size_t) entries.arrayElem(i).member("key").toUInt64(),
+                     keyType, _vmem);
+        state.append(key.member("enabled").toUInt32() ? '1' : '0');
+    }
+
+    return state;
+}
+
+/**
+  * Returns the state of the running kernel that applyAltinstr() and
+  * applyParainstr() depend on: the CPU capabilities and the paravirt
+  * operations. It is read once per verifier.
+  */
+const QByteArray& PageVerifier::patchState()
+{
+    if (!_patchState.isEmpty())
+        return _patchState;
+
+    QStringList vars;
+    vars << "boot_cpu_data" << "pv_init_ops" << "pv_time_ops" << "pv_cpu_ops"
+         << "pv_irq_ops" << "pv_apic_ops" << "pv_mmu_ops" << "pv_lock_ops";
+
+    for (int i = 0; i < vars.size(); ++i) {
+        const Variable *v = _sym.factory().findVarByName(vars[i]);
+        if (!v)
+            continue;
+        Instance inst = v->toInstance(_vmem, BaseType::trLexical, ksAll);
+        if (i == 0)
+            inst = inst.member("x86_capability");
+        if (!inst.isValid())
+            continue;
+
+        QByteArray buf(inst.size(), 0);
+        if (_vmem->readAtomic(inst.address(), buf.data(), buf.size()) != buf.size())
+            buf.fill(0);
+        _patchState.append(vars[i].toAscii()).append(buf);
+    }
+
+    // Distinguish "not read yet" from "nothing found"
+    if (_patchState.isEmpty())
+        _patchState = "none";
+
+    return _patchState;
+}
+
+/**
+  * Returns the SHA-1 digest of the content of \a fileName. The file is only
+  * read again if its size or modification time changed since the last call.
+  */
+QByteArray PageVerifier::moduleFileDigest(const QString &fileName)
+{
+    QFileInfo info(fileName);
+    if (!info.isFile())
+        return QByteArray();
+
+    ModuleFileDigest &d = _moduleFileDigests[info.absoluteFilePath()];
+    if (d.size == info.size() && d.modified == info.lastModified())
+        return d.digest;
+
+    QFile f(fileName);
+    if (!f.open(QIODevice::ReadOnly)) {
+        _moduleFileDigests.remove(info.absoluteFilePath());
+        return QByteArray();
+    }
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(f.readAll());
+    d.size = info.size();
+    d.modified = info.lastModified();
+    d.digest = hash.result();
+
+    return d.digest;
+}
+
+/**
+  * The reference hashes of a module depend on the content of its ELF file,
+  * the address it was loaded to, the state of its jump labels, the CPU
+  * capabilities and paravirt operations used for patching, and the digest
+  * algorithm.
+  */
+QString PageVerifier::refCacheFileName(QString fileName, const Instance &module,
+                                       const QByteArray &jumpState)
+{
+    if (!_refCacheEnabled)
+        return QString();
+
+    const QByteArray fileDigest = moduleFileDigest(fileName);
+    if (fileDigest.isEmpty())
+        return QString();
+
+    QByteArray buf;
+    QDataStream out(&buf, QIODevice::WriteOnly);
+    out << (quint64)module.member("module_core").toPointer()
+        << (quint64)module.member("module_init").toPointer()
+        << jumpState << patchState() << (qint32)PageDigest::defaultAlgorithm();
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(fileDigest);
+    hash.addData(buf);
+
+    return _refCacheDir.absoluteFilePath(hash.result().toHex());
+}
+
+bool PageVerifier::loadCachedModule(const QString &cacheFile, elfParseData &context)
+{
+    QFile f(cacheFile);
+    if (!f.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream in(&f);
+    quint32 magic;
+    qint16 version;
+    QList<QByteArray> hashes;
+
+    in >> magic >> version;
+    if (in.status() != QDataStream::Ok || magic != refHashCacheMagic ||
+        version != refHashCacheVersion)
+        return false;
+
+    in >> hashes >> context.exportedSymbols >> context.exportedFunctions
+       >> context.paravirtJumps >> context.paravirtCalls;
+    if (in.status() != QDataStream::Ok)
+        return false;
+
+    context.textSegmentData.clear();
+    for (int i = 0; i < hashes.size(); ++i) {
+        PageData page;
+        page.hash = hashes[i];
+        context.textSegmentData.append(page);
+    }
+
+    // Replay what parsing the module would have added to the global tables
+    QHash<QString, quint64>::const_iterator it;
+    for (it = context.exportedSymbols.constBegin();
+         it != context.exportedSymbols.constEnd(); ++it)
+        if (!_symTable.contains(it.key()))
+            _symTable.insert(it.key(), it.value());
+    for (it = context.exportedFunctions.constBegin();
+         it != context.exportedFunctions.constEnd(); ++it)
+        if (!_funcTable.contains(it.key()))
+            _funcTable.insert(it.key(), it.value());
+    for (int i = 0; i < context.paravirtJumps.size(); ++i)
+        if (!_paravirtJump.contains(context.paravirtJumps[i]))
+            _paravirtJump.append(context.paravirtJumps[i]);
+    for (int i = 0; i < context.paravirtCalls.size(); ++i)
+        if (!_paravirtCall.contains(context.paravirtCalls[i]))
+            _paravirtCall.append(context.paravirtCalls[i]);
+
+    context.type = Detect::MODULE;
+    context.fromCache = true;
+    return true;
+}
+
+void PageVerifier::storeCachedModule(const QString &cacheFile, const elfParseData &context)
+{
+    // Write to a temporary file first so that no other process ever sees a
+    // partially written cache file
+    QString tmpFile = cacheFile + ".tmp";
+    QFile f(tmpFile);
+    if (!f.open(QIODevice::WriteOnly|QIODevice::Truncate))
+        return;
+
+    QList<QByteArray> hashes;
+    for (int i = 0; i < context.textSegmentData.size(); ++i)
+        hashes.append(context.textSegmentData[i].hash);
+
+    QDataStream out(&f);
+    out << refHashCacheMagic << refHashCacheVersion << hashes
+        << context.exportedSymbols << context.exportedFunctions
+        << context.paravirtJumps << context.paravirtCalls;
+    f.close();
+
+    if (out.status() != QDataStream::Ok || f.error() != QFile::NoError ||
+        (QFile::exists(cacheFile) && !QFile::remove(cacheFile)) ||
+        !QFile::rename(tmpFile, cacheFile))
+        QFile::remove(tmpFile);
+}
+
+/**
+  * Replaces a module that was loaded from the reference hash cache by the
+  * fully parsed ELF file, e.g., to compare the content of a changed page.
+  */
+bool PageVerifier::parseCachedModule(QString moduleName, elfParseData &context)
+{
+    QString fileName = findModuleFile(moduleName);
+    if (fileName.isEmpty())
+        return false;
+
+    // The cached context already contributed its paravirt targets
+    const QByteArray jumpState = context.jumpState;
+    const QList<quint64> paravirtJumps = context.paravirtJumps;
+    const QList<quint64> paravirtCalls = context.paravirtCalls;
+
+    moduleName = moduleName.replace(QString("-"), QString("_"));
+    context = parseKernelModule(fileName, context.currentModule);
+    context.jumpState = jumpState;
+    context.paravirtJumps = paravirtJumps;
+    context.paravirtCalls = paravirtCalls;
+    ParsedExecutables->remove(moduleName);
+    ParsedExecutables->insert(moduleName, context);
+
+    if (!context.fileContent)
+        return false;
+
+    // Replace the cache entry that did not match with the fresh hashes
+    QString cacheFile = refCacheFileName(fileName, context.currentModule, jumpState);
+    if (!cacheFile.isEmpty())
+        storeCachedModule(cacheFile, context);
+
+    return true;
+}
+
 /**
   * Read a File to Memory
   * Important: The buffer must be freed after it was used!
@@ -325,21 +575,25 @@ void PageVerifier::writeModuleToFile(QString origFileName, Instance currentModul
 
 quint64 PageVerifier::findMemAddressOfSegment(elfParseData &context, QString sectionName)
 {
-    //Find the address of the current section in the memory image
-    //Get Number of sections in kernel image
-    Instance attrs = context.currentModule.member("sect_attrs", BaseType::trAny);
-    uint attr_cnt = attrs.member("nsections").toUInt32();
-
-    //Now compare all section names until we find the correct section.
-    for (uint j = 0; j < attr_cnt; ++j) {
-        Instance attr = attrs.member("attrs").arrayElem(j);
-        if(attr.member("name").toString().remove(QChar('"'), Qt::CaseInsensitive).
-                compare(sectionName) == 0)
-        {
-            return attr.member("address").toULong();
+    //Read the section addresses of the module in memory once, the relocation
+    //code asks for them for every relocation entry.
+    if (context.memSectionIndex.isEmpty()) {
+        Instance attrs = context.currentModule.member("sect_attrs", BaseType::trAny);
+        uint attr_cnt = attrs.member("nsections").toUInt32();
+
+        for (uint j = 0; j < attr_cnt; ++j) {
+            Instance attr = attrs.member("attrs").arrayElem(j);
+            QString name = attr.member("name").toString().remove(QChar('"'), Qt::CaseInsensitive);
+            if (!context.memSectionIndex.contains(name))
+                context.memSectionIndex.insert(name, attr.member("address").toULong());
         }
     }
 
+    QHash<QString, quint64>::const_iterator it =
+            context.memSectionIndex.constFind(sectionName);
+    if (it != context.memSectionIndex.constEnd())
+        return it.value();
+
     //If the searching for the .bss section
     //This section is right after the modules struct
     if (sectionName.compare(QString(".bss")) == 0)
@@ -349,29 +603,56 @@ quint64 PageVerifier::findMemAddressOfSegment(elfParseData &context, QString sec
     return 0;
 }
 
-PageVerifier::SegmentInfo PageVerifier::findElfSegmentWithName(char * elfEhdr, QString sectionName)
+PageVerifier::SegmentInfo PageVerifier::findElfSegmentWithName(elfParseData &context, QString sectionName)
 {
-    char * tempBuf = 0;
+    if (context.sectionIndex.isEmpty())
+        indexElfSections(context);
 
-    if(elfEhdr[4] == ELFCLASS32)
+    return context.sectionIndex.value(sectionName);
+}
+
+void PageVerifier::indexElfSections(elfParseData &context)
+{
+    char * elfEhdr = context.fileContent;
+    context.sectionIndex.clear();
+
+    if(!elfEhdr || elfEhdr[4] != ELFCLASS64)
+        return;
+
+    Elf64_Ehdr * elf64Ehdr = (Elf64_Ehdr *) elfEhdr;
+    Elf64_Shdr * elf64Shdr = (Elf64_Shdr *) (elfEhdr + elf64Ehdr->e_shoff);
+    context.sectionIndex.reserve(elf64Ehdr->e_shnum);
+
+    for(unsigned int i = 0; i < elf64Ehdr->e_shnum; i++)
     {
-        //TODO
+        QString name(elfEhdr + elf64Shdr[elf64Ehdr->e_shstrndx].sh_offset + elf64Shdr[i].sh_name);
+        if (!context.sectionIndex.contains(name))
+            context.sectionIndex.insert(name, SegmentInfo(elfEhdr + elf64Shdr[i].sh_offset, elf64Shdr[i].sh_addr, elf64Shdr[i].sh_size));
     }
-    else if(elfEhdr[4] == ELFCLASS64)
-    {
-        Elf64_Ehdr * elf64Ehdr = (Elf64_Ehdr *) elfEhdr;
-        Elf64_Shdr * elf64Shdr = (Elf64_Shdr *) (elfEhdr + elf64Ehdr->e_shoff);
-        for(unsigned int i = 0; i < elf64Ehdr->e_shnum; i++)
-        {
-            tempBuf =  elfEhdr + elf64Shdr[elf64Ehdr->e_shstrndx].sh_offset + elf64Shdr[i].sh_name;
+}
 
-            if (sectionName.compare(tempBuf) == 0){
-                return SegmentInfo(elfEhdr + elf64Shdr[i].sh_offset, elf64Shdr[i].sh_addr, elf64Shdr[i].sh_size);
-                //printf("Found Strtab in Section %i: %s\n", i, tempBuf);
-            }
-        }
+void PageVerifier::indexElfSymbols(elfParseData &context)
+{
+    char * elfEhdr = context.fileContent;
+    context.symbolIndex.clear();
+
+    if(!elfEhdr || elfEhdr[4] != ELFCLASS64)
+        return;
+
+    Elf64_Ehdr * elf64Ehdr = (Elf64_Ehdr *) elfEhdr;
+    Elf64_Shdr * elf64Shdr = (Elf64_Shdr *) (elfEhdr + elf64Ehdr->e_shoff);
+
+    quint32 count = elf64Shdr[context.symindex].sh_size / sizeof(Elf64_Sym);
+    Elf64_Sym *symBase = (Elf64_Sym *) (elfEhdr + elf64Shdr[context.symindex].sh_offset);
+    const char *strtab = elfEhdr + elf64Shdr[context.strindex].sh_offset;
+    context.symbolIndex.reserve(count);
+
+    for(quint32 i = 0; i < count; i++)
+    {
+        QString name(&strtab[symBase[i].st_name]);
+        if (!context.symbolIndex.contains(name))
+            context.symbolIndex.insert(name, i);
     }
-    return SegmentInfo();
 }
 
 quint64 PageVerifier::findElfAddressOfVariable(char * elfEhdr, PageVerifier::elfParseData &context, QString symbolName)
@@ -382,20 +663,20 @@ quint64 PageVerifier::findElfAddressOfVariable(char * elfEhdr, PageVerifier::elf
     }
     else if(elfEhdr[4] == ELFCLASS64)
     {
+        if (context.symbolIndex.isEmpty())
+            indexElfSymbols(context);
+
+        QHash<QString, quint32>::const_iterator it =
+                context.symbolIndex.constFind(symbolName);
+        if (it == context.symbolIndex.constEnd())
+            return 0;
+
         Elf64_Ehdr * elf64Ehdr = (Elf64_Ehdr *) elfEhdr;
         Elf64_Shdr * elf64Shdr = (Elf64_Shdr *) (elfEhdr + elf64Ehdr->e_shoff);
-
-        quint32 symSize = elf64Shdr[context.symindex].sh_size;
         Elf64_Sym *symBase = (Elf64_Sym *) (elfEhdr + elf64Shdr[context.symindex].sh_offset);
 
-        for(Elf64_Sym * sym = symBase; sym < (Elf64_Sym *) (((char*) symBase) + symSize) ; sym++)
-        {
-            QString currentSymbolName = QString(&((elfEhdr + elf64Shdr[context.strindex].sh_offset)[sym->st_name]));
-            if(symbolName.compare(currentSymbolName) == 0)
-            {
-                return sym->st_value;
-            }
-        }
+        // Read the value now, relocation may have changed it
+        return symBase[it.value()].st_value;
     }
     return 0;
 }
@@ -525,19 +806,19 @@ quint8 PageVerifier::paravirt_patch_default(quint32 type, quint16 clobbers, void
 
     BaseType* btFunc = 0;
     const Function* func = 0;
-    btFunc = _sym.factory().typesByName().value("_paravirt_nop");
+    btFunc = _sym.factory().findBaseTypeByName("_paravirt_nop");
     if( btFunc && btFunc->type() == rtFunction && btFunc->size() > 0)
     {
         func = dynamic_cast<const Function*>(btFunc);
         nopFuncAddress = func->pcLow();
     }
-    btFunc = _sym.factory().typesByName().value("_paravirt_ident_32");
+    btFunc = _sym.factory().findBaseTypeByName("_paravirt_ident_32");
     if( btFunc && btFunc->type() == rtFunction && btFunc->size() > 0)
     {
         func = dynamic_cast<const Function*>(btFunc);
         ident32NopFuncAddress = func->pcLow();
     }
-    btFunc = _sym.factory().typesByName().value("_paravirt_ident_64");
+    btFunc = _sym.factory().findBaseTypeByName("_paravirt_ident_64");
     if( btFunc && btFunc->type() == rtFunction && btFunc->size() > 0)
     {
         func = dynamic_cast<const Function*>(btFunc);
@@ -793,7 +1074,7 @@ int PageVerifier::apply_relocate_add(Elf64_Shdr *sechdrs, elfParseData &context)
                 if (!v)
                 {
                     //debugerr("Variable " << &((fileContent + sechdrs[strindex].sh_offset)[sym->st_name]) << " not found! ERROR!");
-                    QList<BaseType*> types = _sym.factory().typesByName().values(symbolName);
+                    QList<BaseType*> types = _sym.factory().typesByName().values(StringAtoms::find(symbolName));
 
                     if(types.size() > 0)
                     {
@@ -861,7 +1142,7 @@ int PageVerifier::apply_relocate_add(Elf64_Shdr *sechdrs, elfParseData &context)
             else
             {
                 QString relocSection = QString(&((fileContent + sechdrs[context.shstrindex].sh_offset)[sechdrs[sym->st_shndx].sh_name]));
-                locOfRelSectionInElf = (void *) findElfSegmentWithName(fileContent, relocSection).index;
+                locOfRelSectionInElf = (void *) findElfSegmentWithName(context, relocSection).index;
                 locOfRelSectionInMem = (void *) findMemAddressOfSegment(context, relocSection);
                 if(doPrint) Console::out() << "SectionName: " << hex << relocSection << dec << endl;
             }
@@ -953,14 +1234,29 @@ void PageVerifier::applyAltinstr(SegmentInfo info, elfParseData &context)
     quint8 * replacement;
     char insnbuf[255-1];
 
+    Instance boot_cpu_data = _sym.factory().findVarByName("boot_cpu_data")->toInstance(_vmem, BaseType::trLexical, ksAll);
+    Instance x86_capability = boot_cpu_data.member("x86_capability");
+
+    //Each capability word is read from memory only once
+    QHash<quint16, quint32> capabilities;
+
+    //The replacement section and its location in memory are the same for
+    //all entries, look them up on first use
+    SegmentInfo altinstr;
+    quint64 altinstrSegmentInMem = 0;
+    quint64 textSegmentInMem = 0;
+    bool altinstrResolved = false;
+
     for(struct alt_instr * a = start ; a < end ; a++)
     {
         //if (!boot_cpu_has(a->cpuid)) continue;
 
-        Instance boot_cpu_data = _sym.factory().findVarByName("boot_cpu_data")->toInstance(_vmem, BaseType::trLexical, ksAll);
-        Instance x86_capability = boot_cpu_data.member("x86_capability");
+        const quint16 word = a->cpuid / 32;
+        QHash<quint16, quint32>::const_iterator cap = capabilities.constFind(word);
+        if (cap == capabilities.constEnd())
+            cap = capabilities.insert(word, x86_capability.arrayElem(word).toUInt32());
 
-        if (!((x86_capability.arrayElem(a->cpuid / 32).toUInt32() >> (a->cpuid % 32)) & 0x1))
+        if (!((cap.value() >> (a->cpuid % 32)) & 0x1))
         {
             continue;
         }
@@ -980,7 +1276,7 @@ void PageVerifier::applyAltinstr(SegmentInfo info, elfParseData &context)
         if(doPrint) Console::out() << "Applying alternative at offset: " << hex << (void*) (instr - (quint8*) context.textSegment.index) << dec << endl;
 
         if(doPrint) Console::out() << hex << "instr: @" << (void*) instr << " len: " << a->instrlen << " offset: " << (void*) (instr - (quint64) context.textSegment.index) <<
-                                      " replacement: @" << (void*) replacement << " len: " << a->replacementlen << " offset: " <<  (void*) (replacement - (quint64) findElfSegmentWithName(fileContent, ".altinstr_replacement").index) << dec << endl;
+                                      " replacement: @" << (void*) replacement << " len: " << a->replacementlen << " offset: " <<  (void*) (replacement - (quint64) findElfSegmentWithName(context, ".altinstr_replacement").index) << dec << endl;
 
         if(doPrint) Console::out() << "CPU ID is: " << hex << a->cpuid << dec << endl;
 
@@ -1001,24 +1297,26 @@ void PageVerifier::applyAltinstr(SegmentInfo info, elfParseData &context)
         // 0xe8 is a relative jump; fix the offset.
         if (insnbuf[0] == (char) 0xe8 && a->replacementlen == 5)
         {
-            SegmentInfo altinstr = findElfSegmentWithName(fileContent, ".altinstr_replacement");
-
-            //If replacement is in the altinstr_replace section fix the offset.
-            if(replacement >= (quint8 *)altinstr.index && replacement < (quint8 *)altinstr.index + altinstr.size)
+            if (!altinstrResolved)
             {
-                quint64 altinstrSegmentInMem = 0;
-                quint64 textSegmentInMem = 0;
+                altinstr = findElfSegmentWithName(context, ".altinstr_replacement");
 
                 if(context.type == Detect::KERNEL_CODE)
                 {
-                    altinstrSegmentInMem = findElfSegmentWithName(fileContent, ".altinstr_replacement").address;
-                    textSegmentInMem = findElfSegmentWithName(fileContent, ".text").address;
+                    altinstrSegmentInMem = altinstr.address;
+                    textSegmentInMem = findElfSegmentWithName(context, ".text").address;
                 }
                 else if(context.type == Detect::MODULE)
                 {
                     altinstrSegmentInMem = findMemAddressOfSegment(context, ".altinstr_replacement");
                     textSegmentInMem = findMemAddressOfSegment(context, ".text");
                 }
+                altinstrResolved = true;
+            }
+
+            //If replacement is in the altinstr_replace section fix the offset.
+            if(replacement >= (quint8 *)altinstr.index && replacement < (quint8 *)altinstr.index + altinstr.size)
+            {
 
                 if(doPrint) Console::out() << hex << "Altinstr in Mem: " << altinstrSegmentInMem << " Text in Mem: " << textSegmentInMem << dec << endl;
 
@@ -1128,8 +1426,8 @@ void PageVerifier::applySmpLocks(SegmentInfo info, elfParseData &context)
 
     if(context.type == Detect::KERNEL_CODE)
     {
-        smpLockSegmentInMem = findElfSegmentWithName(fileContent, ".smp_locks").address;
-        textSegmentInMem = findElfSegmentWithName(fileContent, ".text").address;
+        smpLockSegmentInMem = findElfSegmentWithName(context, ".smp_locks").address;
+        textSegmentInMem = findElfSegmentWithName(context, ".text").address;
     }
     else if(context.type == Detect::MODULE)
     {
@@ -1205,64 +1503,162 @@ void PageVerifier::applyJumpEntries(QByteArray &textSegmentContent, PageVerifier
     struct jump_entry * startEntry = (struct jump_entry *) context.jumpTable.constData();
     struct jump_entry * endEntry = (struct jump_entry *) (context.jumpTable.constData() + context.jumpTable.size());
 
+    //Index the entries of the ELF file by their code address. Several entries
+    //may patch the same code, so keep them in table order.
+    QHash<quint64, QList<struct jump_entry *> > elfEntries;
+    elfEntries.reserve(endEntry - startEntry);
+    for (struct jump_entry * entry = startEntry ; entry < endEntry; entry++)
+        elfEntries[entry->code].append(entry);
+
+    //Reading the entries and their keys from memory is the expensive part,
+    //so it is split across threads. The patches are applied afterwards in
+    //table order, so the result does not depend on the number of threads.
+    QVector<JumpEntryState> states(numberOfJumpEntries);
+    const int threadCount = qMin(MultiThreading::maxThreads(),
+                                 (int)(numberOfJumpEntries / 1024));
+
+    if (threadCount > 1) {
+        bool wasThreadSafe = _vmem->setThreadSafety(true);
+        QList<JumpEntryThread*> threads;
+        const quint32 chunk = (numberOfJumpEntries + threadCount - 1) / threadCount;
+        for (quint32 first = 0; first < numberOfJumpEntries; first += chunk) {
+            threads.append(new JumpEntryThread(this, &context, jumpStart, first,
+                                               qMin(first + chunk, numberOfJumpEntries),
+                                               &states));
+            threads.last()->start();
+        }
+
+        // Pass the first read error on to the caller, as the serial
+        // version would do
+        bool failed = false;
+        GenericException error;
+        for (int i = 0; i < threads.size(); ++i) {
+            threads[i]->wait();
+            if (threads[i]->failed() && !failed) {
+                failed = true;
+                error = threads[i]->error();
+            }
+        }
+
+        qDeleteAll(threads);
+        _vmem->setThreadSafety(wasThreadSafe);
+
+        if (failed)
+            throw error;
+    }
+    else
+        readJumpEntries(context, jumpStart, 0, numberOfJumpEntries, states);
+
     for(quint32 i = 0 ; i < numberOfJumpEntries ; i++)
     {
         doPrint = false;
         //if(context.currentModule.member("name").toString().compare("\"kvm\"") == 0) doPrint = true;
 
-        Instance jumpEntry;
-        if(context.type == Detect::KERNEL_CODE)
+        const quint64 code = states[i].code;
+        const quint32 enabled = states[i].enabled;
+
+        //Do not apply jump entries to .init.text
+        if(context.type == Detect::KERNEL_CODE &&
+           code > textSegmentInMem + context.textSegment.size)
         {
-            jumpEntry = Instance((size_t) jumpStart + i * sizeof(struct jump_entry),_sym.factory().findBaseTypeByName("jump_entry"), _vmem);
+            continue;
+        }
+
+        if(doPrint) Console::out() << hex << "Code: " << code << " offset: " << code - textSegmentInMem << dec << endl;
+        if(doPrint) Console::out() << hex << "Key @ " << states[i].key << " is: " << enabled << dec << endl;
+
+        //Find the elf entries of the current kernel entry
+        const QList<struct jump_entry *> matches = elfEntries.value(code);
+        for (int j = 0; j < matches.size(); j++){
+            struct jump_entry * entry = matches.at(j);
 
-            //Do not apply jump entries to .init.text
-            if (jumpEntry.member("code").toUInt64() > textSegmentInMem + context.textSegment.size)
+            quint64 patchOffset = entry->code - textSegmentInMem;
+
+            char * patchAddress = (char *) (patchOffset + (quint64) textSegmentContent.data());
+
+            if(doPrint) Console::out() << "Jump Entry @ " << hex << patchOffset << dec;
+            if(doPrint) Console::out() << " " << ((enabled) ? "enabled" : "disabled") << endl;
+
+            qint32 destination = entry->target - (entry->code + 5);
+            if(addJumpEntries)_jumpEntries.insert(patchOffset, destination);
+
+
+            if(enabled)
             {
-                continue;
+                if(doPrint) Console::out() << hex << "Patching jump @ : " << patchOffset << dec << endl;
+                *patchAddress = (char) 0xe9;
+                *((qint32*) (patchAddress + 1)) = destination;
+            }
+            else
+            {
+                add_nops(patchAddress, 5);      //add_nops
             }
         }
-        else if(context.type == Detect::MODULE)
-        {
-            jumpEntry = context.currentModule.member("jump_entries").arrayElem(i);
-        }
+    }
+}
 
-        quint64 keyAddress = jumpEntry.member("key").toUInt64();
+void PageVerifier::readJumpEntries(elfParseData &context, quint64 jumpStart,
+                                   quint32 first, quint32 last,
+                                   QVector<JumpEntryState> &states)
+{
+    const BaseType * jumpEntryType = _sym.factory().findBaseTypeByName("jump_entry");
+    const BaseType * staticKeyType = _sym.factory().findBaseTypeByName("static_key");
 
-        if(doPrint) Console::out() << hex << "Code: " << jumpEntry.member("code").toUInt64() << " target: " << jumpEntry.member("target").toUInt64() << dec << endl;
-        if(doPrint) Console::out() << hex << "Code offset : " << jumpEntry.member("code").toUInt64() - textSegmentInMem << " target offset : " << jumpEntry.member("target").toUInt64() - textSegmentInMem << dec << endl;
+    const quint64 textSegmentEnd = context.textSegment.address + context.textSegment.size;
 
-        Instance key = Instance((size_t) keyAddress,_sym.factory().findBaseTypeByName("static_key"), _vmem);
-        quint32 enabled = key.member("enabled").toUInt32();
+    Instance moduleJumpEntries;
+    if(context.type == Detect::MODULE)
+        moduleJumpEntries = context.currentModule.member("jump_entries");
 
-        if(doPrint) Console::out() << hex << "Key @ " << keyAddress << " is: " << enabled << dec << endl;
+    for(quint32 i = first ; i < last ; i++)
+    {
+        Instance jumpEntry;
+        if(context.type == Detect::KERNEL_CODE)
+        {
+            jumpEntry = Instance((size_t) jumpStart + i * sizeof(struct jump_entry), jumpEntryType, _vmem);
+        }
+        else if(context.type == Detect::MODULE)
+        {
+            jumpEntry = moduleJumpEntries.arrayElem(i);
+        }
 
-        for (struct jump_entry * entry = startEntry ; entry < endEntry; entry++){
-            //Check if current elf entry is current kernel entry
-            if (jumpEntry.member("code").toUInt64() ==  entry->code)
-            {
-                quint64 patchOffset = entry->code - textSegmentInMem;
+        JumpEntryState &state = states[i];
+        state.code = jumpEntry.member("code").toUInt64();
 
-                char * patchAddress = (char *) (patchOffset + (quint64) textSegmentContent.data());
+        //Entries of .init.text are not applied, so skip their keys
+        if(context.type == Detect::KERNEL_CODE && state.code > textSegmentEnd)
+            continue;
 
-                if(doPrint) Console::out() << "Jump Entry @ " << hex << patchOffset << dec;
-                if(doPrint) Console::out() << " " << ((enabled) ? "enabled" : "disabled") << endl;
+        state.key = jumpEntry.member("key").toUInt64();
 
-                qint32 destination = entry->target - (entry->code + 5);
-                if(addJumpEntries)_jumpEntries.insert(patchOffset, destination);
+        Instance key = Instance((size_t) state.key, staticKeyType, _vmem);
+        state.enabled = key.member("enabled").toUInt32();
+    }
+}
 
+PageVerifier::JumpEntryThread::JumpEntryThread(PageVerifier *verifier,
+                                               elfParseData *context,
+                                               quint64 jumpStart,
+                                               quint32 first, quint32 last,
+                                               QVector<JumpEntryState> *states)
+    : _verifier(verifier), _context(context), _jumpStart(jumpStart),
+      _first(first), _last(last), _states(states), _failed(false)
+{
+}
 
-                if(enabled)
-                {
-                    if(doPrint) Console::out() << hex << "Patching jump @ : " << patchOffset << dec << endl;
-                    *patchAddress = (char) 0xe9;
-                    *((qint32*) (patchAddress + 1)) = destination;
-                }
-                else
-                {
-                    add_nops(patchAddress, 5);      //add_nops
-                }
-            }
-        }
+void PageVerifier::JumpEntryThread::run()
+{
+    // Exceptions must not escape the thread
+    try {
+        _verifier->readJumpEntries(*_context, _jumpStart, _first, _last,
+                                   *_states);
+    }
+    catch (GenericException& e) {
+        _error = GenericException(QString("%1: %2")
+                                    .arg(e.className()).arg(e.message));
+        _error.file = e.file;
+        _error.line = e.line;
+        _failed = true;
     }
 }
 
@@ -1443,13 +1839,13 @@ PageVerifier::elfParseData PageVerifier::parseKernelModule(QString fileName, Ins
 
     //module_finalize  => http://lxr.free-electrons.com/source/arch/x86/kernel/module.c#L167
 
-    SegmentInfo info = findElfSegmentWithName(fileContent, ".altinstructions");
+    SegmentInfo info = findElfSegmentWithName(context, ".altinstructions");
     if (info.index) applyAltinstr(info, context);
 
-    info = findElfSegmentWithName(fileContent, ".parainstructions");
+    info = findElfSegmentWithName(context, ".parainstructions");
     if (info.index) applyParainstr(info, context);
 
-    info = findElfSegmentWithName(fileContent, ".smp_locks");
+    info = findElfSegmentWithName(context, ".smp_locks");
     if (info.index) applySmpLocks(info, context);
 
     //Content of text section in memory:
@@ -1482,7 +1878,7 @@ PageVerifier::elfParseData PageVerifier::parseKernelModule(QString fileName, Ins
 
     //Save the jump_labels section for later reference.
 
-    info = findElfSegmentWithName(fileContent, "__jump_table");
+    info = findElfSegmentWithName(context, "__jump_table");
     if(info.index != 0) context.jumpTable.append(info.index, info.size);
 
     updateKernelModule(context);
@@ -1506,6 +1902,7 @@ PageVerifier::elfParseData PageVerifier::parseKernelModule(QString fileName, Ins
             {
                 QString symbolName = QString(&((fileContent + elf64Shdr[context.strindex].sh_offset)[sym->st_name]));
                 quint64 symbolAddress = sym->st_value;
+                context.exportedSymbols.insert(symbolName, symbolAddress);
                 if(!_symTable.contains(symbolName))
                 {
                     _symTable.insert(symbolName, symbolAddress);
@@ -1515,6 +1912,7 @@ PageVerifier::elfParseData PageVerifier::parseKernelModule(QString fileName, Ins
             {
                 QString symbolName = QString(&((fileContent + elf64Shdr[context.strindex].sh_offset)[sym->st_name]));
                 quint64 symbolAddress = sym->st_value;
+                context.exportedFunctions.insert(symbolName, symbolAddress);
                 if(!_funcTable.contains(symbolName))
                 {
                     _funcTable.insert(symbolName, symbolAddress);
@@ -1531,7 +1929,7 @@ void PageVerifier::updateKernelModule(elfParseData &context)
 {
     char * fileContent = context.fileContent;
 
-    SegmentInfo info = findElfSegmentWithName(fileContent, "__mcount_loc");
+    SegmentInfo info = findElfSegmentWithName(context, "__mcount_loc");
     applyMcount(info, context, context.textSegmentContent);
 
     applyJumpEntries(context.textSegmentContent, context);
@@ -1539,7 +1937,7 @@ void PageVerifier::updateKernelModule(elfParseData &context)
     //Console::out() << "The Module got " << textSegmentContent.size() / PAGE_SIZE << " pages." << endl;
 
     // Hash
-    QCryptographicHash hash(QCryptographicHash::Sha1);
+    PageDigest hash;
 
     context.textSegmentData.clear();
 
@@ -1573,7 +1971,27 @@ void PageVerifier::loadElfModule(QString moduleName, Instance currentModule){
             return;
         }
 
-        elfParseData context = parseKernelModule(fileName, currentModule);
+        // Try the reference hash cache first
+        QByteArray jumpState = jumpLabelState(currentModule);
+        QString cacheFile = refCacheFileName(fileName, currentModule, jumpState);
+        elfParseData context = elfParseData(currentModule);
+        if (!cacheFile.isEmpty() && loadCachedModule(cacheFile, context))
+        {
+            context.jumpState = jumpState;
+            ParsedExecutables->insert(moduleName.replace(QString("-"), QString("_")) , context);
+            return;
+        }
+
+        int paravirtJumps = _paravirtJump.size();
+        int paravirtCalls = _paravirtCall.size();
+
+        context = parseKernelModule(fileName, currentModule);
+        context.jumpState = jumpState;
+        context.paravirtJumps = _paravirtJump.mid(paravirtJumps);
+        context.paravirtCalls = _paravirtCall.mid(paravirtCalls);
+
+        if (!cacheFile.isEmpty() && context.fileContent)
+            storeCachedModule(cacheFile, context);
 
         ParsedExecutables->insert(moduleName.replace(QString("-"), QString("_")) , context);
 
@@ -1597,19 +2015,21 @@ void PageVerifier::loadElfModule(QString moduleName, Instance currentModule){
         }
     }
 
-    if (oldAddress != newAddress){
+    // Cached hashes are only valid for the jump label state they were
+    // computed for, parsed modules are updated by verifyHashes()
+    if (oldAddress != newAddress ||
+        (context.fromCache && context.jumpState != jumpLabelState(currentModule))){
         debugerr("Reloading module " << moduleName.replace(QString("-"), QString("_")));
         //TODO implement this correct!!!
         if(context.fileContent != NULL){
             munmap(context.fileContent, context.fileContentSize);
         }
-        fclose(context.fp);
+        if(context.fp != NULL){
+            fclose(context.fp);
+        }
 
         ParsedExecutables->remove(moduleName.replace(QString("-"), QString("_")));
-        QString fileName = findModuleFile(moduleName);
-        context = parseKernelModule(fileName, currentModule);
-
-        ParsedExecutables->insert(moduleName.replace(QString("-"), QString("_")) , context);
+        loadElfModule(moduleName, currentModule);
     }
 
 }
@@ -1629,11 +2049,11 @@ PageVerifier::elfParseData PageVerifier::parseKernel(QString fileName)
 
     context.type = Detect::KERNEL_CODE;
 
-    context.textSegment = findElfSegmentWithName(fileContent, ".text");
-    context.dataSegment = findElfSegmentWithName(fileContent, ".data");
-    context.vvarSegment = findElfSegmentWithName(fileContent, ".vvar");
-    context.dataNosaveSegment = findElfSegmentWithName(fileContent, ".data_nosave");
-    context.bssSegment = findElfSegmentWithName(fileContent, ".bss");
+    context.textSegment = findElfSegmentWithName(context, ".text");
+    context.dataSegment = findElfSegmentWithName(context, ".data");
+    context.vvarSegment = findElfSegmentWithName(context, ".vvar");
+    context.dataNosaveSegment = findElfSegmentWithName(context, ".data_nosave");
+    context.bssSegment = findElfSegmentWithName(context, ".bss");
 
     /* read the ELF header */
     Elf64_Ehdr * elf64Ehdr = (Elf64_Ehdr *) fileContent;
@@ -1655,64 +2075,50 @@ PageVerifier::elfParseData PageVerifier::parseKernel(QString fileName)
     }
 
     //Find "__fentry__" to nop calls out later
-    Elf64_Sym *symBase = (Elf64_Sym *) (fileContent + elf64Shdr[context.symindex].sh_offset);
-    Elf64_Sym *sym;
-    for (sym = symBase ; sym < (Elf64_Sym *) (fileContent +
-                                              elf64Shdr[context.symindex].sh_offset +
-                                              elf64Shdr[context.symindex].sh_size); sym++)
-    {
-         QString symbolName = QString(&((fileContent + elf64Shdr[context.strindex].sh_offset)[sym->st_name]));
-         if(symbolName.compare(QString("__fentry__")) == 0)
-         {
-             context.fentryAddress = sym->st_value;
-         }
-         if(symbolName.compare(QString("copy_user_generic_unrolled")) == 0)
-         {
-             context.genericUnrolledAddress = sym->st_value;
-         }
-    }
+    context.fentryAddress = findElfAddressOfVariable(fileContent, context, "__fentry__");
+    context.genericUnrolledAddress = findElfAddressOfVariable(fileContent, context, "copy_user_generic_unrolled");
 
 
 
-    SegmentInfo info = findElfSegmentWithName(fileContent, ".altinstructions");
+    SegmentInfo info = findElfSegmentWithName(context, ".altinstructions");
     if (info.index) applyAltinstr(info, context);
 
 
-    info = findElfSegmentWithName(fileContent, ".parainstructions");
+    info = findElfSegmentWithName(context, ".parainstructions");
     if (info.index) applyParainstr(info, context);
 
-    info = findElfSegmentWithName(fileContent, ".smp_locks");
+    info = findElfSegmentWithName(context, ".smp_locks");
     if (info.index) applySmpLocks(info, context);
 
     QByteArray textSegmentContent = QByteArray();
     textSegmentContent.append(context.textSegment.index, context.textSegment.size);
 
-    info = findElfSegmentWithName(fileContent, ".notes");
+    info = findElfSegmentWithName(context, ".notes");
     quint64 offset = (quint64) info.index - (quint64) context.textSegment.index;
     textSegmentContent = textSegmentContent.leftJustified(offset, 0);
     textSegmentContent.append(info.index, info.size);
 
-    info = findElfSegmentWithName(fileContent, "__ex_table");
+    info = findElfSegmentWithName(context, "__ex_table");
     offset = (quint64) info.index - (quint64) context.textSegment.index;
     textSegmentContent = textSegmentContent.leftJustified(offset, 0);
     textSegmentContent.append(info.index, info.size);
 
 
     //Apply Ftrace changes
-    info = findElfSegmentWithName(fileContent, ".init.text");
+    info = findElfSegmentWithName(context, ".init.text");
     qint64 initTextOffset = - (quint64)info.address + (quint64)info.index;
     info.index = (char *)findElfAddressOfVariable(fileContent, context, "__start_mcount_loc") + initTextOffset;
     info.size = (char *)findElfAddressOfVariable(fileContent, context, "__stop_mcount_loc") + initTextOffset - info.index ;
     applyMcount(info, context, textSegmentContent);
 
     //Apply Tracepoint changes
-//    SegmentInfo rodata = findElfSegmentWithName(fileContent, ".rodata");
+//    SegmentInfo rodata = findElfSegmentWithName(context, ".rodata");
 //    qint64 rodataOffset = - (quint64)rodata.address + (quint64)rodata.index;
 //    info.index = (char *)findElfAddressOfVariable(fileContent, context, "__start___tracepoints_ptrs") + rodataOffset;
 //    info.size = (char *)findElfAddressOfVariable(fileContent, context, "__stop___tracepoints_ptrs") + rodataOffset - info.index ;
 //    applyTracepoints(info, rodata, context, textSegmentContent);
 
-    info = findElfSegmentWithName(fileContent, ".data");
+    info = findElfSegmentWithName(context, ".data");
     qint64 dataOffset = - (quint64)info.address + (quint64)info.index;
     quint64 jumpStart = findElfAddressOfVariable(fileContent, context, "__start___jump_table");
     quint64 jumpStop = findElfAddressOfVariable(fileContent, context, "__stop___jump_table");
@@ -1726,7 +2132,7 @@ PageVerifier::elfParseData PageVerifier::parseKernel(QString fileName)
     applyJumpEntries(textSegmentContent, context, jumpStart, jumpStop);
 
     // Hash
-    QCryptographicHash hash(QCryptographicHash::Sha1);
+    PageDigest hash;
 
     for(int i = 0 ; i <= textSegmentContent.size() / KERNEL_CODEPAGE_SIZE; i++)
     {
@@ -1834,47 +2240,26 @@ void PageVerifier::loadElfKernel(){
 
 Instance PageVerifier::findModuleByName(QString moduleName){
 
-    const Variable *varModules = _sym.factory().findVarByName("modules");
-    const Structured *typeModule = dynamic_cast<const Structured *>
-            (_sym.factory().findBaseTypeByName("module"));
-    assert(varModules != 0);
-    assert(typeModule != 0);
-
-    // Don't depend on the rule engine
-    const int listOffset = typeModule->memberOffset("list");
-    Instance firstModule = varModules->toInstance(_vmem).member("next", BaseType::trAny, -1, ksNone);
-    firstModule.setType(typeModule);
-    firstModule.addToAddress(-listOffset);
-
-    // Does the page belong to a module?
-    // Don't depend on the rule engine
-    Instance currentModule = varModules->toInstance(_vmem).member("next", BaseType::trAny, -1, ksNone);
-    currentModule.setType(typeModule);
-    currentModule.addToAddress(-listOffset);
-
-    do
-    {
-        if(currentModule.member("name").toString().remove(QChar('"'), Qt::CaseInsensitive).compare(moduleName) == 0 ||
-                currentModule.member("name").toString().remove(QChar('"'), Qt::CaseInsensitive).compare(moduleName.replace(QString("_"), QString("-"))) == 0||
-                currentModule.member("name").toString().remove(QChar('"'), Qt::CaseInsensitive).compare(moduleName.replace(QString("-"), QString("_"))) == 0)
-        {
-            return currentModule;
-        }
-        currentModule = currentModule.member("list").member("next", BaseType::trAny, -1, ksNone);
-        currentModule.setType(typeModule);
-        currentModule.addToAddress(-listOffset);
-    } while (currentModule.address() != firstModule.address() &&
-             currentModule.address() != varModules->offset() - listOffset);
-    return Instance();
+    const ModuleIndex *modules = _modules;
+    if (!modules || modules->vmem() != _vmem) {
+        if (_ownModules.vmem() != _vmem)
+            _ownModules.build(_sym.factory(), _vmem);
+        modules = &_ownModules;
+    }
+
+    const ModuleInfo *mod = modules->moduleByName(moduleName);
+    return mod ? mod->module : Instance();
 }
 
-quint64 Detect::inVmap(quint64 address, VirtualMemory *vmem)
+void Detect::buildVmapIndex(VirtualMemory *vmem)
 {
+    _vmapAreas.clear();
+
     const Variable* var_vmap_area = _sym.factory().findVarByName("vmap_area_root");
     if (!var_vmap_area) {
         debugerr("Variable \"vmap_area_root\" does not exist, '"
                  << __PRETTY_FUNCTION__ << "'' will not work!");
-        return 0;
+        return;
     }
 
     // Don't depend on the script engine
@@ -1889,38 +2274,69 @@ quint64 Detect::inVmap(quint64 address, VirtualMemory *vmem)
     if (!vmap_area.isValid() || !rb_node.isValid()) {
         debugerr("It seems not all required symbols have been found, '"
                  << __PRETTY_FUNCTION__ << "'' will not work!");
-        return 0;
+        return;
     }
 
-    quint64 va_start = 0;
-    quint64 va_end = 0;
+    // Collect all areas of the tree once, so that the scanner threads only
+    // need a binary search per page instead of a walk of the tree
+    QList<quint64> nodes;
+    QSet<quint64> visited;
+    nodes.append(rb_node.address());
 
-    while (rb_node.address() != 0) {
-        va_start = (quint64)vmap_area.member("va_start").toPointer();
-        va_end = (quint64)vmap_area.member("va_end").toPointer();
-        
-        if (address >= va_start && address <= va_end) {
-            return vmap_area.member("flags").toULong();
-        }
-        else if (address > va_end) {
-            // Continue right
-            rb_node = rb_node.member("rb_right", BaseType::trAny, -1, ksNone);
-        }
-        else {
-            // Continue left
-            rb_node = rb_node.member("rb_left", BaseType::trAny, -1, ksNone);
-        }
+    while (!nodes.isEmpty()) {
+        quint64 node = nodes.takeLast();
+        // Don't loop forever on a corrupted tree
+        if (!node || visited.contains(node))
+            continue;
+        visited.insert(node);
+
+        vmap_area.setAddress(node - offset);
+        rb_node = vmap_area.member("rb_node", BaseType::trAny, -1, ksNone);
 
-        // Cast next area
-        if (rb_node.address() != 0)
-            vmap_area.setAddress(rb_node.address() - offset);
+        _vmapAreas.append(VmapArea(
+                (quint64)vmap_area.member("va_start").toPointer(),
+                (quint64)vmap_area.member("va_end").toPointer(),
+                vmap_area.member("flags").toULong()));
+
+        nodes.append(rb_node.member("rb_left", BaseType::trAny, -1, ksNone).address());
+        nodes.append(rb_node.member("rb_right", BaseType::trAny, -1, ksNone).address());
     }
 
-    return 0;
+    qSort(_vmapAreas);
 }
 
 
-quint64 PageVerifier::checkCodePage(QString moduleName, quint32 sectionNumber, Detect::ExecutablePage currentPage)
+quint64 Detect::inVmap(quint64 address) const
+{
+    // Find the last area that starts at or before address
+    QList<VmapArea>::const_iterator it =
+            qUpperBound(_vmapAreas.constBegin(), _vmapAreas.constEnd(),
+                        VmapArea(address));
+    if (it == _vmapAreas.constBegin())
+        return 0;
+    --it;
+
+    return (address <= it->end) ? it->flags : 0;
+}
+
+
+bool PageVerifier::loadPageData(Detect::ExecutablePage &page)
+{
+    if ((quint64)page.data.size() == page.size)
+        return true;
+
+    page.data.resize(page.size);
+    if (!_vmem->readPhysical(page.physAddress, page.data.data(), page.size)) {
+        Console::err() << "Could not read page @ 0x" << hex << page.address
+                       << dec << endl;
+        page.data.clear();
+        return false;
+    }
+    return true;
+}
+
+
+quint64 PageVerifier::checkCodePage(QString moduleName, quint32 sectionNumber, Detect::ExecutablePage &currentPage)
 {
 
     quint32 changeCount = 0;
@@ -1939,8 +2355,15 @@ quint64 PageVerifier::checkCodePage(QString moduleName, quint32 sectionNumber, D
         return 1;
     }
 
-    if(context.textSegmentData.at(sectionNumber).hash.toHex() != currentPage.hash.toHex())
+    if(context.textSegmentData.at(sectionNumber).hash != currentPage.hash)
     {
+        // Fetch the content for the detailed comparison
+        if (!loadPageData(currentPage))
+            return 1;
+        if (context.fromCache && !parseCachedModule(moduleName, context))
+            return 1;
+        if (context.textSegmentData.size() <= (qint32) sectionNumber)
+            return 1;
 
 
         if (context.textSegmentData.at(sectionNumber).content.size() != currentPage.data.size())
@@ -1949,9 +2372,18 @@ quint64 PageVerifier::checkCodePage(QString moduleName, quint32 sectionNumber, D
                            << " Length of page: " << currentPage.data.size() << endl;
         }
 
-        for(qint32 i = 0 ; i < currentPage.data.size() ; i++)
+        const QByteArray currentSegment = context.textSegmentData.at(sectionNumber).content;
+        const qint32 compareSize = qMin(currentSegment.size(), currentPage.data.size());
+
+        for(qint32 i = 0 ; i < compareSize ; i++)
         {
-            QByteArray currentSegment = context.textSegmentData.at(sectionNumber).content;
+            // Skip over equal bytes quickly
+            i = PageDigest::firstDifference(currentSegment.constData(),
+                                            currentPage.data.constData(),
+                                            i, compareSize);
+            if (i >= compareSize)
+                break;
+
             if(currentSegment.at(i) != currentPage.data.at(i))
             {
                 //Show first changed byte only
@@ -2098,9 +2530,16 @@ void PageVerifier::verifyParavirtFuncs()
     quint64 unknownJump = 0;
     quint64 unknownCall = 0;
 
+    //Collect the function addresses once instead of once per entry
+    QSet<quint64> functions;
+    functions.reserve(_funcTable.size());
+    for (QHash<QString, quint64>::const_iterator it = _funcTable.constBegin();
+         it != _funcTable.constEnd(); ++it)
+        functions.insert(it.value());
+
     for(int i = 0 ; i < _paravirtJump.length(); i++)
     {
-        if (_funcTable.values().contains(_paravirtJump.at(i)))
+        if (functions.contains(_paravirtJump.at(i)))
         {
             //Console::out() << "Found Paravirt Jump target " << _funcTable.key(_paravirtJump.at(i)) << endl;
         }
@@ -2114,7 +2553,7 @@ void PageVerifier::verifyParavirtFuncs()
 
     for(int i = 0 ; i < _paravirtCall.length(); i++)
     {
-        if (_funcTable.values().contains(_paravirtCall.at(i)))
+        if (functions.contains(_paravirtCall.at(i)))
         {
             //Console::out() << "Found Paravirt Function " << _funcTable.key(_paravirtCall.at(i)) << endl;
         }
@@ -2139,7 +2578,8 @@ void PageVerifier::verifyParavirtFuncs()
             << " unknown targets ) " << endl;
 }
 
-void PageVerifier::verifyHashes(QMultiHash<quint64, Detect::ExecutablePage> *current)
+void PageVerifier::verifyHashes(QMultiHash<quint64, Detect::ExecutablePage> *current,
+                                QSet<quint64> *verified)
 {
 
     if (!current) {
@@ -2181,9 +2621,10 @@ void PageVerifier::verifyHashes(QMultiHash<quint64, Detect::ExecutablePage> *cur
 
 //    extractVDSOPage(0x1c03000);
 
-    QList<Detect::ExecutablePage> sections = current->values();
-
-    //Console::out() << "got list of all sections: " <<  sections.size() <<   " Sections" << endl;
+    // Pages are verified one by one as we go, their content is only read if
+    // the hash does not match
+    QMultiHash<quint64, Detect::ExecutablePage>::const_iterator pageIt,
+            pageEnd = current->constEnd();
 
     if(ParsedExecutables->contains(QString("kernel")))
     {
@@ -2192,7 +2633,7 @@ void PageVerifier::verifyHashes(QMultiHash<quint64, Detect::ExecutablePage> *cur
         {
             iter.next();
             QString moduleName = iter.value().currentModule.member("name").toString();
-            if(moduleName.compare(QString("NULL")) != 0){
+            if(moduleName.compare(QString("NULL")) != 0 && !iter.value().fromCache){
                 updateKernelModule(iter.value());
                 //Console::out()
                 //    << "\t Updated module "
@@ -2204,8 +2645,8 @@ void PageVerifier::verifyHashes(QMultiHash<quint64, Detect::ExecutablePage> *cur
 
     QList<quint64> addresses = QList<quint64>();
 
-    for (int i = 0; i < sections.size(); ++i){
-        Detect::ExecutablePage currentPage = sections.at(i);
+    for (pageIt = current->constBegin(); pageIt != pageEnd; ++pageIt){
+        Detect::ExecutablePage currentPage = pageIt.value();
         elfParseData context;
 
         switch(currentPage.type)
@@ -2213,7 +2654,7 @@ void PageVerifier::verifyHashes(QMultiHash<quint64, Detect::ExecutablePage> *cur
         case Detect::MODULE:
         {
             modulePages++;
-            moduleSize += currentPage.data.size();
+            moduleSize += currentPage.size;
 
             //if(currentPage.module.compare("drm") != 0) return;
 
@@ -2240,18 +2681,20 @@ void PageVerifier::verifyHashes(QMultiHash<quint64, Detect::ExecutablePage> *cur
             {
                 overallChanges += changes;
                 changedPages++;
-                changedSize += currentPage.data.size();
+                changedSize += currentPage.size;
             }
             else
             {
-                totalVerifiedSize += currentPage.data.size();
+                totalVerifiedSize += currentPage.size;
+                if (verified)
+                    verified->insert(currentPage.address);
             }
         }
             break;
         case Detect::KERNEL_CODE:
         {
             kernelCodePages++;
-            kernelCodeSize += currentPage.data.size();
+            kernelCodeSize += currentPage.size;
 
             // Get data from System.map
             quint64 _kernel_code_begin = _sym.memSpecs().systemMap.value("_text").address;
@@ -2265,14 +2708,18 @@ void PageVerifier::verifyHashes(QMultiHash<quint64, Detect::ExecutablePage> *cur
             {
                 overallChanges += changes;
                 changedPages++;
-                changedSize += currentPage.data.size();
+                changedSize += currentPage.size;
+
+                // Only changed pages have been read
+                if (!currentPage.data.isEmpty())
+                    writeSectionToFile("kernel", sectionNumber, currentPage.data);
             }
             else
             {
-                totalVerifiedSize += currentPage.data.size();
+                totalVerifiedSize += currentPage.size;
+                if (verified)
+                    verified->insert(currentPage.address);
             }
-
-            writeSectionToFile("kernel", sectionNumber, currentPage.data);
         }
             break;
         case Detect::KERNEL_DATA:
@@ -2287,31 +2734,31 @@ void PageVerifier::verifyHashes(QMultiHash<quint64, Detect::ExecutablePage> *cur
             {
                 //Kernels .data page
                 //TODO compare
-                //Console::out() << "Got kernel data page @ " << hex << currentPage.address << " with size: " << currentPage.data.size() << dec << endl;
+                //Console::out() << "Got kernel data page @ " << hex << currentPage.address << " with size: " << currentPage.size << dec << endl;
                 kernelDataPages++;
-                kernelDataSize += currentPage.data.size();
+                kernelDataSize += currentPage.size;
 
                 changedDataPages++;
-                changedDataSize += currentPage.data.size();
+                changedDataSize += currentPage.size;
             }
             else if (currentPage.address >= context.bssSegment.address && currentPage.address < context.bssSegment.address + context.bssSegment.size)
             {
                 //Kernels .bss page
                 //TODO compare
-                //Console::out() << "Got kernel data page @ " << hex << currentPage.address << " with size: " << currentPage.data.size() << dec << endl;
+                //Console::out() << "Got kernel data page @ " << hex << currentPage.address << " with size: " << currentPage.size << dec << endl;
                 kernelBssPages++;
-                kernelBssSize += currentPage.data.size();
+                kernelBssSize += currentPage.size;
 
                 changedDataPages++;
-                changedDataSize += currentPage.data.size();
+                changedDataSize += currentPage.size;
             }
             else if (currentPage.address >= context.dataNosaveSegment.address && currentPage.address < context.dataNosaveSegment.address + context.dataNosaveSegment.size)
             {
                 //Kernels .data_nosave page
                 //TODO compare
-                //Console::out() << "Got kernel data page @ " << hex << currentPage.address << " with size: " << currentPage.data.size() << dec << endl;
+                //Console::out() << "Got kernel data page @ " << hex << currentPage.address << " with size: " << currentPage.size << dec << endl;
                 kernelDataPages++;
-                kernelDataSize += currentPage.data.size();
+                kernelDataSize += currentPage.size;
 
                 quint32 sectionNumber = (currentPage.address - context.dataNosaveSegment.address) / 0x1000;
                 if (context.dataNosaveSegmentData.size() <= (qint32) sectionNumber )
@@ -2322,16 +2769,18 @@ void PageVerifier::verifyHashes(QMultiHash<quint64, Detect::ExecutablePage> *cur
                     continue;
                 }
 
-                if(context.dataNosaveSegmentData.at(sectionNumber).hash.toHex() != currentPage.hash.toHex())
+                if(context.dataNosaveSegmentData.at(sectionNumber).hash != currentPage.hash)
                 {
                     //Console::out() << "Data_nosave Section: " << hex << sectionNumber << " Hash mismatch." << dec << endl;
 
                     changedDataPages++;
-                    changedDataSize += currentPage.data.size();
+                    changedDataSize += currentPage.size;
                 }
                 else
                 {
-                    totalVerifiedSize += currentPage.data.size();
+                    totalVerifiedSize += currentPage.size;
+                    if (verified)
+                        verified->insert(currentPage.address);
                 }
             }
             else if (currentPage.address >= context.vvarSegment.address && currentPage.address < context.vvarSegment.address + context.vvarSegment.size)
@@ -2339,9 +2788,9 @@ void PageVerifier::verifyHashes(QMultiHash<quint64, Detect::ExecutablePage> *cur
                 //Kernels .vvar page
                 //see /arch/x86/include/asm/vvar.h
                 //TODO compare
-                //Console::out() << "Got kernel data page @ " << hex << currentPage.address << " with size: " << currentPage.data.size() << dec << endl;
+                //Console::out() << "Got kernel data page @ " << hex << currentPage.address << " with size: " << currentPage.size << dec << endl;
                 kernelVvarPages++;
-                kernelVvarSize += currentPage.data.size();
+                kernelVvarSize += currentPage.size;
 
                 quint32 sectionNumber = (currentPage.address - context.vvarSegment.address) / 0x1000;
                 if (context.vvarSegmentData.size() <= (qint32) sectionNumber )
@@ -2352,56 +2801,58 @@ void PageVerifier::verifyHashes(QMultiHash<quint64, Detect::ExecutablePage> *cur
                     continue;
                 }
 
-                if(context.vvarSegmentData.at(sectionNumber).hash.toHex() != currentPage.hash.toHex())
+                if(context.vvarSegmentData.at(sectionNumber).hash != currentPage.hash)
                 {
                     //Console::out() << "Vvar Section: " << hex << sectionNumber << " Hash mismatch. This is normal as this page contains data" << dec << endl;
                     changedDataPages++;
-                    changedDataSize += currentPage.data.size();
+                    changedDataSize += currentPage.size;
                 }
                 else
                 {
-                    totalVerifiedSize += currentPage.data.size();
+                    totalVerifiedSize += currentPage.size;
+                    if (verified)
+                        verified->insert(currentPage.address);
                 }
             }
             else
             {
                 unknownKernelDataPages++;
-                unknownKernelDataSize += currentPage.data.size();
-                Console::out() << "Unknown data page @ " << hex << currentPage.address << " with size: " << currentPage.data.size() << dec << endl;
+                unknownKernelDataSize += currentPage.size;
+                Console::out() << "Unknown data page @ " << hex << currentPage.address << " with size: " << currentPage.size << dec << endl;
             }
 
             break;
         case Detect::VMAP:
             vmapPages++;
-            vmapSize += currentPage.data.size();
+            vmapSize += currentPage.size;
 
             addresses.append(currentPage.address);
 
             uncheckedPages++;
-            uncheckedPagesSize += currentPage.data.size();
+            uncheckedPagesSize += currentPage.size;
             break;
         case Detect::VMAP_LAZY:
             vmapLazyPages++;
-            vmapLazySize += currentPage.data.size();
+            vmapLazySize += currentPage.size;
 
-            Console::out() << "Unknown data page @ " << hex << currentPage.address << " with size: " << currentPage.data.size() << dec << endl;
+            Console::out() << "Unknown data page @ " << hex << currentPage.address << " with size: " << currentPage.size << dec << endl;
 
             uncheckedPages++;
-            uncheckedPagesSize += currentPage.data.size();
+            uncheckedPagesSize += currentPage.size;
             break;
         case Detect::UNDEFINED:
             undefinedPages++;
-            undefinedSize += currentPage.data.size();
+            undefinedSize += currentPage.size;
 
             uncheckedPages++;
-            uncheckedPagesSize += currentPage.data.size();
+            uncheckedPagesSize += currentPage.size;
             break;
         default:
             Console::out() << "Type: " << hex << currentPage.type << dec << " currently not implemented" << endl;
         }
 
         totalVerified++;
-        totalSize += currentPage.data.size();
+        totalSize += currentPage.size;
     }
 
     qSort(addresses);
@@ -2468,12 +2919,9 @@ void PageVerifier::verifyHashes(QMultiHash<quint64, Detect::ExecutablePage> *cur
 
 void Detect::buildFunctionList(MemoryMap *map)
 {
-    VirtualMemory *vmem = _sym.memDumps().at(_current_index)->vmem();
+    VirtualMemory *vmem = map->vmem();
 
-    if (Functions)
-        Functions->clear();
-    else
-        Functions = new QMultiHash<quint64, FunctionInfo>();
+    _functions.clear();
 
     NodeList roots = map->roots();
 
@@ -2481,8 +2929,8 @@ void Detect::buildFunctionList(MemoryMap *map)
         if (roots.at(i)->type()->type() == rtFunction) {
             const Function* f = dynamic_cast<const Function*>(roots.at(i)->type());
 
-            if (f) {
-                Functions->insert(f->pcLow(), FunctionInfo(MEMORY_MAP, f));
+            if (f && f->pcLow()) {
+                _functions.append(FunctionRange(f->pcLow(), f->pcHigh(), f));
             }
         }
     }
@@ -2492,86 +2940,94 @@ void Detect::buildFunctionList(MemoryMap *map)
     // However, we have the system map. Thus lets add the functions in there as well
     SystemMapEntryList list = vmem->memSpecs().systemMapToList();
 
-
     for (int i = 0; i < list.size(); ++i) {
-        if (list.at(i).type == QString("t").toAscii().at(0) ||
-                list.at(i).type == QString("T").toAscii().at(0)) {
-            Functions->insert(list.at(i).address, FunctionInfo(SYSTEM_MAP, list.at(i).name));
+        if (list.at(i).type == 't' || list.at(i).type == 'T') {
+            _functions.append(FunctionRange(list.at(i).address, 0, 0,
+                                            list.at(i).name));
         }
     }
 
+    // Sort by start address. For System.map entries, the function ends
+    // where the next one starts. Of several entries with the same start
+    // address, keep the one with the largest end.
+    qSort(_functions);
+
+    for (int i = _functions.size() - 1; i >= 0; --i) {
+        FunctionRange &f = _functions[i];
+        if (f.end <= f.start)
+            f.end = (i + 1 < _functions.size()) ?
+                        _functions[i + 1].start : f.start + 1;
+        if (f.end <= f.start)
+            f.end = f.start + 1;
+    }
+
+    int j = 0;
+    for (int i = 1; i < _functions.size(); ++i) {
+        if (_functions[i].start == _functions[j].start) {
+            FunctionRange &f = _functions[j];
+            if (!f.function)
+                f.function = _functions[i].function;
+            if (f.name.isEmpty())
+                f.name = _functions[i].name;
+            f.end = qMax(f.end, _functions[i].end);
+        }
+        else if (++j != i)
+            _functions[j] = _functions[i];
+    }
+    while (_functions.size() > j + 1)
+        _functions.removeLast();
+
+    _functionsBuilt = true;
+}
 
+const Detect::FunctionRange *Detect::functionAt(quint64 address) const
+{
+    // Find the last function that starts at or before address
+    QList<FunctionRange>::const_iterator it =
+            qUpperBound(_functions.constBegin(), _functions.constEnd(),
+                        FunctionRange(address));
+    if (it == _functions.constBegin())
+        return 0;
+    --it;
+
+    return (address < it->end) ? &(*it) : 0;
 }
 
 bool Detect::pointsToKernelFunction(MemoryMap *map, Instance &funcPointer)
 {
-    if (!Functions)
+    if (!_functionsBuilt)
         buildFunctionList(map);
 
-    if (Functions->contains((quint64)funcPointer.toPointer()))
-        return true;
+    // Only pointers to the beginning of a function are valid
+    const quint64 pointsTo = (quint64)funcPointer.toPointer();
+    const FunctionRange *f = functionAt(pointsTo);
 
-    return false;
+    return f && f->start == pointsTo;
 }
 
-bool Detect::pointsToModuleCode(Instance &functionPointer)
+bool Detect::pointsToModuleCode(MemoryMap *map, Instance &functionPointer)
 {
     // Target
     quint64 pointsTo = (quint64)functionPointer.toPointer();
 
-    VirtualMemory *vmem = _sym.memDumps().at(_current_index)->vmem();
-    const Variable *varModules = _sym.factory().findVarByName("modules");
-    const Structured *typeModule = dynamic_cast<const Structured *>
-            (_sym.factory().findBaseTypeByName("module"));
-    assert(varModules != 0);
-    assert(typeModule != 0);
-
-    // Don't depend on the rule engine
-    const int listOffset = typeModule->memberOffset("list");
-    Instance firstModule = varModules->toInstance(vmem).member("next", BaseType::trAny, -1, ksNone);
-    firstModule.setType(typeModule);
-    firstModule.addToAddress(-listOffset);
-
-    Instance currentModule;
-    quint64 currentModuleCore = 0;
-    quint64 currentModuleCoreSize = 0;
-
-    // Don't depend on the rule engine
-    currentModule = varModules->toInstance(vmem).member("next", BaseType::trAny, -1, ksNone);
-    currentModule.setType(typeModule);
-    currentModule.addToAddress(-listOffset);
-
-    do {
-        currentModuleCore = (quint64)currentModule.member("module_core").toPointer();
-        currentModuleCoreSize = (quint64)currentModule.member("core_text_size").toPointer();
-
-        if (pointsTo >= currentModuleCore &&
-                pointsTo <= (currentModuleCore + currentModuleCoreSize)) {
-            return true;
-        }
-
-        // Don't depend on the rule engine
-        currentModule = currentModule.member("list").member("next", BaseType::trAny, -1, ksNone);
-        currentModule.setType(typeModule);
-        currentModule.addToAddress(-listOffset);
+    VirtualMemory *vmem = map->vmem();
+    if (_modules.vmem() != vmem)
+        _modules.build(_sym.factory(), vmem);
 
-    } while (currentModule.address() != firstModule.address() &&
-             currentModule.address() != varModules->offset() - listOffset);
-
-    return false;
+    return _modules.inCoreText(pointsTo);
 }
 
 void Detect::verifyFunctionPointer(MemoryMap *map, Instance &funcPointer,
                                    FunctionPointerStats &stats, bool inUnion)
 {
+    // Increase total count
+    stats.total++;
+
     // Target
     quint64 pointsTo = (quint64)funcPointer.toPointer();
 
     // vmem
-    VirtualMemory *vmem = _sym.memDumps().at(_current_index)->vmem();
-
-    // Increase total count
-    stats.total++;
+    VirtualMemory *vmem = map->vmem();
 
     // Verify the function pointer and gather statistics
     if (MemoryMapHeuristics::isUserLandAddress(pointsTo, vmem->memSpecs())) {
@@ -2617,7 +3073,7 @@ void Detect::verifyFunctionPointer(MemoryMap *map, Instance &funcPointer,
         return;
     }
 
-    if (pointsToModuleCode(funcPointer)) {
+    if (pointsToModuleCode(map, funcPointer)) {
         stats.pointToModule++;
         return;
     }
@@ -2641,6 +3097,7 @@ void Detect::verifyFunctionPointer(MemoryMap *map, Instance &funcPointer,
             }
         }
 
+        QMutexLocker lock(&_outputMutex);
         Console::out()
                 << Console::color(ctWarningLight)
                 << "WARNING:" << Console::color(ctReset)
@@ -2658,49 +3115,94 @@ void Detect::verifyFunctionPointer(MemoryMap *map, Instance &funcPointer,
     }
 }
 
-void Detect::verifyFunctionPointers(MemoryMap *map)
+void Detect::FunctionPointerStats::merge(const FunctionPointerStats &other)
 {
-    assert(map);
+    total += other.total;
+    userlandPointer += other.userlandPointer;
+    defaultValue += other.defaultValue;
+    pointToKernelFunction += other.pointToKernelFunction;
+    pointToModule += other.pointToModule;
+    invalidAddress += other.invalidAddress;
+    pointToNXMemory += other.pointToNXMemory;
+    pointToPhysical += other.pointToPhysical;
+    maliciousUnion += other.maliciousUnion;
+    malicious += other.malicious;
+    unreadable += other.unreadable;
+}
 
-    // Unions
-    bool inUnion = false;
 
-    // Statistics
-    FunctionPointerStats stats;
+Detect::FuncPointerThread::FuncPointerThread(Detect *detect, MemoryMap *map)
+    : _detect(detect), _map(map)
+{
+}
 
-    const QList<FuncPointersInNode> funcPointers = map->funcPointers();
 
-    // Start the Operation
-    operationStarted();
+void Detect::FuncPointerThread::run()
+{
+    _detect->verifyFuncPointerNodes(_map, &stats);
+}
 
-    for (int i = 0; i < funcPointers.size(); ++i) {
-        Instance node = funcPointers[i].node->toInstance();
-        inUnion = false;
 
-        if (!funcPointers[i].paths.empty()) {
-            // Reconstruct each function pointer by following the path
-            for (int j = 0; j < funcPointers[i].paths.size(); ++j) {
+Instance Detect::funcPointerAt(const Instance &node,
+                               const VariableTypeContainerList &path,
+                               bool *inUnion) const
+{
+    // Follow the path through the declared types and sum up the offsets
+    // instead of resolving every member with Instance::member()
+    quint64 offset = 0;
+    const BaseType *type = node.type();
+    QStringList names(node.fullNameComponents());
+    QString name(names.isEmpty() ? QString() : names.takeLast());
+
+    for (int k = 0; k < path.size(); ++k) {
+        const BaseType *t = path.at(k).type;
+        int index = path.at(k).index;
+
+        if (t->type() & StructOrUnion) {
+            const Structured *s = static_cast<const Structured *>(t);
+            if (index < 0 || index >= s->members().size())
+                return Instance();
+
+            const StructuredMember *m = s->members().at(index);
+            offset += m->offset();
+            type = m->refTypeDeep(BaseType::trLexical);
+            names.append(name);
+            name = m->name();
+
+            if (t->type() & rtUnion)
+                *inUnion = true;
+        }
+        else if (t->type() & rtArray) {
+            const Array *a = static_cast<const Array *>(t);
+            if (!a->refType())
+                return Instance();
+
+            offset += index * a->refType()->size();
+            type = a->refTypeDeep(BaseType::trLexical);
+            name += '[' + QString::number(index) + ']';
+        }
+        else {
+            debugerr("This should be a struct or an array!");
+        }
+    }
 
-                Instance funcPointer = node;
+    return Instance(node.address() + offset, type, name, names, node.vmem());
+}
 
-                for (int k = 0; k < funcPointers[i].paths[j].size(); ++k) {
-                    const BaseType *t = funcPointers[i].paths[j].at(k).type;
-                    int index = funcPointers[i].paths[j].at(k).index;
 
-                    if (t->type() & StructOrUnion) {
-                        funcPointer = funcPointer.member(index, BaseType::trLexical, 0,
-                                                         map->knowSrc());
+void Detect::verifyFuncPointerNodes(MemoryMap *map, FunctionPointerStats *stats)
+{
+    int i;
+    while (!interrupted() &&
+           (i = _nextFuncPointer.fetchAndAddOrdered(1)) < _funcPointers.size())
+    {
+        const FuncPointersInNode &fp = _funcPointers.at(i);
+        Instance node = fp.node->toInstance();
 
-                        if (t->type() & rtUnion)
-                            inUnion = true;
-                    }
-                    else if (t->type() & rtArray) {
-                        funcPointer = funcPointer.arrayElem(index);
-                    }
-                    else {
-                        debugerr("This should be a struct or an array!");
-                    }
-                }
+        if (!fp.paths.empty()) {
+            for (int j = 0; j < fp.paths.size(); ++j) {
+                bool inUnion = false;
+                Instance funcPointer = funcPointerAt(node, fp.paths[j], &inUnion);
 
                 // What we have now, should be a function pointer
                 if (!MemoryMapHeuristics::isFunctionPointer(funcPointer)) {
@@ -2711,7 +3213,13 @@ void Detect::verifyFunctionPointers(MemoryMap *map)
                 }
 
                 // Verify Function Pointer
-                verifyFunctionPointer(map, funcPointer, stats, inUnion);
+                try {
+                    verifyFunctionPointer(map, funcPointer, *stats, inUnion);
+                }
+                catch (GenericException&) {
+                    // The pointer or its target page cannot be read
+                    stats->unreadable++;
+                }
             }
         }
         else {
@@ -2724,14 +3232,76 @@ void Detect::verifyFunctionPointers(MemoryMap *map)
             }
 
             // Verify Function Pointer
-            verifyFunctionPointer(map, node, stats, inUnion);
+            try {
+                verifyFunctionPointer(map, node, *stats, false);
+            }
+            catch (GenericException&) {
+                // The pointer or its target page cannot be read
+                stats->unreadable++;
+            }
+        }
+    }
+}
+
+
+Detect::FunctionPointerStats Detect::checkFunctionPointers(
+        MemoryMap *map, const QList<FuncPointersInNode> &funcPointers)
+{
+    assert(map);
+
+    VirtualMemory *vmem = map->vmem();
+
+    // Statistics
+    FunctionPointerStats stats;
+
+    _funcPointers = funcPointers;
+    _nextFuncPointer = 0;
+
+    // The look-up tables must be complete before the threads start
+    if (!_functionsBuilt)
+        buildFunctionList(map);
+    if (_modules.vmem() != vmem)
+        _modules.build(_sym.factory(), vmem);
+
+    // Start the Operation
+    operationStarted();
+
+    const int threadCount = qMin(MultiThreading::maxThreads(),
+                                 _funcPointers.size());
+
+    if (threadCount > 1) {
+        bool wasThreadSafe = vmem->setThreadSafety(true);
+        QList<FuncPointerThread*> threads;
+        for (int i = 0; i < threadCount; ++i) {
+            threads.append(new FuncPointerThread(this, map));
+            threads.last()->start();
         }
 
+        for (int i = 0; i < threads.size(); ++i) {
+            while (!threads[i]->wait(250))
+                checkOperationProgress();
+            stats.merge(threads[i]->stats);
+        }
+
+        qDeleteAll(threads);
+        vmem->setThreadSafety(wasThreadSafe);
     }
+    else
+        verifyFuncPointerNodes(map, &stats);
+
+    _funcPointers.clear();
 
     // Finish
     operationStopped();
 
+    return stats;
+}
+
+
+void Detect::verifyFunctionPointers(MemoryMap *map)
+{
+    FunctionPointerStats stats = checkFunctionPointers(map, map->funcPointers());
+
     // Print Stats
     Console::out() << "\r\nProcessed " << Console::color(ctWarningLight)
                    << stats.total << Console::color(ctReset)
@@ -2771,6 +3341,11 @@ void Detect::verifyFunctionPointers(MemoryMap *map)
                    << " (" << Console::color(ctWarning)
                    << QString("%1").arg((float)stats.pointToPhysical * 100 / stats.total, 0, 'f', 2)
                    << Console::color(ctReset) << "%) pointing into the directly mapped physical memory." << endl;
+    Console::out() << "\t Found " << Console::color(ctWarning)
+                   << stats.unreadable << Console::color(ctReset)
+                   << " (" << Console::color(ctWarning)
+                   << QString("%1").arg((float)stats.unreadable * 100 / stats.total, 0, 'f', 2)
+                   << Console::color(ctReset) << "%) that could not be read." << endl;
     Console::out() << "\t Detected " << Console::color(ctError)
                    << stats.malicious + stats.maliciousUnion << Console::color(ctReset)
                    << " (" << Console::color(ctError)
@@ -2783,275 +3358,395 @@ void Detect::verifyFunctionPointers(MemoryMap *map)
                    << Console::color(ctReset) << "%) of them are located within a union." << endl;
 }
 
-void Detect::hiddenCode(int index)
+void Detect::ScanResult::merge(const ScanResult &other)
 {
-    VirtualMemory *vmem = _sym.memDumps().at(index)->vmem();
+    processed_pages += other.processed_pages;
+    executeable_pages += other.executeable_pages;
+    nonexecutable_pages += other.nonexecutable_pages;
+    nonsupervisor_pages += other.nonsupervisor_pages;
+    hidden_pages += other.hidden_pages;
+    lazy_pages += other.lazy_pages;
+    vmap_pages += other.vmap_pages;
+    unchanged_pages += other.unchanged_pages;
+    readError = readError || other.readError;
+    // The ranges are disjoint, so are the keys
+    hashes.unite(other.hashes);
+    changed.unite(other.changed);
+    hiddenPages.unite(other.hiddenPages);
+}
 
-    quint64 begin = (vmem->memSpecs().pageOffset & ~(PAGE_SIZE - 1));
-    quint64 end = vmem->memSpecs().vaddrSpaceEnd();
 
-    const Variable *varModules = _sym.factory().findVarByName("modules");
-    const Structured *typeModule = dynamic_cast<const Structured *>
-            (_sym.factory().findBaseTypeByName("module"));
-    assert(varModules != 0);
-    assert(typeModule != 0);
+Detect::ScanThread::ScanThread(Detect *detect, VirtualMemory *vmem)
+    : _detect(detect), _vmem(vmem)
+{
+}
 
-    // Don't depend on the rule engine
-    const int listOffset = typeModule->memberOffset("list");
-    Instance firstModule = varModules->toInstance(vmem).member("next", BaseType::trAny, -1, ksNone);
-    firstModule.setType(typeModule);
-    firstModule.addToAddress(-listOffset);
 
-    Instance currentModule;
-    quint64 currentModuleCore = 0;
-    quint64 currentModuleCoreSize = 0;
-    bool found = false;
-    quint64 i = 0;
-    quint64 flags = 0;
+void Detect::ScanThread::run()
+{
+    _detect->scanRanges(_vmem, &result);
+}
 
-    struct PageTableEntries ptEntries;
-    int pageSize = 0;
 
-    // Prepare status output
-    _first_page = begin;
-    _current_page = begin;
-    _final_page = end;
+bool Detect::findModuleOfPage(quint64 address, VirtualMemory *vmem, QString *name)
+{
+    // The index is built by hiddenCode() before the scanner threads start
+    assert(_modules.vmem() == vmem);
+    Q_UNUSED(vmem);
+
+    // Only the core text has a reference image to verify against.
+    // Executable pages within the core data are left to the vmap check.
+    ModuleIndex::RegionType type;
+    const ModuleInfo *mod = _modules.moduleAt(address, &type);
+    if (!mod || type != ModuleIndex::rtCoreText)
+        return false;
+
+    if (name)
+        *name = mod->name;
+    return true;
+}
 
-    // Set index
-    _current_index = index;
 
-    // Statistics
-    quint64 processed_pages = 0;
-    quint64 executeable_pages = 0;
-    quint64 nonexecutable_pages = 0;
-    quint64 nonsupervisor_pages = 0;
-    quint64 hidden_pages = 0;
-    quint64 lazy_pages = 0;
-    quint64 vmap_pages = 0;
+void Detect::addExecutablePage(ScanResult *res, const ExecutablePage &page) const
+{
+    res->hashes.insert(page.address, page);
 
-    // Hash
-    QMultiHash<quint64, ExecutablePage> *currentHashes = new QMultiHash<quint64, ExecutablePage>();
-    QCryptographicHash hash(QCryptographicHash::Sha1);
+    if (!_previousRun)
+        return;
 
-    // Start the Operation
-    operationStarted();
+    // The page is always classified again, only its verification may be
+    // skipped. Pages that failed or were not verified must be verified and
+    // reported again. So must pages that moved to another region, and
+    // module pages if the modules changed, as their reference image may have
+    // changed as well.
+    QMultiHash<quint64, ExecutablePage>::const_iterator prev =
+            _previousRun->pages.constFind(page.address);
+    if (prev != _previousRun->pages.constEnd() &&
+        _previousRun->verified.contains(page.address) &&
+        prev->physAddress == page.physAddress && prev->hash == page.hash &&
+        prev->type == page.type && prev->module == page.module &&
+        (page.type != MODULE || _modulesUnchanged))
+        res->unchanged_pages++;
+    else
+        res->changed.insert(page.address, page);
+}
 
-    // In case of a 64-bit architecture there are TWO references to the same pages.
-    // This is due to the fact that the complete physical memory region
-    // is mapped to ffff8800 00000000 - ffffc7ff ffffffff (=64 TB).
-    // Thus we start in this case after the direct mapping
-    if ((vmem->memSpecs().arch & vmem->memSpecs().ar_x86_64))
-        begin = 0xffffc7ffffffffff + 1;
 
-    for (i = begin; i < end && i >= begin; i += ptEntries.nextPageOffset(vmem->memSpecs()))
-    {
-        found = false;
-        _current_page = i;
-        processed_pages++;
+void Detect::scanPages(VirtualMemory *vmem, const ScanRange &range,
+                       ScanResult *res)
+{
+    quint64 i = 0, size = 0, flags = 0;
+    QString module;
+    PageDigest hash;
+    // Only the hashes are kept, so one buffer serves all pages
+    QByteArray data;
 
-        // Check
-        checkOperationProgress();
+    // Walk the page tables once instead of translating every address
+    PageTableIterator it(vmem, range.first, range.last, true);
 
-        // Reset the entries
-        ptEntries.reset();
+    while (it.next())
+    {
+        i = it.address();
+        size = it.size();
+        const PageTableEntries& ptEntries = it.entries();
 
-        // Try to resolve address
-        vmem->virtualToPhysical(i, &pageSize, false, &ptEntries);
+        // A range may start in the middle of a non-present upper-level
+        // entry. Count such an entry only once, namely in the range that
+        // contains its first page, as a sequential scan would.
+        if (i >= range.first)
+            res->processed_pages++;
 
         // Present?
-        if (!ptEntries.isPresent())
+        if (!it.isPresent())
             continue;
 
-        //debugmsg("Address: " << std::hex << i << std::dec << ", Size: " << ptEntries.nextPageOffset(_sym.memSpecs()));
-
         if (!ptEntries.isExecutable())
         {
             // This one is not executable
-            nonexecutable_pages++;
+            res->nonexecutable_pages++;
             continue;
         }
         else if (!ptEntries.isSupervisor())
         {
             // We are only interested in supervisor pages.
             // Notice that this filter allows us to get rid of I/O pages.
-            nonsupervisor_pages++;
+            res->nonsupervisor_pages++;
             continue;
         }
-        else
-        {
-            executeable_pages++;
 
-            // Is this page also writeable?
-            /*
-            if (ptEntries.isWriteable())
-            {
-                Console::out() << "\rWARNING: Detected a writable and executable page @ 0x"
-                               << hex << i << dec << endl;
-            }
-            */
+        res->executeable_pages++;
 
-            // Create ByteArray
-            QByteArray data;
-            data.resize(ptEntries.nextPageOffset(vmem->memSpecs()));
+        if ((quint64)data.size() < size)
+            data.resize(size);
 
-            // Get data
-            if ((quint64)vmem->readAtomic(i, data.data(), data.size()) != (quint64) data.size()) {
-                std::cout << "ERROR: Could not read data of page!" << std::endl;
-                return;
-            }
+        // Get data, the page is already translated
+        if (!vmem->readPhysical(it.physAddress(), data.data(), size)) {
+            res->readError = true;
+            return;
+        }
 
-            // Calculate hash
-            hash.reset();
-            hash.addData(data);
+        // Calculate hash
+        hash.reset();
+        hash.addData(data.constData(), size);
 
-            // Lies the page within the kernel code area?
-            if (i >= _kernel_code_begin && i <= _kernel_code_end) {
-                currentHashes->insert(i, ExecutablePage(i, KERNEL_CODE, "kernel (code)", hash.result(), data));
-                continue;
-            }
+        // Lies the page within the kernel code area?
+        if (i >= _kernel_code_begin && i <= _kernel_code_end) {
+            addExecutablePage(res, ExecutablePage(i, KERNEL_CODE, "kernel (code)", hash.result(), size, it.physAddress()));
+            continue;
+        }
 
-            // Lies the page within an executable kernel data region
-            if (i >= _kernel_code_end && i <= _kernel_data_exec_end) {
-                currentHashes->insert(i, ExecutablePage(i, KERNEL_DATA, "kernel (data)", hash.result(), data));
-                continue;
-            }
+        // Lies the page within an executable kernel data region
+        if (i >= _kernel_code_end && i <= _kernel_data_exec_end) {
+            addExecutablePage(res, ExecutablePage(i, KERNEL_DATA, "kernel (data)", hash.result(), size, it.physAddress()));
+            continue;
+        }
 
-            // Vsyscall page?
-            if (i == _vsyscall_page) {
-                currentHashes->insert(i, ExecutablePage(i, KERNEL_CODE, "kernel (code)", hash.result(), data));
-                continue;
+        // Vsyscall page?
+        if (i == _vsyscall_page) {
+            addExecutablePage(res, ExecutablePage(i, KERNEL_CODE, "kernel (code)", hash.result(), size, it.physAddress()));
+            continue;
+        }
+
+        // Does the page belong to a module?
+        if (findModuleOfPage(i, vmem, &module)) {
+            addExecutablePage(res, ExecutablePage(i, MODULE, module, hash.result(), size, it.physAddress()));
+            continue;
+        }
+
+        // Check VMAP
+        if ((flags = inVmap(i))) {
+            if (flags & 0x1) {
+                res->lazy_pages++;
+                addExecutablePage(res, ExecutablePage(i, VMAP_LAZY, "vmap (lazy)", hash.result(), size, it.physAddress()));
+            }
+            else {
+                res->vmap_pages++;
+                addExecutablePage(res, ExecutablePage(i, VMAP, "vmap", hash.result(), size, it.physAddress()));
             }
+            continue;
+        }
 
-            // Does the page belong to a module?
-            // Don't depend on the rule engine
-            currentModule = varModules->toInstance(vmem).member("next", BaseType::trAny, -1, ksNone);
-            currentModule.setType(typeModule);
-            currentModule.addToAddress(-listOffset);
-
-            do {
-                currentModuleCore = (quint64)currentModule.member("module_core").toPointer();
-                currentModuleCoreSize = (quint64)currentModule.member("core_text_size").toPointer();
-
-                if (i >= currentModuleCore &&
-                        i <= (currentModuleCore + currentModuleCoreSize)) {
-                    found = true;
-                    currentHashes->insert(i, ExecutablePage(i, MODULE, currentModule.member("name").toString(),
-                                                            hash.result(), data));
-                    break;
-                }
-                else {
-                    //TODO search if page is part of any module
-                    //currently all executable pages have already been found without that
-
-                //                    // Check if address falls into any section of any module
-                //                    Instance attrs = currentModule.member("sect_attrs", BaseType::trAny);
-                //                    uint attr_cnt = attrs.member("nsections").toUInt32();
-
-                //                    quint64 prevSectAddr = 0, sectAddr;
-                //                    QString prevSectName, sectName;
-                //                    for (uint j = 0; j <= attr_cnt && !found; ++j) {
-
-                //                        if (j < attr_cnt) {
-                //                            Instance attr = attrs.member("attrs").arrayElem(j);
-                //                            sectAddr = attr.member("address").toULong();
-                //                            sectName = attr.member("name").toString();
-                //                        }
-                //                        else {
-                //                            sectAddr = (prevSectAddr | 0xfffULL) + 1;
-                //                        }
-                //                        // Make sure we have a chance to contain this address
-                //                        if (j == 0 && i < sectAddr) {
-                //                            attr_cnt = 0;
-                //                            break;
-                //                        }
-
-                //                        if (prevSectAddr <= i && i < sectAddr) {
-                //                            Console::out()
-                //                                    << "Page @ " << Console::color(ctAddress)
-                //                                    << QString("0x%0%6 belongs to module %5%1%6, section %5%2%6 (0x%3 - 0x%4)")
-                //                                       .arg(i, 0, 16)
-                //                                       .arg(currentModule.member("name").toString())
-                //                                       .arg(prevSectName)
-                //                                       .arg(prevSectAddr, 0, 16)
-                //                                       .arg(sectAddr-1, 0, 16)
-                //                                       .arg(Console::color(ctString))
-                //                                       .arg(Console::color(ctReset))
-                //                                    << endl;
-                //                            found = true;
-                //                        }
-
-                //                        prevSectAddr = sectAddr;
-                //                        prevSectName = sectName;
-                //                    }
+        // Well this seems to be a hidden page
+        res->hidden_pages++;
+        res->hiddenPages.insert(i, HiddenPage(i, size, ptEntries));
+    }
+}
 
-                }
 
-                // Don't depend on the rule engine
-                currentModule = currentModule.member("list").member("next", BaseType::trAny, -1, ksNone);
-                currentModule.setType(typeModule);
-                currentModule.addToAddress(-listOffset);
+void Detect::scanRanges(VirtualMemory *vmem, ScanResult *res)
+{
+    int i;
+    while (!res->readError && !interrupted() &&
+           (i = _nextScanRange.fetchAndAddOrdered(1)) < _scanRanges.size())
+        scanPages(vmem, _scanRanges[i], res);
+}
 
-            } while (currentModule.address() != firstModule.address() &&
-                     currentModule.address() != varModules->offset() - listOffset &&
-                     !found);
 
-            if(found) continue;
+void Detect::resetMonitor(const MemoryDump *dump)
+{
+    if (!MonitorStates)
+        return;
 
-            // Check VMAP
-            if ((flags = inVmap(i, vmem))) {
-                found = true;
+    if (dump)
+        MonitorStates->remove(dump);
+    else
+        MonitorStates->clear();
 
-                if (flags & 0x1) {
-                    lazy_pages++;
-                    currentHashes->insert(i, ExecutablePage(i, VMAP_LAZY, "vmap (lazy)", hash.result(), data));
-                }
-                else {
-                    vmap_pages++;
-                    currentHashes->insert(i, ExecutablePage(i, VMAP, "vmap", hash.result(), data));
-                }
-            }
+    if (MonitorStates->isEmpty()) {
+        delete MonitorStates;
+        MonitorStates = 0;
+    }
+}
 
 
-            if (!found)
-            {
-                // Well this seems to be a hidden page
-                Console::out()
-                        << "\r" << Console::color(ctWarningLight)
-                        << "WARNING:" << Console::color(ctReset)
-                        << " Detected hidden code page @ "
-                        << Console::color(ctAddress) << "0x" << hex << i << dec
-                        << Console::color(ctReset)
-                        << " (Flags: ";
-                if (ptEntries.isWriteable()) {
-                    Console::out()
-                            << Console::color(ctError) << 'W'
-                            << Console::color(ctReset);
-                }
-                else
-                    Console::out() << ' ';
-                if (ptEntries.isSupervisor()) {
-                    Console::out()
-                            << Console::color(ctNumber) << 'S'
-                            << Console::color(ctReset);
-                }
-                else
-                    Console::out() << ' ';
-                Console::out() << ") (Size: 0x"
-                               << hex << ptEntries.nextPageOffset(vmem->memSpecs()) << dec
-                               << ")"
-                               << endl;
-
-                Console::out()
-                        << Console::color(ctDim)
-                        << "PGD: 0x" << hex << ptEntries.pgd
-                        << ", PUD: 0x" << hex << ptEntries.pud
-                        << ", PMD: 0x" << hex << ptEntries.pmd
-                        << ", PTE: 0x" << hex << ptEntries.pte
-                        << dec << Console::color(ctReset) << endl;
-
-                hidden_pages++;
-            }
+void Detect::takeSnapshot(VirtualMemory *vmem)
+{
+    _modules.build(_sym.factory(), vmem);
+    buildVmapIndex(vmem);
+}
+
+
+void Detect::setSnapshot(const ModuleIndex &modules,
+                         const QList<VmapArea> &vmapAreas)
+{
+    _modules = modules;
+    _vmapAreas = vmapAreas;
+    qSort(_vmapAreas);
+}
+
+
+void Detect::scanAddressSpace(VirtualMemory *vmem, ScanResult *res)
+{
+    const MemSpecs& specs = vmem->memSpecs();
+
+    quint64 begin = (specs.pageOffset & ~(PAGE_SIZE - 1));
+    quint64 end = specs.vaddrSpaceEnd();
+
+    // In case of a 64-bit architecture there are TWO references to the same pages.
+    // This is due to the fact that the complete physical memory region
+    // is mapped to ffff8800 00000000 - ffffc7ff ffffffff (=64 TB).
+    // Thus we start in this case after the direct mapping
+    if ((specs.arch & specs.ar_x86_64))
+        begin = 0xffffc7ffffffffff + 1;
+
+    // Split the address space into ranges that are aligned to the second
+    // level of the page table, so every range starts with a fresh page table
+    // walk and non-present entries are skipped as a whole.
+    const quint64 rangeSize = (specs.arch & specs.ar_x86_64) ?
+                (1ULL << 30) : (1ULL << 22);
+    _scanRanges.clear();
+    for (quint64 i = begin; i < end && i >= begin; i += rangeSize)
+        _scanRanges.append(ScanRange(i, qMin(i + rangeSize - 1, end - 1)));
+    _nextScanRange = 0;
+
+    // Scan the ranges in parallel
+    const int threadCount = qMin(MultiThreading::maxThreads(),
+                                 _scanRanges.size());
+
+    if (threadCount > 1) {
+        bool wasThreadSafe = vmem->setThreadSafety(true);
+        QList<ScanThread*> threads;
+        for (int i = 0; i < threadCount; ++i) {
+            threads.append(new ScanThread(this, vmem));
+            threads.last()->start();
+        }
+
+        for (int i = 0; i < threads.size(); ++i) {
+            while (!threads[i]->wait(250))
+                checkOperationProgress();
+            res->merge(threads[i]->result);
+        }
+
+        qDeleteAll(threads);
+        vmem->setThreadSafety(wasThreadSafe);
+    }
+    else
+        scanRanges(vmem, res);
+
+    _scanRanges.clear();
+}
+
+
+void Detect::hiddenCode(int index, bool monitor)
+{
+    QTime checkTimer;
+    checkTimer.start();
+
+    const MemoryDump *dump = _sym.memDumps().at(index);
+    VirtualMemory *vmem = dump->vmem();
+    const MemSpecs& specs = vmem->memSpecs();
+
+    quint64 begin = (specs.pageOffset & ~(PAGE_SIZE - 1));
+    quint64 end = specs.vaddrSpaceEnd();
+
+    // Prepare status output
+    _first_page = begin;
+    _current_page = begin;
+    _final_page = end;
+
+    // Set index
+    _current_index = index;
+
+    // Start the Operation
+    operationStarted();
+
+    // The scanner threads only read this snapshot
+    takeSnapshot(vmem);
+
+    QHash<QString, quint64> currentModules;
+    for (int i = 0; i < _modules.modules().size(); ++i)
+        currentModules.insert(_modules.modules().at(i).name,
+                              _modules.modules().at(i).core);
+
+    // In monitor mode, compare against the pages of the previous run on
+    // this dump. Equal digests only prove that a page is unchanged if an
+    // attacker cannot forge them.
+    const bool skipUnchanged = monitor &&
+            PageDigest::isCryptographic(PageDigest::defaultAlgorithm());
+    if (monitor) {
+        if (!MonitorStates)
+            MonitorStates = new QHash<const MemoryDump*, MonitorState>();
+        if (!skipUnchanged)
+            MonitorStates->remove(dump);
+    }
+
+    if (skipUnchanged && MonitorStates->contains(dump)) {
+        _previousRun = &MonitorStates->find(dump).value();
+        _modulesUnchanged = _previousRun->modules == currentModules;
+    }
+    else {
+        _previousRun = 0;
+        _modulesUnchanged = false;
+    }
+
+    ScanResult total;
+    scanAddressSpace(vmem, &total);
+
+    if (total.readError) {
+        std::cout << "ERROR: Could not read data of page!" << std::endl;
+        _previousRun = 0;
+        operationStopped();
+        return;
+    }
+
+    // Only verify what changed since the previous monitor run
+    QMultiHash<quint64, ExecutablePage> *currentHashes =
+            new QMultiHash<quint64, ExecutablePage>(
+                _previousRun ? total.changed : total.hashes);
+    total.changed.clear();
+
+    // The skipped pages remain verified, the others have to prove it again
+    MonitorState state;
+    if (monitor) {
+        if (_previousRun) {
+            QSet<quint64>::const_iterator it, e = _previousRun->verified.end();
+            for (it = _previousRun->verified.begin(); it != e; ++it)
+                if (total.hashes.contains(*it) && !currentHashes->contains(*it))
+                    state.verified.insert(*it);
         }
+        state.pages = total.hashes;
+        state.modules = currentModules;
+        _previousRun = 0;
+    }
+    total.hashes.clear();
+
+    // Report the hidden pages in address order
+    QMap<quint64, HiddenPage>::const_iterator it, e = total.hiddenPages.end();
+    for (it = total.hiddenPages.begin(); it != e; ++it) {
+        const HiddenPage& page = it.value();
+        Console::out()
+                << "\r" << Console::color(ctWarningLight)
+                << "WARNING:" << Console::color(ctReset)
+                << " Detected hidden code page @ "
+                << Console::color(ctAddress) << "0x" << hex << page.address << dec
+                << Console::color(ctReset)
+                << " (Flags: ";
+        if (page.ptEntries.isWriteable()) {
+            Console::out()
+                    << Console::color(ctError) << 'W'
+                    << Console::color(ctReset);
+        }
+        else
+            Console::out() << ' ';
+        if (page.ptEntries.isSupervisor()) {
+            Console::out()
+                    << Console::color(ctNumber) << 'S'
+                    << Console::color(ctReset);
+        }
+        else
+            Console::out() << ' ';
+        Console::out() << ") (Size: 0x"
+                       << hex << page.size << dec
+                       << ")"
+                       << endl;
+
+        Console::out()
+                << Console::color(ctDim)
+                << "PGD: 0x" << hex << page.ptEntries.pgd
+                << ", PUD: 0x" << hex << page.ptEntries.pud
+                << ", PMD: 0x" << hex << page.ptEntries.pmd
+                << ", PTE: 0x" << hex << page.ptEntries.pte
+                << dec << Console::color(ctReset) << endl;
     }
 
     // Finish
@@ -3059,37 +3754,53 @@ void Detect::hiddenCode(int index)
 
     // Print Stats
     Console::out() << "\r\nProcessed " << Console::color(ctWarningLight)
-                   << processed_pages << Console::color(ctReset)
+                   << total.processed_pages << Console::color(ctReset)
                    << " pages in " << elapsedTime() << " min" << endl;
     Console::out() << "\t Found " << Console::color(ctNumber)
-                   << nonexecutable_pages << Console::color(ctReset)
+                   << total.nonexecutable_pages << Console::color(ctReset)
                    << " non-executable pages." << endl;
     Console::out() << "\t Found " << Console::color(ctNumber)
-                   << nonsupervisor_pages << Console::color(ctReset)
+                   << total.nonsupervisor_pages << Console::color(ctReset)
                    << " executable non-supervisor pages." << endl;
     Console::out() << "\t Found " << Console::color(ctNumber)
-                   << executeable_pages << Console::color(ctReset)
+                   << total.executeable_pages << Console::color(ctReset)
                    << " executable supervisor pages." << endl;
     Console::out() << "\t Found " << Console::color(ctNumber)
-                   << vmap_pages << Console::color(ctReset)
+                   << total.vmap_pages << Console::color(ctReset)
                    << " vmapped pages." << endl;
     Console::out() << "\t Found " << Console::color(ctNumber)
-                   << lazy_pages << Console::color(ctReset)
+                   << total.lazy_pages << Console::color(ctReset)
                    << " not yet unmapped pages." << endl;
     Console::out() << "\t Detected " << Console::color(ctError)
-                   << hidden_pages << Console::color(ctReset) << " hidden pages.\n" << endl;
+                   << total.hidden_pages << Console::color(ctReset) << " hidden pages.\n" << endl;
+    if (monitor) {
+        Console::out() << "\t Skipped " << Console::color(ctNumber)
+                       << total.unchanged_pages << Console::color(ctReset)
+                       << " unchanged pages, verifying " << Console::color(ctNumber)
+                       << currentHashes->size() << Console::color(ctReset)
+                       << " changed pages." << endl;
+    }
 
     // Verify hashes
-    PageVerifier pageVerifier = PageVerifier(_sym);
-    pageVerifier.verifyHashes(currentHashes);
+    PageVerifier pageVerifier(_sym, index, &_modules);
+    pageVerifier.verifyHashes(currentHashes, monitor ? &state.verified : 0);
 
     delete currentHashes;
 
+    if (monitor)
+        MonitorStates->insert(dump, state);
+
     pageVerifier.verifyParavirtFuncs();
 
     // Verify function pointers?
     if (_sym.memDumps().at(index)->map())
         verifyFunctionPointers(_sym.memDumps().at(index)->map());
+
+    if (monitor) {
+        Console::out() << "\r\nMonitor check took " << Console::color(ctNumber)
+                       << checkTimer.elapsed() << Console::color(ctReset)
+                       << " ms." << endl;
+    }
 }
 
 void PageVerifier::operationProgress(){}
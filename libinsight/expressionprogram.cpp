@@ -0,0 +1,228 @@
+#include <insight/expressionprogram.h>
+#include <insight/astexpression.h>
+#include <QVarLengthArray>
+#include "expressionevalexception.h"
+
+
+ExpressionProgram::ExpressionProgram(const ASTExpression *expr)
+    : _depth(0), _maxDepth(0)
+{
+    compile(expr);
+}
+
+
+void ExpressionProgram::clear()
+{
+    _code.clear();
+    _constants.clear();
+    _variables.clear();
+    _depth = _maxDepth = 0;
+}
+
+
+void ExpressionProgram::compile(const ASTExpression *expr)
+{
+    clear();
+    if (!expr)
+        return;
+
+    compileRek(expr);
+    assert(_depth == 1);
+
+    _code.squeeze();
+    _constants.squeeze();
+    _variables.squeeze();
+}
+
+
+void ExpressionProgram::compileRek(const ASTExpression *expr)
+{
+    switch (expr->type()) {
+    case etVariable:
+        addInstruction(opVariable, 0, _variables.size());
+        _variables.append(dynamic_cast<const ASTVariableExpression*>(expr));
+        break;
+
+    case etUnaryDec:
+    case etUnaryInc:
+    case etUnaryStar:
+    case etUnaryAmp:
+    case etUnaryMinus:
+    case etUnaryInv:
+    case etUnaryNot: {
+        const ASTUnaryExpression* u =
+                dynamic_cast<const ASTUnaryExpression*>(expr);
+        if (!u->child()) {
+            addConstant(ExpressionResult());
+            break;
+        }
+        compileRek(u->child());
+        // The star operator reads from memory and cannot be folded
+        if (u->type() != etUnaryStar && lastIsConst(1)) {
+            try {
+                ExpressionResult res =
+                        ASTUnaryExpression::evaluate(u->type(),
+                                                     _constants.last());
+                _code.pop_back();
+                _constants.pop_back();
+                --_depth;
+                addConstant(res);
+                break;
+            }
+            catch (ExpressionEvalException&) {
+                // Leave it to the evaluation to report the error
+            }
+        }
+        addInstruction(opUnary, u->type());
+        break;
+    }
+
+    case etLogicalOr:
+    case etLogicalAnd:
+    case etInclusiveOr:
+    case etExclusiveOr:
+    case etAnd:
+    case etEquality:
+    case etUnequality:
+    case etRelationalGE:
+    case etRelationalGT:
+    case etRelationalLE:
+    case etRelationalLT:
+    case etShiftLeft:
+    case etShiftRight:
+    case etAdditivePlus:
+    case etAdditiveMinus:
+    case etMultiplicativeMult:
+    case etMultiplicativeDiv:
+    case etMultiplicativeMod: {
+        const ASTBinaryExpression* b =
+                dynamic_cast<const ASTBinaryExpression*>(expr);
+        if (!b->left() || !b->right()) {
+            addConstant(ExpressionResult());
+            break;
+        }
+        compileRek(b->left());
+        compileRek(b->right());
+        if (!lastIsConst(1)) {
+            addInstruction(opBinary, b->type());
+            break;
+        }
+
+        // Never fold a division by zero, the evaluation has to trap it
+        const ExpressionResult& rr = _constants.last();
+        bool divByZero = (b->type() == etMultiplicativeDiv ||
+                          b->type() == etMultiplicativeMod) &&
+                (rr.size & esInteger) && !rr.uvalue();
+
+        if (lastIsConst(2) && !divByZero) {
+            try {
+                int n = _constants.size();
+                ExpressionResult res =
+                        ASTBinaryExpression::evaluate(b->type(),
+                                                      _constants[n - 2],
+                                                      _constants[n - 1]);
+                _code.resize(_code.size() - 2);
+                _constants.resize(n - 2);
+                _depth -= 2;
+                addConstant(res);
+                break;
+            }
+            catch (ExpressionEvalException&) {
+                // Leave it to the evaluation to report the error
+            }
+        }
+
+        // Merge the constant right-hand operand into the operator
+        Instruction& last = _code.last();
+        last.op = opBinaryConst;
+        last.exprType = b->type();
+        --_depth;
+        break;
+    }
+
+    default:
+        // All remaining expressions do not depend on an instance
+        addConstant(expr->result(0));
+        break;
+    }
+}
+
+
+void ExpressionProgram::addInstruction(OpCode op, int exprType, int arg)
+{
+    Instruction i;
+    i.op = op;
+    i.exprType = exprType;
+    i.arg = arg;
+    _code.append(i);
+
+    if (op == opConst || op == opVariable) {
+        if (++_depth > _maxDepth)
+            _maxDepth = _depth;
+    }
+    else if (op == opBinary)
+        --_depth;
+}
+
+
+void ExpressionProgram::addConstant(const ExpressionResult &value)
+{
+    addInstruction(opConst, 0, _constants.size());
+    _constants.append(value);
+}
+
+
+bool ExpressionProgram::lastIsConst(int n) const
+{
+    // Constants are always appended to the pool in the order they are pushed,
+    // so the n last instructions refer to the n last pool entries
+    if (_code.size() < n)
+        return false;
+    for (int i = _code.size() - n; i < _code.size(); ++i)
+        if (_code[i].op != opConst)
+            return false;
+    return true;
+}
+
+
+ExpressionResult ExpressionProgram::result(const Instance *inst) const
+{
+    if (_code.isEmpty())
+        return ExpressionResult();
+
+    QVarLengthArray<ExpressionResult, 8> stack(_maxDepth);
+    ExpressionResult* top = stack.data() - 1;
+    const Instruction* ip = _code.constData();
+    const Instruction* end = ip + _code.size();
+
+    for (; ip != end; ++ip) {
+        switch (ip->op) {
+        case opConst:
+            *(++top) = _constants[ip->arg];
+            break;
+
+        case opVariable:
+            *(++top) = _variables[ip->arg]->result(inst);
+            break;
+
+        case opUnary:
+            *top = ASTUnaryExpression::evaluate(
+                        (ExpressionType)ip->exprType, *top, inst);
+            break;
+
+        case opBinary:
+            --top;
+            *top = ASTBinaryExpression::evaluate(
+                        (ExpressionType)ip->exprType, top[0], top[1]);
+            break;
+
+        case opBinaryConst:
+            *top = ASTBinaryExpression::evaluate(
+                        (ExpressionType)ip->exprType, *top,
+                        _constants[ip->arg]);
+            break;
+        }
+    }
+
+    return stack[0];
+}
@@ -33,19 +33,19 @@ QString FuncParam::prettyName(const QString &varName) const
     const FuncPointer *fp = dynamic_cast<const FuncPointer*>(
                 refTypeDeep(BaseType::trAnyButTypedef));
     if (fp)
-        return fp->prettyName(_name, dynamic_cast<const RefBaseType*>(t));
+        return fp->prettyName(name(), dynamic_cast<const RefBaseType*>(t));
     else if (t)
-        return t->prettyName(_name);
+        return t->prettyName(name());
     else if (!_refTypeId)
-        return _name.isEmpty() ?
-                    QString("void") : QString("void %2").arg(_name);
+        return name().isEmpty() ?
+                    QString("void") : QString("void %2").arg(name());
     else
-        return _name.isEmpty() ?
+        return name().isEmpty() ?
                     QString("(unresolved type 0x%1) %2")
                         .arg((uint)_refTypeId, 0, 16) :
                     QString("(unresolved type 0x%1) %2")
                         .arg((uint)_refTypeId, 0, 16)
-                        .arg(_name);
+                        .arg(name());
 }
 
 
@@ -53,7 +53,7 @@ Instance FuncParam::toInstance(size_t address,
 		VirtualMemory* vmem, const Instance* parent,
 		int resolveTypes) const
 {
-	return createRefInstance(address, vmem, _name,
+	return createRefInstance(address, vmem, name(),
 			parent ? parent->parentNameComponents() : QStringList(),
 			resolveTypes);
 }
@@ -44,12 +44,12 @@ QString Function::prettyName(const QString &varName) const
 	}
 	if (_refTypeId) {
 		if (refType())
-			func = refType()->prettyName(_name);
+			func = refType()->prettyName(name());
 		else
-			func = QString("(unresolved type 0x%1) ").arg(_refTypeId, 0, 16) + _name;
+			func = QString("(unresolved type 0x%1) ").arg(_refTypeId, 0, 16) + name();
 	}
 	else
-		func = "void " + _name;
+		func = "void " + name();
 	return func + "(" + param + ")";
 }
 
@@ -70,7 +70,7 @@ Instance Function::toInstance(size_t address, VirtualMemory *vmem,
     Q_UNUSED(resolveTypes);
     Q_UNUSED(maxPtrDeref);
     Q_UNUSED(derefCount);
-    Instance inst(_pcLow, this, _name, QStringList(), vmem, _id, Instance::orBaseType);
+    Instance inst(_pcLow, this, name(), QStringList(), vmem, _id, Instance::orBaseType);
     return inst;
 }
 
@@ -0,0 +1,160 @@
+#ifndef ADDRESSPROTOTYPE_H
+#define ADDRESSPROTOTYPE_H
+
+#include <QObject>
+#include <QScriptable>
+#include <QScriptValue>
+#include <QMetaType>
+
+class QScriptEngine;
+class QScriptContext;
+
+namespace js
+{
+extern const char* address;
+}
+
+/**
+ * A 64-bit virtual address that is passed to the QtScript environment as a
+ * native object instead of a hex-encoded string.
+ */
+struct ScriptAddress
+{
+    ScriptAddress(quint64 value = 0) : value(value) {}
+    quint64 value;
+};
+
+Q_DECLARE_METATYPE(ScriptAddress)
+
+
+/**
+ * This class is the prototype for script objects of type ScriptAddress. It
+ * allows to do 64-bit address arithmetic within the scripting environment
+ * without converting the addresses from and to hex strings.
+ *
+ * New Address objects can be constructed from a hex string, a number, another
+ * Address object, or from the 32 most and least significant bits:
+ * \code
+ * var a = new Address("ffffffff81a0d020");
+ * var b = new Address(0xffffffff, 0x81a0d020);
+ * var c = a.Add(0x40).And(~0xfff);
+ * print(c + " " + a.Diff(b) + " " + a.Equals(b));
+ * \endcode
+ *
+ * All methods that expect an address or offset as argument accept the same
+ * kinds of values as the constructor. The methods never modify the callee
+ * but return a new Address object.
+ *
+ * \note JavaScript compares objects by reference, so use Equals() or
+ * Compare() instead of the \c == and \c < operators.
+ *
+ * \sa InstancePrototype::AddressValue()
+ */
+class AddressPrototype : public QObject, protected QScriptable
+{
+    Q_OBJECT
+
+public:
+    /**
+     * Constructor
+     * @param parent parent object, defaults to 0
+     */
+    AddressPrototype(QObject *parent = 0);
+
+    /**
+     * Registers the ScriptAddress type with engine \a eng, using this object
+     * as prototype.
+     * @param eng the script engine
+     * @return the constructor function for Address objects
+     */
+    QScriptValue registerWith(QScriptEngine* eng);
+
+    /**
+     * Converts \a val to an address. \a val may either be an Address object,
+     * a number, or a string in hex format with an optional "0x" prefix.
+     * @param val the value to convert
+     * @param ok returns \c true if the conversion succeeded, \c false
+     * otherwise
+     * @return the converted address
+     */
+    static quint64 valueFromScriptValue(const QScriptValue& val, bool* ok = 0);
+
+    static QScriptValue toScriptValue(QScriptEngine* eng,
+                                      const ScriptAddress& addr);
+    static void fromScriptValue(const QScriptValue& obj, ScriptAddress& addr);
+
+public slots:
+    /**
+     * Returns a new Address that is the sum of this address and \a offset.
+     */
+    ScriptAddress Add(const QScriptValue& offset) const;
+
+    /**
+     * Returns a new Address that is this address minus \a offset.
+     */
+    ScriptAddress Sub(const QScriptValue& offset) const;
+
+    /**
+     * Returns the bitwise AND of this address and \a mask. A 32-bit negative
+     * \a mask is sign-extended, so <tt>a.And(~0xfff)</tt> yields the start of
+     * the page.
+     */
+    ScriptAddress And(const QScriptValue& mask) const;
+
+    /**
+     * Returns the bitwise OR of this address and \a mask.
+     */
+    ScriptAddress Or(const QScriptValue& mask) const;
+
+    /**
+     * Returns the signed distance between this address and \a other. The
+     * result is exact as long as it is smaller than 2^53.
+     */
+    double Diff(const QScriptValue& other) const;
+
+    /**
+     * Compares this address to \a other.
+     * @return -1 if this address is smaller, 0 if they are equal, 1 if this
+     * address is greater than \a other
+     */
+    int Compare(const QScriptValue& other) const;
+
+    /**
+     * Returns \c true if this address equals \a other, \c false otherwise.
+     */
+    bool Equals(const QScriptValue& other) const;
+
+    /**
+     * Returns \c true if this address is zero.
+     */
+    bool IsNull() const;
+
+    /**
+     * Returns the most significant 32 bits of this address.
+     */
+    quint32 High() const;
+
+    /**
+     * Returns the least significant 32 bits of this address.
+     */
+    quint32 Low() const;
+
+    /**
+     * Returns this address as a number. Addresses greater than 2^53 lose
+     * precision.
+     */
+    double toNumber() const;
+
+    /**
+     * Returns this address as a string.
+     * @param base the base to use, defaults to 16
+     */
+    QString toString(int base = 16) const;
+
+private:
+    quint64 thisValue() const;
+    quint64 argValue(const QScriptValue& val) const;
+    static QScriptValue construct(QScriptContext* ctx, QScriptEngine* eng);
+};
+
+#endif // ADDRESSPROTOTYPE_H
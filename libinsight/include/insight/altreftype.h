@@ -5,6 +5,7 @@
 #include <QXmlStreamWriter>
 #include "instance_def.h"
 #include "kernelsymbolstream.h"
+#include "expressionprogram.h"
 
 class SymFactory;
 class ASTExpression;
@@ -90,14 +91,20 @@ public:
     inline void setExpr(const ASTExpression* expr)
     {
         _expr = expr;
-        updateVarExpr();
+        updateExpr();
     }
 
+    /**
+     * Returns the compiled form of expr() that is used by toInstance().
+     */
+    inline const ExpressionProgram& program() const { return _program; }
+
 private:
-    void updateVarExpr();
+    void updateExpr();
     int _id;
     const ASTExpression* _expr;
     VarExprList _varExpr;
+    ExpressionProgram _program;
 };
 
 typedef QList<AltRefType> AltRefTypeList;
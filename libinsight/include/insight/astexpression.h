@@ -585,6 +585,18 @@ public:
     static ExprResultSizes binaryExprSize(const ExpressionResult& r1,
                                                const ExpressionResult& r2);
 
+    /**
+     * Applies the binary operator \a type to the operands \a lr and \a rr.
+     * This is what result() does after evaluating both children.
+     * @param type the operator, e.g. etAdditivePlus
+     * @param lr result of the left-hand operand
+     * @param rr result of the right-hand operand
+     * @return the combined result
+     */
+    static ExpressionResult evaluate(ExpressionType type,
+                                     const ExpressionResult& lr,
+                                     const ExpressionResult& rr);
+
     virtual void readFrom(KernelSymbolStream &in, SymFactory* factory);
     virtual void writeTo(KernelSymbolStream &out) const;
 
@@ -678,6 +690,17 @@ public:
 
     virtual ExpressionResult result(const Instance* inst = 0) const;
 
+    /**
+     * Applies the unary operator \a type to the operand \a res. This is what
+     * result() does after evaluating its child.
+     * @param type the operator, e.g. etUnaryMinus
+     * @param res result of the operand
+     * @param inst the instance to read from for etUnaryStar
+     * @return the result
+     */
+    static ExpressionResult evaluate(ExpressionType type, ExpressionResult res,
+                                     const Instance* inst = 0);
+
     inline virtual ASTExpression* copy(ASTExpressionList& list,
                                        bool recursive = true) const
     {
@@ -19,7 +19,8 @@ enum MuxerChannels {
 /// Binary data that can be retrieved from the InSight daemon
 enum BinaryData {
     bdMemDumpList,
-    bdInstance
+    bdInstance,
+    bdScriptBatch
 };
 
 /// File to save the history to, relative to home directory
@@ -34,4 +35,10 @@ extern const char* mt_log_file;
 /// Socket to communicate between daemon and CLI tool
 extern const char* mt_sock_file;
 
+/// Directory for cached type evaluation results of kernel source files
+extern const char* mt_source_cache_dir;
+
+/// Directory for cached reference page hashes of kernel modules
+extern const char* mt_refhash_cache_dir;
+
 #endif /* CONSTDEFS_H_ */
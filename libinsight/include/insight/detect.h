@@ -3,9 +3,24 @@
 
 #include "kernelsymbols.h"
 #include "function.h"
+#include "virtualmemory.h"
+#include "moduleindex.h"
+#include "memorymap.h"
+
+#include <QThread>
+#include <QAtomicInt>
+#include <QMutex>
+#include <QMap>
+#include <QHash>
+#include <QSet>
+#include <QVector>
+#include <QDir>
+#include <QDateTime>
 
 #include <elf.h>
 
+class MemoryDump;
+
 class Detect : public LongOperation
 {
 public:
@@ -26,21 +41,29 @@ public:
         UNKOWN
     };
 
+    /**
+     * An executable page found by hiddenCode(). Only the hash of the page is
+     * kept, the content is read again by PageVerifier::loadPageData() if the
+     * hash does not match the expected one.
+     */
     struct ExecutablePage
     {
         ExecutablePage() : address(0), type(UNDEFINED), module(""),
-                           hash(), data() {}
+                           hash(), size(0), physAddress(0), data() {}
 
         ExecutablePage(quint64 address, PageType type, QString module,
-                       QByteArray hash, QByteArray data) :
+                       QByteArray hash, quint64 size, quint64 physAddress) :
                         address(address), type(type), module(module),
-                        hash(hash), data(data) {}
+                        hash(hash), size(size), physAddress(physAddress),
+                        data() {}
 
         quint64 address;
         PageType type;
         QString module;
         QByteArray hash;
-        QByteArray data;
+        quint64 size;         ///< size of the page in bytes
+        quint64 physAddress;  ///< physical address of the page
+        QByteArray data;      ///< page content, empty unless loaded
     };
 
     struct FunctionPointerStats
@@ -48,7 +71,7 @@ public:
         FunctionPointerStats() : total(0), userlandPointer(0), defaultValue(0),
             pointToKernelFunction(0), pointToModule(0),
             invalidAddress(0), pointToNXMemory(0), pointToPhysical(0),
-            maliciousUnion(0), malicious(0) {}
+            maliciousUnion(0), malicious(0), unreadable(0) {}
 
         // Convenient
         quint64 total;
@@ -70,6 +93,14 @@ public:
         quint64 maliciousUnion;
         // Those are malicious.
         quint64 malicious;
+
+        // The pointer or its target could not be read
+        quint64 unreadable;
+
+        /**
+         * Adds the counters of \a other to this one.
+         */
+        void merge(const FunctionPointerStats& other);
     };
 
     struct FunctionInfo
@@ -87,13 +118,196 @@ public:
         static QString no_function;
     };
 
+    /// An executable page that could not be attributed to any known region
+    struct HiddenPage
+    {
+        HiddenPage() : address(0), size(0) {}
+        HiddenPage(quint64 address, quint64 size, const PageTableEntries& pte)
+            : address(address), size(size), ptEntries(pte) {}
+
+        quint64 address;
+        quint64 size;
+        PageTableEntries ptEntries;
+    };
+
+    /// Results and statistics of scanning one or more address ranges
+    struct ScanResult
+    {
+        ScanResult() : processed_pages(0), executeable_pages(0),
+            nonexecutable_pages(0), nonsupervisor_pages(0), hidden_pages(0),
+            lazy_pages(0), vmap_pages(0), unchanged_pages(0),
+            readError(false) {}
+
+        /**
+         * Adds the statistics and pages of \a other to this result.
+         */
+        void merge(const ScanResult& other);
+
+        quint64 processed_pages;
+        quint64 executeable_pages;
+        quint64 nonexecutable_pages;
+        quint64 nonsupervisor_pages;
+        quint64 hidden_pages;
+        quint64 lazy_pages;
+        quint64 vmap_pages;
+        quint64 unchanged_pages;
+        bool readError;
+        QMultiHash<quint64, ExecutablePage> hashes;
+        /// pages that changed since the previous monitor run
+        QMultiHash<quint64, ExecutablePage> changed;
+        QMap<quint64, HiddenPage> hiddenPages;
+    };
+
+    /// An area of the kernel's vmalloc allocator, see inVmap()
+    struct VmapArea
+    {
+        VmapArea(quint64 start = 0, quint64 end = 0, quint64 flags = 0)
+            : start(start), end(end), flags(flags) {}
+
+        inline bool operator<(const VmapArea& other) const
+        {
+            return start < other.start;
+        }
+
+        quint64 start;  ///< first address (\c va_start)
+        quint64 end;    ///< end address (\c va_end), considered part of the area
+        quint64 flags;  ///< flags of the \c vmap_area
+    };
+
     Detect(KernelSymbols &sym);
     ~Detect();
 
-    void hiddenCode(int index);
+    /**
+     * Scans memory dump \a index for executable pages, reports pages that
+     * cannot be attributed to the kernel or a module, and verifies the
+     * pages and function pointers against the kernel and module images.
+     *
+     * In monitor mode, the digests and module table of the previous monitor
+     * run on the same memory dump are kept. Every page is classified again,
+     * but a page that passed verification and whose physical address, digest
+     * and classification did not change since then is not verified again.
+     * Pages are only skipped if the digest is cryptographic, see
+     * PageDigest::isCryptographic().
+     * @param index the memory dump index
+     * @param monitor enables monitor mode
+     * \sa resetMonitor()
+     */
+    void hiddenCode(int index, bool monitor = false);
+
+    /**
+     * Discards the state kept by hiddenCode() in monitor mode, so that the
+     * next monitor run checks all pages.
+     * @param dump the memory dump to discard the state of, or null to discard
+     * the state of all dumps
+     */
+    static void resetMonitor(const MemoryDump* dump = 0);
+
+    /**
+     * Uses \a modules and \a vmapAreas to classify the pages found by
+     * scanAddressSpace() instead of reading the kernel's \c modules list and
+     * vmap areas, e.g., for testing.
+     * @param modules the loaded modules
+     * @param vmapAreas the vmap areas
+     */
+    void setSnapshot(const ModuleIndex& modules,
+                     const QList<VmapArea>& vmapAreas);
+
+    /**
+     * Scans the kernel address space of \a vmem in parallel for executable
+     * supervisor pages. Each page is classified as kernel code or data,
+     * module code, vmap page or hidden page, based on the System.map and
+     * on the snapshot of the modules and vmap areas taken by hiddenCode()
+     * or passed to setSnapshot().
+     * @param vmem the virtual memory to scan
+     * @param res returns the pages found and the statistics
+     */
+    void scanAddressSpace(VirtualMemory *vmem, ScanResult *res);
+
+    /**
+     * Verifies the function pointers \a funcPointers of nodes of \a map in
+     * parallel. Pointers that cannot be read are counted as unreadable.
+     * hiddenCode() passes the function pointers found while building \a map,
+     * but they can be given explicitly, e.g., for testing.
+     * @param map the memory map the nodes belong to
+     * @param funcPointers the function pointers to verify
+     * @return the statistics of the verified pointers
+     */
+    FunctionPointerStats checkFunctionPointers(
+            MemoryMap *map, const QList<FuncPointersInNode> &funcPointers);
+
     void operationProgress();
 
 private:
+    /// An address range [first, last] to be scanned by a ScanThread
+    struct ScanRange
+    {
+        ScanRange(quint64 first = 0, quint64 last = 0)
+            : first(first), last(last) {}
+        quint64 first;
+        quint64 last;
+    };
+
+    /// Address range [start, end) of a kernel function
+    struct FunctionRange
+    {
+        FunctionRange(quint64 start = 0, quint64 end = 0,
+                      const Function* function = 0,
+                      const QString& name = QString())
+            : start(start), end(end), function(function), name(name) {}
+
+        inline bool operator<(const FunctionRange& other) const
+        {
+            return start < other.start;
+        }
+
+        quint64 start;
+        quint64 end;
+        const Function* function;  ///< function from the debugging symbols
+        QString name;              ///< name from the System.map
+    };
+
+    /**
+     * Helper class that scans the address ranges in Detect::_scanRanges
+     * for executable pages.
+     */
+    class ScanThread : public QThread
+    {
+    public:
+        ScanThread(Detect* detect, VirtualMemory* vmem);
+
+        ScanResult result;
+
+    protected:
+        void run();
+
+    private:
+        Detect* _detect;
+        VirtualMemory* _vmem;
+    };
+
+    friend class ScanThread;
+
+    /**
+     * Helper class that verifies the function pointers of the nodes in
+     * Detect::_funcPointers.
+     */
+    class FuncPointerThread : public QThread
+    {
+    public:
+        FuncPointerThread(Detect* detect, MemoryMap* map);
+
+        FunctionPointerStats stats;
+
+    protected:
+        void run();
+
+    private:
+        Detect* _detect;
+        MemoryMap* _map;
+    };
+
+    friend class FuncPointerThread;
+
     quint64 _kernel_code_begin;
     quint64 _kernel_code_end;
     quint64 _kernel_data_exec_end;
@@ -104,20 +318,51 @@ private:
     quint64 _final_page;
 
     QString _current_file;
-    QMultiHash<quint64, FunctionInfo> *Functions;
+    QList<FunctionRange> _functions;
+    bool _functionsBuilt;
 
 
     const KernelSymbols &_sym;
     quint64 _current_index;
 
-    static QMultiHash<quint64, ExecutablePage> *ExecutablePages;
+    /// State kept between the monitor runs on one memory dump
+    struct MonitorState
+    {
+        QMultiHash<quint64, ExecutablePage> pages; ///< pages of the last run
+        QSet<quint64> verified;          ///< addresses of verified pages
+        QHash<QString, quint64> modules; ///< module names and core addresses
+    };
 
-    quint64 inVmap(quint64 address, VirtualMemory *vmem);
+    static QHash<const MemoryDump*, MonitorState> *MonitorStates;
+
+    const MonitorState *_previousRun;
+    bool _modulesUnchanged;
+
+    ModuleIndex _modules;
+    QList<VmapArea> _vmapAreas;
+    QList<ScanRange> _scanRanges;
+    QAtomicInt _nextScanRange;
+    QList<FuncPointersInNode> _funcPointers;
+    QAtomicInt _nextFuncPointer;
+    QMutex _outputMutex;
+
+    void takeSnapshot(VirtualMemory *vmem);
+    void buildVmapIndex(VirtualMemory *vmem);
+    quint64 inVmap(quint64 address) const;
+    bool findModuleOfPage(quint64 address, VirtualMemory *vmem, QString *name);
+    void addExecutablePage(ScanResult *res, const ExecutablePage &page) const;
+    void scanPages(VirtualMemory *vmem, const ScanRange &range, ScanResult *res);
+    void scanRanges(VirtualMemory *vmem, ScanResult *res);
     void buildFunctionList(MemoryMap *map);
+    const FunctionRange *functionAt(quint64 address) const;
     bool pointsToKernelFunction(MemoryMap *map, Instance &funcPointer);
-    bool pointsToModuleCode(Instance &functionPointer);
+    bool pointsToModuleCode(MemoryMap *map, Instance &functionPointer);
+    Instance funcPointerAt(const Instance &node,
+                           const VariableTypeContainerList &path,
+                           bool *inUnion) const;
     void verifyFunctionPointer(MemoryMap *map, Instance &funcPointer,
                                FunctionPointerStats &stats, bool inUnion=false);
+    void verifyFuncPointerNodes(MemoryMap *map, FunctionPointerStats *stats);
     void verifyFunctionPointers(MemoryMap *map);
 };
 
@@ -142,22 +387,24 @@ public:
 
     struct elfParseData{
         elfParseData() :
-            fileContent(0), type(Detect::UNDEFINED),
+            fp(0), fileContent(0), fileContentSize(0), type(Detect::UNDEFINED),
             symindex(0), strindex(0),
             textSegment(), dataSegment(), vvarSegment(), dataNosaveSegment(), bssSegment(),
             fentryAddress(0), genericUnrolledAddress(0),
             percpuDataSegment(0), textSegmentData(), textSegmentInitialized(0),
             vvarSegmentData(), dataNosaveSegmentData(), smpOffsets(),
-            jumpTable(), textSegmentContent(), currentModule()
+            jumpTable(), textSegmentContent(), currentModule(),
+            fromCache(false)
         {}
         elfParseData(Instance curMod) :
-            fileContent(0), type(Detect::UNDEFINED),
+            fp(0), fileContent(0), fileContentSize(0), type(Detect::UNDEFINED),
             symindex(0), strindex(0),
             textSegment(), dataSegment(), vvarSegment(), dataNosaveSegment(), bssSegment(),
             fentryAddress(0), genericUnrolledAddress(0),
             percpuDataSegment(0), textSegmentData(), textSegmentInitialized(0),
             vvarSegmentData(), dataNosaveSegmentData(), smpOffsets(),
-            jumpTable(), textSegmentContent(), currentModule(curMod)
+            jumpTable(), textSegmentContent(), currentModule(curMod),
+            fromCache(false)
         {}
         ~elfParseData();
 
@@ -186,11 +433,43 @@ public:
         QByteArray jumpTable;
         QByteArray textSegmentContent;
         Instance currentModule;
-    };
 
-    PageVerifier(const KernelSymbols &sym);
+        // The following is stored in the reference hash cache of a module.
+        // If fromCache is set, only the hashes of textSegmentData are valid
+        // and the ELF file has not been read.
+        bool fromCache;
+        QByteArray jumpState;
+        QHash<QString, quint64> exportedSymbols;
+        QHash<QString, quint64> exportedFunctions;
+        QList<quint64> paravirtJumps;
+        QList<quint64> paravirtCalls;
+
+        // Name indexes that are built on first use, see indexElfSections(),
+        // indexElfSymbols() and findMemAddressOfSegment()
+        QHash<QString, SegmentInfo> sectionIndex;
+        QHash<QString, quint32> symbolIndex;
+        QHash<QString, quint64> memSectionIndex;
+    };
 
-    void verifyHashes(QMultiHash<quint64, Detect::ExecutablePage> *current);
+    /**
+     * Constructor
+     * @param sym the kernel symbols to use
+     * @param index index of the memory dump whose pages are verified; page
+     * content is read from this dump
+     * @param modules index of the loaded modules to share; if it is null or
+     * was built for another memory dump, the verifier builds its own
+     */
+    PageVerifier(const KernelSymbols &sym, int index = 0,
+                 const ModuleIndex *modules = 0);
+
+    /**
+     * Verifies the pages \a current against the kernel and module images.
+     * @param current the pages to verify
+     * @param verified if given, the addresses of all pages that passed the
+     * verification are added to it
+     */
+    void verifyHashes(QMultiHash<quint64, Detect::ExecutablePage> *current,
+                      QSet<quint64> *verified = 0);
     void verifyParavirtFuncs();
 
     void operationProgress();
@@ -198,6 +477,11 @@ public:
 private:
     const KernelSymbols &_sym;
     VirtualMemory *_vmem;
+    const ModuleIndex *_modules;
+    ModuleIndex _ownModules;
+    QDir _refCacheDir;
+    bool _refCacheEnabled;
+    QByteArray _patchState;
 
     const unsigned char * const * ideal_nops;
 
@@ -212,7 +496,27 @@ private:
     static QList<quint64> _paravirtJump;
     static QList<quint64> _paravirtCall;
 
+    /// Digest of the content of a module file, see moduleFileDigest()
+    struct ModuleFileDigest{
+        ModuleFileDigest(): size(-1) {}
+
+        qint64 size;
+        QDateTime modified;
+        QByteArray digest;
+    };
+
+    static QHash<QString, QString> _moduleFiles;
+    static QHash<QString, ModuleFileDigest> _moduleFileDigests;
+
     QString findModuleFile(QString moduleName);
+    QByteArray moduleFileDigest(const QString &fileName);
+    QByteArray jumpLabelState(const Instance &module);
+    const QByteArray& patchState();
+    QString refCacheFileName(QString fileName, const Instance &module,
+                             const QByteArray &jumpState);
+    bool loadCachedModule(const QString &cacheFile, elfParseData &context);
+    void storeCachedModule(const QString &cacheFile, const elfParseData &context);
+    bool parseCachedModule(QString moduleName, elfParseData &context);
     void readFile(QString fileName, elfParseData &context);
     void writeSectionToFile(QString moduleName, quint32 sectionNumber, QByteArray data);
     void writeModuleToFile(QString origFileName, Instance currentModule, char * buffer );
@@ -245,10 +549,75 @@ private:
     void applyTracepoints(SegmentInfo tracePoint, SegmentInfo rodata, elfParseData &context, QByteArray &segmentData);
     void applyJumpEntries(QByteArray &textSegmentContent, PageVerifier::elfParseData &context, quint64 jumpStart = 0, quint64 jumpStop = 0);
 
-    SegmentInfo findElfSegmentWithName(char * elfEhdr, QString sectionName);
+    /// State of a jump entry of the running kernel or module
+    struct JumpEntryState{
+        JumpEntryState(): code(0), key(0), enabled(0) {}
+
+        quint64 code;
+        quint64 key;
+        quint32 enabled;
+    };
+
+    void readJumpEntries(elfParseData &context, quint64 jumpStart,
+                         quint32 first, quint32 last,
+                         QVector<JumpEntryState> &states);
+
+    /**
+     * Helper class that reads a range of jump entries and their keys from
+     * memory, see readJumpEntries().
+     */
+    class JumpEntryThread : public QThread
+    {
+    public:
+        JumpEntryThread(PageVerifier* verifier, elfParseData* context,
+                        quint64 jumpStart, quint32 first, quint32 last,
+                        QVector<JumpEntryState>* states);
+
+        /**
+         * Returns \c true if reading the entries failed, see error().
+         */
+        inline bool failed() const { return _failed; }
+
+        /**
+         * Returns the error that occurred while reading the entries. The
+         * message starts with the class name of the original exception.
+         */
+        inline const GenericException& error() const { return _error; }
+
+    protected:
+        void run();
+
+    private:
+        PageVerifier* _verifier;
+        elfParseData* _context;
+        quint64 _jumpStart;
+        quint32 _first;
+        quint32 _last;
+        QVector<JumpEntryState>* _states;
+        bool _failed;
+        GenericException _error;
+    };
+
+    friend class JumpEntryThread;
+
+    SegmentInfo findElfSegmentWithName(elfParseData &context, QString sectionName);
     Instance findModuleByName(QString moduleName);
     quint64 findElfAddressOfVariable(char * elfEhdr, elfParseData &context, QString symbolName);
 
+    /**
+     * Indexes the sections of the ELF file in \a context by name. The first
+     * section of a name wins, as with a linear search.
+     */
+    void indexElfSections(elfParseData &context);
+
+    /**
+     * Indexes the symbol table of the ELF file in \a context by name. The
+     * index stores the position of the first symbol of a name, so values
+     * changed by relocation are still seen. Requires \c symindex and
+     * \c strindex to be set.
+     */
+    void indexElfSymbols(elfParseData &context);
+
     elfParseData parseKernelModule(QString fileName, Instance currentModule);
     void updateKernelModule(elfParseData &context);
     void loadElfModule(QString moduleName, Instance currentModule);
@@ -256,7 +625,8 @@ private:
     elfParseData parseKernel(QString fileName);
     void loadElfKernel();
 
-    quint64 checkCodePage(QString moduleName, quint32 sectionNumber, Detect::ExecutablePage currentPage);
+    bool loadPageData(Detect::ExecutablePage &page);
+    quint64 checkCodePage(QString moduleName, quint32 sectionNumber, Detect::ExecutablePage &currentPage);
 
     void extractVDSOPage(quint64 address);
 
@@ -13,7 +13,8 @@ enum ErrorCodes {
     ecInvalidArguments    = -7,
     ecCaughtException     = -8,
     ecInvalidId           = -9,
-    ecInvalidExpression   = -10
+    ecInvalidExpression   = -10,
+    ecScriptFailed        = -11
 };
 
 #endif // ERRORCODES_H
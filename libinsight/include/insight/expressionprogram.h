@@ -0,0 +1,100 @@
+#ifndef EXPRESSIONPROGRAM_H
+#define EXPRESSIONPROGRAM_H
+
+#include <QVector>
+#include "expressionresult.h"
+
+class ASTExpression;
+class ASTVariableExpression;
+class Instance;
+
+/**
+ * This class holds an ASTExpression tree compiled into a flat sequence of
+ * stack machine instructions. Evaluating the program with result() yields the
+ * same ExpressionResult as ASTExpression::result(), but without the virtual
+ * calls and the recursion of walking the tree.
+ *
+ * All sub-expressions that do not depend on an instance are folded into
+ * constants when the program is compiled. Binary operators with a constant
+ * right-hand operand are encoded as a single instruction.
+ *
+ * \note The program references the ASTVariableExpression objects of the
+ * compiled tree, so the tree must live as long as the program is used.
+ */
+class ExpressionProgram
+{
+public:
+    /**
+     * Constructor
+     * @param expr the expression to compile
+     * \sa compile()
+     */
+    explicit ExpressionProgram(const ASTExpression* expr = 0);
+
+    /**
+     * Compiles the expression \a expr, replacing any previous program.
+     * @param expr the expression to compile, may be \c null
+     */
+    void compile(const ASTExpression* expr);
+
+    /**
+     * Evaluates the program for instance \a inst.
+     * @param inst the instance to evaluate the variables with
+     * @return the result of the expression, or an undefined result if no
+     * expression was compiled
+     * \sa ASTExpression::result()
+     */
+    ExpressionResult result(const Instance* inst = 0) const;
+
+    /**
+     * Returns \c true if no expression was compiled, \c false otherwise.
+     */
+    inline bool isEmpty() const { return _code.isEmpty(); }
+
+    /**
+     * Returns the number of instructions of this program.
+     */
+    inline int size() const { return _code.size(); }
+
+    /**
+     * Returns \c true if the whole expression was folded into a constant.
+     */
+    inline bool isConstant() const
+    {
+        return _code.size() == 1 && _code[0].op == opConst;
+    }
+
+    /**
+     * Discards the program.
+     */
+    void clear();
+
+private:
+    enum OpCode {
+        opConst,        ///< push constant \a arg
+        opVariable,     ///< push result of variable expression \a arg
+        opUnary,        ///< apply unary operator to top of stack
+        opBinary,       ///< apply binary operator to the two topmost values
+        opBinaryConst   ///< apply binary operator to top and constant \a arg
+    };
+
+    struct Instruction
+    {
+        quint8 op;        ///< the OpCode
+        quint8 exprType;  ///< the ExpressionType of opUnary and opBinary*
+        quint16 arg;      ///< index into the constant or variable pool
+    };
+
+    void compileRek(const ASTExpression* expr);
+    void addInstruction(OpCode op, int exprType = 0, int arg = 0);
+    void addConstant(const ExpressionResult& value);
+    bool lastIsConst(int n) const;
+
+    QVector<Instruction> _code;
+    QVector<ExpressionResult> _constants;
+    QVector<const ASTVariableExpression*> _variables;
+    int _depth;
+    int _maxDepth;
+};
+
+#endif // EXPRESSIONPROGRAM_H
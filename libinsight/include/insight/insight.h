@@ -11,6 +11,7 @@
 #include <QString>
 #include <QStringList>
 #include <QByteArray>
+#include "scriptbatch.h"
 
 // forward declaration
 class QObject;
@@ -112,6 +113,21 @@ public:
      */
     bool memDumpUnload(int index);
 
+    /**
+     * Executes the script file \a fileName for each of the memory dumps
+     * \a memDumps concurrently and returns the results per memory dump.
+     * @param fileName the script file, as seen by the InSight daemon
+     * @param memDumps indices of the memory dumps to execute the script for
+     * @param args additional arguments that are passed to the script, each
+     * element as one argument
+     * @return one result for each memory dump, in the order of \a memDumps
+     * \exception InsightError if the connection to the InSight daemon fails
+     * or the script cannot be executed
+     */
+    ScriptBatchResultList scriptBatch(const QString& fileName,
+                                      const QList<int>& memDumps,
+                                      const QStringList& args = QStringList());
+
     /**
      * Evaluates the given command \a cmd in InSight's shell syntax and returns
      * the error code of the evaluation or zero, if no error occured.
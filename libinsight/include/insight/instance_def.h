@@ -279,6 +279,18 @@ public:
      */
     InstanceList members(KnowledgeSources src = ksAll) const;
 
+    /**
+     * Returns the same instance as <tt>members(src).at(index)</tt>, but
+     * without creating the instances of all other members.
+     * @param index index of the member
+     * @param src selects which sources of knowledge to use when accessing
+     *  members
+     * @return the instance of member \a index, or an empty instance if
+     * \a index is out of bounds
+     * \sa members()
+     */
+    Instance memberAt(int index, KnowledgeSources src = ksAll) const;
+
     /**
      * Gives access to the concrete BaseType of this instance.
      * @return the BaseType of this instance
@@ -1067,6 +1079,8 @@ private:
 
     Instance memberCandidate(const StructuredMember* m, int cndtIndex) const;
 
+    Instance memberAt(const StructuredMember* m, KnowledgeSources src) const;
+
 	bool memberCandidateCompatible(const StructuredMember* m,
 								   int cndtIndex) const;
 
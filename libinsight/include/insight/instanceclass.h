@@ -11,6 +11,7 @@
 #include <QScriptClass>
 #include <QScriptString>
 #include <QStringList>
+#include <QSet>
 #include "instance.h"
 
 namespace js
@@ -26,6 +27,8 @@ extern const char* useCandidates;
 class QScriptContext;
 class QScriptEngine;
 class InstancePrototype;
+class InstanceMembersClass;
+class AddressPrototype;
 class KernelSymbols;
 
 /**
@@ -42,6 +45,21 @@ public:
 
     QScriptValue newInstance(const Instance& inst);
 
+    /**
+     * Returns the constructor function for Address objects.
+     * \sa AddressPrototype
+     */
+    QScriptValue addressConstructor() const;
+
+    /**
+     * Creates an array-like object holding the members of \a inst. The
+     * Instance object of a member is created the first time it is accessed.
+     * @param inst the struct or union instance
+     * @param src the knowledge sources to use, see Instance::memberAt()
+     * @return an object with a \c length property and one property per member
+     */
+    QScriptValue newMemberList(const Instance& inst, KnowledgeSources src);
+
     QueryFlags queryProperty(const QScriptValue& object,
                              const QScriptString& name,
                              QueryFlags flags, uint *id);
@@ -79,6 +97,10 @@ private:
     InstancePrototype* _proto;
     QScriptValue _protoScriptVal;
     QScriptValue _ctor;
+    AddressPrototype* _addrProto;
+    QScriptValue _addrCtor;
+    InstanceMembersClass* _membersClass;
+    QSet<QScriptString> _methodNames;
     const KernelSymbols* _symbols;
 };
 
@@ -13,6 +13,7 @@
 #include <QStringList>
 #include "instance.h"
 #include "genericexception.h"
+#include "addressprototype.h"
 
 class SymFactory;
 
@@ -46,6 +47,13 @@ class SymFactory;
  * The access method for <tt>long long</tt> integer values comes with three
  * getter and three setter methods in the same fashion.
  *
+ * To avoid the conversion from and to hex strings, AddressValue() returns the
+ * address as a native Address object that supports 64-bit arithmetic, see
+ * AddressPrototype. SetAddressValue() accepts such an object, too. Reading
+ * many values at once is cheaper with the bulk accessors ReadUInt32Array(),
+ * ReadUInt64Array() and MemberValues() than with one Instance object per
+ * value.
+ *
  * An Instance object within the scripting environment can be retrieved by
  * passing the name of a global variable to the constructor of an Instance
  * object, for example:
@@ -65,8 +73,9 @@ class SymFactory;
  * \endcode
  *
  * If the instance represents a struct or a union, it members can be accessed
- * using the Members() method. This method returns an array of Instance
- * objects of all members of the callee:
+ * using the Members() method. This method returns an array-like object of
+ * Instance objects of all members of the callee. The Instance object of a
+ * member is only created when it is accessed for the first time:
  * \code
  * // Iterate over all members using an array of Instance objects
  * var members = init.Members();
@@ -167,6 +176,22 @@ public slots:
      */
     void SetAddress(QString addr);
 
+    /**
+     * Retrieves the virtual address of this instance as a native Address
+     * object.
+     * @return the address
+     * \sa Address(), SetAddressValue(), AddressPrototype
+     */
+    ScriptAddress AddressValue() const;
+
+    /**
+     * Sets the virtual address of this instance.
+     * @param addr the new address, either as Address object, number, or
+     * string in hex format
+     * \sa AddressValue(), SetAddress()
+     */
+    void SetAddressValue(const QScriptValue& addr);
+
     /**
      * @return the most significant 32 bits of the address as \c uint32
      * \sa AddressLow(), Address(), SetAddressHigh()
@@ -311,10 +336,22 @@ public slots:
      * \a declaredTypes to \c true.
      * @param declaredTypes selects if candidate types or declared types should
      * be used, where applicable
-     * @return a list of instances of all members
-     * \sa MemberNames(), Member()
+     * @return an array-like object of instances of all members
+     * \sa MemberNames(), Member(), MemberValues()
+     */
+    QScriptValue Members(bool declaredTypes = false) const;
+
+    /**
+     * Reads the values of the members \a names in one call. Integer and
+     * floating point members are returned as numbers, 64-bit integers and
+     * pointers as Address objects. Members of any other type are returned as
+     * Instance objects, non-existing members as \c null. The members are
+     * read with their declared types.
+     * @param names the names of the members to read
+     * @return an array with one value per name in \a names
+     * \sa Members(), AddressValue()
      */
-    InstanceList Members(bool declaredTypes = false) const;
+    QScriptValue MemberValues(const QStringList& names) const;
 
     /**
      * Retrieves the real type of this instance, as defined by
@@ -551,6 +588,36 @@ public slots:
      */
     QString MemberAddress(const QString& name, bool declaredType = false) const;
 
+    /**
+     * Calculates the virtual address of member \a name, if this is a struct or
+     * union.
+     * @param name the name of the member
+     * @param declaredType selects if the candidate type (if it exists) or the
+     * declared types should be used, defaults to \c false
+     * @return the virtual address of member \a name as Address object
+     * \sa MemberAddress()
+     */
+    ScriptAddress MemberAddressValue(const QString& name,
+                                     bool declaredType = false) const;
+
+    /**
+     * Reads \a count consecutive 32-bit unsigned integers, starting at the
+     * address of this instance, regardless of its type.
+     * @param count the number of values to read
+     * @return an array of \a count numbers
+     * \sa ReadUInt64Array()
+     */
+    QScriptValue ReadUInt32Array(int count) const;
+
+    /**
+     * Reads \a count consecutive 64-bit unsigned integers, starting at the
+     * address of this instance, regardless of its type.
+     * @param count the number of values to read
+     * @return an array of \a count Address objects
+     * \sa ReadUInt32Array(), AddressPrototype
+     */
+    QScriptValue ReadUInt64Array(int count) const;
+
     /**
      * This method always returns 4 on 32-bit kernels and 8 on 64-bit kernels.
      * @return the size of pointers for this architecture, in bytes
@@ -849,6 +916,7 @@ public slots:
 
 private:
     inline Instance* thisInstance() const;
+    bool readMemory(const Instance* inst, char* buf, qint64 size) const;
     inline void injectScriptError(const GenericException& e) const;
     inline void injectScriptError(const QString& msg) const;
     KnowledgeSources _knowSrc;
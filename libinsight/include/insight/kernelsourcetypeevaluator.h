@@ -16,6 +16,7 @@ class SymFactory;
 class ASTExpressionEvaluator;
 
 class StructuredMember;
+class TypeUsageLog;
 
 /**
  * Exception class for KernelSourceTypeEvaluator operations
@@ -59,6 +60,25 @@ public:
     virtual int evaluateIntExpression(const ASTNode* node, bool* ok = 0);
     virtual void evaluateMagicNumbers(const ASTNode *node);
 
+    /**
+     * Returns the log that records all changes this evaluator applies to the
+     * SymFactory, or \c null if changes are not recorded.
+     * \sa setUsageLog()
+     */
+    inline TypeUsageLog* usageLog() const
+    {
+        return _usageLog;
+    }
+
+    /**
+     * Sets the log that records all changes this evaluator applies to the
+     * SymFactory. The log is not owned by this evaluator.
+     * @param log the log to use, or \c null to disable recording
+     */
+    inline void setUsageLog(TypeUsageLog* log)
+    {
+        _usageLog = log;
+    }
 
 
 protected:
@@ -72,9 +92,13 @@ private:
             QString &string);
     virtual void evaluateMagicNumbers_initializer(const ASTNode *node, 
             const Structured *structured, QString &string);
+    void magicNumberNotConstant(StructuredMember* member);
+    void magicNumberConstant(StructuredMember* member, qint64 value);
+    void magicNumberConstant(StructuredMember* member, const QString& value);
     
     SymFactory* _factory;
     ASTExpressionEvaluator* _eval;
+    TypeUsageLog* _usageLog;
 };
 
 
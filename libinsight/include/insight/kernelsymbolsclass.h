@@ -13,6 +13,7 @@
 #include <QScriptValue>
 #include <QMultiHash>
 #include "instance.h"
+#include "stringatoms.h"
 
 // Forward declaration
 class InstanceClass;
@@ -190,7 +191,7 @@ private:
 
 	template <class T>
 	QScriptValue listGeneric(QString filter, int index,	const QList<T*>& list,
-			const QMultiHash<QString, T*>& hash,
+			const QMultiHash<StringAtom, T*>& hash,
 			Instance (getInst)(const T*, VirtualMemory*));
 
 	VirtualMemory* vmemFromIndex(int index) const;
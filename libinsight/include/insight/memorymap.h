@@ -275,7 +275,7 @@ public:
     bool isBuilding() const;
 
     /**
-     * Inserts the given name \a name in the static list of names and returns
+     * Inserts the given name \a name in the StringAtoms table and returns
      * a reference to it. This static function was introduced to only hold one
      * copy of any kernel object name in memory, thus saving memory.
      * @param name the name to insert into the static name list
@@ -319,9 +319,6 @@ protected:
     virtual void operationProgress();
 
 private:
-    /// Holds the static list of kernel object names. \sa insertName()
-	static StringSet _names;
-
     /**
      * Checks if a given Instance object already exists in the virtual memory
      * mapping. If an instance at the same address already exists, the
@@ -0,0 +1,141 @@
+#ifndef MODULEINDEX_H
+#define MODULEINDEX_H
+
+#include <QList>
+#include <QHash>
+#include <QString>
+#include "instance.h"
+
+class SymFactory;
+class VirtualMemory;
+
+/**
+ * Information about one loaded kernel module, as read from its
+ * <tt>struct module</tt>.
+ */
+struct ModuleInfo
+{
+    ModuleInfo() : core(0), coreSize(0), coreTextSize(0), init(0), initSize(0),
+        initTextSize(0) {}
+
+    QString name;          ///< module name, without quotes
+    Instance module;       ///< the <tt>struct module</tt> instance
+    quint64 core;          ///< start of the core region (\c module_core)
+    quint64 coreSize;      ///< size of the core region (\c core_size)
+    quint64 coreTextSize;  ///< size of the core text (\c core_text_size)
+    quint64 init;          ///< start of the init region (\c module_init)
+    quint64 initSize;      ///< size of the init region (\c init_size)
+    quint64 initTextSize;  ///< size of the init text (\c init_text_size)
+};
+
+
+/**
+ * This class holds a snapshot of the kernel's \c modules list as a sorted
+ * table of the modules' core and init regions. Looking up the module that
+ * contains an address is a binary search instead of a walk of the linked
+ * list with one member look-up per module.
+ *
+ * The snapshot is taken by build() and is not updated automatically.
+ */
+class ModuleIndex
+{
+public:
+    /// Type of a module region
+    enum RegionType {
+        rtCoreText,  ///< executable part of the core region
+        rtCoreData,  ///< remainder of the core region
+        rtInitText,  ///< executable part of the init region
+        rtInitData   ///< remainder of the init region
+    };
+
+    /**
+     * Constructor, creates an empty index.
+     */
+    ModuleIndex();
+
+    /**
+     * Reads the \c modules list from \a vmem and builds the index. Any
+     * previous contents are discarded.
+     * @param factory the symbol factory to look up \c modules and
+     * <tt>struct module</tt> in
+     * @param vmem the virtual memory to read from
+     * @return the number of modules found
+     */
+    int build(const SymFactory& factory, VirtualMemory* vmem);
+
+    /**
+     * Builds the index from the given \a modules instead of reading the
+     * \c modules list, e.g., for testing. Any previous contents are
+     * discarded.
+     * @param modules the loaded modules
+     * @param vmem the virtual memory the modules belong to
+     * @return the number of modules
+     */
+    int build(const QList<ModuleInfo>& modules, VirtualMemory* vmem);
+
+    /**
+     * Discards all modules.
+     */
+    void clear();
+
+    /**
+     * Returns the virtual memory the index was built for, or null if it is
+     * empty.
+     */
+    inline VirtualMemory* vmem() const { return _vmem; }
+
+    /**
+     * Returns the list of all modules, in list order.
+     */
+    inline const QList<ModuleInfo>& modules() const { return _modules; }
+
+    /**
+     * Finds the module region that contains \a address.
+     * @param address the virtual address to look up
+     * @param type returns the type of the region, if found
+     * @return the module containing \a address, or null if there is none
+     */
+    const ModuleInfo* moduleAt(quint64 address, RegionType* type = 0) const;
+
+    /**
+     * Returns \c true if \a address lies within the core text of any module.
+     */
+    bool inCoreText(quint64 address) const;
+
+    /**
+     * Finds the module called \a name. Dashes and underscores are treated as
+     * equal, as the kernel does.
+     * @param name the module name
+     * @return the module, or null if not found
+     */
+    const ModuleInfo* moduleByName(const QString& name) const;
+
+private:
+    struct Region
+    {
+        Region(quint64 start = 0, quint64 end = 0, RegionType type = rtCoreText,
+               int module = -1)
+            : start(start), end(end), type(type), module(module) {}
+
+        inline bool operator<(const Region& other) const
+        {
+            return start < other.start;
+        }
+
+        quint64 start;    ///< first address
+        quint64 end;      ///< first address after the region
+        RegionType type;
+        int module;       ///< index into _modules
+    };
+
+    static QString normalizedName(const QString& name);
+    void addRegion(quint64 start, quint64 size, RegionType type, int module);
+    void addModule(const ModuleInfo& module);
+
+    VirtualMemory* _vmem;
+    QList<ModuleInfo> _modules;
+    QList<Region> _regions;
+    QHash<QString, int> _byName;
+};
+
+#endif // MODULEINDEX_H
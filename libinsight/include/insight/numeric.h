@@ -55,7 +55,7 @@ public:
      */
     virtual QString prettyName(const QString& varName = QString()) const
     {
-        if (!_name.isEmpty())
+        if (!name().isEmpty())
             return BaseType::prettyName(varName);
 
         QString ret;
@@ -0,0 +1,127 @@
+#ifndef PAGEDIGEST_H
+#define PAGEDIGEST_H
+
+#include <QByteArray>
+
+class QCryptographicHash;
+
+/**
+ * This class computes the digests that are used to detect changes of memory
+ * pages. Its interface follows QCryptographicHash. By default it uses SHA-1,
+ * as the digests of the integrity checks must withstand an attacker who can
+ * choose the page content. The much faster, non-cryptographic 64-bit xxHash
+ * algorithm is available for change detection where this is not the case,
+ * e.g., of data that an attacker cannot write to.
+ *
+ * Digests are returned as binary values of digestSize() bytes and should be
+ * compared as such, not via their hex representation.
+ */
+class PageDigest
+{
+public:
+    /// Available digest algorithms
+    enum Algorithm {
+        daXxHash64,  ///< 64-bit xxHash (XXH64), seed 0
+        daSha1       ///< SHA-1 as computed by QCryptographicHash
+    };
+
+    /**
+     * Constructor
+     * @param algorithm the algorithm to use
+     */
+    PageDigest(Algorithm algorithm = defaultAlgorithm());
+
+    /**
+     * Destructor
+     */
+    ~PageDigest();
+
+    /**
+     * Resets the digest so that a new computation can start.
+     */
+    void reset();
+
+    /**
+     * Adds \a length bytes of \a data to the digest.
+     */
+    void addData(const char* data, int length);
+
+    /**
+     * Adds \a data to the digest.
+     */
+    inline void addData(const QByteArray& data)
+    {
+        addData(data.constData(), data.size());
+    }
+
+    /**
+     * Returns the digest of all data added since the last reset(). This does
+     * not reset the digest.
+     */
+    QByteArray result() const;
+
+    /**
+     * Returns the algorithm this digest uses.
+     */
+    inline Algorithm algorithm() const { return _algorithm; }
+
+    /**
+     * Computes the digest of \a data in one go.
+     * @param data the data to digest
+     * @param algorithm the algorithm to use
+     * @return the binary digest
+     */
+    static QByteArray hash(const QByteArray& data,
+                           Algorithm algorithm = defaultAlgorithm());
+
+    /**
+     * Returns the size in bytes of digests created with \a algorithm.
+     */
+    static int digestSize(Algorithm algorithm);
+
+    /**
+     * Returns \c true if an attacker cannot forge digests of \a algorithm,
+     * i.e., if equal digests prove that the digested data is equal.
+     */
+    static bool isCryptographic(Algorithm algorithm);
+
+    /**
+     * Returns the algorithm used by default, initially daSha1.
+     */
+    static Algorithm defaultAlgorithm();
+
+    /**
+     * Sets the algorithm used by default. This is not thread-safe and must
+     * not be done while digests are being computed.
+     */
+    static void setDefaultAlgorithm(Algorithm algorithm);
+
+    /**
+     * Finds the first byte at which the buffers \a a and \a b differ,
+     * starting at offset \a from. Equal bytes are compared word-wise.
+     * @param a first buffer
+     * @param b second buffer
+     * @param from offset to start at
+     * @param size number of bytes in both buffers
+     * @return offset of the first difference, or \a size if the remainder of
+     * both buffers is equal
+     */
+    static int firstDifference(const char* a, const char* b, int from,
+                               int size);
+
+private:
+    Q_DISABLE_COPY(PageDigest)
+
+    void xxhConsume(const char* data, int length);
+
+    Algorithm _algorithm;
+    QCryptographicHash* _sha1;
+    quint64 _v[4];
+    quint64 _total;
+    char _buf[32];
+    int _bufSize;
+
+    static Algorithm _defaultAlgorithm;
+};
+
+#endif // PAGEDIGEST_H
@@ -0,0 +1,160 @@
+#ifndef RULERESULTCACHE_H
+#define RULERESULTCACHE_H
+
+#include <QCache>
+#include <QMutex>
+#include <QAtomicInt>
+#include "instance_def.h"
+#include "memberlist.h"
+
+class VirtualMemory;
+class BaseType;
+class StructuredMember;
+struct ActiveRule;
+
+/**
+ * Key of a RuleResultCache entry: the address, type and virtual memory of the
+ * instance passed to TypeRuleEngine::match() together with the members
+ * accessed from that instance.
+ */
+struct RuleResultKey
+{
+    /// Maximal number of members a key can hold
+    enum { maxMembers = 4 };
+
+    RuleResultKey() : address(0), vmem(0), type(0), memberCount(0)
+    {
+        for (int i = 0; i < maxMembers; ++i)
+            members[i] = 0;
+    }
+
+    /**
+     * Initializes this key for instance \a inst and the members \a members.
+     * @return \c true if the key could be initialized, \c false if the member
+     * list is too long
+     */
+    bool set(const Instance* inst, const ConstMemberList& members);
+
+    bool operator==(const RuleResultKey& other) const;
+
+    quint64 address;
+    const VirtualMemory* vmem;
+    const BaseType* type;
+    int memberCount;
+    const StructuredMember* members[maxMembers];
+};
+
+uint qHash(const RuleResultKey& key);
+
+
+/**
+ * Value of a RuleResultCache entry, i.e., the output of
+ * TypeRuleEngine::match().
+ */
+struct RuleResult
+{
+    RuleResult() : match(0), priority(0), rule(0), hasInst(false),
+        inheritedNames(-1) {}
+    int match;               ///< the MatchResult flags
+    int priority;            ///< priority of the matched rule
+    const ActiveRule* rule;  ///< the rule that was applied, if any
+    Instance inst;           ///< the resulting instance, if \a hasInst is set
+    bool hasInst;            ///< is \a inst valid?
+    /// No. of leading parent name components of \a inst that are the full
+    /// name of the matched instance, or -1 if they are not derived from it
+    int inheritedNames;
+};
+
+
+/**
+ * This class caches the results of TypeRuleEngine::match() for rules whose
+ * results only depend on the inspected memory. It is bounded in size and can
+ * be used concurrently from several threads. Entries are evicted in the
+ * least-recently-used order.
+ *
+ * Internally the cache is split into several shards, each protected by a lock
+ * of its own, to reduce the lock contention.
+ */
+class RuleResultCache
+{
+public:
+    /**
+     * Constructor, creates a disabled cache.
+     */
+    RuleResultCache();
+
+    /**
+     * Returns the maximal number of entries in the cache. A value of 0 means
+     * that the cache is disabled.
+     */
+    inline int maxSize() const { return _maxSize; }
+
+    /**
+     * Sets the maximal number of entries. Setting a size of 0 disables the
+     * cache and discards all entries.
+     * @param size max. no. of entries
+     */
+    void setMaxSize(int size);
+
+    /**
+     * Returns \c true if the cache is enabled, \c false otherwise.
+     */
+    inline bool isEnabled() const { return _maxSize > 0; }
+
+    /**
+     * Looks up \a key in the cache.
+     * @param key the key to look up
+     * @param result returns the cached result, if found
+     * @return \c true if \a key was found, \c false otherwise
+     */
+    bool find(const RuleResultKey& key, RuleResult* result);
+
+    /**
+     * Inserts \a result for \a key into the cache.
+     * @param key the key
+     * @param result the result to cache
+     */
+    void insert(const RuleResultKey& key, const RuleResult& result);
+
+    /**
+     * Discards all entries, e.g., because the rules or the memory dumps
+     * changed.
+     */
+    void clear();
+
+    /**
+     * Returns the number of successful lookups.
+     */
+    inline int hits() const { return _hits; }
+
+    /**
+     * Returns the number of failed lookups.
+     */
+    inline int misses() const { return _misses; }
+
+    /**
+     * Resets the hit and miss counters.
+     */
+    void resetStatistics();
+
+private:
+    enum { shardCount = 16 };
+
+    struct Shard
+    {
+        QMutex lock;
+        QCache<RuleResultKey, RuleResult> cache;
+    };
+
+    inline Shard& shard(const RuleResultKey& key)
+    {
+        return _shards[qHash(key) % shardCount];
+    }
+
+    Shard _shards[shardCount];
+    int _maxSize;
+    QAtomicInt _hits;
+    QAtomicInt _misses;
+};
+
+#endif // RULERESULTCACHE_H
@@ -0,0 +1,115 @@
+#ifndef SCRIPTBATCH_H
+#define SCRIPTBATCH_H
+
+#include <QThread>
+#include <QMutex>
+#include <QStringList>
+#include <QDataStream>
+#include "typeruleenginecontextprovider.h"
+
+class KernelSymbols;
+class ScriptEngine;
+
+/**
+ * Result of the execution of a script on one memory dump by ScriptBatch.
+ */
+struct ScriptBatchResult
+{
+    ScriptBatchResult() : memDumpIndex(-1), failed(false), duration(0) {}
+    int memDumpIndex;   ///< index of the memory dump
+    QString fileName;   ///< file name of the memory dump
+    QString output;     ///< output of the script's print() and println() calls
+    QString result;     ///< return value of the script, as a string
+    QString error;      ///< error message, if \a failed is set
+    bool failed;        ///< was the script aborted by an error?
+    int duration;       ///< execution time in milliseconds
+};
+
+typedef QList<ScriptBatchResult> ScriptBatchResultList;
+
+/**
+ * Serializes \a result to the stream \a out.
+ */
+QDataStream& operator<<(QDataStream& out, const ScriptBatchResult& result);
+
+/**
+ * Deserializes \a result from the stream \a in.
+ */
+QDataStream& operator>>(QDataStream& in, ScriptBatchResult& result);
+
+
+/**
+ * This class executes one script on several memory dumps concurrently. Every
+ * worker thread uses a ScriptEngine of its own, and the output of the script
+ * is collected per memory dump instead of being written to the console.
+ */
+class ScriptBatch
+{
+public:
+    /**
+     * Constructor
+     * @param symbols the kernel symbols to use
+     * @param knowledgeSources the knowledge sources to use when resolving
+     * members, see KnowledgeSources
+     */
+    ScriptBatch(KernelSymbols* symbols, int knowledgeSources = 0);
+
+    /**
+     * Destructor
+     */
+    ~ScriptBatch();
+
+    /**
+     * Evaluates the script \a code once for each memory dump in
+     * \a memDumpIndices. Up to MultiThreading::maxThreads() scripts are
+     * executed concurrently. The function returns when all scripts have
+     * finished or the user interrupted the operation.
+     * @param code the script code to be evaluated
+     * @param argv a list of parameters that is available as global array
+     *  \c ARGV within the script, the first element should be the file name
+     * @param includePaths list of paths to look for script file includes
+     * @param memDumpIndices the indices of the memory dumps to use
+     * @return one result per memory dump, in the order of \a memDumpIndices
+     */
+    ScriptBatchResultList run(const QString& code, const QStringList& argv,
+                              const QStringList& includePaths,
+                              const QList<int>& memDumpIndices);
+
+private:
+    /**
+     * Helper class that executes the script for one memory dump after the
+     * other.
+     */
+    class WorkerThread: public QThread, public TypeRuleEngineContextProvider
+    {
+    public:
+        WorkerThread(ScriptBatch* batch);
+        ~WorkerThread();
+        void terminateScript();
+
+    protected:
+        void run();
+
+    private:
+        ScriptBatch* _batch;
+        ScriptEngine* _engine;
+        QMutex _engineMutex;
+    };
+
+    friend class WorkerThread;
+
+    void terminateWorkers();
+
+    KernelSymbols* _symbols;
+    int _knowSrc;
+    QString _code;
+    QStringList _argv;
+    QStringList _includePaths;
+    QList<int> _indices;
+    ScriptBatchResultList _results;
+    int _nextIndex;
+    QMutex _indexMutex;
+    QList<WorkerThread*> _threads;
+};
+
+#endif // SCRIPTBATCH_H
@@ -13,6 +13,8 @@
 #include <QScriptSyntaxCheckResult>
 #include <QVector>
 #include <QMutex>
+#include <QHash>
+#include <QScriptProgram>
 
 // Forward declaration
 class QScriptEngine;
@@ -158,6 +160,18 @@ public:
             const QScriptValueList& funcArgs, const QScriptProgram &program,
                                   const QStringList &includePaths, int memDumpIndex = -1);
 
+    /**
+     * Returns a copy of \a program that is private to this engine. The copy
+     * is created on the first call and returned again by subsequent calls, so
+     * that this engine compiles \a program only once. A copy is required
+     * because evaluating the same QScriptProgram by several engines
+     * concurrently causes a segmentation fault, see
+     * https://bugreports.qt-project.org/browse/QTBUG-29246
+     * @param program the program to copy
+     * @return private copy of \a program
+     */
+    QScriptProgram localProgram(const QScriptProgram* program);
+
     /**
      * Checks if the function named \a func is defined within the scope of
      * program \a program. For this check, the programm is evaluated as usual
@@ -221,6 +235,20 @@ public:
      */
     void initScriptEngine();
 
+    /**
+     * Redirects the output of the script functions \c print() and
+     * \c println() to \a buffer instead of the console.
+     * @param buffer the buffer to append the output to, or \c null to write
+     * to the console again
+     */
+    inline void setOutputBuffer(QString* buffer) { _outBuf = buffer; }
+
+    /**
+     * Returns the buffer the script output is redirected to, if any.
+     * \sa setOutputBuffer()
+     */
+    inline QString* outputBuffer() const { return _outBuf; }
+
     /**
      * Gives access to the script engine used internally. This function returns
      * \c null unless initScriptEngine() has been called.
@@ -239,16 +267,19 @@ private:
 	bool _lastEvalFailed;
 	bool _initialized;
 	bool _contextPushed;
+	QHash<const QScriptProgram*, QScriptProgram> _programs;
 	int _knowSrc;
 	int _memDumpIndex;
 	KernelSymbols* _symbols;
+	QString* _outBuf;
 	static QMutex _printMutex;
 
 	void prepareEvaluation(const QStringList &argv, const QStringList &includePaths);
+	void print(QScriptContext* ctx, bool newline);
 
     static QScriptValue scriptGetInstance(QScriptContext* ctx, QScriptEngine* eng, void* arg);
-    static QScriptValue scriptPrint(QScriptContext* ctx, QScriptEngine* eng);
-    static QScriptValue scriptPrintLn(QScriptContext* ctx, QScriptEngine* eng);
+    static QScriptValue scriptPrint(QScriptContext* ctx, QScriptEngine* eng, void* arg);
+    static QScriptValue scriptPrintLn(QScriptContext* ctx, QScriptEngine* eng, void* arg);
     static QScriptValue scriptInclude(QScriptContext *context, QScriptEngine *engine);
 };
 
@@ -0,0 +1,80 @@
+#ifndef STRINGATOMS_H
+#define STRINGATOMS_H
+
+#include <QString>
+
+/// A 32-bit identifier for a string within the StringAtoms table
+typedef quint32 StringAtom;
+
+/**
+ * This static class implements a process-wide, thread-safe table of string
+ * atoms. Each distinct string is stored exactly once and is identified by a
+ * 32-bit StringAtom. Two strings are equal if and only if their atoms are
+ * equal, so comparing names is reduced to comparing integers.
+ *
+ * Atoms are never removed from the table, and the string returned by
+ * string() remains valid for the lifetime of the process.
+ *
+ * The table is used for the names of all Symbol objects, for the name indices
+ * of SymFactory, for MemoryMap::insertName() and for literal name matches in
+ * TypeFilter.
+ */
+class StringAtoms
+{
+public:
+    enum {
+        emptyAtom   = 0,          ///< atom of the empty string
+        invalidAtom = 0xFFFFFFFFU ///< returned by find() for unknown strings
+    };
+
+    /**
+     * Returns the atom for string \a s. If \a s is not yet part of the table,
+     * it is inserted.
+     * @param s the string
+     * @return atom of \a s
+     * \sa find()
+     */
+    static StringAtom atom(const QString& s);
+
+    /**
+     * Returns the atom for string \a s without inserting it into the table.
+     * Use this for lookups of arbitrary strings, e.g., from user input.
+     * @param s the string
+     * @return atom of \a s, if \a s is in the table, \c invalidAtom otherwise
+     * \sa atom()
+     */
+    static StringAtom find(const QString& s);
+
+    /**
+     * Returns the string represented by atom \a a.
+     * @param a the atom
+     * @return the string of \a a, or an empty string if \a a is invalid
+     */
+    static const QString& string(StringAtom a);
+
+    /**
+     * Returns the number of strings in the table.
+     */
+    static int count();
+
+    /**
+     * Returns the approximate amount of memory in bytes used by the strings
+     * in the table and the table itself.
+     */
+    static qint64 memoryUsage();
+
+    /**
+     * Returns the approximate amount of memory in bytes that \a count separate
+     * copies of strings with a total length of \a length characters would
+     * occupy without the atom table. This allows to measure the savings of
+     * the table.
+     * @param count number of strings
+     * @param length sum of the length of all strings
+     */
+    static qint64 unsharedMemoryUsage(qint64 count, qint64 length);
+
+private:
+    StringAtoms() {}
+};
+
+#endif // STRINGATOMS_H
@@ -13,8 +13,13 @@
 
 #include <QList>
 #include <QStringList>
+#include <QAtomicPointer>
 #include "memberlist.h"
 
+// forward declarations
+struct IndexedMember;
+struct StructuredMemberIndex;
+
 namespace str
 {
 extern const char* anonymous;
@@ -196,24 +201,45 @@ protected:
 
 private:
     /**
-     * Searches for a member with the name \a memberName in this structure or
-     * all nested anonymous structs or unions, if requested.
+     * Returns the member index of this struct or union. The index is created
+     * on first access and re-created whenever a member was added or one of
+     * the anonymous members has changed. Outdated indexes are kept until this
+     * object is deleted. This function is thread-safe as long as no members
+     * are added concurrently.
+     * @return the member index
+     */
+    const StructuredMemberIndex* memberIndex() const;
+
+    /**
+     * Checks if the members and the types of the anonymous members that
+     * \a idx was built from are still the same.
+     * @param idx the member index to check
+     * @return \c true if \a idx is up to date, \c false otherwise
+     */
+    bool memberIndexValid(const StructuredMemberIndex* idx) const;
+
+    /**
+     * Creates a new member index for this struct or union.
+     * @return a newly allocated member index
+     */
+    StructuredMemberIndex* buildMemberIndex() const;
+
+    /**
+     * Looks up member \a memberName in the member index.
      * @param memberName name of the member to search
      * @param recursive also search in nested, anonymous structs and unions
-     * @return the member, if it exists, \c 0 otherwise
+     * @return the index entry for that member, if it exists, \c 0 otherwise
      */
-    template<class T, class S>
-    inline T* member(const QString& memberName, bool recursive) const;
+    const IndexedMember* indexedMember(const QString& memberName,
+                                       bool recursive) const;
 
     /**
-     * Searches for a member with the name \a memberName in this structure or
-     * all nested anonymous structs or unions, if required.
-     * @param memberName name of the member to search
-     * @param skipLocal do not search (again) the member names of this structure
-     * @return list of members leading to \a memberName
+     * Deletes the member index along with all outdated ones.
      */
-    template<class T, class S>
-    QList<T*> memberChain(const QString& memberName, bool skipLocal = false) const;
+    void clearMemberIndex();
+
+    /// Index of all members by name and offset, see memberIndex()
+    mutable QAtomicPointer<StructuredMemberIndex> _memberIndex;
 };
 
 
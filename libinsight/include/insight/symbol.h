@@ -10,6 +10,7 @@
 
 #include "typeinfo.h"
 #include "kernelsymbolstream.h"
+#include "stringatoms.h"
 
 // forward declaration
 class SymFactory;
@@ -50,7 +51,14 @@ public:
     /**
      * @return the name of that type, e.g. "int"
      */
-    QString name() const;
+    const QString& name() const;
+
+    /**
+     * Returns the name of this symbol as StringAtom. Two symbols have the
+     * same name if and only if their name atoms are equal.
+     * \sa name(), StringAtoms
+     */
+    StringAtom nameAtom() const;
 
     /**
      * Set the name of this symbol
@@ -150,13 +158,19 @@ protected:
     int _id;              ///< local ID of this type, assigned by SymFactory
     int _origId;          ///< original ID of this type, given by objdump
     int _origFileIndex;   ///< ID of this type, given by objdump
-    QString _name;        ///< name of this type, e.g. "int"
+    StringAtom _name;     ///< name of this type, e.g. "int", see StringAtoms
     KernelSymbols* _symbols; ///< the factory that created this symbol
     static const QString emptyString;
 };
 
 
-inline QString Symbol::name() const
+inline const QString& Symbol::name() const
+{
+    return StringAtoms::string(_name);
+}
+
+
+inline StringAtom Symbol::nameAtom() const
 {
     return _name;
 }
@@ -164,7 +178,7 @@ inline QString Symbol::name() const
 
 inline void Symbol::setName(const QString& name)
 {
-    _name = name;
+    _name = StringAtoms::atom(name);
 }
 
 
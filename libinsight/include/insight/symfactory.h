@@ -31,6 +31,9 @@ class Array;
 class ASTType;
 class ASTTypeEvaluator;
 class TypeEvalDetails;
+class TypeUsageLog;
+class TypeFilter;
+class VariableFilter;
 
 #include "numeric.h"
 #include "typeinfo.h"
@@ -38,6 +41,7 @@ class TypeEvalDetails;
 #include "structured.h"
 #include "memspecs.h"
 #include "astexpression.h"
+#include "stringatoms.h"
 #include <astsymbol.h>
 #include <typeinfooracle.h>
 
@@ -89,11 +93,11 @@ typedef QList<Structured*> StructuredList;
 /// Key for hashing elements of BaseType based on their name and size
 typedef QPair<QString, quint32> BaseTypeHashKey;
 
-/// Hash table for BaseType pointers
-typedef QMultiHash<QString, BaseType*> BaseTypeStringHash;
+/// Hash table for BaseType pointers, indexed by the StringAtom of their name
+typedef QMultiHash<StringAtom, BaseType*> BaseTypeAtomHash;
 
-/// Hash table for Variable pointers
-typedef QMultiHash<QString, Variable*> VariableStringHash;
+/// Hash table for Variable pointers, indexed by the StringAtom of their name
+typedef QMultiHash<StringAtom, Variable*> VariableAtomHash;
 
 /// Set of type IDs
 typedef QSet<int> IntSet;
@@ -343,9 +347,10 @@ public:
     }
 
     /**
-     * @return the hash of all types by their name
+     * @return the hash of all types by the StringAtom of their name
+     * \sa StringAtoms::find()
      */
-    inline const BaseTypeStringHash& typesByName() const
+    inline const BaseTypeAtomHash& typesByName() const
     {
         return _typesByName;
     }
@@ -375,9 +380,10 @@ public:
 	}
 
 	/**
-	 * @return the hash of all variables by their name
+	 * @return the hash of all variables by the StringAtom of their name
+	 * \sa StringAtoms::find()
 	 */
-	inline const VariableStringHash& varsByName() const
+	inline const VariableAtomHash& varsByName() const
 	{
 		return _varsByName;
 	}
@@ -456,8 +462,40 @@ public:
 
     QList<Variable*> varsUsingId(int id) const;
 
+    /**
+     * Returns all types that match \a filter. The types are matched in
+     * parallel by up to MultiThreading::maxThreads() threads, the result
+     * is in the same order as types().
+     * @param filter the filter to apply
+     * @return list of matching types
+     * \sa varsMatching()
+     */
+    BaseTypeList typesMatching(const TypeFilter* filter) const;
+
+    /**
+     * Returns all variables that match \a filter. The variables are matched
+     * in parallel by up to MultiThreading::maxThreads() threads, the result
+     * is in the same order as vars().
+     * @param filter the filter to apply
+     * @return list of matching variables
+     * \sa typesMatching()
+     */
+    VariableList varsMatching(const VariableFilter* filter) const;
+
     void typeAlternateUsage(const TypeEvalDetails *ed, ASTTypeEvaluator* eval);
 
+    /**
+     * Applies all changes recorded in \a log to the types and variables of
+     * this factory, as if the source file the log was recorded for had been
+     * evaluated again. The records are first read completely, so if any of
+     * them cannot be resolved, no changes are applied at all.
+     * @param log the recorded changes
+     * @return the number of applied records, or -1 if the log does not match
+     * the symbols of this factory
+     * \sa KernelSourceTypeEvaluator::setUsageLog()
+     */
+    int replayTypeUsage(const TypeUsageLog& log);
+
     FoundBaseTypes findBaseTypesForAstType(const ASTType* astType,
                                             ASTTypeEvaluator *eval,
                                            bool includeCustomTypes = false);
@@ -574,6 +612,8 @@ protected:
 										 const BaseTypeList& ctxBaseTypes,
 										 ASTTypeEvaluator *eval);
 
+	static TypeUsageLog* usageLog(ASTTypeEvaluator *eval);
+
 	void typeAlternateUsageVar(const TypeEvalDetails *ed,
 							   const BaseType *targetBaseType,
 							   ASTTypeEvaluator *eval);
@@ -836,11 +876,11 @@ private:
     CompileUnitIntHash _sources;      ///< Holds all source files
 	VariableList _vars;               ///< Holds all Variable objects
 	VariableLList _externalVars;      ///< Holds all external Variable declarations
-	VariableStringHash _varsByName;   ///< Holds all Variable objects, indexed by name
+	VariableAtomHash _varsByName;   ///< Holds all Variable objects, indexed by name
 	VariableIntHash _varsById;	      ///< Holds all Variable objects, indexed by ID
 	EnumStringHash _enumsByName;         ///< Holds all enumerator values, indexed by name
 	BaseTypeList _types;              ///< Holds all BaseType objects which were parsed or read from symbol files
-	BaseTypeStringHash _typesByName;  ///< Holds all BaseType objects, indexed by name
+	BaseTypeAtomHash _typesByName;  ///< Holds all BaseType objects, indexed by name
 	BaseTypeIntHash _typesById;       ///< Holds all BaseType objects, indexed by ID
 	IntIntMultiHash _equivalentTypes; ///< Holds all type IDs of equivalent types
 	IntIntHash _replacedMemberTypes;  ///< Holds all member IDs whose ref. type had been replaced
@@ -884,13 +924,13 @@ inline Variable* SymFactory::findVarById(int id) const
 
 inline BaseType* SymFactory::findBaseTypeByName(const QString & name) const
 {
-	return _typesByName.value(name);
+	return _typesByName.value(StringAtoms::find(name));
 }
 
 
 inline Variable* SymFactory::findVarByName(const QString & name) const
 {
-	return _varsByName.value(name);
+	return _varsByName.value(StringAtoms::find(name));
 }
 
 
@@ -6,10 +6,11 @@
 #include <QStringList>
 #include <QRegExp>
 #include <QHash>
-#include <QMutex>
+#include <QVector>
 #include <safeflags.h>
 #include "filterexception.h"
 #include "keyvaluestore.h"
+#include "stringatoms.h"
 
 class BaseType;
 class Variable;
@@ -76,6 +77,71 @@ DECLARE_SAFE_FLAGS(Options, Option)
 }
 
 
+/**
+ * This class holds a name pattern compiled for fast matching. Literal names
+ * are compared by their StringAtom first. Wildcard expressions are compiled
+ * into a sequence of fixed segments separated by \c *, so that matching does
+ * not need a QRegExp. Regular expressions without any special characters are
+ * matched as sub-strings, all others by a QRegExp that is compiled only once.
+ *
+ * In contrast to a QRegExp, the match() function can be called concurrently
+ * from several threads.
+ */
+class NameMatcher
+{
+public:
+    /**
+     * Constructor, creates a matcher that matches any name.
+     */
+    NameMatcher() { clear(); }
+
+    /**
+     * Compiles the pattern \a name.
+     * @param name the literal name or the pattern
+     * @param syntax the pattern syntax of \a name
+     * @param rx regular expression for \a name, as returned by
+     * GenericFilter::setNamePattern() for Filter::psWildcard and
+     * Filter::psRegExp
+     */
+    void compile(const QString& name, Filter::PatternSyntax syntax,
+                 const QRegExp& rx);
+
+    /**
+     * Resets the matcher to match any name.
+     */
+    void clear();
+
+    /**
+     * Matches \a name against the compiled pattern.
+     * @param name the name to match
+     * @param atom atom of \a name, or StringAtoms::invalidAtom if unknown
+     * @return \c true if \a name matches, \c false otherwise
+     */
+    bool match(const QString& name,
+               StringAtom atom = StringAtoms::invalidAtom) const;
+
+private:
+    enum Mode {
+        mAny,        ///< matches any name
+        mLiteral,    ///< case-insensitive literal match
+        mGlob,       ///< wildcard expression compiled into segments
+        mSubString,  ///< regular expression without special characters
+        mRegExp      ///< any other regular expression
+    };
+
+    bool compileGlob(const QString& pattern);
+    bool matchGlob(const QString& name) const;
+    bool matchSegment(const QString& name, int pos, const QString& seg) const;
+
+    Mode _mode;
+    QString _literal;
+    StringAtom _atom;
+    Qt::CaseSensitivity _cs;
+    QVector<QString> _segments;
+    QRegExp _rx;
+};
+
+
 /**
  * This is the base class for other filters and provides data to match on a
  * type's name, data type (RealType), and type size.
@@ -87,8 +153,7 @@ public:
      * Default constructor
      */
     GenericFilter()
-        : _filters(Filter::ftNone), _typeRegEx(0), _typeId(0), _realTypes(0),
-          _size(0) {}
+        : _filters(Filter::ftNone), _typeId(0), _realTypes(0), _size(0) {}
 
     /**
      * Copy constructor
@@ -262,14 +327,14 @@ protected:
      */
     static Filter::PatternSyntax givenSyntax(const KeyValueStore* keyVal);
 
-    bool matchTypeName(const QString& name) const;
+    bool matchTypeName(const QString& name,
+                       StringAtom atom = StringAtoms::invalidAtom) const;
 
     Filter::Options _filters;
-    mutable QMutex _regExLock;
 
 private:
     QString _typeName;
-    QRegExp *_typeRegEx;
+    NameMatcher _typeMatcher;
     int _typeId;
     int _realTypes;
     quint32 _size;
@@ -285,7 +350,7 @@ public:
     /**
      * Default constructor
      */
-    MemberFilter() : _nameRegEx(0) {}
+    MemberFilter() {}
 
     /**
      * Initializing constructor
@@ -365,7 +430,7 @@ public:
 
 private:
     QString _name;
-    QRegExp *_nameRegEx;
+    NameMatcher _nameMatcher;
 };
 
 /// List of FieldFilter objects
@@ -472,7 +537,7 @@ public:
      * @param symFiles list of files the symbols in SymFactory were parsed from
      */
     FunctionFilter(const QStringList& symFiles = QStringList())
-        : _symFileRegEx(0), _symFiles(symFiles) {}
+        : _symFiles(symFiles) {}
 
     /**
      * Copy constructor
@@ -562,7 +627,7 @@ protected:
     bool matchSymFileName(const QString& name) const;
 
 private:
-    QRegExp* _symFileRegEx;
+    NameMatcher _symFileMatcher;
     QString _symFile;
     const QStringList& _symFiles;
 };
@@ -579,7 +644,7 @@ public:
      * @param symFiles list of files the symbols in SymFactory were parsed from
      */
     VariableFilter(const QStringList& symFiles = QStringList())
-        : FunctionFilter(symFiles), _varRegEx(0) {}
+        : FunctionFilter(symFiles) {}
 
     /**
      * Copy constructor
@@ -603,7 +668,6 @@ public:
      */
     inline bool operator==(const VariableFilter& other) const
     {
-        // Do NOT compare the _varRegEx pointer
         return FunctionFilter::operator ==(other);
     }
 
@@ -670,11 +734,12 @@ public:
     static const KeyValueStore& supportedFilters();
 
 protected:
-    bool matchVarName(const QString& name) const;
+    bool matchVarName(const QString& name,
+                      StringAtom atom = StringAtoms::invalidAtom) const;
 
 private:
     QString _varName;
-    QRegExp* _varRegEx;
+    NameMatcher _varMatcher;
 };
 
 
@@ -2,6 +2,7 @@
 #define TYPERULE_H
 
 #include <QStringList>
+#include <QHash>
 #include "memberlist.h"
 #include "instance_def.h"
 #include "altreftype.h"
@@ -201,13 +202,16 @@ public:
         atNone       = 0,        ///< no action specified
         atExpression = (1 << 0), ///< action() represents a C expression
         atInlineCode = (1 << 1), ///< action() represents a script that is evaluated
-        atFunction   = (1 << 2)  ///< action() is the name of a function in scriptFile() that is invoked
+        atFunction   = (1 << 2), ///< action() is the name of a function in scriptFile() that is invoked
+        atListEntry  = (1 << 3), ///< action() natively follows a list based on <tt>struct list_head</tt>
+        atHListEntry = (1 << 4), ///< action() natively follows a list based on <tt>struct hlist_node</tt>
+        atDiscriminant = (1 << 5) ///< action() natively selects the valid union member by a discriminant
     };
 
     /**
      * Constructor
      */
-    TypeRuleAction() : _srcLine(0) {}
+    TypeRuleAction() : _srcLine(0), _pure(false) {}
 
     /**
      * Destructor
@@ -228,6 +232,22 @@ public:
      */
     inline void setSrcLine(int line) { _srcLine = line; }
 
+    /**
+     * Returns \c true if the result of this action only depends on the
+     * instance, the accessed members and the inspected memory, and if the
+     * action has no side effects. The results of pure actions may be cached
+     * by the TypeRuleEngine.
+     * \sa setPure()
+     */
+    inline bool isPure() const { return _pure; }
+
+    /**
+     * Declares this action as pure or not.
+     * @param pure \c true if the action is pure, \c false otherwise
+     * \sa isPure()
+     */
+    inline void setPure(bool pure) { _pure = pure; }
+
     /**
      * Returns the specified type of action that is performed when the rule
      * hits.
@@ -290,8 +310,16 @@ public:
      */
     static ActionType strToActionType(const QString& action);
 
+    /**
+     * Returns the name of action type \a type as used in the rule files.
+     * @param type the action type
+     * @return the action type as string
+     */
+    static QString actionTypeToStr(ActionType type);
+
 private:
     int _srcLine;
+    bool _pure;
 };
 
 
@@ -335,6 +363,15 @@ public:
     Instance evaluate(const Instance *inst, const ConstMemberList &members,
                       ScriptEngine* eng, bool* matched) const;
 
+    /**
+     * Checks if this script implements an idiom that a native action
+     * implements as well, so that the script could be replaced by that action.
+     * The default implementation returns TypeRuleAction::atNone.
+     * @return the type of the equivalent native action, or
+     * TypeRuleAction::atNone if there is none
+     */
+    virtual ActionType nativeEquivalent() const { return atNone; }
+
 protected:
     /**
      * Retuns the name of the script function to call for evaluation.
@@ -399,6 +436,11 @@ public:
      */
     QString toString(const ColorPalette *col = 0) const;
 
+    /**
+     * \copydoc ScriptAction::nativeEquivalent()
+     */
+    ActionType nativeEquivalent() const;
+
 protected:
     /**
      * \copydoc ScriptAction::funcToCall()
@@ -465,7 +507,11 @@ public:
     /**
      * Constructor
      */
-    ExpressionAction() : _expr(0), _srcType(0), _targetType(0) {}
+    ExpressionAction() : _expr(0), _srcType(0), _targetType(0)
+    {
+        // Expressions only read memory
+        setPure(true);
+    }
 
     /**
      * Destructor
@@ -604,4 +650,139 @@ private:
     AltRefType _altRefType;
 };
 
+
+/**
+ * This TypeRuleAction natively follows a linked list that is based on an
+ * embedded <tt>struct list_head</tt> or <tt>struct hlist_node</tt>, just like
+ * the \c container_of() macro of the Linux kernel. The members accessed from
+ * the instance lead to the embedded list node, where the last member is the
+ * pointer to the next (or previous) node. The action returns the object that
+ * embeds that node, which has the same type as the original instance.
+ */
+class ListEntryAction: public TypeRuleAction
+{
+public:
+    /**
+     * Constructor
+     * @param hlist set to \c true for a list based on <tt>struct
+     * hlist_node</tt>, which can only be followed by its \c next member
+     */
+    explicit ListEntryAction(bool hlist = false) : _hlist(hlist)
+    {
+        // Lists are followed by only reading memory
+        setPure(true);
+    }
+
+    /**
+     * \copydoc TypeRuleAction::actionType()
+     * @return TypeRuleAction::atListEntry or TypeRuleAction::atHListEntry
+     */
+    ActionType actionType() const { return _hlist ? atHListEntry : atListEntry; }
+
+    /**
+     * \copydoc TypeRuleAction::check()
+     */
+    bool check(const QString& xmlFile, const TypeRule* rule, SymFactory *factory);
+
+    /**
+     * \copydoc TypeRuleAction::evaluate()
+     */
+    Instance evaluate(const Instance *inst, const ConstMemberList &members,
+                      ScriptEngine* eng, bool* matched) const;
+
+    /**
+     * \copydoc TypeRuleAction::toString()
+     */
+    QString toString(const ColorPalette *col = 0) const;
+
+private:
+    bool _hlist;
+};
+
+
+/**
+ * This TypeRuleAction natively restricts the access to the members of a union
+ * based on the value of a discriminant. The discriminant is a (nested) member
+ * of the instance, e.g., <tt>common.type</tt>. Each case maps a value of the
+ * discriminant to the names of the members that are valid for this value. If
+ * no case matches, the default members are valid.
+ *
+ * The last accessed member is compared to the valid members. For a valid
+ * member, the action requests the default handler, otherwise it returns an
+ * invalid instance.
+ */
+class DiscriminantAction: public TypeRuleAction
+{
+public:
+    /**
+     * Constructor
+     */
+    DiscriminantAction()
+    {
+        // The discriminant is only read from memory
+        setPure(true);
+    }
+
+    /**
+     * Returns the member path of the discriminant, as a string.
+     */
+    inline const QString& discriminantStr() const { return _discrStr; }
+
+    /**
+     * Sets the member path of the discriminant, as a string.
+     * @param discr dot-separated member names, e.g. <tt>common.type</tt>
+     */
+    inline void setDiscriminantStr(const QString& discr) { _discrStr = discr; }
+
+    /**
+     * Declares member \a member as valid for the discriminant value \a value.
+     * @param value value of the discriminant
+     * @param member name of the member
+     */
+    inline void addCase(qint64 value, const QString& member)
+    {
+        _cases[value].append(member);
+    }
+
+    /**
+     * Declares member \a member as valid if no case matches the value of the
+     * discriminant.
+     * @param member name of the member
+     */
+    inline void addDefault(const QString& member) { _defaults.append(member); }
+
+    /**
+     * Returns the number of cases.
+     */
+    inline int caseCount() const { return _cases.size(); }
+
+    /**
+     * \copydoc TypeRuleAction::actionType()
+     * @return TypeRuleAction::atDiscriminant
+     */
+    ActionType actionType() const { return atDiscriminant; }
+
+    /**
+     * \copydoc TypeRuleAction::check()
+     */
+    bool check(const QString& xmlFile, const TypeRule* rule, SymFactory *factory);
+
+    /**
+     * \copydoc TypeRuleAction::evaluate()
+     */
+    Instance evaluate(const Instance *inst, const ConstMemberList &members,
+                      ScriptEngine* eng, bool* matched) const;
+
+    /**
+     * \copydoc TypeRuleAction::toString()
+     */
+    QString toString(const ColorPalette *col = 0) const;
+
+private:
+    QString _discrStr;
+    QStringList _discrPath;
+    QHash<qint64, QStringList> _cases;
+    QStringList _defaults;
+};
+
 #endif // TYPERULE_H
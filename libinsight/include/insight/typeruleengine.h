@@ -7,9 +7,13 @@
 #include <QSharedPointer>
 #include <QScriptProgram>
 #include <QScriptValue>
+#include <QAtomicInt>
+#include <QMutex>
 #include "colorpalette.h"
 #include "memberlist.h"
 #include "longoperation.h"
+#include "stringatoms.h"
+#include "ruleresultcache.h"
 
 class TypeRule;
 class TypeRuleReader;
@@ -33,15 +37,25 @@ extern const char* inlinefunc;
 /// Represents an active TypeRule
 struct ActiveRule
 {
-    ActiveRule() : index(-1), usageCount(0), rule(0) {}
+    ActiveRule()
+        : index(-1), usageCount(0), rule(0), membersIndexed(false),
+          cacheable(false) {}
     explicit ActiveRule(int index, const TypeRule* rule, const QScriptProgram* prog)
-        : index(index), usageCount(0), rule(rule), prog(prog) {}
+        : index(index), usageCount(0), rule(rule), prog(prog),
+          membersIndexed(false), cacheable(false) {}
     explicit ActiveRule(int index, const TypeRule* rule, const QScriptProgramPtr& prog)
-        : index(index), usageCount(0), rule(rule), prog(prog) {}
+        : index(index), usageCount(0), rule(rule), prog(prog),
+          membersIndexed(false), cacheable(false) {}
     int index;
     uint usageCount;
     const TypeRule* rule;
     QScriptProgramPtr prog;
+    /// The member filters only match literal names and are fully decided by
+    /// the dispatch index of the TypeRuleEngine
+    bool membersIndexed;
+    /// The rule has a pure action and does not match variable names, so its
+    /// results may be cached
+    bool cacheable;
 };
 
 /// List of type rules
@@ -57,9 +71,94 @@ typedef QHash<int, ActiveRule*> ActiveRuleHash;
 /// Hash of OsFilter objects
 typedef QHash<uint, const OsFilter*> OsFilterHash;
 
+/**
+ * A node of the rule dispatch index of TypeRuleEngine. The root node of a
+ * type holds all rules for that type, each child node holds the rules whose
+ * member filters match the member names on the path from the root, e.g., the
+ * node reached via "list" and "next" holds the rules for "list.next" as well
+ * as those for "list.next.prev". All lists are sorted by descending priority.
+ */
+struct RuleDispatchNode
+{
+    ~RuleDispatchNode() { qDeleteAll(children); }
+    /// rules with literal member names that match the path up to this node
+    ActiveRuleCList rules;
+    /// rules with other member filters, only used in the root node
+    ActiveRuleCList generic;
+    /// child nodes by member name
+    QHash<StringAtom, RuleDispatchNode*> children;
+};
+
+/// Hash of dispatch index root nodes by type ID
+typedef QHash<int, RuleDispatchNode*> RuleDispatchHash;
+
 class KernelSymbols;
 class TypeRuleEngineContext;
 
+/**
+ * This class holds a pool of TypeRuleEngineContext objects whose scripting
+ * engines are already initialized. Threads that do not inherit
+ * TypeRuleEngineContextProvider check out a context from the pool to evaluate
+ * script rules and return it afterwards. Thus, they neither share a single
+ * scripting engine nor have to set up a new one for every evaluation.
+ *
+ * All functions of this class are thread-safe.
+ */
+class TypeRuleEngineContextPool
+{
+public:
+    /**
+     * Constructor
+     * @param symbols the kernel symbols to create the contexts for
+     */
+    TypeRuleEngineContextPool(KernelSymbols* symbols);
+
+    /**
+     * Destructor, deletes all idle contexts.
+     */
+    ~TypeRuleEngineContextPool();
+
+    /**
+     * Checks out an idle context from the pool, or creates a new one if none
+     * is left. The context must be returned with release().
+     * @return initialized context for exclusive use by the calling thread
+     */
+    TypeRuleEngineContext* acquire();
+
+    /**
+     * Returns context  ctx to the pool. If the pool already holds enough
+     * idle contexts,  ctx is deleted.
+     * @param ctx context previously obtained by acquire()
+     */
+    void release(TypeRuleEngineContext* ctx);
+
+    /**
+     * Creates and initializes contexts until at least  count of them are
+     * idle.
+     * @param count no. of contexts to provide
+     */
+    void reserve(int count);
+
+    /**
+     * Returns the number of idle contexts.
+     */
+    int idleCount() const;
+
+    /**
+     * Deletes all idle contexts. Contexts that are currently checked out are
+     * not affected.
+     */
+    void clear();
+
+private:
+    TypeRuleEngineContext* create() const;
+    int maxIdle() const;
+
+    KernelSymbols* _symbols;
+    QList<TypeRuleEngineContext*> _idle;
+    mutable QMutex _lock;
+};
+
 /**
  * This class manages a set of rules that have to be applied to certain types.
  */
@@ -75,6 +174,19 @@ public:
         mrDefaultHandler  = (1 << 3)   ///< the matched rule requested to use the default handler
     };
 
+    /// Statistics about the rules tested by match()
+    struct MatchStatistics
+    {
+        MatchStatistics()
+            : lookups(0), candidates(0), matches(0), cacheHits(0),
+              cacheMisses(0) {}
+        int lookups;     ///< no. of calls to match() for types with rules
+        int candidates;  ///< no. of rules tested in these calls
+        int matches;     ///< no. of calls that returned mrMatch
+        int cacheHits;   ///< no. of results found in the result cache
+        int cacheMisses; ///< no. of results not found in the result cache
+    };
+
     /// How verbose should we be during rule evaluation?
     enum VerboseEvaluation {
         veOff = 0,        ///< no verbose output
@@ -221,17 +333,52 @@ public:
     bool setInactive(const TypeRule* rule);
 
     /**
-     * Resets all usage counters to zero.
+     * Resets all usage counters and the match statistics to zero.
+     * \sa matchStatistics()
      */
     void resetActiveRulesUsage();
 
+    /**
+     * Returns statistics about the rules tested by match() since the last
+     * call to resetActiveRulesUsage().
+     */
+    MatchStatistics matchStatistics() const;
+
+    /**
+     * Returns the maximal number of entries of the result cache, or 0 if the
+     * cache is disabled (the default).
+     * \sa setResultCacheSize()
+     */
+    inline int resultCacheSize() const { return _resultCache.maxSize(); }
+
+    /**
+     * Enables the result cache for up to \a size results of match(), or
+     * disables it if \a size is 0.
+     *
+     * The cache is only used for lookups in which all tested rules have a
+     * pure action (see TypeRuleAction::isPure()) and do not filter on
+     * variable names or symbol files. The name of a cached instance is
+     * derived from the instance and the members passed to match().
+     * @param size max. no. of cached results
+     * \sa invalidateResultCache()
+     */
+    void setResultCacheSize(int size);
+
+    /**
+     * Discards all cached results. This must be called whenever the memory
+     * of a VirtualMemory object changes or a memory dump is unloaded.
+     */
+    void invalidateResultCache();
+
     /**
      * Matches the given Instance with the given member access pattern agains
-     * the rule set.
+     * the rule set. The candidate rules are looked up in a dispatch index by
+     * the instance's type ID and the names of \a members, and they are tested
+     * in the order of descending priority.
      *
-     * \warning This function is \b not thread-safe! For concurrent rule
-     * matching, the individual threads must inherit from class
-     * TypeRuleEngineContextProvider.
+     * Script rules are evaluated with the context of the current thread if it
+     * inherits from TypeRuleEngineContextProvider. All other threads check out
+     * a context from the contextPool() for the duration of the call.
      *
      * @param inst instance to match
      * @param members accessed members, originating from the structure pointed
@@ -302,6 +449,13 @@ public:
      */
     void operationProgress();
 
+    /**
+     * Returns the pool of script contexts used by threads that do not provide
+     * a context of their own.
+     * \sa TypeRuleEngineContextProvider
+     */
+    inline TypeRuleEngineContextPool& contextPool() const { return _ctxPool; }
+
     /**
      * Every thread needs its own context to evaluate rules. This function
      * creates a context for one thread.
@@ -345,19 +499,25 @@ private:
     int addAllLexicalTypes(const BaseType* type, ActiveRule *arule);
 
     bool checkRule(TypeRule *rule, int index, const OsSpecs *specs);
-
+    void buildDispatchIndex();
+    void clearDispatchIndex();
 
     TypeRuleList _rules;
     ActiveRuleList _activeRules;
     ActiveRuleHash _rulesPerType;
+    RuleDispatchHash _dispatch;
+    mutable RuleResultCache _resultCache;
     OsFilterHash _osFilters;
     QStringList _ruleFiles;
     QVector<int> _hits;
-    TypeRuleEngineContext *_ctx;
+    mutable TypeRuleEngineContextPool _ctxPool;
     int _rulesChecked;
     int _rulesToCheck;
     VerboseEvaluation _verbose;
     KernelSymbols* _symbols;
+    mutable QAtomicInt _matchLookups;
+    mutable QAtomicInt _matchCandidates;
+    mutable QAtomicInt _matchHits;
 };
 
 #endif // TYPERULEENGINE_H
@@ -37,6 +37,13 @@ extern const char* srcType;
 extern const char* targetType;
 extern const char* expression;
 extern const char* priority;
+extern const char* pure;
+extern const char* listEntry;
+extern const char* hlistEntry;
+extern const char* discriminant;
+extern const char* discrCase;
+extern const char* discrDefault;
+extern const char* value;
 }
 
 /**
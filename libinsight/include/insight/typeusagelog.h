@@ -0,0 +1,132 @@
+#ifndef TYPEUSAGELOG_H
+#define TYPEUSAGELOG_H
+
+#include <QByteArray>
+#include <QString>
+#include "kernelsymbolstream.h"
+
+class StructuredMember;
+class Variable;
+class ASTExpression;
+
+/**
+ * This class records the changes that the type evaluation of one kernel
+ * source file applies to the SymFactory, i.e., the alternative types of struct
+ * members and global variables as well as the constant values found for
+ * struct members. All records refer to symbols by their ID, so a log can be
+ * stored and later be replayed with SymFactory::replayTypeUsage() against the
+ * same set of symbols without parsing the file again.
+ *
+ * Changes that involve type copies cannot be expressed by stable IDs. If such
+ * a change is recorded, the log becomes invalid and must not be replayed.
+ */
+class TypeUsageLog
+{
+public:
+    /// Type of one record within the log
+    enum RecordType {
+        lrNone = 0,
+        lrMemberAltRefType,   ///< alternative type of a struct member
+        lrVarAltRefType,      ///< alternative type of a variable
+        lrMemberNotConstant,  ///< member was assigned a non-constant value
+        lrMemberConstInt,     ///< member was assigned a constant integer
+        lrMemberConstString   ///< member was assigned a constant string
+    };
+
+    /**
+     * Constructor
+     */
+    TypeUsageLog();
+
+    /**
+     * Records that \a member was assigned the alternative type \a targetId
+     * through expression \a expr.
+     */
+    void addAltRefType(const StructuredMember* member, int targetId,
+                       const ASTExpression* expr);
+
+    /**
+     * Records that \a var was assigned the alternative type \a targetId
+     * through expression \a expr.
+     */
+    void addAltRefType(const Variable* var, int targetId,
+                       const ASTExpression* expr);
+
+    /**
+     * Records that \a member was found to hold no constant value.
+     * \sa StructuredMember::evaluateMagicNumberFoundNotConstant()
+     */
+    void addNotConstant(const StructuredMember* member);
+
+    /**
+     * Records that \a member was assigned the constant \a value.
+     * \sa StructuredMember::evaluateMagicNumberFoundInt()
+     */
+    void addConstant(const StructuredMember* member, qint64 value);
+
+    /**
+     * Records that \a member was assigned the constant \a value.
+     * \sa StructuredMember::evaluateMagicNumberFoundString()
+     */
+    void addConstant(const StructuredMember* member, const QString& value);
+
+    /**
+     * Marks this log as invalid, i.e., not all changes could be recorded.
+     */
+    void invalidate();
+
+    /**
+     * Returns \c true if all changes could be recorded, \c false otherwise.
+     */
+    bool isValid() const;
+
+    /**
+     * Returns the number of records in this log.
+     */
+    int count() const;
+
+    /**
+     * Returns the serialized records of this log.
+     */
+    const QByteArray& data() const;
+
+    /**
+     * Replaces the contents of this log with \a count records serialized in
+     * \a data, as returned by data().
+     */
+    void setData(const QByteArray& data, int count);
+
+    /**
+     * Discards all records and makes the log valid again.
+     */
+    void clear();
+
+private:
+    bool beginMemberRecord(RecordType type, const StructuredMember* member);
+    bool checkExpression(const ASTExpression* expr);
+
+    QByteArray _data;
+    KernelSymbolStream _out;
+    int _count;
+    bool _valid;
+};
+
+
+inline bool TypeUsageLog::isValid() const
+{
+    return _valid;
+}
+
+
+inline int TypeUsageLog::count() const
+{
+    return _count;
+}
+
+
+inline const QByteArray& TypeUsageLog::data() const
+{
+    return _data;
+}
+
+#endif // TYPEUSAGELOG_H
@@ -94,12 +94,117 @@ struct PageTableEntries {
     quint64 pte;
 };
 
+class VirtualMemory;
+
+/**
+ * This class enumerates the mappings of a virtual address space in address
+ * order by walking the page table hierarchy. Each page table page is read
+ * only once and then kept until the walk leaves it, so enumerating the 512
+ * entries of one page table costs one read instead of 512 full walks with
+ * VirtualMemory::virtualToPhysical().
+ *
+ * The iterator supports x86_64, i386 PAE and i386 non-PAE paging. It uses
+ * the kernel's page tables by default, or the page global directory of a
+ * user-land process.
+ *
+ * \code
+ * PageTableIterator it(vmem, begin, end - 1);
+ * while (it.next()) {
+ *     // Use it.address(), it.physAddress(), it.size(), it.entries()
+ * }
+ * \endcode
+ */
+class PageTableIterator
+{
+public:
+    /**
+     * Constructor
+     * @param vmem the virtual memory to walk
+     * @param first the first virtual address to consider
+     * @param last the last virtual address to consider (inclusive)
+     * @param includeNonPresent if \c true, next() also stops at entries
+     * that are not present, i.e., at every entry that
+     * PageTableEntries::nextPageOffset() would skip over
+     * @param pgd physical address of the page global directory of a user-land
+     * process as found in \c CR3, or 0 for the kernel page tables; with PAE,
+     * this is the address of the page directory pointer table
+     */
+    PageTableIterator(VirtualMemory* vmem, quint64 first, quint64 last,
+                      bool includeNonPresent = false, quint64 pgd = 0);
+
+    /**
+     * Advances the iterator to the next mapping.
+     * @return \c true if there is another mapping, \c false if the end of
+     * the range has been reached
+     */
+    bool next();
+
+    /**
+     * Returns the virtual address of the current mapping. It is aligned to
+     * size(), so the first mapping may start before the \a first address
+     * passed to the constructor.
+     */
+    inline quint64 address() const { return _addr; }
+
+    /**
+     * Returns the physical address the current mapping starts at, or
+     * PADDR_ERROR if the mapping is not present.
+     */
+    inline quint64 physAddress() const { return _paddr; }
+
+    /**
+     * Returns the size of the current mapping in bytes, e.g., 4 kB for a
+     * page, 2 MB for a large page or 512 GB for a non-present PGD entry.
+     */
+    inline quint64 size() const { return _size; }
+
+    /**
+     * Returns \c true if the current mapping is present.
+     */
+    inline bool isPresent() const { return _paddr != PADDR_ERROR; }
+
+    /**
+     * Returns the page table entries of the current mapping in the same form
+     * as VirtualMemory::virtualToPhysical() does.
+     */
+    inline const PageTableEntries& entries() const { return _entries; }
+
+private:
+    enum { maxLevels = 4, tableSize = 4096 };
+
+    bool readEntry(int level, quint64 table, quint64* entry);
+    bool advance();
+
+    VirtualMemory* _vmem;
+    quint64 _next;
+    quint64 _last;
+    quint64 _root;
+    bool _includeNonPresent;
+    bool _done;
+    quint64 _addr;
+    quint64 _paddr;
+    quint64 _size;
+    PageTableEntries _entries;
+
+    int _levels;
+    int _entrySize;
+    quint64 _physMask;
+    const int* _shifts;
+    const int* _largeLevels;
+    quint64 PageTableEntries::* const* _fields;
+    quint64 _tableAddr[maxLevels];
+    char _tables[maxLevels][tableSize];
+};
+
+
 /**
  * This class provides read access to a virtual address space and performs
  * the virtual to physical address translation.
  */
 class VirtualMemory: protected QIODevice
 {
+    friend class PageTableIterator;
+
 public:
     enum PageTableFlags {
         Present = 0x1,              ///< If set the page is present
@@ -130,6 +235,18 @@ public:
      */
     qint64 readAtomic(qint64 pos, char * data, qint64 maxlen);
 
+    /**
+     * Reads \a size bytes from the physical address \a paddr into \a buf.
+     * If thread-safety is enabled (see setThreadSafety()), then the whole
+     * operation is performed atomically.
+     * @param paddr physical address to read from
+     * @param buf buffer to write the data to
+     * @param size number of bytes to read
+     * @return \c true if all bytes could be read, \c false otherwise
+     * \sa PageTableIterator::physAddress()
+     */
+    bool readPhysical(quint64 paddr, char* buf, qint64 size);
+
 //    /**
 //     * Configures this instance to work on the user-land part of the memory only.
 //     * Reset with setKernelSpace
@@ -385,6 +502,11 @@ private:
      */
     quint64 updateFlags(quint64 currentFlags, quint64 entry);
 
+    /**
+     * Returns the physical address of the kernel's top-level page table.
+     */
+    quint64 kernelPageTableRoot() const;
+
     QIODevice* _physMem;
     qint64 _physMemSize;
     // This must be a reference, not an object, since MemoryDump::init() might
@@ -7,6 +7,7 @@
 
 #include <QDir>
 #include <QProcess>
+#include <QRegExp>
 #include <QThread>
 #include <QDataStream>
 #include <QCoreApplication>
@@ -31,6 +32,25 @@ void socket_state_id_foo() { Q_UNUSED(socket_state_id); }
     } while (0)
 
 
+/**
+ * Quotes \a word such that the daemon's shell parses it as a single argument.
+ * @param word the argument to quote
+ * @return the quoted argument
+ */
+static QString shellQuote(QString word)
+{
+    QRegExp rxSpecial("[\\s\"'|]");
+
+    if (!word.isEmpty() && !word.contains(rxSpecial))
+        return word;
+    if (!word.contains('\''))
+        return "'" + word + "'";
+    if (!word.contains('"'))
+        return "\"" + word + "\"";
+    return "'" + word.replace("'", "\\'") + "'";
+}
+
+
 Insight::Insight()
     : _helper(new SocketHelper())
 {
@@ -193,6 +213,35 @@ QStringList Insight::memDumpList()
 }
 
 
+ScriptBatchResultList Insight::scriptBatch(const QString &fileName,
+                                           const QList<int> &memDumps,
+                                           const QStringList &args)
+{
+    QStringList dumps;
+    for (int i = 0; i < memDumps.size(); ++i)
+        dumps += QString::number(memDumps[i]);
+
+    QString cmd = QString("binary %1 %2 %3")
+            .arg((int) bdScriptBatch)
+            .arg(dumps.join(","))
+            .arg(shellQuote(fileName));
+    for (int i = 0; i < args.size(); ++i)
+        cmd += " " + shellQuote(args[i]);
+
+    int ret = eval(cmd);
+    if (ret)
+        insightError(QString("Error executing command \"%1\", error code #%2")
+                .arg(cmd)
+                .arg(ret));
+
+    ScriptBatchResultList list;
+    QByteArray ba = _helper->bin()->readAll();
+    QDataStream in(ba);
+    in >> list;
+    return list;
+}
+
+
 bool Insight::memDumpLoad(const QString& fileName)
 {
     int ret = eval(QString("memory load %1").arg(fileName));
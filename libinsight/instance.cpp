@@ -139,19 +139,34 @@ InstanceList Instance::members(KnowledgeSources src) const
 
 	const MemberList& list = dynamic_cast<const Structured*>(_d->type)->members();
 	InstanceList ret;
-	for (int i = 0; i < list.count(); ++i) {
-		const StructuredMember* m = list[i];
-		// Use declared or candidate type?
-		if (src || m->altRefTypeCount() != 1)
-			ret.append(m->toInstance(_d->address, _d->vmem, this,
-										   BaseType::trLexical));
-		else
-			ret.append(memberCandidate(m, 0));
-	}
+	for (int i = 0; i < list.count(); ++i)
+		ret.append(memberAt(list[i], src));
 	return ret;
 }
 
 
+Instance Instance::memberAt(int index, KnowledgeSources src) const
+{
+    if (!_d->type || !(_d->type->type() & StructOrUnion))
+        return Instance();
+
+    const MemberList& list = dynamic_cast<const Structured*>(_d->type)->members();
+    if (index < 0 || index >= list.count())
+        return Instance();
+    return memberAt(list[index], src);
+}
+
+
+Instance Instance::memberAt(const StructuredMember* m, KnowledgeSources src) const
+{
+    // Use declared or candidate type?
+    if (src || m->altRefTypeCount() != 1)
+        return m->toInstance(_d->address, _d->vmem, this, BaseType::trLexical);
+    else
+        return memberCandidate(m, 0);
+}
+
+
 bool Instance::equals(const Instance& other) const
 {
     bool ok1 = false, ok2 = false;
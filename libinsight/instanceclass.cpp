@@ -11,6 +11,7 @@
 #include <QMetaMethod>
 #include <insight/instancedata.h>
 #include <insight/instanceprototype.h>
+#include <insight/addressprototype.h>
 #include <insight/basetype.h>
 #include <insight/kernelsymbols.h>
 #include <debug.h>
@@ -23,6 +24,8 @@ const char* instance      = "Instance";
 const char* length        = "length";
 const char* useRules      = "useRules";
 const char* useCandidates = "useCandidates";
+const char* listInstance  = "instance";
+const char* listKnowSrc   = "knowledgeSources";
 
 const int propIgnore        = -1;
 const int propUseRules      = -2;
@@ -31,6 +34,7 @@ const int propUseCandidates = -3;
 
 const uint MEMBER_NOT_FOUND = -1;
 const uint CALL_BY_NAME     = -2;
+const uint LIST_LENGTH      = -3;
 
 /**
  * This is an iterator for the properties of InstanceClass object.
@@ -59,10 +63,170 @@ private:
 };
 
 
+/**
+ * This class provides the array-like member lists returned by
+ * InstancePrototype::Members(). The data object of a list is an array that
+ * caches the Instance objects of all members accessed so far, and holds the
+ * struct instance and the knowledge sources as additional properties.
+ */
+class InstanceMembersClass : public QScriptClass
+{
+public:
+    InstanceMembersClass(InstanceClass* instClass);
+
+    QScriptValue newMemberList(const Instance& inst, KnowledgeSources src);
+
+    QueryFlags queryProperty(const QScriptValue& object,
+                             const QScriptString& name,
+                             QueryFlags flags, uint *id);
+
+    QScriptValue property(const QScriptValue& object,
+                          const QScriptString& name, uint id);
+
+    QScriptValue::PropertyFlags propertyFlags(
+        const QScriptValue& object, const QScriptString& name, uint id);
+
+    QScriptClassPropertyIterator *newIterator(const QScriptValue& object);
+
+    QString name() const;
+
+private:
+    InstanceClass* _instClass;
+    QScriptString _length;
+    QScriptValue _arrayProto;
+};
+
+
+/**
+ * This is an iterator for the indices of an InstanceMembersClass object.
+ */
+class InstanceMembersPropertyIterator : public QScriptClassPropertyIterator
+{
+public:
+    InstanceMembersPropertyIterator(const QScriptValue &object)
+        : QScriptClassPropertyIterator(object), m_index(0), m_last(-1),
+          m_count(object.data().property(js::length).toInt32())
+    {
+    }
+
+    bool hasNext() const { return m_index < m_count; }
+    void next() { m_last = m_index++; }
+    bool hasPrevious() const { return m_index > 0; }
+    void previous() { m_last = --m_index; }
+    void toFront() { m_index = 0; m_last = -1; }
+    void toBack() { m_index = m_count; m_last = -1; }
+
+    QScriptString name() const
+    {
+        return object().engine()->toStringHandle(QString::number(m_last));
+    }
+
+    uint id() const { return m_last; }
+
+private:
+    int m_index;
+    int m_last;
+    int m_count;
+};
+
+
+//------------------------------------------------------------------------------
+
+InstanceMembersClass::InstanceMembersClass(InstanceClass *instClass)
+    : QScriptClass(instClass->engine()), _instClass(instClass)
+{
+    _length = engine()->toStringHandle(js::length);
+    // Allows to use forEach(), map() etc. on the list
+    _arrayProto = engine()->globalObject().property("Array").property("prototype");
+}
+
+
+QScriptValue InstanceMembersClass::newMemberList(const Instance &inst,
+                                                 KnowledgeSources src)
+{
+    QScriptValue data = engine()->newArray(inst.memberCount());
+    data.setProperty(js::listInstance,
+                     engine()->newVariant(qVariantFromValue(inst)));
+    data.setProperty(js::listKnowSrc, QScriptValue(engine(), (int) src));
+
+    QScriptValue ret = engine()->newObject(this, data);
+    ret.setPrototype(_arrayProto);
+    return ret;
+}
+
+
+QScriptClass::QueryFlags InstanceMembersClass::queryProperty(
+        const QScriptValue &object, const QScriptString &name,
+        QueryFlags flags, uint *id)
+{
+    if (name == _length) {
+        *id = LIST_LENGTH;
+        return flags & HandlesReadAccess;
+    }
+
+    bool isIndex;
+    quint32 index = name.toArrayIndex(&isIndex);
+    if (isIndex &&
+        index < (quint32) object.data().property(_length).toUInt32())
+    {
+        *id = index;
+        return flags & HandlesReadAccess;
+    }
+
+    return 0;
+}
+
+
+QScriptValue InstanceMembersClass::property(const QScriptValue &object,
+                                            const QScriptString &name, uint id)
+{
+    Q_UNUSED(name);
+    QScriptValue data = object.data();
+    if (id == LIST_LENGTH)
+        return data.property(_length);
+
+    // Create the member on first access only
+    QScriptValue member = data.property(id);
+    if (member.isUndefined()) {
+        Instance *inst = qscriptvalue_cast<Instance*>(
+                    data.property(js::listInstance));
+        if (!inst)
+            return QScriptValue();
+        KnowledgeSources src =
+                (KnowledgeSources) data.property(js::listKnowSrc).toInt32();
+        member = _instClass->newInstance(inst->memberAt(id, src));
+        data.setProperty(id, member);
+    }
+    return member;
+}
+
+
+QScriptValue::PropertyFlags InstanceMembersClass::propertyFlags(
+        const QScriptValue& /*object*/, const QScriptString& /*name*/,
+        uint /*id*/)
+{
+    return QScriptValue::Undeletable | QScriptValue::ReadOnly;
+}
+
+
+QScriptClassPropertyIterator *InstanceMembersClass::newIterator(
+        const QScriptValue &object)
+{
+    return new InstanceMembersPropertyIterator(object);
+}
+
+
+QString InstanceMembersClass::name() const
+{
+    return QLatin1String("InstanceMembers");
+}
+
+
 //------------------------------------------------------------------------------
 
 InstanceClass::InstanceClass(const KernelSymbols *symbols, QScriptEngine *eng, KnowledgeSources src)
-    : QScriptClass(eng), _proto(0), _symbols(symbols)
+    : QScriptClass(eng), _proto(0), _addrProto(0), _membersClass(0),
+      _symbols(symbols)
 {
     qScriptRegisterMetaType<Instance>(eng, instToScriptValue, instFromScriptValue);
     qScriptRegisterMetaType<InstanceList>(eng, membersToScriptValue, membersFromScriptValue);
@@ -78,6 +242,20 @@ InstanceClass::InstanceClass(const KernelSymbols *symbols, QScriptEngine *eng, K
     QScriptValue global = eng->globalObject();
     _protoScriptVal.setPrototype(global.property("Object").property("prototype"));
 
+    // Cache the names of all callable methods of the prototype
+    const QMetaObject* mo = _proto->metaObject();
+    for (int i = 0; i < mo->methodCount(); ++i) {
+        QString s(mo->method(i).signature());
+        int pos = s.indexOf(QChar('('));
+        if (pos > 0)
+            s = s.left(pos);
+        _methodNames.insert(eng->toStringHandle(s));
+    }
+
+    _addrProto = new AddressPrototype();
+    _addrCtor = _addrProto->registerWith(eng);
+    _membersClass = new InstanceMembersClass(this);
+
     _ctor = eng->newFunction(construct, _protoScriptVal);
     _ctor.setData(qScriptValueFromValue(eng, this));
     _ctor.setProperty(js::useCandidates, eng->newFunction(getSetUseCandidates),
@@ -95,23 +273,21 @@ InstanceClass::~InstanceClass()
 {
 	if (_proto)
 		delete _proto;
+	if (_addrProto)
+		delete _addrProto;
+	if (_membersClass)
+		delete _membersClass;
 }
 
 
 QScriptClass::QueryFlags InstanceClass::queryProperty(const QScriptValue& object,
         const QScriptString& name, QueryFlags flags, uint* id)
 {
-    // Initialize set of callable methods for the first time
-    static QSet<QString> methodNames;
-    if (methodNames.isEmpty()) {
-        for (int i = 0; i < _proto->metaObject()->methodCount(); ++i) {
-            QString s(_proto->metaObject()->method(i).signature());
-            int pos = s.indexOf(QChar('('));
-            if (pos > 0)
-                s = s.left(pos);
-            methodNames.insert(s);
-        }
-    }
+    // Check if a slot with the same name exists in the prototype class.
+    // Slots have precedence over members with the same name. The member
+    // is still accessible using Member("name").
+    if (_methodNames.contains(name))
+        return 0;
 
     Instance *inst = qscriptvalue_cast<Instance*>(object.data());
     if (!inst)
@@ -119,12 +295,6 @@ QScriptClass::QueryFlags InstanceClass::queryProperty(const QScriptValue& object
 
     QString nameStr = name.toString();
 
-    // Check if a slot with the same name exists in the prototype class.
-    // Slots have precedence over members with the same name. The member
-    // is still accessible using Member("name").
-    if (methodNames.contains(nameStr))
-        return 0;
-
     // If we have a member with that index, we handle it as a property
     int index = inst->indexOfMember(nameStr);
     if (index >= 0) {
@@ -277,6 +447,19 @@ QScriptValue InstanceClass::newInstance(const Instance& inst)
 }
 
 
+QScriptValue InstanceClass::addressConstructor() const
+{
+    return _addrCtor;
+}
+
+
+QScriptValue InstanceClass::newMemberList(const Instance &inst,
+                                          KnowledgeSources src)
+{
+    return _membersClass->newMemberList(inst, src);
+}
+
+
 QScriptValue InstanceClass::construct(QScriptContext* ctx, QScriptEngine* eng)
 {
 	// Try to obtain the "this" object (set in the constructor)
@@ -360,7 +543,8 @@ QScriptValue InstanceClass::membersToScriptValue(QScriptEngine* eng, const Insta
 void InstanceClass::membersFromScriptValue(const QScriptValue& obj, InstanceList& list)
 {
     list.clear();
-    if (!obj.isArray())
+    // Accept arrays as well as lists returned by InstancePrototype::Members()
+    if (!obj.isArray() && !obj.property(js::length).isNumber())
         return;
 
     QScriptValue lenVal = obj.property(js::length);
@@ -6,17 +6,54 @@
  */
 
 #include <insight/instanceprototype.h>
+#include <insight/instanceclass.h>
 #include <QScriptEngine>
+#include <QVector>
 #include <insight/basetype.h>
 #include <insight/console.h>
 #include <insight/structured.h>
 #include <insight/symfactory.h>
 #include <insight/variable.h>
 #include <insight/function.h>
+#include <insight/virtualmemory.h>
 #include <debug.h>
 
 #define INT32MASK 0xFFFFFFFFULL
 
+namespace
+{
+/**
+ * Converts the value of \a member to a script value, see
+ * InstancePrototype::MemberValues().
+ */
+QScriptValue memberValue(QScriptEngine* eng, const Instance& member)
+{
+    Instance m = member.dereference(BaseType::trLexical);
+    if (m.isNull() || !m.isValid())
+        return eng->nullValue();
+
+    int type = m.type()->type();
+    if (type & (rtPointer|rtFuncPointer))
+        return AddressPrototype::toScriptValue(
+                    eng, ScriptAddress((quint64)m.toPointer()));
+    else if (type & IntegerTypes) {
+        if (m.size() == 8 && m.bitSize() < 0)
+            return AddressPrototype::toScriptValue(
+                        eng, ScriptAddress(m.toUInt64()));
+        else if (type & (SignedIntegerTypes|rtEnum))
+            return QScriptValue(eng, (double) m.toNumber());
+        else
+            return QScriptValue(eng, (double) m.toUnsignedNumber());
+    }
+    else if (type == rtFloat)
+        return QScriptValue(eng, m.toFloat());
+    else if (type == rtDouble)
+        return QScriptValue(eng, m.toDouble());
+
+    return eng->toScriptValue(member);
+}
+}
+
 InstancePrototype::InstancePrototype(const SymFactory *factory, QObject *parent)
     : QObject(parent), _factory(factory)
 {
@@ -67,6 +104,28 @@ void InstancePrototype::SetAddress(QString addrStr)
 }
 
 
+ScriptAddress InstancePrototype::AddressValue() const
+{
+    Instance* inst;
+    return ((inst = thisInstance())) ? ScriptAddress(inst->address()) :
+                                       ScriptAddress();
+}
+
+
+void InstancePrototype::SetAddressValue(const QScriptValue &addr)
+{
+    Instance* inst = thisInstance();
+    if (!inst)
+        return;
+    bool ok;
+    quint64 value = AddressPrototype::valueFromScriptValue(addr, &ok);
+    if (ok)
+        inst->setAddress(value);
+    else
+        injectScriptError(QString("Illegal address: %1").arg(addr.toString()));
+}
+
+
 quint32 InstancePrototype::AddressHigh() const
 {
     Instance* inst;
@@ -249,11 +308,38 @@ QStringList InstancePrototype::MemberNames() const
 }
 
 
-InstanceList InstancePrototype::Members(bool declaredTypes) const
+QScriptValue InstancePrototype::Members(bool declaredTypes) const
 {
-	Instance* inst;
-	return ((inst = thisInstance())) ?
-				inst->members(declaredTypes ? ksNone : _knowSrc) : InstanceList();
+    Instance* inst = thisInstance();
+    if (!inst)
+        return QScriptValue();
+
+    KnowledgeSources src = declaredTypes ? ksNone : _knowSrc;
+    // Create the members lazily, if possible
+    InstanceClass* cls = dynamic_cast<InstanceClass*>(thisObject().scriptClass());
+    if (cls)
+        return cls->newMemberList(*inst, src);
+    return engine()->toScriptValue(inst->members(src));
+}
+
+
+QScriptValue InstancePrototype::MemberValues(const QStringList &names) const
+{
+    Instance* inst = thisInstance();
+    if (!inst)
+        return QScriptValue();
+
+    QScriptValue ret = engine()->newArray(names.size());
+    try {
+        for (int i = 0; i < names.size(); ++i) {
+            Instance m = inst->member(names[i], BaseType::trLexical, 0, ksNone);
+            ret.setProperty(i, memberValue(engine(), m));
+        }
+    }
+    catch (GenericException& e) {
+        injectScriptError(e);
+    }
+    return ret;
 }
 
 
@@ -460,6 +546,52 @@ QString InstancePrototype::MemberAddress(const QString &name,
 }
 
 
+ScriptAddress InstancePrototype::MemberAddressValue(const QString &name,
+                                                   bool declaredType) const
+{
+    Instance* inst;
+    return ((inst = thisInstance()))
+            ? ScriptAddress(inst->memberAddress(name, 0, 0, declaredType ?
+                                                    ksNone : _knowSrc))
+            : ScriptAddress();
+}
+
+
+QScriptValue InstancePrototype::ReadUInt32Array(int count) const
+{
+    Instance* inst = thisInstance();
+    if (!inst)
+        return QScriptValue();
+
+    QVector<quint32> buf(qMax(count, 0));
+    if (!readMemory(inst, (char*)buf.data(), buf.size() * sizeof(quint32)))
+        return QScriptValue();
+
+    QScriptValue ret = engine()->newArray(buf.size());
+    for (int i = 0; i < buf.size(); ++i)
+        ret.setProperty(i, QScriptValue(engine(), buf[i]));
+    return ret;
+}
+
+
+QScriptValue InstancePrototype::ReadUInt64Array(int count) const
+{
+    Instance* inst = thisInstance();
+    if (!inst)
+        return QScriptValue();
+
+    QVector<quint64> buf(qMax(count, 0));
+    if (!readMemory(inst, (char*)buf.data(), buf.size() * sizeof(quint64)))
+        return QScriptValue();
+
+    QScriptValue ret = engine()->newArray(buf.size());
+    for (int i = 0; i < buf.size(); ++i)
+        ret.setProperty(i, AddressPrototype::toScriptValue(
+                            engine(), ScriptAddress(buf[i])));
+    return ret;
+}
+
+
 int InstancePrototype::SizeofPointer() const
 {
     Instance* inst;
@@ -774,6 +906,29 @@ Instance* InstancePrototype::thisInstance() const
 }
 
 
+bool InstancePrototype::readMemory(const Instance *inst, char *buf,
+                                   qint64 size) const
+{
+    if (size <= 0)
+        return true;
+    try {
+        if (inst->vmem() &&
+            inst->vmem()->readAtomic(inst->address(), buf, size) == size)
+            return true;
+    }
+    catch (GenericException& e) {
+        injectScriptError(e);
+        return false;
+    }
+
+    injectScriptError(QString("Error reading %1 byte from memory position "
+                              "0x%2")
+                      .arg(size)
+                      .arg(inst->address(), 0, 16));
+    return false;
+}
+
+
 void InstancePrototype::injectScriptError(const GenericException& e) const
 {
     QString msg = QString("%1: %2")
@@ -15,6 +15,7 @@
 #include <abstractsyntaxtree.h>
 #include <insight/console.h>
 #include <insight/astexpressionevaluator.h>
+#include <insight/typeusagelog.h>
 #include "expressionevalexception.h"
 #include "typeevaluatorexception.h"
 
@@ -26,7 +27,7 @@ KernelSourceTypeEvaluator::KernelSourceTypeEvaluator(AbstractSyntaxTree* ast,
                        factory->memSpecs().sizeofLong,
                        factory->memSpecs().sizeofPointer,
                        factory),
-      _factory(factory), _eval(0)
+      _factory(factory), _eval(0), _usageLog(0)
 {
     _eval = new ASTExpressionEvaluator(this, _factory);
 }
@@ -39,6 +40,32 @@ KernelSourceTypeEvaluator::~KernelSourceTypeEvaluator()
 }
 
 
+void KernelSourceTypeEvaluator::magicNumberNotConstant(StructuredMember *member)
+{
+    member->evaluateMagicNumberFoundNotConstant();
+    if (_usageLog)
+        _usageLog->addNotConstant(member);
+}
+
+
+void KernelSourceTypeEvaluator::magicNumberConstant(StructuredMember *member,
+                                                    qint64 value)
+{
+    member->evaluateMagicNumberFoundInt(value);
+    if (_usageLog)
+        _usageLog->addConstant(member, value);
+}
+
+
+void KernelSourceTypeEvaluator::magicNumberConstant(StructuredMember *member,
+                                                    const QString &value)
+{
+    member->evaluateMagicNumberFoundString(value);
+    if (_usageLog)
+        _usageLog->addConstant(member, value);
+}
+
+
 void KernelSourceTypeEvaluator::primaryExpressionTypeChange(
         const TypeEvalDetails &ed)
 {
@@ -110,6 +137,8 @@ void KernelSourceTypeEvaluator::primaryExpressionTypeChange(
         _factory->typeAlternateUsage(&ed, this);
     }
     catch (FactoryException& e) {
+        if (_usageLog)
+            _usageLog->invalidate();
         // Print the source of the embedding external declaration
         const ASTNode* n = ed.srcNode;
         while (n && n->parent && n->type != nt_function_definition)
@@ -454,17 +483,17 @@ void KernelSourceTypeEvaluator::evaluateMagicNumbers_initializer(
             }
 
             if ((!intConst && !stringConst)){
-                member->evaluateMagicNumberFoundNotConstant();
+                magicNumberNotConstant(member);
 #ifdef DEBUGMAGICNUMBERS
                 string.append(QString("Found not constant\n"));
 #endif /* DEBUGMAGICNUMBERS */
             } else if(intConst){
-                member->evaluateMagicNumberFoundInt(resultInt);
+                magicNumberConstant(member, resultInt);
 #ifdef DEBUGMAGICNUMBERS
                 string.append(QString("Found constant Int: %1\n").arg(resultInt));
 #endif /* DEBUGMAGICNUMBERS */
             } else if (stringConst) {
-                member->evaluateMagicNumberFoundString(resultString);
+                magicNumberConstant(member, resultString);
 #ifdef DEBUGMAGICNUMBERS
                 string.append(QString("Found constant String: %1\n").arg(resultString));
 #endif /* DEBUGMAGICNUMBERS */
@@ -631,7 +660,7 @@ void KernelSourceTypeEvaluator::evaluateMagicNumbers(const ASTNode *node)
 
                             case nt_postfix_expression_inc:
                             case nt_postfix_expression_dec:
-                                if (member) member->evaluateMagicNumberFoundNotConstant();
+                                if (member) magicNumberNotConstant(member);
                                 return;
 
                             default:
@@ -724,7 +753,7 @@ void KernelSourceTypeEvaluator::evaluateMagicNumbers(const ASTNode *node)
                 case nt_unary_expression_op:
                     while(localNode->parent){
                         if (localNode->parent->type == nt_postfix_expression_parens){
-                            member->evaluateMagicNumberFoundNotConstant();
+                            magicNumberNotConstant(member);
                             return;
                         }
                         localNode = localNode->parent;
@@ -733,7 +762,7 @@ void KernelSourceTypeEvaluator::evaluateMagicNumbers(const ASTNode *node)
 
                 case nt_unary_expression_dec:
                 case nt_unary_expression_inc:
-                    member->evaluateMagicNumberFoundNotConstant();
+                    magicNumberNotConstant(member);
                     return;
                 
                 default:
@@ -753,7 +782,7 @@ void KernelSourceTypeEvaluator::evaluateMagicNumbers(const ASTNode *node)
         
         if (antlrTokenToStr(localNode->u.assignment_expression.assignment_operator) != "=")
         {
-            if(member) member->evaluateMagicNumberFoundNotConstant();
+            if(member) magicNumberNotConstant(member);
             return;
         }
 
@@ -777,17 +806,17 @@ void KernelSourceTypeEvaluator::evaluateMagicNumbers(const ASTNode *node)
                     string);
 
             if ((!intConst && !stringConst)){
-                member->evaluateMagicNumberFoundNotConstant();
+                magicNumberNotConstant(member);
 #ifdef DEBUGMAGICNUMBERS
                 string.append(QString("Found not constant\n"));
 #endif /* DEBUGMAGICNUMBERS */
             } else if(intConst){
-                member->evaluateMagicNumberFoundInt(resultInt);
+                magicNumberConstant(member, resultInt);
 #ifdef DEBUGMAGICNUMBERS
                 string.append(QString("Found constant Int: %1\n").arg(resultInt));
 #endif /* DEBUGMAGICNUMBERS */
             } else if (stringConst) {
-                member->evaluateMagicNumberFoundString(resultString);
+                magicNumberConstant(member, resultString);
 #ifdef DEBUGMAGICNUMBERS
                 string.append(QString("Found constant String: %1\n").arg(resultString));
 #endif /* DEBUGMAGICNUMBERS */
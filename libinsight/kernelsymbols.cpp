@@ -30,6 +30,7 @@
 #include <insight/typerulereader.h>
 #include <insight/osfilter.h>
 #include <insight/errorcodes.h>
+#include <insight/detect.h>
 
 
 //------------------------------------------------------------------------------
@@ -329,8 +330,12 @@ int KernelSymbols::unloadMemDump(const QString &indexOrFileName,
         // Finally, delete the memory dump
         if (unloadedFile)
             *unloadedFile = _memDumps[ret]->fileName();
+        // Monitor results must not carry over to a dump at the same address
+        Detect::resetMonitor(_memDumps[ret]);
         delete _memDumps[ret];
         _memDumps[ret] = 0;
+        // Cached rule results may refer to the deleted memory
+        _ruleEngine.invalidateResultCache();
     }
 
     return ret;
@@ -30,7 +30,7 @@ KernelSymbolsClass::~KernelSymbolsClass()
 
 template <class T>
 inline QScriptValue KernelSymbolsClass::listGeneric(QString filter, int index,
-		const QList<T*>& list, const QMultiHash<QString, T*>& hash,
+		const QList<T*>& list, const QMultiHash<StringAtom, T*>& hash,
 		Instance (getInst)(const T*, VirtualMemory*))
 {
 	typedef QList<T*> ListT;
@@ -51,7 +51,7 @@ inline QScriptValue KernelSymbolsClass::listGeneric(QString filter, int index,
 	QRegExp rxNoWC("[_a-zA-Z0-9]+");
 	if (applyFilter && rxNoWC.exactMatch(filter)) {
 		// Use the name hash
-		ListT types = hash.values(filter);
+		ListT types = hash.values(StringAtoms::find(filter));
 		for (typename ListT::const_iterator it = types.begin(); it != types.end();
 				++it)
 		{
@@ -123,7 +123,11 @@ QStringList KernelSymbolsClass::typeNames() const
 	if (!_symbols)
 		return QStringList();
 
-	return _symbols->factory().typesByName().uniqueKeys();
+	QStringList ret;
+	foreach (StringAtom a, _symbols->factory().typesByName().uniqueKeys())
+		ret += StringAtoms::string(a);
+	ret.sort();
+	return ret;
 }
 
 
@@ -143,7 +147,11 @@ QStringList KernelSymbolsClass::variableNames() const
 	if (!_symbols)
 		return QStringList();
 
-	return _symbols->factory().varsByName().uniqueKeys();
+	QStringList ret;
+	foreach (StringAtom a, _symbols->factory().varsByName().uniqueKeys())
+		ret += StringAtoms::string(a);
+	ret.sort();
+	return ret;
 }
 
 
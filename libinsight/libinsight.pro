@@ -29,6 +29,7 @@ QT -= gui webkit
 HEADERS += \
     eventloopthread.h \
     sockethelper.h \
+    include/insight/addressprototype.h \
     include/insight/altreftype.h \
     include/insight/array.h \
     include/insight/astexpressionevaluator.h \
@@ -41,6 +42,7 @@ HEADERS += \
     include/insight/consttype.h \
     include/insight/devicemuxer.h \
     include/insight/enum.h \
+    include/insight/expressionprogram.h \
     include/insight/expressionresult.h \
     include/insight/funcparam.h \
     include/insight/funcpointer.h \
@@ -73,16 +75,21 @@ HEADERS += \
     include/insight/memorymapverifier.h \
     include/insight/memspecparser.h \
     include/insight/memspecs.h \
+    include/insight/moduleindex.h \
     include/insight/multithreading.h \
     include/insight/numeric.h \
     include/insight/osfilter.h \
+    include/insight/pagedigest.h \
     include/insight/pointer.h \
     include/insight/refbasetype.h \
+    include/insight/ruleresultcache.h \
     include/insight/referencingtype.h \
+    include/insight/scriptbatch.h \
     include/insight/scriptengine.h \
     include/insight/shellutil.h \
     include/insight/slubobjects.h \
     include/insight/sourceref.h \
+    include/insight/stringatoms.h \
     include/insight/structured.h \
     include/insight/structuredmember.h \
     include/insight/symbol.h \
@@ -95,6 +102,7 @@ HEADERS += \
     include/insight/typerule.h \
     include/insight/typeruleparser.h \
     include/insight/typerulereader.h \
+    include/insight/typeusagelog.h \
     include/insight/variable.h \
     include/insight/virtualmemory.h \
     include/insight/volatiletype.h \
@@ -105,6 +113,7 @@ HEADERS += \
     include/insight/detect.h
 
 SOURCES += \
+    addressprototype.cpp \
     altreftype.cpp \
     array.cpp \
     astexpression.cpp \
@@ -118,6 +127,7 @@ SOURCES += \
     devicemuxer.cpp \
     enum.cpp \
     eventloopthread.cpp \
+    expressionprogram.cpp \
     expressionresult.cpp \
     funcparam.cpp \
     funcpointer.cpp \
@@ -150,17 +160,22 @@ SOURCES += \
     memorymapverifier.cpp \
     memspecparser.cpp \
     memspecs.cpp \
+    moduleindex.cpp \
     multithreading.cpp \
     numeric.cpp \
     osfilter.cpp \
+    pagedigest.cpp \
     pointer.cpp \
     refbasetype.cpp \
+    ruleresultcache.cpp \
     referencingtype.cpp \
+    scriptbatch.cpp \
     scriptengine.cpp \
     shellutil.cpp \
     slubobjects.cpp \
     sockethelper.cpp \
     sourceref.cpp \
+    stringatoms.cpp \
     structured.cpp \
     structuredmember.cpp \
     symbol.cpp \
@@ -173,6 +188,7 @@ SOURCES += \
     typeruleengine.cpp \
     typeruleparser.cpp \
     typerulereader.cpp \
+    typeusagelog.cpp \
     variable.cpp \
     virtualmemory.cpp \
     volatiletype.cpp \
@@ -197,7 +197,7 @@ BaseType* MemoryDump::getType(const QString& type) const
 
 	// Resolve type
 	// Try to find the given type by name
-	QList<BaseType *> results = _factory->typesByName().values(type);
+	QList<BaseType *> results = _factory->typesByName().values(StringAtoms::find(type));
 
 	if(results.size() > 0) {
 		// Check if type is ambiguous
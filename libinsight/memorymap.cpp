@@ -36,19 +36,9 @@ static const int interestingTypes =
         BaseType::trLexical |
         rtFuncPointer;
 
-// static variable
-StringSet MemoryMap::_names;
-
-
 const QString& MemoryMap::insertName(const QString& name)
 {
-    static QMutex mutex;
-    QMutexLocker lock(&mutex);
-
-    StringSet::const_iterator it = _names.constFind(name);
-    if (it == _names.constEnd())
-        it = _names.insert(name);
-    return *it;
+    return StringAtoms::string(StringAtoms::atom(name));
 }
 
 
@@ -0,0 +1,179 @@
+#include <insight/moduleindex.h>
+#include <insight/symfactory.h>
+#include <insight/structured.h>
+#include <insight/variable.h>
+#include <insight/virtualmemory.h>
+#include <debug.h>
+#include <QtAlgorithms>
+
+
+ModuleIndex::ModuleIndex()
+    : _vmem(0)
+{
+}
+
+
+void ModuleIndex::clear()
+{
+    _vmem = 0;
+    _modules.clear();
+    _regions.clear();
+    _byName.clear();
+}
+
+
+QString ModuleIndex::normalizedName(const QString &name)
+{
+    QString ret(name);
+    ret.remove(QChar('"'));
+    ret.replace(QChar('-'), QChar('_'));
+    return ret;
+}
+
+
+void ModuleIndex::addRegion(quint64 start, quint64 size, RegionType type,
+                            int module)
+{
+    if (start && size)
+        _regions.append(Region(start, start + size, type, module));
+}
+
+
+int ModuleIndex::build(const SymFactory &factory, VirtualMemory *vmem)
+{
+    clear();
+
+    const Variable *varModules = factory.findVarByName("modules");
+    const Structured *typeModule = dynamic_cast<const Structured *>
+            (factory.findBaseTypeByName("module"));
+    if (!varModules || !typeModule) {
+        debugerr("Variable \"modules\" or type \"struct module\" does not "
+                 "exist, cannot build the module index.");
+        return 0;
+    }
+
+    _vmem = vmem;
+
+    // Not all kernels have all of these members
+    const bool hasCore = typeModule->memberExists("module_core", false);
+    const bool hasCoreSize = typeModule->memberExists("core_size", false);
+    const bool hasCoreText = typeModule->memberExists("core_text_size", false);
+    const bool hasInit = typeModule->memberExists("module_init", false);
+    const bool hasInitSize = typeModule->memberExists("init_size", false);
+    const bool hasInitText = typeModule->memberExists("init_text_size", false);
+
+    // Don't depend on the rule engine
+    const int listOffset = typeModule->memberOffset("list");
+    Instance firstModule = varModules->toInstance(vmem).member("next", BaseType::trAny, -1, ksNone);
+    firstModule.setType(typeModule);
+    firstModule.addToAddress(-listOffset);
+
+    Instance currentModule(firstModule);
+
+    while (currentModule.address() != varModules->offset() - listOffset) {
+        ModuleInfo mod;
+        mod.module = currentModule;
+        mod.name = currentModule.member("name").toString().remove(QChar('"'));
+        if (hasCore)
+            mod.core = (quint64)currentModule.member("module_core").toPointer();
+        if (hasCoreSize)
+            mod.coreSize = currentModule.member("core_size").toULong();
+        if (hasCoreText)
+            mod.coreTextSize = currentModule.member("core_text_size").toULong();
+        if (hasInit)
+            mod.init = (quint64)currentModule.member("module_init").toPointer();
+        if (hasInitSize)
+            mod.initSize = currentModule.member("init_size").toULong();
+        if (hasInitText)
+            mod.initTextSize = currentModule.member("init_text_size").toULong();
+
+        addModule(mod);
+
+        // Don't depend on the rule engine
+        currentModule = currentModule.member("list").member("next", BaseType::trAny, -1, ksNone);
+        currentModule.setType(typeModule);
+        currentModule.addToAddress(-listOffset);
+
+        if (currentModule.address() == firstModule.address())
+            break;
+    }
+
+    qSort(_regions);
+
+    return _modules.size();
+}
+
+
+int ModuleIndex::build(const QList<ModuleInfo> &modules, VirtualMemory *vmem)
+{
+    clear();
+    _vmem = vmem;
+
+    for (int i = 0; i < modules.size(); ++i)
+        addModule(modules[i]);
+
+    qSort(_regions);
+
+    return _modules.size();
+}
+
+
+void ModuleIndex::addModule(const ModuleInfo &module)
+{
+    ModuleInfo mod(module);
+
+    // The text always comes first within a region
+    if (mod.coreSize && mod.coreTextSize > mod.coreSize)
+        mod.coreTextSize = mod.coreSize;
+    if (mod.initSize && mod.initTextSize > mod.initSize)
+        mod.initTextSize = mod.initSize;
+
+    const int idx = _modules.size();
+    addRegion(mod.core, mod.coreTextSize, rtCoreText, idx);
+    if (mod.coreSize > mod.coreTextSize)
+        addRegion(mod.core + mod.coreTextSize, mod.coreSize - mod.coreTextSize,
+                  rtCoreData, idx);
+    addRegion(mod.init, mod.initTextSize, rtInitText, idx);
+    if (mod.initSize > mod.initTextSize)
+        addRegion(mod.init + mod.initTextSize, mod.initSize - mod.initTextSize,
+                  rtInitData, idx);
+
+    _byName.insert(normalizedName(mod.name), idx);
+    _modules.append(mod);
+}
+
+
+const ModuleInfo* ModuleIndex::moduleAt(quint64 address, RegionType *type) const
+{
+    if (_regions.isEmpty())
+        return 0;
+
+    // Find the last region that starts at or before address
+    QList<Region>::const_iterator it =
+            qUpperBound(_regions.constBegin(), _regions.constEnd(),
+                        Region(address));
+    if (it == _regions.constBegin())
+        return 0;
+    --it;
+
+    if (address >= it->end)
+        return 0;
+
+    if (type)
+        *type = it->type;
+    return &_modules[it->module];
+}
+
+
+bool ModuleIndex::inCoreText(quint64 address) const
+{
+    RegionType type;
+    return moduleAt(address, &type) && type == rtCoreText;
+}
+
+
+const ModuleInfo* ModuleIndex::moduleByName(const QString &name) const
+{
+    QHash<QString, int>::const_iterator it = _byName.find(normalizedName(name));
+    return (it == _byName.constEnd()) ? 0 : &_modules[it.value()];
+}
@@ -0,0 +1,236 @@
+#include <insight/pagedigest.h>
+#include <QCryptographicHash>
+#include <QtEndian>
+#include <string.h>
+
+// Constants and round functions as defined by the xxHash specification
+#define XXH_PRIME64_1 0x9E3779B185EBCA87ULL
+#define XXH_PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define XXH_PRIME64_3 0x165667B19E3779F9ULL
+#define XXH_PRIME64_4 0x85EBCA77C2B2CA63ULL
+#define XXH_PRIME64_5 0x27D4EB2F165667C5ULL
+
+PageDigest::Algorithm PageDigest::_defaultAlgorithm = PageDigest::daSha1;
+
+
+static inline quint64 rotl64(quint64 x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+
+static inline quint64 read64(const char* p)
+{
+    quint64 v;
+    memcpy(&v, p, sizeof(v));
+    return qFromLittleEndian(v);
+}
+
+
+static inline quint32 read32(const char* p)
+{
+    quint32 v;
+    memcpy(&v, p, sizeof(v));
+    return qFromLittleEndian(v);
+}
+
+
+static inline quint64 xxhRound(quint64 acc, quint64 input)
+{
+    acc += input * XXH_PRIME64_2;
+    acc = rotl64(acc, 31);
+    return acc * XXH_PRIME64_1;
+}
+
+
+static inline quint64 xxhMergeRound(quint64 acc, quint64 val)
+{
+    acc ^= xxhRound(0, val);
+    return acc * XXH_PRIME64_1 + XXH_PRIME64_4;
+}
+
+
+PageDigest::PageDigest(Algorithm algorithm)
+    : _algorithm(algorithm), _sha1(0)
+{
+    if (_algorithm == daSha1)
+        _sha1 = new QCryptographicHash(QCryptographicHash::Sha1);
+    reset();
+}
+
+
+PageDigest::~PageDigest()
+{
+    delete _sha1;
+}
+
+
+void PageDigest::reset()
+{
+    if (_sha1) {
+        _sha1->reset();
+        return;
+    }
+
+    _v[0] = XXH_PRIME64_1 + XXH_PRIME64_2;
+    _v[1] = XXH_PRIME64_2;
+    _v[2] = 0;
+    _v[3] = 0 - XXH_PRIME64_1;
+    _total = 0;
+    _bufSize = 0;
+}
+
+
+void PageDigest::xxhConsume(const char *data, int length)
+{
+    // Process full stripes of 32 bytes
+    const char* end = data + length;
+    quint64 v0 = _v[0], v1 = _v[1], v2 = _v[2], v3 = _v[3];
+    for (; data + 32 <= end; data += 32) {
+        v0 = xxhRound(v0, read64(data));
+        v1 = xxhRound(v1, read64(data + 8));
+        v2 = xxhRound(v2, read64(data + 16));
+        v3 = xxhRound(v3, read64(data + 24));
+    }
+    _v[0] = v0; _v[1] = v1; _v[2] = v2; _v[3] = v3;
+}
+
+
+void PageDigest::addData(const char *data, int length)
+{
+    if (_sha1) {
+        _sha1->addData(data, length);
+        return;
+    }
+
+    if (length <= 0)
+        return;
+    _total += length;
+
+    // Complete a partial stripe first
+    if (_bufSize) {
+        int n = qMin(32 - _bufSize, length);
+        memcpy(_buf + _bufSize, data, n);
+        _bufSize += n;
+        data += n;
+        length -= n;
+        if (_bufSize < 32)
+            return;
+        xxhConsume(_buf, 32);
+        _bufSize = 0;
+    }
+
+    int full = length & ~31;
+    xxhConsume(data, full);
+
+    // Keep the remainder for the next call or the final result
+    _bufSize = length - full;
+    memcpy(_buf, data + full, _bufSize);
+}
+
+
+QByteArray PageDigest::result() const
+{
+    if (_sha1)
+        return _sha1->result();
+
+    quint64 h;
+    if (_total >= 32) {
+        h = rotl64(_v[0], 1) + rotl64(_v[1], 7) + rotl64(_v[2], 12) +
+            rotl64(_v[3], 18);
+        h = xxhMergeRound(h, _v[0]);
+        h = xxhMergeRound(h, _v[1]);
+        h = xxhMergeRound(h, _v[2]);
+        h = xxhMergeRound(h, _v[3]);
+    }
+    else
+        h = _v[2] + XXH_PRIME64_5;
+
+    h += _total;
+
+    const char* p = _buf;
+    const char* end = _buf + _bufSize;
+    for (; p + 8 <= end; p += 8) {
+        h ^= xxhRound(0, read64(p));
+        h = rotl64(h, 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+    }
+    if (p + 4 <= end) {
+        h ^= (quint64)read32(p) * XXH_PRIME64_1;
+        h = rotl64(h, 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+        p += 4;
+    }
+    for (; p < end; ++p) {
+        h ^= (quint64)(quint8)*p * XXH_PRIME64_5;
+        h = rotl64(h, 11) * XXH_PRIME64_1;
+    }
+
+    h ^= h >> 33;
+    h *= XXH_PRIME64_2;
+    h ^= h >> 29;
+    h *= XXH_PRIME64_3;
+    h ^= h >> 32;
+
+    // Canonical representation is big endian
+    QByteArray ret(sizeof(h), Qt::Uninitialized);
+    qToBigEndian(h, (uchar*)ret.data());
+    return ret;
+}
+
+
+QByteArray PageDigest::hash(const QByteArray &data, Algorithm algorithm)
+{
+    PageDigest d(algorithm);
+    d.addData(data);
+    return d.result();
+}
+
+
+int PageDigest::digestSize(Algorithm algorithm)
+{
+    return algorithm == daSha1 ? 20 : 8;
+}
+
+
+bool PageDigest::isCryptographic(Algorithm algorithm)
+{
+    return algorithm == daSha1;
+}
+
+
+PageDigest::Algorithm PageDigest::defaultAlgorithm()
+{
+    return _defaultAlgorithm;
+}
+
+
+void PageDigest::setDefaultAlgorithm(Algorithm algorithm)
+{
+    _defaultAlgorithm = algorithm;
+}
+
+
+int PageDigest::firstDifference(const char *a, const char *b, int from,
+                                int size)
+{
+    int i = from;
+
+    // Compare four words at once as long as they are equal, the compiler
+    // vectorizes this loop
+    for (; i + 32 <= size; i += 32) {
+        quint64 x = 0;
+        for (int j = 0; j < 32; j += 8) {
+            quint64 wa, wb;
+            memcpy(&wa, a + i + j, sizeof(wa));
+            memcpy(&wb, b + i + j, sizeof(wb));
+            x |= wa ^ wb;
+        }
+        if (x)
+            break;
+    }
+
+    for (; i < size; ++i)
+        if (a[i] != b[i])
+            return i;
+
+    return size;
+}
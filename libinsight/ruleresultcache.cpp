@@ -0,0 +1,101 @@
+#include <insight/ruleresultcache.h>
+#include <insight/instance.h>
+
+
+bool RuleResultKey::set(const Instance *inst, const ConstMemberList &members)
+{
+    if (members.size() > maxMembers)
+        return false;
+
+    address = inst->address();
+    vmem = inst->vmem();
+    type = inst->type();
+    memberCount = members.size();
+    for (int i = 0; i < maxMembers; ++i)
+        this->members[i] = (i < memberCount) ? members[i] : 0;
+
+    return true;
+}
+
+
+bool RuleResultKey::operator==(const RuleResultKey &other) const
+{
+    if (address != other.address || type != other.type ||
+        vmem != other.vmem || memberCount != other.memberCount)
+        return false;
+    for (int i = 0; i < memberCount; ++i)
+        if (members[i] != other.members[i])
+            return false;
+    return true;
+}
+
+
+uint qHash(const RuleResultKey &key)
+{
+    uint h = qHash(key.address) ^ qHash(key.type) ^ (qHash(key.vmem) << 3);
+    for (int i = 0; i < key.memberCount; ++i)
+        h = ((h << 5) | (h >> 27)) ^ qHash(key.members[i]);
+    return h;
+}
+
+
+RuleResultCache::RuleResultCache()
+    : _maxSize(0)
+{
+    setMaxSize(0);
+}
+
+
+void RuleResultCache::setMaxSize(int size)
+{
+    _maxSize = size > 0 ? size : 0;
+    // Each shard holds an equal share of the entries
+    int shardSize = (_maxSize + shardCount - 1) / shardCount;
+    for (int i = 0; i < shardCount; ++i) {
+        QMutexLocker lock(&_shards[i].lock);
+        _shards[i].cache.setMaxCost(shardSize);
+    }
+}
+
+
+bool RuleResultCache::find(const RuleResultKey &key, RuleResult *result)
+{
+    Shard& s = shard(key);
+    s.lock.lock();
+    const RuleResult* r = s.cache.object(key);
+    if (r)
+        *result = *r;
+    s.lock.unlock();
+
+    if (r)
+        _hits.fetchAndAddRelaxed(1);
+    else
+        _misses.fetchAndAddRelaxed(1);
+    return r != 0;
+}
+
+
+void RuleResultCache::insert(const RuleResultKey &key, const RuleResult &result)
+{
+    if (!_maxSize)
+        return;
+    Shard& s = shard(key);
+    QMutexLocker lock(&s.lock);
+    s.cache.insert(key, new RuleResult(result));
+}
+
+
+void RuleResultCache::clear()
+{
+    for (int i = 0; i < shardCount; ++i) {
+        QMutexLocker lock(&_shards[i].lock);
+        _shards[i].cache.clear();
+    }
+}
+
+
+void RuleResultCache::resetStatistics()
+{
+    _hits = 0;
+    _misses = 0;
+}
@@ -0,0 +1,192 @@
+#include <insight/scriptbatch.h>
+#include <insight/scriptengine.h>
+#include <insight/kernelsymbols.h>
+#include <insight/memorydump.h>
+#include <insight/multithreading.h>
+#include <insight/console.h>
+#include <QScriptEngine>
+#include <QTime>
+
+
+QDataStream& operator<<(QDataStream& out, const ScriptBatchResult& result)
+{
+    out << (qint32) result.memDumpIndex << result.fileName << result.output
+        << result.result << result.error << result.failed
+        << (qint32) result.duration;
+    return out;
+}
+
+
+QDataStream& operator>>(QDataStream& in, ScriptBatchResult& result)
+{
+    qint32 index, duration;
+    in >> index >> result.fileName >> result.output >> result.result
+       >> result.error >> result.failed >> duration;
+    result.memDumpIndex = index;
+    result.duration = duration;
+    return in;
+}
+
+
+//------------------------------------------------------------------------------
+// ScriptBatch::WorkerThread
+//------------------------------------------------------------------------------
+
+ScriptBatch::WorkerThread::WorkerThread(ScriptBatch *batch)
+    : TypeRuleEngineContextProvider(batch->_symbols), _batch(batch),
+      _engine(0)
+{
+}
+
+
+ScriptBatch::WorkerThread::~WorkerThread()
+{
+}
+
+
+void ScriptBatch::WorkerThread::terminateScript()
+{
+    QMutexLocker lock(&_engineMutex);
+    if (_engine)
+        _engine->terminateScript();
+}
+
+
+void ScriptBatch::WorkerThread::run()
+{
+    // Create the engine within this thread
+    ScriptEngine engine(_batch->_symbols, _batch->_knowSrc);
+    _engineMutex.lock();
+    _engine = &engine;
+    _engineMutex.unlock();
+
+    QMutexLocker indexLock(&_batch->_indexMutex);
+
+    while (!Console::interrupted() &&
+           _batch->_nextIndex < _batch->_indices.size())
+    {
+        int i = _batch->_nextIndex++;
+        ScriptBatchResult res(_batch->_results.at(i));
+        indexLock.unlock();
+
+        QTime timer;
+        timer.start();
+
+        // Every memory dump gets a fresh scripting environment
+        _engineMutex.lock();
+        engine.reset();
+        engine.initScriptEngine();
+        _engineMutex.unlock();
+
+        res.failed = false;
+        res.error.clear();
+        engine.setOutputBuffer(&res.output);
+        QScriptValue ret(engine.evaluate(_batch->_code, _batch->_argv,
+                                         _batch->_includePaths,
+                                         res.memDumpIndex));
+        engine.setOutputBuffer(0);
+
+        if (engine.hasUncaughtException()) {
+            res.failed = true;
+            res.error = QString("Exception occured on line %1: %2")
+                    .arg(engine.uncaughtExceptionLineNumber())
+                    .arg(engine.uncaughtException().toString());
+            QStringList bt = engine.uncaughtExceptionBacktrace();
+            for (int j = 0; j < bt.size(); ++j)
+                res.error += "\n    " + bt[j];
+        }
+        else if (ret.isError()) {
+            res.failed = true;
+            res.error = ret.toString();
+        }
+        else if (!ret.isUndefined())
+            res.result = ret.toString();
+        res.duration = timer.elapsed();
+
+        indexLock.relock();
+        _batch->_results[i] = res;
+    }
+
+    indexLock.unlock();
+
+    _engineMutex.lock();
+    _engine = 0;
+    _engineMutex.unlock();
+}
+
+
+//------------------------------------------------------------------------------
+// ScriptBatch
+//------------------------------------------------------------------------------
+
+ScriptBatch::ScriptBatch(KernelSymbols *symbols, int knowledgeSources)
+    : _symbols(symbols), _knowSrc(knowledgeSources), _nextIndex(0)
+{
+}
+
+
+ScriptBatch::~ScriptBatch()
+{
+    terminateWorkers();
+    for (int i = 0; i < _threads.size(); ++i)
+        _threads[i]->wait();
+    qDeleteAll(_threads);
+}
+
+
+void ScriptBatch::terminateWorkers()
+{
+    for (int i = 0; i < _threads.size(); ++i)
+        _threads[i]->terminateScript();
+}
+
+
+ScriptBatchResultList ScriptBatch::run(const QString &code,
+                                       const QStringList &argv,
+                                       const QStringList &includePaths,
+                                       const QList<int> &memDumpIndices)
+{
+    _code = code;
+    _argv = argv;
+    _includePaths = includePaths;
+    _indices = memDumpIndices;
+    _nextIndex = 0;
+
+    // Prepare one result per memory dump, so that we can tell which scripts
+    // did not run in case of an interruption
+    _results.clear();
+    for (int i = 0; i < _indices.size(); ++i) {
+        ScriptBatchResult res;
+        res.memDumpIndex = _indices[i];
+        const MemoryDump* dump = (_indices[i] >= 0 &&
+                                  _indices[i] < _symbols->memDumps().size()) ?
+                    _symbols->memDumps().at(_indices[i]) : 0;
+        if (dump)
+            res.fileName = dump->fileName();
+        res.failed = true;
+        res.error = "Script was not executed.";
+        _results.append(res);
+    }
+
+    const int threadCount = qMin(MultiThreading::maxThreads(), _indices.size());
+    for (int i = 0; i < threadCount; ++i) {
+        WorkerThread* thread = new WorkerThread(this);
+        _threads.append(thread);
+        thread->start();
+    }
+
+    // Abort all scripts when the user interrupts the operation
+    for (int i = 0; i < _threads.size(); ++i) {
+        while (!_threads[i]->wait(250)) {
+            if (Console::interrupted())
+                terminateWorkers();
+        }
+    }
+
+    qDeleteAll(_threads);
+    _threads.clear();
+
+    ScriptBatchResultList ret(_results);
+    _results.clear();
+    return ret;
+}
@@ -8,6 +8,7 @@
 #include <insight/scriptengine.h>
 #include <QScriptEngine>
 #include <insight/instanceclass.h>
+#include <insight/addressprototype.h>
 #include <insight/kernelsymbols.h>
 #include <insight/kernelsymbolsclass.h>
 #include <insight/memorydumpsclass.h>
@@ -39,7 +40,7 @@ QMutex ScriptEngine::_printMutex;
 ScriptEngine::ScriptEngine(KernelSymbols *symbols, int knowledgeSources)
 	: _engine(0), _instClass(0), _symClass(0), _memClass(0),
 	  _lastEvalFailed(false), _initialized(false), _knowSrc(knowledgeSources),
-	  _memDumpIndex(-1), _symbols(symbols)
+	  _memDumpIndex(-1), _symbols(symbols), _outBuf(0)
 {
 }
 
@@ -54,6 +55,7 @@ void ScriptEngine::reset()
 {
 	terminateScript();
 
+	_programs.clear();
 	if (_engine) {
 		delete _engine;
 		_engine = 0;
@@ -127,11 +129,11 @@ void ScriptEngine::initScriptEngine()
 			QScriptValue::ReadOnly | QScriptValue::Undeletable;
 
     _engine->globalObject().setProperty(js::print,
-    		_engine->newFunction(scriptPrint),
+    		_engine->newFunction(scriptPrint, this),
     		roFlags|QScriptValue::SkipInEnumeration);
 
     _engine->globalObject().setProperty(js::println,
-            _engine->newFunction(scriptPrintLn),
+            _engine->newFunction(scriptPrintLn, this),
             roFlags|QScriptValue::SkipInEnumeration);
 
     _engine->globalObject().setProperty(js::getInstance,
@@ -147,6 +149,10 @@ void ScriptEngine::initScriptEngine()
     		_instClass->constructor(),
     		roFlags);
 
+    _engine->globalObject().setProperty(js::address,
+            _instClass->addressConstructor(),
+            roFlags);
+
     _symClass = new KernelSymbolsClass(_symbols, _instClass);
     _engine->globalObject().setProperty(js::symbols,
     		_engine->newQObject(_symClass,
@@ -260,6 +266,20 @@ QScriptValue ScriptEngine::evaluateFunction(const QString &func,
 }
 
 
+QScriptProgram ScriptEngine::localProgram(const QScriptProgram *program)
+{
+	QScriptProgram& local = _programs[program];
+	// Another program might have been allocated at the same address
+	if (local.isNull() || local.sourceCode() != program->sourceCode() ||
+		local.fileName() != program->fileName())
+	{
+		local = QScriptProgram(program->sourceCode(), program->fileName(),
+							   program->firstLineNumber());
+	}
+	return local;
+}
+
+
 ScriptEngine::FuncExistsResult ScriptEngine::functionExists(const QString& func,
 		const QScriptProgram& program)
 {
@@ -380,8 +400,20 @@ QScriptValue ScriptEngine::scriptGetInstance(QScriptContext* ctx,
 }
 
 
-QScriptValue ScriptEngine::scriptPrint(QScriptContext* ctx, QScriptEngine* eng)
+void ScriptEngine::print(QScriptContext* ctx, bool newline)
 {
+    // Collect the output in the buffer, if set
+    if (_outBuf) {
+        for (int i = 0; i < ctx->argumentCount(); ++i) {
+            if (i > 0)
+                *_outBuf += " ";
+            *_outBuf += ctx->argument(i).toString();
+        }
+        if (newline)
+            *_outBuf += "\n";
+        return;
+    }
+
     QMutexLocker lock(&_printMutex);
 
     for (int i = 0; i < ctx->argumentCount(); ++i) {
@@ -389,23 +421,27 @@ QScriptValue ScriptEngine::scriptPrint(QScriptContext* ctx, QScriptEngine* eng)
             Console::out() << " ";
         Console::out() << ctx->argument(i).toString();
     }
-    Console::out() << flush;
-
-    return eng->undefinedValue();
+    if (newline)
+        Console::out() << endl;
+    else
+        Console::out() << flush;
 }
 
 
-QScriptValue ScriptEngine::scriptPrintLn(QScriptContext* ctx, QScriptEngine* eng)
+QScriptValue ScriptEngine::scriptPrint(QScriptContext* ctx, QScriptEngine* eng,
+                                       void* arg)
 {
-    QMutexLocker lock(&_printMutex);
+    assert(arg != 0);
+    ((ScriptEngine*)arg)->print(ctx, false);
+    return eng->undefinedValue();
+}
 
-    for (int i = 0; i < ctx->argumentCount(); ++i) {
-        if (i > 0)
-            Console::out() << " ";
-        Console::out() << ctx->argument(i).toString();
-    }
-    Console::out() << endl;
 
+QScriptValue ScriptEngine::scriptPrintLn(QScriptContext* ctx, QScriptEngine* eng,
+                                         void* arg)
+{
+    assert(arg != 0);
+    ((ScriptEngine*)arg)->print(ctx, true);
     return eng->undefinedValue();
 }
 
@@ -0,0 +1,131 @@
+#include <insight/stringatoms.h>
+#include <QHash>
+#include <QReadWriteLock>
+
+#include <string.h>
+
+namespace
+{
+// Strings are stored in blocks that never move once allocated, so references
+// returned by StringAtoms::string() stay valid while the table grows.
+const int blockBits = 12;
+const quint32 blockSize = 1U << blockBits;
+const quint32 blockMask = blockSize - 1;
+const quint32 maxBlocks = 1U << 16;
+
+// Approximate size of the private data header of a QString
+const int stringHeaderSize = 3 * sizeof(int) + sizeof(void*) + sizeof(ushort);
+
+struct AtomTable
+{
+    AtomTable() : count(0), chars(0)
+    {
+        memset(blocks, 0, sizeof(blocks));
+        // The empty string always has the atom StringAtoms::emptyAtom
+        insert(QString());
+    }
+
+    StringAtom insert(const QString& s)
+    {
+        StringAtom a = count;
+        quint32 b = a >> blockBits;
+        if (b >= maxBlocks)
+            qFatal("String atom table is full (%u atoms)", count);
+        if (!blocks[b])
+            blocks[b] = new QString[blockSize];
+        blocks[b][a & blockMask] = s;
+        byString.insert(s, a);
+        chars += s.size();
+        ++count;
+        return a;
+    }
+
+    QString* blocks[maxBlocks];
+    QHash<QString, StringAtom> byString;
+    quint32 count;
+    qint64 chars;
+    QReadWriteLock lock;
+};
+
+
+inline AtomTable& table()
+{
+    static AtomTable t;
+    return t;
+}
+}
+
+
+StringAtom StringAtoms::atom(const QString &s)
+{
+    if (s.isEmpty())
+        return emptyAtom;
+
+    AtomTable& t = table();
+    t.lock.lockForRead();
+    QHash<QString, StringAtom>::const_iterator it = t.byString.constFind(s);
+    if (it != t.byString.constEnd()) {
+        StringAtom a = it.value();
+        t.lock.unlock();
+        return a;
+    }
+    t.lock.unlock();
+
+    // Check again, another thread might have inserted it meanwhile
+    QWriteLocker wlock(&t.lock);
+    it = t.byString.constFind(s);
+    if (it != t.byString.constEnd())
+        return it.value();
+    return t.insert(s);
+}
+
+
+StringAtom StringAtoms::find(const QString &s)
+{
+    if (s.isEmpty())
+        return emptyAtom;
+
+    AtomTable& t = table();
+    QReadLocker rlock(&t.lock);
+    return t.byString.value(s, invalidAtom);
+}
+
+
+const QString& StringAtoms::string(StringAtom a)
+{
+    // Atoms are only handed out after their string has been stored, so we
+    // can read it without locking
+    const AtomTable& t = table();
+    quint32 b = a >> blockBits;
+    if (a == invalidAtom || b >= maxBlocks || !t.blocks[b])
+        return t.blocks[0][emptyAtom];
+    return t.blocks[b][a & blockMask];
+}
+
+
+int StringAtoms::count()
+{
+    AtomTable& t = table();
+    QReadLocker rlock(&t.lock);
+    return t.count;
+}
+
+
+qint64 StringAtoms::memoryUsage()
+{
+    AtomTable& t = table();
+    QReadLocker rlock(&t.lock);
+    // The QString in the blocks and the key in the hash share their data
+    qint64 blocksUsed = (t.count + blockSize - 1) >> blockBits;
+    return unsharedMemoryUsage(t.count, t.chars) +
+            blocksUsed * blockSize * sizeof(QString) +
+            t.count * (sizeof(QString) + sizeof(StringAtom) + 2 * sizeof(void*));
+}
+
+
+qint64 StringAtoms::unsharedMemoryUsage(qint64 count, qint64 length)
+{
+    // Each QString data block holds a header and a terminating null character
+    return count * (sizeof(QString) + stringHeaderSize + sizeof(QChar)) +
+            length * sizeof(QChar);
+}
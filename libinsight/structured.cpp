@@ -14,6 +14,10 @@
 #include <insight/typerule.h>
 #include "bitop.h"
 #include <insight/kernelsymbols.h>
+#include <QHash>
+#include <QAtomicInt>
+#include <QVector>
+#include <QtAlgorithms>
 
 namespace str
 {
@@ -38,6 +42,7 @@ Structured::Structured(KernelSymbols *symbols, const TypeInfo& info)
 
 Structured::~Structured()
 {
+	clearMemberIndex();
 	for (int i = 0; i < _members.size(); i++)
 		delete _members[i];
 	_members.clear();
@@ -125,83 +130,208 @@ bool Structured::memberExists(const QString& memberName, bool recursive) const
 }
 
 
-template<class T, class S>
-inline QList<T*> Structured::memberChain(const QString& memberName,
-                                         bool skipLocal) const
+/**
+ * Entry of the member index of a Structured type.
+ */
+struct IndexedMember
 {
-    if (!skipLocal) {
-        foreach (T* m, _members) {
-            if (m->name() == memberName) {
-                QList<T*> list;
-                list += m;
-                return list;
-            }
-        }
+    IndexedMember() : offset(0) {}
+    MemberList chain; ///< members leading to the indexed member
+    size_t offset;    ///< offset relative to the indexing struct or union
+};
+
+/// Hash table of indexed members by name
+typedef QHash<StringAtom, IndexedMember> IndexedMemberHash;
+
+/**
+ * An anonymous member of a Structured type. If it is a nested anonymous
+ * struct or union, its members were flattened into the member index of its
+ * enclosing type.
+ */
+struct NestedMemberIndex
+{
+    const StructuredMember* member; ///< the anonymous member
+    const BaseType* type;           ///< the type of \a member when indexed
+    quint32 serial;                 ///< serial of the nested index that was used, or 0
+};
+
+/// Source of serial numbers for member indexes
+static QAtomicInt memberIndexSerial;
+
+/**
+ * Index of all members of a Structured type, including the members of nested
+ * anonymous structs and unions.
+ */
+struct StructuredMemberIndex
+{
+    StructuredMemberIndex()
+        : serial(memberIndexSerial.fetchAndAddOrdered(1) + 1),
+          offsetsSorted(true), retired(0) {}
+
+    quint32 serial;           ///< unique number of this index
+    IndexedMemberHash byName; ///< all (flattened) members by name
+    QVector<size_t> offsets;  ///< offsets of all local members, in order
+    bool offsetsSorted;       ///< are all values in \a offsets sorted?
+    QVector<NestedMemberIndex> nested; ///< all anonymous local members
+    /// Outdated index that might still be used by another thread
+    StructuredMemberIndex* retired;
+};
+
+
+bool Structured::memberIndexValid(const StructuredMemberIndex *idx) const
+{
+    // Members are only ever appended
+    if (idx->offsets.size() != _members.size())
+        return false;
+
+    // The anonymous members might have been resolved to another type, and
+    // the flattened structs and unions might have changed themselves
+    for (int i = 0; i < idx->nested.size(); ++i) {
+        const NestedMemberIndex& n = idx->nested[i];
+        const BaseType* t = n.member->refType();
+        if (t != n.type)
+            return false;
+        if (n.serial &&
+            static_cast<const Structured*>(t)->memberIndex()->serial != n.serial)
+            return false;
     }
+    return true;
+}
+
+
+const StructuredMemberIndex* Structured::memberIndex() const
+{
+    StructuredMemberIndex* idx = _memberIndex;
+    if (idx && memberIndexValid(idx))
+        return idx;
+
+    // Other threads might still use the outdated index, so all of them are
+    // kept until this type is deleted along with the SymFactory. An index is
+    // only replaced if members of this type or its anonymous members change.
+    StructuredMemberIndex* newIdx = buildMemberIndex();
+    newIdx->retired = idx;
+    if (_memberIndex.testAndSetOrdered(idx, newIdx))
+        return newIdx;
+
+    // Another thread was faster
+    newIdx->retired = 0;
+    delete newIdx;
+    return _memberIndex;
+}
 
-    QList<T*> list;
 
-    // If we didn't find the member yet, try all anonymous structs/unions
-    foreach (T* m, _members) {
-        // Look out for anonymous struct or union members
-        if (m->refType() && (m->refType()->type() & StructOrUnion) &&
-            m->name().isEmpty() && m->refType()->name().isEmpty())
+StructuredMemberIndex* Structured::buildMemberIndex() const
+{
+    StructuredMemberIndex* idx = new StructuredMemberIndex();
+    idx->byName.reserve(_members.size());
+    idx->offsets.reserve(_members.size());
+
+    // Local members take precedence, the first one wins
+    for (int i = 0; i < _members.size(); ++i) {
+        StructuredMember* m = _members[i];
+        if (!idx->byName.contains(m->nameAtom())) {
+            IndexedMember& im = idx->byName[m->nameAtom()];
+            im.chain.append(m);
+            im.offset = m->offset();
+        }
+        if (!idx->offsets.isEmpty() && idx->offsets.last() > m->offset())
+            idx->offsetsSorted = false;
+        idx->offsets.append(m->offset());
+    }
+
+    // Flatten all anonymous structs/unions in order of their appearance.
+    // Remember all anonymous members, as their type might not be resolved yet.
+    for (int i = 0; i < _members.size(); ++i) {
+        StructuredMember* m = _members[i];
+        if (m->nameAtom() != StringAtoms::emptyAtom)
+            continue;
+        const BaseType* t = m->refType();
+        NestedMemberIndex n = { m, t, 0 };
+        if (t && (t->type() & StructOrUnion) &&
+            t->nameAtom() == StringAtoms::emptyAtom)
         {
-            S* s = dynamic_cast<S*>(m->refType());
-            assert(s != 0);
-            list = s->memberChain<T, S>(memberName);
-            if (!list.isEmpty()) {
-                list.prepend(m);
-                return list;
+            const Structured* s = static_cast<const Structured*>(t);
+            const StructuredMemberIndex* nested = s->memberIndex();
+            n.serial = nested->serial;
+            for (IndexedMemberHash::const_iterator it = nested->byName.constBegin(),
+                 e = nested->byName.constEnd(); it != e; ++it)
+            {
+                if (idx->byName.contains(it.key()))
+                    continue;
+                IndexedMember& im = idx->byName[it.key()];
+                im.chain.append(m);
+                im.chain += it.value().chain;
+                im.offset = m->offset() + it.value().offset;
             }
         }
+        idx->nested.append(n);
     }
 
-    return list;
+    return idx;
 }
 
 
-MemberList Structured::memberChain(const QString &memberName)
+const IndexedMember* Structured::indexedMember(const QString &memberName,
+                                               bool recursive) const
 {
-    return memberChain<StructuredMember, Structured>(memberName);
+    StringAtom name = StringAtoms::find(memberName);
+    if (name == StringAtoms::invalidAtom)
+        return 0;
+
+    const StructuredMemberIndex* idx = memberIndex();
+    IndexedMemberHash::const_iterator it = idx->byName.constFind(name);
+    if (it == idx->byName.constEnd())
+        return 0;
+    // Members of nested structs have a longer chain
+    if (!recursive && it.value().chain.size() > 1)
+        return 0;
+    return &it.value();
 }
 
 
-ConstMemberList Structured::memberChain(const QString &memberName) const
+void Structured::clearMemberIndex()
 {
-    return memberChain<const StructuredMember, const Structured>(memberName);
+    StructuredMemberIndex* idx = _memberIndex.fetchAndStoreOrdered(0);
+    while (idx) {
+        StructuredMemberIndex* retired = idx->retired;
+        delete idx;
+        idx = retired;
+    }
 }
 
 
-template<class T, class S>
-inline T* Structured::member(const QString& memberName, bool recursive) const
+MemberList Structured::memberChain(const QString &memberName)
 {
-    foreach (T* m, _members)
-        if (m->name() == memberName)
-            return m;
+    const IndexedMember* im = indexedMember(memberName, true);
+    return im ? im->chain : MemberList();
+}
 
-    if (recursive) {
-        QList<T*> list = memberChain<T, S>(memberName, true);
-        if (!list.isEmpty())
-            return list.last();
-    }
 
-    return 0;
+ConstMemberList Structured::memberChain(const QString &memberName) const
+{
+    ConstMemberList list;
+    const IndexedMember* im = indexedMember(memberName, true);
+    if (im) {
+        for (int i = 0; i < im->chain.size(); ++i)
+            list.append(im->chain[i]);
+    }
+    return list;
 }
 
 
 StructuredMember* Structured::member(const QString& memberName,
                                          bool recursive)
 {
-    return member<StructuredMember, Structured>(memberName, recursive);
+    const IndexedMember* im = indexedMember(memberName, recursive);
+    return im ? im->chain.last() : 0;
 }
 
 
 const StructuredMember* Structured::member(const QString& memberName,
                                            bool recursive) const
 {
-    return member<const StructuredMember, const Structured>(
-                memberName, recursive);
+    const IndexedMember* im = indexedMember(memberName, recursive);
+    return im ? im->chain.last() : 0;
 }
 
 
@@ -212,13 +342,29 @@ const StructuredMember *Structured::memberAtOffset(size_t offset, bool exactMatc
     if (offset >= _size)
         return 0;
 
-    for (i = 0, size = _members.size(); i < size; ++i) {
-        const StructuredMember* m = _members[i];
-        if (m->offset() > offset)
-            break;
-        // Ignore members that have a size of 0
-        if (m->offset() == offset && m->refType()->size() > 0)
-            return m;
+    const StructuredMemberIndex* idx = memberIndex();
+
+    if (idx->offsetsSorted) {
+        // Find the first member behind offset
+        QVector<size_t>::const_iterator first = idx->offsets.constBegin(),
+                upper = qUpperBound(first, idx->offsets.constEnd(), offset);
+        i = upper - first;
+        // Check all members that start exactly at offset
+        for (int j = qLowerBound(first, upper, offset) - first; j < i; ++j) {
+            // Ignore members that have a size of 0
+            if (_members[j]->refType()->size() > 0)
+                return _members[j];
+        }
+    }
+    else {
+        for (i = 0, size = _members.size(); i < size; ++i) {
+            const StructuredMember* m = _members[i];
+            if (m->offset() > offset)
+                break;
+            // Ignore members that have a size of 0
+            if (m->offset() == offset && m->refType()->size() > 0)
+                return m;
+        }
     }
 
     if (exactMatch || _members.isEmpty())
@@ -232,23 +378,8 @@ const StructuredMember *Structured::memberAtOffset(size_t offset, bool exactMatc
 
 int Structured::memberOffset(const QString &member, bool recursive) const
 {
-    foreach (const StructuredMember* m, _members)
-        if (m->name() == member)
-            return m->offset();
-
-    if (recursive) {
-        ConstMemberList list(
-                    memberChain<const StructuredMember, const Structured>(
-                        member, true));
-        if (list.isEmpty())
-            return -1;
-        int offset = 0;
-        foreach (const StructuredMember* m, list)
-            offset += m->offset();
-        return offset;
-    }
-
-    return -1;
+    const IndexedMember* im = indexedMember(member, recursive);
+    return im ? (int)im->offset : -1;
 }
 
 
@@ -504,8 +635,8 @@ RealType Struct::type() const
 
 QString Struct::prettyName(const QString &varName) const
 {
-    QString ret = QString("struct %1").arg(_name.isEmpty() ?
-                                               QString(str::anonymous) : _name);
+    QString ret = QString("struct %1").arg(name().isEmpty() ?
+                                               QString(str::anonymous) : name());
     if (!varName.isEmpty())
         ret += " " + varName;
     return ret;
@@ -533,8 +664,8 @@ RealType Union::type() const
 
 QString Union::prettyName(const QString &varName) const
 {
-    QString ret = QString("union %1").arg(_name.isEmpty() ?
-                                              QString(str::anonymous) : _name);
+    QString ret = QString("union %1").arg(name().isEmpty() ?
+                                              QString(str::anonymous) : name());
     if (!varName.isEmpty())
         ret += " " + varName;
     return ret;
@@ -54,18 +54,18 @@ QString StructuredMember::prettyName(const QString &varName) const
     const FuncPointer *fp = dynamic_cast<const FuncPointer*>(
                 refTypeDeep(BaseType::trAnyButTypedef));
     if (fp)
-        return fp->prettyName(_name, dynamic_cast<const RefBaseType*>(t));
+        return fp->prettyName(name(), dynamic_cast<const RefBaseType*>(t));
     else if (t)
-        return t->prettyName(_name);
+        return t->prettyName(name());
     else
-        return QString("(unresolved type 0x%1) %2").arg((uint)_refTypeId, 0, 16).arg(_name);
+        return QString("(unresolved type 0x%1) %2").arg((uint)_refTypeId, 0, 16).arg(name());
 }
 
 Instance StructuredMember::toInstance(size_t structAddress,
 		VirtualMemory* vmem, const Instance* parent,
 		int resolveTypes, int maxPtrDeref) const
 {
-    Instance inst = createRefInstance(structAddress + _offset, vmem, _name,
+    Instance inst = createRefInstance(structAddress + _offset, vmem, name(),
 			parent ? parent->fullNameComponents() : QStringList(),
 			resolveTypes, maxPtrDeref);
 	// Is this a bit-field with bit-size/offset?
@@ -13,14 +13,15 @@ const QString Symbol::emptyString;
 
 
 Symbol::Symbol(KernelSymbols *symbols)
-    : _id(0), _origId(0), _origFileIndex(-1), _symbols(symbols)
+    : _id(0), _origId(0), _origFileIndex(-1), _name(StringAtoms::emptyAtom),
+      _symbols(symbols)
 {
 }
 
 
 Symbol::Symbol(KernelSymbols *symbols, const TypeInfo& info)
     : _id(info.id()), _origId(info.origId()), _origFileIndex(info.fileIndex()),
-      _name(info.name()), _symbols(symbols)
+      _name(StringAtoms::atom(info.name())), _symbols(symbols)
 {
 }
 
@@ -33,15 +34,17 @@ Symbol::~Symbol()
 QString Symbol::prettyName(const QString &varName) const
 {
     if (varName.isEmpty())
-        return _name;
+        return name();
     else
-        return _name + " " + varName;
+        return name() + " " + varName;
 }
 
 
 void Symbol::readFrom(KernelSymbolStream& in)
 {
-    in >> _id >> _name;
+    QString name;
+    in >> _id >> name;
+    _name = StringAtoms::atom(name);
     // Original symbol reference since version 17
     if (in.kSymVersion() >= kSym::VERSION_17)
         in >> _origId >> _origFileIndex;
@@ -50,7 +53,7 @@ void Symbol::readFrom(KernelSymbolStream& in)
 
 void Symbol::writeTo(KernelSymbolStream& out) const
 {
-    out << _id << _name << _origId << _origFileIndex;
+    out << _id << name() << _origId << _origFileIndex;
 }
 
 
@@ -6,6 +6,7 @@
  */
 
 #include <QMutexLocker>
+#include <QAtomicInt>
 #include <debug.h>
 #include <insight/symfactory.h>
 #include <insight/basetype.h>
@@ -28,6 +29,8 @@
 #include <insight/astexpressionevaluator.h>
 #include <insight/multithreading.h>
 #include <insight/kernelsymbols.h>
+#include <insight/typeusagelog.h>
+#include <insight/typefilter.h>
 #include <string.h>
 #include <asttypeevaluator.h>
 #include <astnode.h>
@@ -591,6 +594,107 @@ QList<Variable*> SymFactory::varsUsingId(int id) const
 }
 
 
+namespace
+{
+/**
+ * Matches the elements of a list against a filter. The list is split into
+ * chunks of fixed size which are claimed by the workers one after the other.
+ * The matches of each chunk are stored separately, so that the result can be
+ * combined in the original order.
+ */
+template<class T, class F>
+class FilterMatcher
+{
+public:
+    typedef bool (F::*MatchFunc)(const T*) const;
+
+    FilterMatcher(const QList<T*>& list, const F* filter, MatchFunc func)
+        : _list(list), _filter(filter), _func(func),
+          _results((list.size() + chunkSize - 1) / chunkSize)
+    {
+    }
+
+    QList<T*> run()
+    {
+        const int threadCount = qMin(MultiThreading::maxThreads(),
+                                     _results.size());
+        if (threadCount > 1) {
+            QList<Worker*> workers;
+            for (int i = 0; i < threadCount; ++i) {
+                workers.append(new Worker(this));
+                workers.last()->start();
+            }
+            for (int i = 0; i < workers.size(); ++i)
+                workers[i]->wait();
+            qDeleteAll(workers);
+        }
+        else
+            matchChunks();
+
+        QList<T*> ret;
+        for (int i = 0; i < _results.size(); ++i)
+            ret += _results[i];
+        return ret;
+    }
+
+private:
+    enum { chunkSize = 1024 };
+
+    class Worker: public QThread
+    {
+    public:
+        Worker(FilterMatcher* matcher) : _matcher(matcher) {}
+    protected:
+        void run() { _matcher->matchChunks(); }
+    private:
+        FilterMatcher* _matcher;
+    };
+
+    void matchChunks()
+    {
+        int chunk;
+        while (!Console::interrupted() &&
+               (chunk = _nextChunk.fetchAndAddOrdered(1)) < _results.size())
+        {
+            const int end = qMin((chunk + 1) * chunkSize, _list.size());
+            for (int i = chunk * chunkSize; i < end; ++i) {
+                if ((_filter->*_func)(_list[i]))
+                    _results[chunk].append(_list[i]);
+            }
+        }
+    }
+
+    const QList<T*>& _list;
+    const F* _filter;
+    MatchFunc _func;
+    QVector< QList<T*> > _results;
+    QAtomicInt _nextChunk;
+};
+}
+
+
+BaseTypeList SymFactory::typesMatching(const TypeFilter *filter) const
+{
+    if (!filter || !filter->filters())
+        return _types;
+
+    FilterMatcher<BaseType, TypeFilter> matcher(_types, filter,
+                                                &TypeFilter::matchType);
+    return matcher.run();
+}
+
+
+VariableList SymFactory::varsMatching(const VariableFilter *filter) const
+{
+    if (!filter || !filter->filters())
+        return _vars;
+
+    FilterMatcher<Variable, VariableFilter> matcher(_vars, filter,
+                                                    &VariableFilter::matchVar);
+    return matcher.run();
+}
+
+
 void SymFactory::updateTypeRelations(const TypeInfo& info, BaseType* target)
 {
     updateTypeRelations(info.id(), info.name(), target);
@@ -639,7 +743,7 @@ void SymFactory::updateTypeRelations(const int new_id, const QString& new_name,
                          .arg(target->id(), 0, 16));
         // Add this type into the name relation table
         if (!new_name.isEmpty() || (target->type() & (rtStruct|rtUnion|rtEnum)))
-            _typesByName.insertMulti(new_name, target);
+            _typesByName.insertMulti(StringAtoms::atom(new_name), target);
 
         RefBaseType* rbt = dynamic_cast<RefBaseType*>(target);
         Enum* en = 0;
@@ -770,7 +874,7 @@ void SymFactory::insert(Variable* var)
 	var->setSymbols(_symbols);
 	_vars.append(var);
 	_varsById.insert(var->id(), var);
-	_varsByName.insertMulti(var->name(), var);
+	_varsByName.insertMulti(var->nameAtom(), var);
 	insertUsedBy(var);
 }
 
@@ -1192,7 +1296,7 @@ void SymFactory::replaceType(const BaseType* oldType, BaseType* newType)
     assert(oldType != 0);
 
     if (!oldType->name().isEmpty())
-        _typesByName.remove(oldType->name(), const_cast<BaseType*>(oldType));
+        _typesByName.remove(oldType->nameAtom(), const_cast<BaseType*>(oldType));
     if (oldType->hashIsValid())
         _typesByHash.remove(oldType->hash(), const_cast<BaseType*>(oldType));
 
@@ -1310,9 +1414,9 @@ int SymFactory::replaceZeroSizeStructs()
         // Skip anonymous types
         if (!s->name().isEmpty()) {
             // Count the number of structured types with that name
-            BaseTypeStringHash::iterator bit = _typesByName.find(s->name());
+            BaseTypeAtomHash::iterator bit = _typesByName.find(s->nameAtom());
             while (bit != _typesByName.end() &&
-                   bit.value()->name() == s->name())
+                   bit.key() == s->nameAtom())
             {
                 BaseType* t = bit.value();
                 if ((t->type() & StructOrUnion) && t->size() > 0) {
@@ -1350,9 +1454,9 @@ inline bool idLessThan(const BaseType* t1, const BaseType* t2)
 bool SymFactory::varDeclAvailable(Variable* v) const
 {
     if (!v->name().isEmpty()) {
-        VariableStringHash::const_iterator vit, ve = _varsByName.end();
-        for (vit = _varsByName.find(v->name()); vit != ve &&
-             vit.key() == v->name(); ++vit)
+        VariableAtomHash::const_iterator vit, ve = _varsByName.end();
+        for (vit = _varsByName.find(v->nameAtom()); vit != ve &&
+             vit.key() == v->nameAtom(); ++vit)
         {
             Variable* other = vit.value();
             if (v->refType() && other->refType() &&
@@ -1402,8 +1506,9 @@ bool SymFactory::isTypeName(const QString &name, int types) const
         }
     }
 
-    BaseTypeStringHash::const_iterator it = _typesByName.find(name);
-    while (it != _typesByName.constEnd() && it.key() == name) {
+    StringAtom atom = StringAtoms::find(name);
+    BaseTypeAtomHash::const_iterator it = _typesByName.find(atom);
+    while (it != _typesByName.constEnd() && it.key() == atom) {
         if (it.value()->type() & types)
             return true;
         ++it;
@@ -1426,8 +1531,9 @@ ASTType *SymFactory::typeOfIdentifier(const QString &name, int types) const
         }
     }
 
-    BaseTypeStringHash::const_iterator it = _typesByName.find(name);
-    while (it != _typesByName.constEnd() && it.key() == name) {
+    StringAtom atom = StringAtoms::find(name);
+    BaseTypeAtomHash::const_iterator it = _typesByName.find(atom);
+    while (it != _typesByName.constEnd() && it.key() == atom) {
         if (it.value()->type() & types)
             return baseTypeToAstType(it.value());
         ++it;
@@ -1608,6 +1714,30 @@ void SymFactory::symbolsFinished(RestoreType rt)
         Console::out() << "  | Empty structs replaced:    " << zeroReplaced << endl;
     Console::out() << "  | Empty structs remaining:   " << _zeroSizeStructs.size() << endl;
 
+    // Compare the memory used by all symbol names with and without atoms
+    qint64 nameCount = 0, nameLength = 0;
+    for (int i = 0; i < _types.size(); ++i) {
+        ++nameCount;
+        nameLength += _types[i]->name().size();
+        if (_types[i]->type() & StructOrUnion) {
+            const Structured* s = static_cast<const Structured*>(_types[i]);
+            for (int j = 0; j < s->members().size(); ++j) {
+                ++nameCount;
+                nameLength += s->members().at(j)->name().size();
+            }
+        }
+    }
+    for (int i = 0; i < _vars.size(); ++i) {
+        ++nameCount;
+        nameLength += _vars[i]->name().size();
+    }
+    Console::out() << "  | No. of name atoms:         " << StringAtoms::count() << endl;
+    Console::out() << "  | Name atom memory (kB):     "
+                   << (StringAtoms::memoryUsage() >> 10) << endl;
+    Console::out() << "  | Unshared name memory (kB): "
+                   << (StringAtoms::unsharedMemoryUsage(nameCount, nameLength) >> 10)
+                   << endl;
+
     Console::out() << qSetFieldWidth(0) << left;
 
 	if (!_postponedTypes.isEmpty()) {
@@ -2052,7 +2182,7 @@ FoundBaseTypes SymFactory::findBaseTypesForAstType(const ASTType* astType,
                 // Distinguish between typedef and variable
                 if (dec->u.declaration.isTypedef) {
                     BaseTypeList temp;
-                    baseTypes = _typesByName.values(id);
+                    baseTypes = _typesByName.values(StringAtoms::find(id));
                     for (int i = baseTypes.size() - 1; i >= 0; --i) {
                         // Dereference any pointers or typedefs
                         baseTypes[i] = baseTypes[i]->dereferencedBaseType(BaseType::trLexicalPointersArrays);
@@ -2068,7 +2198,7 @@ FoundBaseTypes SymFactory::findBaseTypesForAstType(const ASTType* astType,
                     baseTypes += temp;
                 }
                 else {
-                    VariableList vars = _varsByName.values(id);
+                    VariableList vars = _varsByName.values(StringAtoms::find(id));
                     isVarType = true;
                     for (int i = 0; i < vars.size(); ++i) {
                         // Dereference any pointers, arrays or typedefs
@@ -2117,7 +2247,8 @@ FoundBaseTypes SymFactory::findBaseTypesForAstType(const ASTType* astType,
 //                debugmsg("The context type has no identifier.");
         }
         else {
-            baseTypes = _typesByName.values(astTypeNonPtr->identifier());
+            baseTypes = _typesByName.values(
+                        StringAtoms::find(astTypeNonPtr->identifier()));
         }
     }
     else if (astTypeNonPtr->type() & FunctionTypes) {
@@ -2165,7 +2296,7 @@ FoundBaseTypes SymFactory::findBaseTypesForAstType(const ASTType* astType,
             }
         }
         else {
-            baseTypes = _typesByName.values(name);
+            baseTypes = _typesByName.values(StringAtoms::find(name));
 #ifdef DEBUG_APPLY_USED_AS
             if (baseTypes.isEmpty())
                 debugerr("No type with name " << name << " found!");
@@ -2573,6 +2704,9 @@ void SymFactory::typeAlternateUsageStructMember2(const TypeEvalDetails *ed,
                         BaseType* typeCopy =
                                 makeDeepTypeCopy(nestingMember->refType(), false);
                         ++_typesCopied;
+                        // Changes to type copies cannot be replayed
+                        if (usageLog(eval))
+                            usageLog(eval)->invalidate();
                         // Update the type relations
                         _usedByStructMembers.remove(nestingMember->refTypeId(),
                                                     nestingMember);
@@ -2634,6 +2768,9 @@ void SymFactory::typeAlternateUsageStructMember2(const TypeEvalDetails *ed,
 
                 member->addAltRefType(targetBaseType->id(),
                                       expr->copy(_expressions));
+                if (usageLog(eval))
+                    usageLog(eval)->addAltRefType(member, targetBaseType->id(),
+                                                  expr);
 
 //                if (ctxBaseTypes[i]->name() == "task_struct" &&
 //                    targetBaseType->prettyName().contains("task_struct"))
@@ -2694,7 +2831,7 @@ void SymFactory::typeAlternateUsageVar(const TypeEvalDetails* ed,
                                        const BaseType* targetBaseType,
                                        ASTTypeEvaluator* eval)
 {
-    VariableList vars = _varsByName.values(ed->sym->name());
+    VariableList vars = _varsByName.values(StringAtoms::find(ed->sym->name()));
     int varsFound = 0;
 
     if (vars.size() > 1) {
@@ -2768,6 +2905,9 @@ void SymFactory::typeAlternateUsageVar(const TypeEvalDetails* ed,
 
                 vars[i]->addAltRefType(targetBaseType->id(),
                                        expr->copy(_expressions));
+                if (usageLog(eval))
+                    usageLog(eval)->addAltRefType(vars[i], targetBaseType->id(),
+                                                  expr);
             }
         }
         // Otherwise copy the type and apply the change to it
@@ -2784,6 +2924,9 @@ void SymFactory::typeAlternateUsageVar(const TypeEvalDetails* ed,
                 // Clear all existing alternative types on the copy
                 t = makeDeepTypeCopy(t, true);
                 ++_typesCopied;
+                // Changes to type copies cannot be replayed
+                if (usageLog(eval))
+                    usageLog(eval)->invalidate();
 
                 _usedByVars.remove(vars[i]->refTypeId(), vars[i]);
                 vars[i]->setRefTypeId(t->id());
@@ -2831,6 +2974,134 @@ void SymFactory::typeAlternateUsageVar(const TypeEvalDetails* ed,
 }
 
 
+/// A resolved record of a TypeUsageLog, see SymFactory::replayTypeUsage()
+struct TypeUsageRecord
+{
+    TypeUsageRecord()
+        : type(TypeUsageLog::lrNone), target(0), member(0), var(0),
+          targetType(0), expr(0), intValue(0) {}
+    qint8 type;
+    ReferencingType* target;
+    StructuredMember* member;
+    Variable* var;
+    const BaseType* targetType;
+    ASTExpression* expr;
+    qint64 intValue;
+    QString strValue;
+};
+
+
+TypeUsageLog* SymFactory::usageLog(ASTTypeEvaluator *eval)
+{
+    KernelSourceTypeEvaluator* kEval =
+            dynamic_cast<KernelSourceTypeEvaluator*>(eval);
+    return kEval ? kEval->usageLog() : 0;
+}
+
+
+int SymFactory::replayTypeUsage(const TypeUsageLog &log)
+{
+    // Allow only one thread at a time in here
+    QMutexLocker lock(&_typeAltUsageMutex);
+
+    // Read and resolve all records first
+    QList<TypeUsageRecord> records;
+    KernelSymbolStream in(log.data());
+    qint8 type;
+    qint32 id, index, targetId;
+
+    try {
+        for (int i = 0; i < log.count(); ++i) {
+            TypeUsageRecord r;
+
+            in >> type >> id;
+            r.type = type;
+
+            if (type == TypeUsageLog::lrVarAltRefType) {
+                if (!(r.var = findVarById(id)))
+                    return -1;
+                r.target = r.var;
+            }
+            else {
+                in >> index;
+                Structured* s = dynamic_cast<Structured*>(findBaseTypeById(id));
+                if (!s || index < 0 || index >= s->members().size())
+                    return -1;
+                r.member = s->members().at(index);
+                r.target = r.member;
+            }
+
+            switch (type) {
+            case TypeUsageLog::lrMemberAltRefType:
+            case TypeUsageLog::lrVarAltRefType:
+                in >> targetId;
+                if (!(r.targetType = findBaseTypeById(targetId)))
+                    return -1;
+                if (!(r.expr = ASTExpression::fromStream(in, this)))
+                    return -1;
+                break;
+
+            case TypeUsageLog::lrMemberNotConstant:
+                break;
+
+            case TypeUsageLog::lrMemberConstInt:
+                in >> r.intValue;
+                break;
+
+            case TypeUsageLog::lrMemberConstString:
+                in >> r.strValue;
+                break;
+
+            default:
+                return -1;
+            }
+
+            if (in.status() != QDataStream::Ok)
+                return -1;
+            records.append(r);
+        }
+    }
+    catch (GenericException&) {
+        // Expressions might reference types that do not exist
+        return -1;
+    }
+
+    // Apply the changes
+    for (int i = 0; i < records.size(); ++i) {
+        const TypeUsageRecord& r = records[i];
+        switch (r.type) {
+        case TypeUsageLog::lrMemberAltRefType:
+        case TypeUsageLog::lrVarAltRefType:
+            if (typeChangeDecision(r.target, r.targetType, r.expr)) {
+                ++_totalTypesChanged;
+                ++_uniqeTypesChanged;
+                if (r.var)
+                    ++_varTypeChanges;
+                if (r.target->altRefTypeCount() > 0)
+                    ++_ambiguesAltTypes;
+                // The expression is already owned by the factory
+                r.target->addAltRefType(r.targetType->id(), r.expr);
+            }
+            break;
+
+        case TypeUsageLog::lrMemberNotConstant:
+            r.member->evaluateMagicNumberFoundNotConstant();
+            break;
+
+        case TypeUsageLog::lrMemberConstInt:
+            r.member->evaluateMagicNumberFoundInt(r.intValue);
+            break;
+
+        case TypeUsageLog::lrMemberConstString:
+            r.member->evaluateMagicNumberFoundString(r.strValue);
+            break;
+        }
+    }
+
+    return records.size();
+}
+
+
 bool SymFactory::typeChangeDecision(const ReferencingType* r,
                                     const BaseType* targetBaseType,
                                     const ASTExpression* expr)
@@ -3196,9 +3467,10 @@ BaseTypeList SymFactory::findBaseTypesByName(const QString &name,
                                              int realTypes) const
 {
     BaseTypeList list;
-    BaseTypeStringHash::const_iterator it = _typesByName.find(name),
+    StringAtom atom = StringAtoms::find(name);
+    BaseTypeAtomHash::const_iterator it = _typesByName.find(atom),
             e = _typesByName.end();
-    while (it != e && it.key() == name) {
+    while (it != e && it.key() == atom) {
         if (it.value()->type() & realTypes)
             list += it.value();
         ++it;
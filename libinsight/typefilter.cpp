@@ -8,7 +8,6 @@
 #include <insight/shellutil.h>
 #include <insight/console.h>
 #include <insight/symfactory.h>
-#include <QMutexLocker>
 
 namespace xml
 {
@@ -64,23 +63,199 @@ using namespace Filter;
             filterError(QString("Illegal integer number: %1").arg(s)); \
     } while (0)
 
+//------------------------------------------------------------------------------
+// NameMatcher
+//------------------------------------------------------------------------------
+
+// Marks a "?" within a compiled wildcard segment
+static const QChar globAnyChar(0xFFFF);
+
+
+void NameMatcher::clear()
+{
+    _mode = mAny;
+    _literal.clear();
+    _atom = StringAtoms::emptyAtom;
+    _cs = Qt::CaseInsensitive;
+    _segments.clear();
+    _rx = QRegExp();
+}
+
+
+void NameMatcher::compile(const QString &name, PatternSyntax syntax,
+                          const QRegExp &rx)
+{
+    clear();
+
+    switch (syntax) {
+    case psLiteral:
+        _mode = mLiteral;
+        _literal = name;
+        // Don't add names to the global table that no symbol has. Such a
+        // name has no atom and is compared as string.
+        _atom = StringAtoms::find(name);
+        break;
+
+    case psWildcard:
+        _cs = rx.caseSensitivity();
+        if (compileGlob(rx.pattern()))
+            _mode = mGlob;
+        else {
+            _mode = mRegExp;
+            _rx = rx;
+        }
+        break;
+
+    case psRegExp: {
+        // Expressions without special characters are plain sub-string matches
+        QRegExp rxPlain("[a-zA-Z0-9_ ]+");
+        _cs = rx.caseSensitivity();
+        if (rxPlain.exactMatch(rx.pattern())) {
+            _mode = mSubString;
+            _literal = rx.pattern();
+        }
+        else {
+            _mode = mRegExp;
+            _rx = rx;
+        }
+        break;
+    }
+
+    default:
+        break;
+    }
+}
+
+
+bool NameMatcher::compileGlob(const QString &pattern)
+{
+    // Split the pattern into the fixed segments between the "*"
+    QString seg;
+    for (int i = 0; i < pattern.size(); ++i) {
+        QChar c = pattern[i];
+        if (c == QChar('*')) {
+            _segments.append(seg);
+            seg.clear();
+            continue;
+        }
+        // Character sets are left to QRegExp
+        else if (c == QChar('['))
+            return false;
+        else if (c == QChar('?'))
+            c = globAnyChar;
+        else if (c == QChar('\\') && i + 1 < pattern.size())
+            c = pattern[++i];
+
+        seg += (_cs == Qt::CaseInsensitive) ? c.toCaseFolded() : c;
+    }
+    _segments.append(seg);
+    _segments.squeeze();
+
+    return true;
+}
+
+
+bool NameMatcher::matchSegment(const QString &name, int pos,
+                               const QString &seg) const
+{
+    const QChar* n = name.constData() + pos;
+    const QChar* s = seg.constData();
+    const QChar* e = s + seg.size();
+
+    if (_cs == Qt::CaseInsensitive) {
+        for (; s != e; ++s, ++n)
+            if (*s != globAnyChar && *s != n->toCaseFolded())
+                return false;
+    }
+    else {
+        for (; s != e; ++s, ++n)
+            if (*s != globAnyChar && *s != *n)
+                return false;
+    }
+    return true;
+}
+
+
+bool NameMatcher::matchGlob(const QString &name) const
+{
+    const int n = _segments.size();
+
+    // Pattern without any "*"
+    if (n == 1)
+        return name.size() == _segments[0].size() &&
+                matchSegment(name, 0, _segments[0]);
+
+    // The first and the last segment are anchored to the begin and the end
+    const QString& head = _segments[0];
+    const QString& tail = _segments[n - 1];
+    if (head.size() + tail.size() > name.size() ||
+        !matchSegment(name, 0, head) ||
+        !matchSegment(name, name.size() - tail.size(), tail))
+        return false;
+
+    // Find the remaining segments from left to right
+    int pos = head.size(), end = name.size() - tail.size();
+    for (int i = 1; i < n - 1; ++i) {
+        const QString& seg = _segments[i];
+        while (pos + seg.size() <= end && !matchSegment(name, pos, seg))
+            ++pos;
+        if (pos + seg.size() > end)
+            return false;
+        pos += seg.size();
+    }
+
+    return true;
+}
+
+
+bool NameMatcher::match(const QString &name, StringAtom atom) const
+{
+    switch (_mode) {
+    case mAny:
+        return true;
+
+    case mLiteral:
+        // Equal atoms mean equal strings, and strings of different length can
+        // never match, regardless of the case
+        if (atom != StringAtoms::invalidAtom && atom == _atom)
+            return true;
+        if (_literal.size() != name.size())
+            return false;
+        return _literal.compare(name, Qt::CaseInsensitive) == 0;
+
+    case mGlob:
+        return matchGlob(name);
+
+    case mSubString:
+        return name.contains(_literal, _cs);
+
+    case mRegExp: {
+        // QRegExp stores the match state, so use a copy that shares the
+        // compiled expression with _rx
+        QRegExp rx(_rx);
+        return (rx.patternSyntax() == QRegExp::RegExp) ?
+                    rx.indexIn(name) >= 0 : rx.exactMatch(name);
+    }
+    }
+
+    return false;
+}
+
+
 //------------------------------------------------------------------------------
 // GenericFilter
 //------------------------------------------------------------------------------
 
 GenericFilter::GenericFilter(const GenericFilter& from)
-    : _filters(from._filters), _typeName(from._typeName), _typeRegEx(0),
-      _typeId(from._typeId), _realTypes(from._realTypes), _size(from._size)
+    : _filters(from._filters), _typeName(from._typeName),
+      _typeMatcher(from._typeMatcher), _typeId(from._typeId),
+      _realTypes(from._realTypes), _size(from._size)
 {
-    if (from._typeRegEx)
-        _typeRegEx = new QRegExp(*from._typeRegEx);
 }
 
 
 GenericFilter::~GenericFilter()
 {
-    if (_typeRegEx)
-        delete _typeRegEx;
 }
 
 
@@ -88,12 +263,9 @@ void GenericFilter::clear()
 {
     _filters = ftNone;
     _typeName.clear();
+    _typeMatcher.clear();
     _realTypes = 0;
     _size = 0;
-    if (_typeRegEx) {
-        delete _typeRegEx;
-        _typeRegEx = 0;
-    }
 }
 
 
@@ -101,15 +273,10 @@ GenericFilter &GenericFilter::operator=(const GenericFilter &src)
 {
     _filters = src._filters;
     _typeName = src._typeName;
+    _typeMatcher = src._typeMatcher;
     _typeId = src._typeId;
     _realTypes = src._realTypes;
     _size = src._size;
-    if (_typeRegEx) {
-        delete _typeRegEx;
-        _typeRegEx = 0;
-    }
-    if (src._typeRegEx)
-        _typeRegEx = new QRegExp(*src._typeRegEx);
 
     return *this;
 }
@@ -117,7 +284,6 @@ GenericFilter &GenericFilter::operator=(const GenericFilter &src)
 
 bool GenericFilter::operator==(const GenericFilter &other) const
 {
-    // Do NOT compare the _typeRegEx pointer
     if (_filters != other._filters ||  _typeName != other._typeName ||
         _realTypes != other._realTypes || _size != other._size)
         return false;
@@ -206,7 +372,7 @@ bool GenericFilter::matchType(const BaseType *type) const
 
     if (filterActive(ftTypeNameAll)) {
         const BaseType* t = type;
-        while (t && !matchTypeName(t->name())) {
+        while (t && !matchTypeName(t->name(), t->nameAtom())) {
             if (t->type() & BaseType::trLexical)
                 t = dynamic_cast<const RefBaseType*>(t)->refType();
             else
@@ -224,6 +390,7 @@ void GenericFilter::setTypeName(const QString &name, PatternSyntax syntax)
 {
     QRegExp rx;
     syntax = setNamePattern(name, _typeName, rx, syntax);
+    _typeMatcher.compile(_typeName, syntax, rx);
     _filters &= ~ftTypeNameAll;
 
     switch (syntax) {
@@ -233,13 +400,6 @@ void GenericFilter::setTypeName(const QString &name, PatternSyntax syntax)
     case psRegExp:   _filters |= ftTypeNameRegEx; break;
     case psWildcard: _filters |= ftTypeNameWildcard; break;
     }
-
-    if (_typeRegEx)
-        delete _typeRegEx;
-    if (syntax & (psWildcard|psRegExp))
-        _typeRegEx = new QRegExp(rx);
-    else
-        _typeRegEx = 0;
 }
 
 
@@ -415,22 +575,9 @@ PatternSyntax GenericFilter::givenSyntax(const KeyValueStore *keyVal)
 }
 
 
-bool GenericFilter::matchTypeName(const QString &name) const
+bool GenericFilter::matchTypeName(const QString &name, StringAtom atom) const
 {
-    if (filterActive(ftTypeNameLiteral) &&
-        _typeName.compare(name, Qt::CaseInsensitive) != 0)
-        return false;
-    else {
-        QMutexLocker lock(&_regExLock);
-        if (filterActive(ftTypeNameWildcard) &&
-            !_typeRegEx->exactMatch(name))
-            return false;
-        else if (filterActive(ftTypeNameRegEx) &&
-                 _typeRegEx->indexIn(name) < 0)
-            return false;
-    }
-
-    return true;
+    return _typeMatcher.match(name, atom);
 }
 
 
@@ -439,36 +586,27 @@ bool GenericFilter::matchTypeName(const QString &name) const
 //------------------------------------------------------------------------------
 
 MemberFilter::MemberFilter(const QString& name, PatternSyntax syntax)
-    : _nameRegEx(0)
 {
     setName(name, syntax);
 }
 
 
 MemberFilter::MemberFilter(const MemberFilter& from)
-    : GenericFilter(from), _name(from._name), _nameRegEx(0)
+    : GenericFilter(from), _name(from._name), _nameMatcher(from._nameMatcher)
 {
-    if (from._nameRegEx)
-        _nameRegEx = new QRegExp(*from._nameRegEx);
 }
 
 
 MemberFilter::~MemberFilter()
 {
-    if (_nameRegEx)
-        delete _nameRegEx;
 }
 
 
 MemberFilter &MemberFilter::operator=(const MemberFilter &src)
 {
     GenericFilter::operator=(src);
-    if (_nameRegEx) {
-        delete _nameRegEx;
-        _nameRegEx = 0;
-    }
-    if (src._nameRegEx)
-        _nameRegEx = new QRegExp(*src._nameRegEx);
+    _name = src._name;
+    _nameMatcher = src._nameMatcher;
 
     return *this;
 }
@@ -476,7 +614,6 @@ MemberFilter &MemberFilter::operator=(const MemberFilter &src)
 
 bool MemberFilter::operator==(const MemberFilter &other) const
 {
-    // Do NOT compare the _nameRegEx pointer
     if (_name != other._name)
         return false;
     return GenericFilter::operator ==(other);
@@ -516,6 +653,7 @@ void MemberFilter::setName(const QString &name, PatternSyntax syntax)
 {
     QRegExp rx;
     syntax = TypeFilter::setNamePattern(name, _name, rx, syntax);
+    _nameMatcher.compile(_name, syntax, rx);
     _filters &= ~ftVarNameAll;
 
     switch (syntax) {
@@ -525,13 +663,6 @@ void MemberFilter::setName(const QString &name, PatternSyntax syntax)
     case psWildcard: _filters |= ftVarNameWildcard; break;
     case psRegExp:   _filters |= ftVarNameRegEx; break;
     }
-
-    if (_nameRegEx)
-        delete _nameRegEx;
-    if (syntax & (psWildcard|psRegExp))
-        _nameRegEx = new QRegExp(rx);
-    else
-        _nameRegEx = 0;
 }
 
 
@@ -553,18 +684,8 @@ bool MemberFilter::match(const StructuredMember *member) const
     if (!member)
         return false;
 
-    if (filterActive(ftVarNameLiteral) &&
-             QString::compare(_name, member->name(), Qt::CaseInsensitive) != 0)
+    if (!_nameMatcher.match(member->name(), member->nameAtom()))
         return false;
-    else {
-        QMutexLocker lock(&_regExLock);
-        if (filterActive(ftVarNameWildcard) &&
-            !_nameRegEx->exactMatch(member->name()))
-            return false;
-        else if (filterActive(Options(ftVarNameRegEx)) &&
-            _nameRegEx->indexIn(member->name()) < 0)
-            return false;
-    }
 
     return matchType(member->refTypeDeep(BaseType::trLexical));
 }
@@ -751,17 +872,14 @@ void TypeFilter::parseOptions(const QStringList &list)
 static const QStringList emptyList;
 
 FunctionFilter::FunctionFilter(const FunctionFilter &from)
-    : TypeFilter(from), _symFileRegEx(0), _symFiles(emptyList)
+    : TypeFilter(from), _symFileMatcher(from._symFileMatcher),
+      _symFile(from._symFile), _symFiles(emptyList)
 {
-    if (from._symFileRegEx)
-        _symFileRegEx = new QRegExp(*from._symFileRegEx);
 }
 
 
 FunctionFilter::~FunctionFilter()
 {
-    if (_symFileRegEx)
-        delete _symFileRegEx;
 }
 
 
@@ -770,6 +888,7 @@ void FunctionFilter::setSymFileName(const QString &name, Filter::PatternSyntax s
     _filters &= ~ftSymFileAll;
     QRegExp rx;
     syntax = setNamePattern(name, _symFile, rx, syntax, "[-_.a-zA-Z0-9]*");
+    _symFileMatcher.compile(_symFile, syntax, rx);
 
     switch (syntax) {
     case psAuto: break;
@@ -778,13 +897,6 @@ void FunctionFilter::setSymFileName(const QString &name, Filter::PatternSyntax s
     case psRegExp:   _filters |= ftSymFileRegEx; break;
     case psWildcard: _filters |= ftSymFileWildcard; break;
     }
-
-    if (_symFileRegEx)
-        delete _symFileRegEx;
-    if (syntax & (psRegExp|psWildcard))
-        _symFileRegEx = new QRegExp(rx);
-    else
-        _symFileRegEx = 0;
 }
 
 
@@ -804,10 +916,7 @@ Filter::PatternSyntax FunctionFilter::symFileNameSyntax() const
 void FunctionFilter::clear()
 {
     TypeFilter::clear();
-    if (_symFileRegEx) {
-        delete _symFileRegEx;
-        _symFileRegEx = 0;
-    }
+    _symFileMatcher.clear();
     _symFile.clear();
 }
 
@@ -827,20 +936,7 @@ bool FunctionFilter::matchType(const BaseType *type) const
 
 bool FunctionFilter::matchSymFileName(const QString &name) const
 {
-    if (filterActive(ftSymFileLiteral) &&
-        _symFile.compare(name, Qt::CaseInsensitive) != 0)
-        return false;
-    else {
-        QMutexLocker lock(&_regExLock);
-        if (filterActive(ftSymFileWildcard) &&
-            !_symFileRegEx->exactMatch(name))
-            return false;
-        else if (filterActive(ftSymFileRegEx) &&
-                 _symFileRegEx->indexIn(name) < 0)
-            return false;
-    }
-
-    return true;
+    return _symFileMatcher.match(name);
 }
 
 
@@ -905,52 +1001,30 @@ const KeyValueStore &FunctionFilter::supportedFilters()
 //------------------------------------------------------------------------------
 
 VariableFilter::VariableFilter(const VariableFilter& from)
-    : FunctionFilter(from), _varRegEx(0)
+    : FunctionFilter(from), _varName(from._varName),
+      _varMatcher(from._varMatcher)
 {
-    if (from._varRegEx)
-        _varRegEx = new QRegExp(*from._varRegEx);
 }
 
 
 VariableFilter::~VariableFilter()
 {
-    if (_varRegEx)
-        delete _varRegEx;
 }
 
 
 VariableFilter &VariableFilter::operator=(const VariableFilter &src)
 {
     GenericFilter::operator=(src);
-
-    QMutexLocker lock(&_regExLock);
-    if (_varRegEx) {
-        delete _varRegEx;
-        _varRegEx = 0;
-    }
-    if (src._varRegEx)
-        _varRegEx = new QRegExp(*src._varRegEx);
+    _varName = src._varName;
+    _varMatcher = src._varMatcher;
 
     return *this;
 }
 
 
-bool VariableFilter::matchVarName(const QString &name) const
+bool VariableFilter::matchVarName(const QString &name, StringAtom atom) const
 {
-    if (filterActive(ftVarNameLiteral) &&
-        _varName.compare(name, Qt::CaseInsensitive) != 0)
-        return false;
-    else {
-        QMutexLocker lock(&_regExLock);
-        if (filterActive(ftVarNameWildcard) &&
-            !_varRegEx->exactMatch(name))
-            return false;
-        else if (filterActive(ftVarNameRegEx) &&
-                 _varRegEx->indexIn(name) < 0)
-            return false;
-    }
-
-    return true;
+    return _varMatcher.match(name, atom);
 }
 
 
@@ -959,7 +1033,7 @@ bool VariableFilter::matchVar(const Variable *var) const
     if (!var)
         return false;
 
-    if (filterActive(ftVarNameAll) && !matchVarName(var->name()))
+    if (filterActive(ftVarNameAll) && !matchVarName(var->name(), var->nameAtom()))
         return false;
 
     // Note: FunctionFilter::matchType() matches the type's origFileName()
@@ -979,10 +1053,7 @@ bool VariableFilter::matchVar(const Variable *var) const
 void VariableFilter::clear()
 {
     FunctionFilter::clear();
-    if (_varRegEx) {
-        delete _varRegEx;
-        _varRegEx = 0;
-    }
+    _varMatcher.clear();
     _varName.clear();
 }
 
@@ -992,6 +1063,7 @@ void VariableFilter::setVarName(const QString &name, PatternSyntax syntax)
     _filters &= ~ftVarNameAll;
     QRegExp rx;
     syntax = setNamePattern(name, _varName, rx, syntax);
+    _varMatcher.compile(_varName, syntax, rx);
 
     switch (syntax) {
     case psAuto: break;
@@ -1000,13 +1072,6 @@ void VariableFilter::setVarName(const QString &name, PatternSyntax syntax)
     case psRegExp:   _filters |= ftVarNameRegEx; break;
     case psWildcard: _filters |= ftVarNameWildcard; break;
     }
-
-    if (_varRegEx)
-        delete _varRegEx;
-    if (syntax & (psRegExp|psWildcard))
-        _varRegEx = new QRegExp(rx);
-    else
-        _varRegEx = 0;
 }
 
 
@@ -16,11 +16,14 @@
 #include <insight/console.h>
 #include <insight/instanceclass.h>
 #include <insight/kernelsourcetypeevaluator.h>
+#include <insight/structuredmember.h>
+#include <insight/instance.h>
 #include <abstractsyntaxtree.h>
 #include <astbuilder.h>
 #include <astscopemanager.h>
 #include <astnodefinder.h>
 #include <QDir>
+#include <QFileInfo>
 #include <QScriptProgram>
 
 //------------------------------------------------------------------------------
@@ -150,12 +153,6 @@ Instance ScriptAction::evaluate(const Instance *inst,
 //    static QMutex lock(QMutex::Recursive);
 //    QMutexLocker l(&lock);
 
-    // Using the same QScriptProgram by multiple engines concurrently causes
-    // a segmentation fault.
-    // See https://bugreports.qt-project.org/browse/QTBUG-29246
-    QScriptProgram prog(_program->sourceCode(), _program->fileName(),
-                        _program->firstLineNumber());
-
     if (matched)
         *matched = true;
 
@@ -164,6 +161,10 @@ Instance ScriptAction::evaluate(const Instance *inst,
 
     eng->initScriptEngine();
 
+    // Each engine evaluates a private copy of the program which it compiles
+    // only once, see ScriptEngine::localProgram()
+    QScriptProgram prog(eng->localProgram(_program));
+
     // Instance passed to the rule as 1. argument
     QScriptValue instVal = InstanceClass::instToScriptValue(eng->engine(), *inst);
     // List of accessed member indices passed to the rule as 2. argument
@@ -298,6 +299,19 @@ QString FuncCallScriptAction::toString(const ColorPalette *col) const
 }
 
 
+TypeRuleAction::ActionType FuncCallScriptAction::nativeEquivalent() const
+{
+    // The generic list functions shipped with our rules
+    if (QFileInfo(_scriptFile).fileName() == "generic_lists.js") {
+        if (_function == "list_head_member")
+            return atListEntry;
+        else if (_function == "hlist_node_next")
+            return atHListEntry;
+    }
+    return atNone;
+}
+
+
 //------------------------------------------------------------------------------
 // ProgramScriptAction
 //------------------------------------------------------------------------------
@@ -754,6 +768,175 @@ QString ExpressionAction::toString(const ColorPalette *col) const
 }
 
 
+//------------------------------------------------------------------------------
+// ListEntryAction
+//------------------------------------------------------------------------------
+
+bool ListEntryAction::check(const QString &xmlFile, const TypeRule *rule,
+                            SymFactory *factory)
+{
+    Q_UNUSED(factory);
+
+    // We need at least the pointer to the next list node
+    if (!rule->filter() || rule->filter()->members().isEmpty()) {
+        typeRuleError2(xmlFile, srcLine(), -1,
+                       QString("Action type \"%1\" requires the filter to "
+                               "specify at least one member.")
+                               .arg(_hlist ? xml::hlistEntry : xml::listEntry));
+    }
+
+    return true;
+}
+
+
+Instance ListEntryAction::evaluate(const Instance *inst,
+                                   const ConstMemberList &members,
+                                   ScriptEngine *eng, bool *matched) const
+{
+    Q_UNUSED(eng);
+
+    if (matched)
+        *matched = true;
+
+    if (!inst || !inst->type() || members.isEmpty())
+        return Instance();
+
+    // We can only follow the "next" member of a hlist_node
+    if (_hlist && members.last()->name() != "next") {
+        if (matched)
+            *matched = false;
+        return Instance();
+    }
+
+    // Follow the members to the list node and sum up the offsets of the
+    // embedded members
+    Instance ret(*inst);
+    quint64 offset = 0;
+    for (int i = 0; i < members.size(); ++i) {
+        if (i + 1 < members.size())
+            offset += members[i]->offset();
+        ret = ret.member(members[i]->index(), BaseType::trLexicalAllPointers,
+                         -1, ksNone);
+        // Fall back to the default handler for invalid or empty lists
+        if (!ret.isValid() || ret.isNull()) {
+            if (matched)
+                *matched = false;
+            return Instance();
+        }
+    }
+
+    // The embedding object has the same type as the instance
+    ret.setType(inst->type());
+    ret.addToAddress(-offset);
+
+    return ret;
+}
+
+
+QString ListEntryAction::toString(const ColorPalette *col) const
+{
+    return QString("Follow %1 based list")
+            .arg(Console::colorize(_hlist ? "struct hlist_node" :
+                                            "struct list_head", ctBold, col));
+}
+
+
+//------------------------------------------------------------------------------
+// DiscriminantAction
+//------------------------------------------------------------------------------
+
+bool DiscriminantAction::check(const QString &xmlFile, const TypeRule *rule,
+                               SymFactory *factory)
+{
+    Q_UNUSED(factory);
+
+    // The accessed member is compared to the valid members
+    if (!rule->filter() || rule->filter()->members().isEmpty()) {
+        typeRuleError2(xmlFile, srcLine(), -1,
+                       QString("Action type \"%1\" requires the filter to "
+                               "specify at least one member.")
+                               .arg(xml::discriminant));
+    }
+
+    _discrPath = _discrStr.trimmed().split('.');
+    for (int i = 0; i < _discrPath.size(); ++i) {
+        _discrPath[i] = _discrPath[i].trimmed();
+        if (_discrPath[i].isEmpty())
+            typeRuleError2(xmlFile, srcLine(), -1,
+                           QString("Invalid discriminant: \"%1\"")
+                                .arg(_discrStr));
+    }
+
+    if (_cases.isEmpty() && _defaults.isEmpty())
+        typeRuleError2(xmlFile, srcLine(), -1,
+                       QString("Action type \"%1\" requires at least one "
+                               "element \"%2\" or \"%3\".")
+                            .arg(xml::discriminant)
+                            .arg(xml::discrCase)
+                            .arg(xml::discrDefault));
+
+    return true;
+}
+
+
+Instance DiscriminantAction::evaluate(const Instance *inst,
+                                      const ConstMemberList &members,
+                                      ScriptEngine *eng, bool *matched) const
+{
+    Q_UNUSED(eng);
+
+    if (matched)
+        *matched = true;
+
+    if (!inst || !inst->type() || members.isEmpty() || _discrPath.isEmpty())
+        return Instance();
+
+    // Read the discriminant
+    Instance d(*inst);
+    for (int i = 0; i < _discrPath.size() && d.isValid(); ++i)
+        d = d.member(_discrPath[i], BaseType::trLexicalAllPointers, -1, ksNone);
+
+    const QStringList* valid = &_defaults;
+    if (d.isValid() && !d.isNull() && (d.type()->type() & IntegerTypes)) {
+        qint64 value = (d.type()->type() & SignedIntegerTypes) ?
+                    d.toNumber() : (qint64)d.toUnsignedNumber();
+        QHash<qint64, QStringList>::const_iterator it = _cases.find(value);
+        if (it != _cases.end())
+            valid = &it.value();
+    }
+
+    // Use the default handler for valid members only
+    if (valid->contains(members.last()->name()) && matched)
+        *matched = false;
+
+    return Instance();
+}
+
+
+QString DiscriminantAction::toString(const ColorPalette *col) const
+{
+    QString s;
+
+    s += Console::colorize("Discriminant:", ctColHead, col) + " " + _discrStr;
+
+    QList<qint64> values(_cases.keys());
+    qSort(values);
+    foreach (qint64 value, values) {
+        s += "\n" + Console::colorize("Case:", ctColHead, col) +
+                QString(" %1 => %2")
+                    .arg(value < 0 ? QString::number(value) :
+                                     QString("0x%1").arg(value, 0, 16))
+                    .arg(_cases[value].join(", "));
+    }
+
+    if (!_defaults.isEmpty())
+        s += "\n" + Console::colorize("Default:", ctColHead, col) + " " +
+                _defaults.join(", ");
+
+    return s;
+}
+
+
 bool TypeRuleAction::match(const BaseType *type, const OsSpecs *specs) const
 {
     Q_UNUSED(type);
@@ -766,7 +949,8 @@ const QStringList &TypeRuleAction::supportedActionTypes()
 {
     static QStringList types;
     if (types.isEmpty())
-        types << xml::expression  << xml::inlineCode << xml::function;
+        types << xml::expression  << xml::inlineCode << xml::function
+              << xml::listEntry << xml::hlistEntry << xml::discriminant;
     return types;
 }
 
@@ -779,9 +963,30 @@ TypeRuleAction::ActionType TypeRuleAction::strToActionType(const QString& action
         return TypeRuleAction::atFunction;
     else if (action == xml::inlineCode)
         return TypeRuleAction::atInlineCode;
+    else if (action == xml::listEntry)
+        return TypeRuleAction::atListEntry;
+    else if (action == xml::hlistEntry)
+        return TypeRuleAction::atHListEntry;
+    else if (action == xml::discriminant)
+        return TypeRuleAction::atDiscriminant;
     else
         return TypeRuleAction::atNone;
 }
 
 
+QString TypeRuleAction::actionTypeToStr(ActionType type)
+{
+    switch (type) {
+    case atExpression:   return xml::expression;
+    case atInlineCode:   return xml::inlineCode;
+    case atFunction:     return xml::function;
+    case atListEntry:    return xml::listEntry;
+    case atHListEntry:   return xml::hlistEntry;
+    case atDiscriminant: return xml::discriminant;
+    case atNone:         break;
+    }
+    return QString();
+}
+
+
 
@@ -10,9 +10,13 @@
 #include <insight/refbasetype.h>
 #include <insight/variable.h>
 #include <insight/typeruleenginecontextprovider.h>
+#include <insight/structured.h>
+#include <insight/structuredmember.h>
+#include <insight/multithreading.h>
 #include <debug.h>
 #include <QTextStream>
 #include <QThread>
+#include <QSet>
 
 namespace js
 {
@@ -31,9 +35,160 @@ public:
 };
 
 
+namespace
+{
+/// Returns \c true if \a a has to be tested before \a b by match()
+inline bool rulePrecedes(const ActiveRule* a, const ActiveRule* b)
+{
+    int pa = a->rule->priority(), pb = b->rule->priority();
+    return pa > pb || (pa == pb && a->index < b->index);
+}
+
+
+void sortDispatchNode(RuleDispatchNode* node)
+{
+    qStableSort(node->rules.begin(), node->rules.end(), rulePrecedes);
+    qStableSort(node->generic.begin(), node->generic.end(), rulePrecedes);
+    foreach (RuleDispatchNode* child, node->children)
+        sortDispatchNode(child);
+}
+
+
+/// Returns a context checked out from a TypeRuleEngineContextPool when going
+/// out of scope
+class PooledContextGuard
+{
+public:
+    PooledContextGuard(TypeRuleEngineContextPool* pool)
+        : _pool(pool), _ctx(0) {}
+    ~PooledContextGuard() { if (_ctx) _pool->release(_ctx); }
+    TypeRuleEngineContext* acquire() { return _ctx = _pool->acquire(); }
+
+private:
+    TypeRuleEngineContextPool* _pool;
+    TypeRuleEngineContext* _ctx;
+};
+
+
+/// Returns the no. of parent name components of \a result that are the full
+/// name of \a inst, or -1 if the name of \a result is not derived from it
+int inheritedNameCount(const Instance* result, const Instance* inst)
+{
+    const QStringList instNames(inst->fullNameComponents());
+    const QStringList parentNames(result->parentNameComponents());
+    if (parentNames.size() < instNames.size())
+        return -1;
+    for (int i = 0; i < instNames.size(); ++i)
+        if (parentNames[i] != instNames[i])
+            return -1;
+    return instNames.size();
+}
+
+
+void insertIntoDispatchNode(RuleDispatchNode* node, const ActiveRule* arule,
+                            const QList<QList<StringAtom> >& path, int depth)
+{
+    node->rules.append(arule);
+    if (depth >= path.size())
+        return;
+    foreach (StringAtom a, path[depth]) {
+        RuleDispatchNode*& child = node->children[a];
+        if (!child)
+            child = new RuleDispatchNode();
+        insertIntoDispatchNode(child, arule, path, depth + 1);
+    }
+}
+}
+
+
+TypeRuleEngineContextPool::TypeRuleEngineContextPool(KernelSymbols *symbols)
+    : _symbols(symbols)
+{
+}
+
+
+TypeRuleEngineContextPool::~TypeRuleEngineContextPool()
+{
+    clear();
+}
+
+
+TypeRuleEngineContext* TypeRuleEngineContextPool::create() const
+{
+    TypeRuleEngineContext* ctx = new TypeRuleEngineContext(_symbols);
+    // Set up the scripting environment and its bindings only once
+    ctx->eng.initScriptEngine();
+    return ctx;
+}
+
+
+int TypeRuleEngineContextPool::maxIdle() const
+{
+    return MultiThreading::maxThreads();
+}
+
+
+TypeRuleEngineContext* TypeRuleEngineContextPool::acquire()
+{
+    _lock.lock();
+    if (!_idle.isEmpty()) {
+        TypeRuleEngineContext* ctx = _idle.takeLast();
+        _lock.unlock();
+        return ctx;
+    }
+    _lock.unlock();
+
+    // Initialize the new context without holding the lock
+    return create();
+}
+
+
+void TypeRuleEngineContextPool::release(TypeRuleEngineContext *ctx)
+{
+    if (!ctx)
+        return;
+    ctx->currentRule = 0;
+
+    _lock.lock();
+    if (_idle.size() < maxIdle()) {
+        _idle.append(ctx);
+        ctx = 0;
+    }
+    _lock.unlock();
+
+    // Pool is full, so discard this context
+    if (ctx)
+        delete ctx;
+}
+
+
+void TypeRuleEngineContextPool::reserve(int count)
+{
+    for (int i = idleCount(); i < count; ++i) {
+        TypeRuleEngineContext* ctx = create();
+        QMutexLocker lock(&_lock);
+        _idle.append(ctx);
+    }
+}
+
+
+int TypeRuleEngineContextPool::idleCount() const
+{
+    QMutexLocker lock(&_lock);
+    return _idle.size();
+}
+
+
+void TypeRuleEngineContextPool::clear()
+{
+    QMutexLocker lock(&_lock);
+    qDeleteAll(_idle);
+    _idle.clear();
+}
+
+
 TypeRuleEngine::TypeRuleEngine(KernelSymbols *symbols)
-    : _ctx(new TypeRuleEngineContext(symbols)), _verbose(veOff),
-      _symbols(symbols)
+    : _ctxPool(symbols), _verbose(veOff), _symbols(symbols)
 {
 }
 
@@ -41,7 +196,6 @@ TypeRuleEngine::TypeRuleEngine(KernelSymbols *symbols)
 TypeRuleEngine::~TypeRuleEngine()
 {
     clear();
-    delete _ctx;
 }
 
 
@@ -51,6 +205,7 @@ void TypeRuleEngine::clear()
         delete _rules[i];
     _rules.clear();
     _rulesPerType.clear();
+    clearDispatchIndex();
     for (int i = 0; i < _activeRules.size(); ++i)
         delete _activeRules[i];
     _activeRules.clear();
@@ -63,6 +218,8 @@ void TypeRuleEngine::clear()
     _osFilters.clear();
     _ruleFiles.clear();
     _hits.clear();
+    // The scripting engines cache the programs of the deleted rules
+    _ctxPool.clear();
 }
 
 
@@ -163,6 +320,7 @@ void TypeRuleEngine::checkRules(int from)
         from = 0;
         _hits.fill(0, _rules.size());
         _rulesPerType.clear();
+        clearDispatchIndex();
         for (int i = 0; i < _activeRules.size(); ++i)
             delete _activeRules[i];
         _activeRules.clear();
@@ -189,6 +347,8 @@ void TypeRuleEngine::checkRules(int from)
         checkRule(_rules[i], i, &specs);
     }
 
+    buildDispatchIndex();
+
     operationStopped();
     operationProgress();
     shellEndl();
@@ -234,6 +394,18 @@ bool TypeRuleEngine::checkRule(TypeRule *rule, int index, const OsSpecs *specs)
         return false;
     }
 
+    // Point out scripts that could be replaced by a faster native action
+    const ScriptAction* sa = dynamic_cast<const ScriptAction*>(rule->action());
+    TypeRuleAction::ActionType native =
+            sa ? sa->nativeEquivalent() : TypeRuleAction::atNone;
+    if (native != TypeRuleAction::atNone) {
+        ruleMsg(rule, index, "Hint",
+                QString("could use the native action type \"%1\" instead of "
+                        "a script.")
+                    .arg(TypeRuleAction::actionTypeToStr(native)),
+                ctWarningLight, ctWarning);
+    }
+
     QScriptProgramPtr prog;
     ActiveRule* arule = new ActiveRule(index, rule, prog);
 
@@ -241,8 +413,8 @@ bool TypeRuleEngine::checkRule(TypeRule *rule, int index, const OsSpecs *specs)
     int hits = 0;
     // If we have a type name or a type ID, we don't have to try all rules
     if (rule->filter()->filterActive(Filter::ftTypeNameLiteral)) {
-        const QString& name = rule->filter()->typeName();
-        BaseTypeStringHash::const_iterator
+        StringAtom name = StringAtoms::find(rule->filter()->typeName());
+        BaseTypeAtomHash::const_iterator
                 it = factory->typesByName().find(name),
                 e = factory->typesByName().end();
         while (it != e && it.key() == name) {
@@ -345,7 +517,8 @@ bool TypeRuleEngine::setActive(const TypeRule *rule)
             // Check if the rule is already active
             if (_hits[i] == 0) {
                 OsSpecs specs(&_symbols->memSpecs());
-                checkRule(const_cast<TypeRule*>(rule), i, &specs);
+                if (checkRule(const_cast<TypeRule*>(rule), i, &specs))
+                    buildDispatchIndex();
             }
             return _hits[i] > 0;
         }
@@ -384,6 +557,7 @@ bool TypeRuleEngine::setInactive(const TypeRule *rule)
             else
                 ++hit;
         }
+        buildDispatchIndex();
     }
 
     delete arule;
@@ -396,6 +570,112 @@ void TypeRuleEngine::resetActiveRulesUsage()
 {
     for (int i = 0; i < _activeRules.size(); ++i)
         _activeRules[i]->usageCount = 0;
+    _matchLookups = 0;
+    _matchCandidates = 0;
+    _matchHits = 0;
+    _resultCache.resetStatistics();
+}
+
+
+TypeRuleEngine::MatchStatistics TypeRuleEngine::matchStatistics() const
+{
+    MatchStatistics stats;
+    stats.lookups = _matchLookups;
+    stats.candidates = _matchCandidates;
+    stats.matches = _matchHits;
+    stats.cacheHits = _resultCache.hits();
+    stats.cacheMisses = _resultCache.misses();
+    return stats;
+}
+
+
+void TypeRuleEngine::setResultCacheSize(int size)
+{
+    _resultCache.setMaxSize(size);
+    if (!size)
+        _resultCache.clear();
+}
+
+
+void TypeRuleEngine::invalidateResultCache()
+{
+    _resultCache.clear();
+}
+
+
+void TypeRuleEngine::clearDispatchIndex()
+{
+    qDeleteAll(_dispatch);
+    _dispatch.clear();
+    _resultCache.clear();
+}
+
+
+void TypeRuleEngine::buildDispatchIndex()
+{
+    clearDispatchIndex();
+
+    // Find all rules that only match literal member names. Only these rules
+    // can be dispatched by the member names.
+    QHash<QString, QList<StringAtom> > spellings;
+    for (int i = 0; i < _activeRules.size(); ++i) {
+        ActiveRule* arule = _activeRules[i];
+        const InstanceFilter* filter = arule->rule->filter();
+        arule->membersIndexed = (filter != 0);
+        for (int j = 0; arule->membersIndexed && j < filter->members().size(); ++j)
+            if ((int)filter->members().at(j).filters() != Filter::ftVarNameLiteral)
+                arule->membersIndexed = false;
+        arule->cacheable = filter && arule->rule->action() &&
+                arule->rule->action()->isPure() &&
+                !filter->filterActive(
+                    Filter::Options(Filter::ftVarNameAll|Filter::ftSymFileAll));
+        if (arule->membersIndexed)
+            for (int j = 0; j < filter->members().size(); ++j)
+                spellings.insert(filter->members().at(j).name().toLower(),
+                                 QList<StringAtom>());
+    }
+
+    // Member names are matched case-insensitive, so collect all spellings of
+    // the names that occur in any struct or union
+    if (!spellings.isEmpty()) {
+        QSet<StringAtom> seen;
+        foreach (const BaseType* bt, _symbols->factory().types()) {
+            if (!(bt->type() & (rtStruct|rtUnion)))
+                continue;
+            const Structured* s = static_cast<const Structured*>(bt);
+            foreach (const StructuredMember* m, s->members()) {
+                if (seen.contains(m->nameAtom()))
+                    continue;
+                seen.insert(m->nameAtom());
+                QHash<QString, QList<StringAtom> >::iterator it =
+                        spellings.find(m->name().toLower());
+                if (it != spellings.end())
+                    it.value().append(m->nameAtom());
+            }
+        }
+    }
+
+    for (ActiveRuleHash::const_iterator it = _rulesPerType.constBegin(),
+         e = _rulesPerType.constEnd(); it != e; ++it)
+    {
+        RuleDispatchNode*& root = _dispatch[it.key()];
+        if (!root)
+            root = new RuleDispatchNode();
+        const ActiveRule* arule = it.value();
+
+        if (arule->membersIndexed) {
+            const MemberFilterList& mfl = arule->rule->filter()->members();
+            QList<QList<StringAtom> > path;
+            for (int i = 0; i < mfl.size(); ++i)
+                path.append(spellings.value(mfl[i].name().toLower()));
+            insertIntoDispatchNode(root, arule, path, 0);
+        }
+        else
+            root->generic.append(arule);
+    }
+
+    foreach (RuleDispatchNode* root, _dispatch)
+        sortDispatchNode(root);
 }
 
 
@@ -403,6 +683,7 @@ int TypeRuleEngine::match(const Instance *inst, const ConstMemberList &members,
                           Instance** newInst, int *priority) const
 {
     TypeRuleEngineContext *ctx = 0;
+    PooledContextGuard pooledCtx(&_ctxPool);
     if (priority)
         *priority = 0;
 
@@ -414,15 +695,66 @@ int TypeRuleEngine::match(const Instance *inst, const ConstMemberList &members,
     *newInst = 0;
     int ruleInfosPrinted = 0;
 
-    ActiveRuleHash::const_iterator it = _rulesPerType.find(inst->type()->id()),
-            e = _rulesPerType.end();
+    const RuleDispatchNode* root = _dispatch.value(inst->type()->id());
+    if (!root)
+        return mrNoMatch;
 
+    // Follow the accessed members through the dispatch index. For verbose
+    // output of all rules, we need to consider all rules of this type.
+    const bool allRules = (_verbose >= veAllRules);
+    const RuleDispatchNode* node = root;
+    for (int i = 0; !allRules && node && i < members.size(); ++i)
+        node = node->children.value(members[i]->nameAtom());
+
+    // Try the result cache first
+    RuleResultKey cacheKey;
+    const bool useCache = _resultCache.isEnabled() && !_verbose &&
+            cacheKey.set(inst, members);
+    RuleResult cached;
+    if (useCache && _resultCache.find(cacheKey, &cached)) {
+        if (priority)
+            *priority = cached.priority;
+        if (cached.hasInst) {
+            *newInst = new Instance(cached.inst);
+            // The name is relative to the instance the result was cached for
+            if (cached.inheritedNames >= 0) {
+                QStringList parentNames(inst->fullNameComponents());
+                parentNames += cached.inst.parentNameComponents()
+                        .mid(cached.inheritedNames);
+                (*newInst)->setParentNameComponents(parentNames);
+            }
+        }
+        if (cached.rule)
+            ++const_cast<ActiveRule*>(cached.rule)->usageCount;
+        _matchLookups.fetchAndAddRelaxed(1);
+        if (cached.match & mrMatch)
+            _matchHits.fetchAndAddRelaxed(1);
+        return cached.match;
+    }
+    bool cacheable = true;
+
+    static const ActiveRuleCList noRules;
+    const ActiveRuleCList& literal = node ? node->rules : noRules;
+    const ActiveRuleCList& generic = root->generic;
+    int li = 0, gi = 0, candidates = 0;
+
+    // Both lists are sorted by priority, so we merge them on the fly.
     // Rules with variable names might need to match inst->name(), so check all.
     // We can stop as soon as all possibly ORed values are included.
-    for (; it != e && it.key() == inst->type()->id(); ++it) {
-        const ActiveRule* arule = it.value();
+    while (li < literal.size() || gi < generic.size()) {
+        const ActiveRule* arule =
+                (gi >= generic.size() ||
+                 (li < literal.size() && rulePrecedes(literal[li], generic[gi]))) ?
+                    literal[li++] : generic[gi++];
         const TypeRule* rule = arule->rule;
 
+        // No rule with a lower priority can override a previous match, but it
+        // might still match with further members given, which the caller
+        // needs to know. So we can stop only once mrDefer is set.
+        const bool deferOnly = (ret & mrMatch) && rule->priority() < prio;
+        if (deferOnly && (ret & mrDefer) && !_verbose)
+            break;
+
         // If the result is already clear, check only for higher priority rules
         if (ret == (mrMatch|mrAmbiguous|mrDefer) && rule->priority() <= prio) {
             // Output information
@@ -434,11 +766,17 @@ int TypeRuleEngine::match(const Instance *inst, const ConstMemberList &members,
 
         const InstanceFilter* filter = rule->filter();
         bool match = false, evaluated = false, skipped = true;
+        // The dispatch index already matched the member names
+        const bool checkMembers = allRules || !arule->membersIndexed;
         tmp_ret = 0;
 
-        // Ignore rules with a lower priority than the previously matched one
-        if (filter && (!(ret & mrMatch) || rule->priority() >= prio)) {
+        // Only check if rules with a lower priority than the previously matched
+        // one defer
+        if (filter && (!deferOnly || !(ret & mrDefer))) {
             skipped = false;
+            ++candidates;
+            if (!arule->cacheable)
+                cacheable = false;
             if (!filter->filterActive(Filter::ftVarNameAll) ||
                 filter->matchInst(inst))
             {
@@ -446,7 +784,7 @@ int TypeRuleEngine::match(const Instance *inst, const ConstMemberList &members,
                 if (filter->members().size() > members.size()) {
                     // Check if the fields given so far match the required fields
                     match = true;
-                    for (int i = 0; match && i < members.size(); ++i)
+                    for (int i = 0; checkMembers && match && i < members.size(); ++i)
                         if (!filter->members().at(i).match(members[i]))
                             match = false;
                     // Match but not all fields given yet ==> defer
@@ -456,12 +794,13 @@ int TypeRuleEngine::match(const Instance *inst, const ConstMemberList &members,
                 // Required no. of fields given ==> match
                 // However, we don't need to evaluate anymore non-high-prio
                 // rules if both mrMatch and mrAmbiguous are already set
-                else if (filter->members().size() == members.size() &&
+                else if (!deferOnly &&
+                         filter->members().size() == members.size() &&
                          (!((ret & mrMatch) && (ret & mrAmbiguous)) ||
                           rule->priority() > prio))
                 {
                     match = true;
-                    for (int i = 0; match && i < members.size(); ++i)
+                    for (int i = 0; checkMembers && match && i < members.size(); ++i)
                         if (!filter->members().at(i).match(members[i]))
                             match = false;
 
@@ -474,8 +813,8 @@ int TypeRuleEngine::match(const Instance *inst, const ConstMemberList &members,
                             const TypeRuleEngineContextProvider* ctxp =
                                     dynamic_cast<const TypeRuleEngineContextProvider*>(
                                         QThread::currentThread());
-                            ctx = ctxp ? ctxp->typeRuleCtx() : _ctx;
-
+                            // Use a pooled context if this thread has none
+                            ctx = ctxp ? ctxp->typeRuleCtx() : pooledCtx.acquire();
                         }
 
                         // Evaluate the rule
@@ -484,7 +823,7 @@ int TypeRuleEngine::match(const Instance *inst, const ConstMemberList &members,
                         if (ctx)
                             ctx->currentRule = arule;
                         Instance instRet(evaluateRule(arule, inst, members,
-                                                      &match, ctx ? ctx : _ctx));
+                                                      &match, ctx));
                         if (ctx)
                             ctx->currentRule = 0;
                         instRet.setOrigin(Instance::orRuleEngine);
@@ -532,11 +871,16 @@ int TypeRuleEngine::match(const Instance *inst, const ConstMemberList &members,
         }
         // Output information
         if (_verbose) {
-            if (ruleMatchInfo(it.value(), inst, members, tmp_ret, evaluated, skipped))
+            if (ruleMatchInfo(arule, inst, members, tmp_ret, evaluated, skipped))
                 ++ruleInfosPrinted;
         }
     }
 
+    _matchLookups.fetchAndAddRelaxed(1);
+    _matchCandidates.fetchAndAddRelaxed(candidates);
+    if (ret & mrMatch)
+        _matchHits.fetchAndAddRelaxed(1);
+
     if (ruleInfosPrinted > 0) {
         Console::out() << "==> Result: ";
         if (usedRule)
@@ -564,6 +908,21 @@ int TypeRuleEngine::match(const Instance *inst, const ConstMemberList &members,
         *newInst = 0;
     }
 
+    // Remember the result if all tested rules allow it. Results that point
+    // back into the instance depend on its name, so don't cache them.
+    if (useCache && cacheable && !(*newInst && inst->overlaps(**newInst))) {
+        RuleResult r;
+        r.match = ret;
+        r.priority = (ret & mrMatch) ? prio : 0;
+        r.rule = usedRule;
+        if (*newInst) {
+            r.inst = **newInst;
+            r.hasInst = true;
+            r.inheritedNames = inheritedNameCount(*newInst, inst);
+        }
+        _resultCache.insert(cacheKey, r);
+    }
+
     // Increase usage counter for matched rule
     if (usedRule)
         ++usedRule->usageCount;
@@ -681,7 +1040,7 @@ Instance TypeRuleEngine::evaluateRule(const ActiveRule* arule,
     if (arule->rule->action()) {
         try {
             ret = arule->rule->action()->evaluate(inst, members,
-                                                 ctx ? &ctx->eng : &_ctx->eng, &m);
+                                                 ctx ? &ctx->eng : 0, &m);
             if (matched)
                 *matched = m;
 
@@ -961,6 +1320,12 @@ QString TypeRuleEngine::matchingRulesToStr(const ActiveRuleCList &rules,
 			break;
 		}
 
+		case TypeRuleAction::atListEntry:
+		case TypeRuleAction::atHListEntry:
+		case TypeRuleAction::atDiscriminant:
+			out << action->toString(col).replace("\n", "; ");
+			break;
+
 		case TypeRuleAction::atNone:
 			break;
 		}
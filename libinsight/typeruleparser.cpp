@@ -48,6 +48,13 @@ const char* srcType = "sourcetype";
 const char* targetType = "targettype";
 const char* expression = "expression";
 const char* priority = "priority";
+const char* pure = "pure";
+const char* listEntry = "listentry";
+const char* hlistEntry = "hlistentry";
+const char* discriminant = "discriminant";
+const char* discrCase = "case";
+const char* discrDefault = "default";
+const char* value = "value";
 }
 
 
@@ -282,6 +289,18 @@ bool TypeRuleParser::startElement(const QString &namespaceURI,
             action = new ProgramScriptAction();
             break;
 
+        case TypeRuleAction::atListEntry:
+            action = new ListEntryAction(false);
+            break;
+
+        case TypeRuleAction::atHListEntry:
+            action = new ListEntryAction(true);
+            break;
+
+        case TypeRuleAction::atDiscriminant:
+            action = new DiscriminantAction();
+            break;
+
         default: {
             typeRuleErrorLoc(QString("Unknown action type '%1', must be one "
                                      "of: %2")
@@ -291,6 +310,23 @@ bool TypeRuleParser::startElement(const QString &namespaceURI,
         }
 
         action->setSrcLine(_locator ? _locator->lineNumber() : 0);
+
+        // Is the action declared to have no side effects?
+        if (attributes.contains(xml::pure)) {
+            QString pure = attributes[xml::pure].toLower();
+            if (pure == "true" || pure == "1")
+                action->setPure(true);
+            else if (pure == "false" || pure == "0")
+                action->setPure(false);
+            else {
+                delete action;
+                typeRuleErrorLoc(QString("Invalid value for attribute \"%1\": "
+                                         "%2. Allowed values are: true, false")
+                                 .arg(xml::pure)
+                                 .arg(attributes[xml::pure]));
+            }
+        }
+
         _rule->setAction(action);
     }
 
@@ -397,6 +433,22 @@ bool TypeRuleParser::endElement(const QString &namespaceURI,
             }
             break;
         }
+        case TypeRuleAction::atListEntry:
+        case TypeRuleAction::atHListEntry:
+            break;
+
+        case TypeRuleAction::atDiscriminant: {
+            if (_children.isEmpty() ||
+                !_children.top().contains(xml::discriminant))
+            {
+                typeRuleErrorLoc(QString("Action type \"%1\" in element \"%2\" "
+                                         "requires the child element \"%3\".")
+                                 .arg(xml::discriminant)
+                                 .arg(name)
+                                 .arg(xml::discriminant));
+            }
+            break;
+        }
         default:
             typeRuleErrorLoc(QString("Action type \"%1\" unknown for attribute "
                                   "\"%2\" in element \"%3\".")
@@ -427,6 +479,37 @@ bool TypeRuleParser::endElement(const QString &namespaceURI,
         else
             action->setExpressionStr(_cdata.trimmed());
     }
+    // <discriminant>
+    // <case>
+    // <default>
+    else if (name == xml::discriminant || name == xml::discrCase ||
+             name == xml::discrDefault)
+    {
+        errorIfNull(_rule);
+
+        DiscriminantAction* action =
+                dynamic_cast<DiscriminantAction*>(_rule->action());
+        if (!action)
+            typeRuleErrorLoc(QString("Element \"%1\" only valid for action "
+                                     "type \"%2\".")
+                             .arg(name)
+                             .arg(xml::discriminant));
+
+        if (name == xml::discriminant)
+            action->setDiscriminantStr(_cdata.trimmed());
+        else if (name == xml::discrDefault)
+            action->addDefault(_cdata.trimmed());
+        else {
+            // Accept decimal, octal, and hexadecimal values
+            bool ok;
+            QString value = _attributes.top().value(xml::value);
+            qint64 v = value.trimmed().toLongLong(&ok, 0);
+            if (!ok)
+                typeRuleErrorLoc(QString("Not a valid integer number: %1")
+                                 .arg(value));
+            action->addCase(v, _cdata.trimmed());
+        }
+    }
     // <filter>
     else if (name == xml::filter) {
         errorIfNull(_rule);
@@ -537,7 +620,9 @@ const XmlSchema &TypeRuleParser::schema()
         // <action>
         ruleSchema.addElement(xml::action,
                               QStringList() << xml::srcType << xml::targetType
-                              << xml::expression, QStringList(xml::file),
+                              << xml::expression << xml::discriminant
+                              << xml::discrCase << xml::discrDefault,
+                              QStringList() << xml::file << xml::pure,
                               QStringList(xml::type), false);
 
         // <sourcetype>
@@ -549,6 +634,16 @@ const XmlSchema &TypeRuleParser::schema()
         // <expression>
         ruleSchema.addElement(xml::expression);
 
+        // <discriminant>
+        ruleSchema.addElement(xml::discriminant, empty, empty, empty, false);
+
+        // <case>
+        ruleSchema.addElement(xml::discrCase, empty, empty,
+                              QStringList(xml::value));
+
+        // <default>
+        ruleSchema.addElement(xml::discrDefault);
+
         // <filter>
         children = VariableFilter::supportedFilters().keys();
         // Add <members> instead of <member> as child of <filter>
@@ -0,0 +1,122 @@
+#include <insight/typeusagelog.h>
+#include <insight/structuredmember.h>
+#include <insight/structured.h>
+#include <insight/variable.h>
+#include <insight/astexpression.h>
+
+
+TypeUsageLog::TypeUsageLog()
+    : _out(&_data, QIODevice::WriteOnly), _count(0), _valid(true)
+{
+}
+
+
+bool TypeUsageLog::beginMemberRecord(RecordType type,
+                                     const StructuredMember *member)
+{
+    if (!_valid)
+        return false;
+
+    // Members of type copies are not identified by a stable ID
+    const Structured* s = member ? member->belongsTo() : 0;
+    int index = s ? s->members().indexOf(const_cast<StructuredMember*>(member))
+                  : -1;
+    if (!s || s->id() <= 0 || index < 0) {
+        invalidate();
+        return false;
+    }
+
+    _out << (qint8) type << (qint32) s->id() << (qint32) index;
+    ++_count;
+    return true;
+}
+
+
+bool TypeUsageLog::checkExpression(const ASTExpression *expr)
+{
+    if (!expr) {
+        invalidate();
+        return false;
+    }
+
+    // The expression must not reference any type copies
+    ASTConstExpressionList vars = expr->findExpressions(etVariable);
+    for (int i = 0; i < vars.size(); ++i) {
+        const ASTVariableExpression* v =
+                dynamic_cast<const ASTVariableExpression*>(vars[i]);
+        if (v && v->baseType() && v->baseType()->id() <= 0) {
+            invalidate();
+            return false;
+        }
+    }
+    return true;
+}
+
+
+void TypeUsageLog::addAltRefType(const StructuredMember *member, int targetId,
+                                 const ASTExpression *expr)
+{
+    if (targetId <= 0)
+        invalidate();
+    if (!checkExpression(expr) || !beginMemberRecord(lrMemberAltRefType, member))
+        return;
+    _out << (qint32) targetId;
+    ASTExpression::toStream(expr, _out);
+}
+
+
+void TypeUsageLog::addAltRefType(const Variable *var, int targetId,
+                                 const ASTExpression *expr)
+{
+    if (!var || targetId <= 0)
+        invalidate();
+    if (!_valid || !checkExpression(expr))
+        return;
+    _out << (qint8) lrVarAltRefType << (qint32) var->id() << (qint32) targetId;
+    ASTExpression::toStream(expr, _out);
+    ++_count;
+}
+
+
+void TypeUsageLog::addNotConstant(const StructuredMember *member)
+{
+    beginMemberRecord(lrMemberNotConstant, member);
+}
+
+
+void TypeUsageLog::addConstant(const StructuredMember *member, qint64 value)
+{
+    if (beginMemberRecord(lrMemberConstInt, member))
+        _out << value;
+}
+
+
+void TypeUsageLog::addConstant(const StructuredMember *member,
+                               const QString &value)
+{
+    if (beginMemberRecord(lrMemberConstString, member))
+        _out << value;
+}
+
+
+void TypeUsageLog::invalidate()
+{
+    _valid = false;
+}
+
+
+void TypeUsageLog::setData(const QByteArray &data, int count)
+{
+    clear();
+    _out.writeRawData(data.constData(), data.size());
+    _count = count;
+}
+
+
+void TypeUsageLog::clear()
+{
+    _out.device()->seek(0);
+    _data.clear();
+    _count = 0;
+    _valid = true;
+}
@@ -38,11 +38,11 @@ QString Variable::prettyName(const QString &varName) const
                 refTypeDeep(BaseType::trAnyButTypedef));
 
     if (fp)
-        return fp->prettyName(_name, dynamic_cast<const RefBaseType*>(t));
+        return fp->prettyName(name(), dynamic_cast<const RefBaseType*>(t));
     else if (t)
-        return t->prettyName(_name);
+        return t->prettyName(name());
     else
-        return QString("(unresolved type 0x%1) %2").arg((uint)_refTypeId, 0, 16).arg(_name);
+        return QString("(unresolved type 0x%1) %2").arg((uint)_refTypeId, 0, 16).arg(name());
 }
 
 
@@ -66,7 +66,7 @@ Instance Variable::toInstance(VirtualMemory* vmem, int resolveTypes,
 
 	// If allowed, and available, try the rule engine first
 	if (_ruleEngine && !(src & ksNoRulesEngine)) {
-		ret = createRefInstance(_offset, vmem, _name, _id, resolveTypes);
+		ret = createRefInstance(_offset, vmem, name(), _id, resolveTypes);
 		ret.setOrigin(Instance::orVariable);
 
 		Instance *newInst = 0;
@@ -97,7 +97,7 @@ Instance Variable::toInstance(VirtualMemory* vmem, int resolveTypes,
 		if ((src & ksNoAltTypes) || (match & TypeRuleEngine::mrAmbiguous) ||
 			altRefTypeCount() != 1)
 		{
-			ret = createRefInstance(_offset, vmem, _name, _id, resolveTypes);
+			ret = createRefInstance(_offset, vmem, name(), _id, resolveTypes);
 			ret.setOrigin(Instance::orVariable);
 		}
 		else
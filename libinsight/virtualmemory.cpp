@@ -63,6 +63,10 @@
 #define PHYSICAL_PAGE_MASK_X86_PAE   (~(KPAGE_SIZE-1) & (__PHYSICAL_MASK_X86_PAE << PAGE_SHIFT))
 #define PHYSICAL_PAGE_MASK_X86_64    (~(KPAGE_SIZE-1) & (__PHYSICAL_MASK_X86_64 << PAGE_SHIFT))
 
+// In PAE mode, CR3 points to the 32-byte aligned page directory pointer
+// table, see <linux/arch/x86/include/asm/pgtable-3level_types.h>
+#define CR3_PDPT_MASK_X86_PAE        (~0x1fULL & __PHYSICAL_MASK_X86)
+
 #define KERNEL_PAGE_OFFSET_FOR_MASK (KPAGE_SIZE - 1)
 #define PAGEMASK    ~((unsigned long long)KERNEL_PAGE_OFFSET_FOR_MASK)
 
@@ -1075,6 +1079,223 @@ bool VirtualMemory::isExecutable(quint64 vaddr)
 }
 
 
+quint64 VirtualMemory::kernelPageTableRoot() const
+{
+    quint64 root;
+
+    if (_specs.arch & MemSpecs::ar_i386) {
+        if (_specs.swapperPgDir >= _specs.pageOffset)
+            root = _specs.swapperPgDir - _specs.pageOffset;
+        else
+            root = _specs.swapperPgDir;
+
+        return root & ((_specs.arch & MemSpecs::ar_pae_enabled) ?
+                       PHYSICAL_PAGE_MASK_X86_PAE : PHYSICAL_PAGE_MASK_X86);
+    }
+
+    if (_specs.initLevel4Pgt >= _specs.startKernelMap)
+        root = _specs.initLevel4Pgt - (quint64) _specs.startKernelMap;
+    else if (_specs.initLevel4Pgt >= _specs.pageOffset)
+        root = _specs.initLevel4Pgt - _specs.pageOffset;
+    else
+        root = _specs.initLevel4Pgt;
+
+    return root & PHYSICAL_PAGE_MASK_X86_64;
+}
+
+
+bool VirtualMemory::readPhysical(quint64 paddr, char *buf, qint64 size)
+{
+    bool doLock = _threadSafe;
+    bool ok;
+
+    if (doLock) _physMemMutex.lock();
+    ok = _physMem->seek(paddr) && _physMem->read(buf, size) == size;
+    if (doLock) _physMemMutex.unlock();
+
+    return ok;
+}
+
+
+//------------------------------------------------------------------------------
+// PageTableIterator
+//------------------------------------------------------------------------------
+
+namespace
+{
+// Shifts of the virtual address bits that index each level, and the levels
+// that may map large pages, terminated by -1
+const int shifts_x86_64[] = { PML4_SHIFT_X86_64, PGDIR_SHIFT_X86_64,
+                              PMD_SHIFT_X86_64, PAGE_SHIFT };
+const int large_x86_64[] = { 1, 2, -1 };
+quint64 PageTableEntries::* const fields_x86_64[] = {
+    &PageTableEntries::pgd, &PageTableEntries::pud,
+    &PageTableEntries::pmd, &PageTableEntries::pte };
+
+const int shifts_x86_pae[] = { PGDIR_SHIFT_X86_PAE, PMD_SHIFT_X86_PAE,
+                               PAGE_SHIFT };
+const int large_x86_pae[] = { 1, -1 };
+quint64 PageTableEntries::* const fields_x86_pae[] = {
+    &PageTableEntries::pgd, &PageTableEntries::pmd, &PageTableEntries::pte };
+
+const int shifts_x86[] = { PGDIR_SHIFT_X86, PAGE_SHIFT };
+const int large_x86[] = { 0, -1 };
+quint64 PageTableEntries::* const fields_x86[] = {
+    &PageTableEntries::pgd, &PageTableEntries::pte };
+}
+
+
+PageTableIterator::PageTableIterator(VirtualMemory *vmem, quint64 first,
+                                     quint64 last, bool includeNonPresent,
+                                     quint64 pgd)
+    : _vmem(vmem), _next(first), _last(last),
+      _includeNonPresent(includeNonPresent), _done(first > last), _addr(0),
+      _paddr(PADDR_ERROR), _size(0)
+{
+    const MemSpecs& specs = vmem->memSpecs();
+
+    if (specs.arch & MemSpecs::ar_x86_64) {
+        _levels = 4;
+        _entrySize = 8;
+        _physMask = PHYSICAL_PAGE_MASK_X86_64;
+        _shifts = shifts_x86_64;
+        _largeLevels = large_x86_64;
+        _fields = fields_x86_64;
+    }
+    else if (specs.arch & MemSpecs::ar_pae_enabled) {
+        _levels = 3;
+        _entrySize = 8;
+        _physMask = PHYSICAL_PAGE_MASK_X86_PAE;
+        _shifts = shifts_x86_pae;
+        _largeLevels = large_x86_pae;
+        _fields = fields_x86_pae;
+    }
+    else {
+        _levels = 2;
+        _entrySize = 4;
+        _physMask = PHYSICAL_PAGE_MASK_X86;
+        _shifts = shifts_x86;
+        _largeLevels = large_x86;
+        _fields = fields_x86;
+    }
+
+    // The PDPT of PAE is only 32-byte aligned, so don't mask it like a page
+    if (!pgd)
+        _root = vmem->kernelPageTableRoot();
+    else if (_levels == 3)
+        _root = pgd & CR3_PDPT_MASK_X86_PAE;
+    else
+        _root = pgd & _physMask;
+
+    for (int i = 0; i < maxLevels; ++i)
+        _tableAddr[i] = PADDR_ERROR;
+}
+
+
+bool PageTableIterator::readEntry(int level, quint64 table, quint64 *entry)
+{
+    // Read the whole table page only if we enter a new table
+    if (_tableAddr[level] != table) {
+        if (!_vmem->readPhysical(table, _tables[level], tableSize)) {
+            _tableAddr[level] = PADDR_ERROR;
+            return false;
+        }
+        _tableAddr[level] = table;
+    }
+
+    const int entries = tableSize / _entrySize;
+    const int index = (_next >> _shifts[level]) & (entries - 1);
+
+    if (_entrySize == 8)
+        *entry = ((const quint64*)_tables[level])[index];
+    else
+        *entry = ((const quint32*)_tables[level])[index];
+
+    return true;
+}
+
+
+bool PageTableIterator::advance()
+{
+    quint64 next = _addr + _size;
+    // Check for overflow or end of range
+    if (next < _addr || next > _last) {
+        _done = true;
+        return false;
+    }
+
+    // Skip the non-canonical hole of x86_64
+    if (_levels == 4 && next > VIRTUAL_USERSPACE_END_X86_64 &&
+        next < 0xffff800000000000ULL)
+    {
+        next = 0xffff800000000000ULL;
+        if (next > _last) {
+            _done = true;
+            return false;
+        }
+    }
+
+    _next = next;
+    return true;
+}
+
+
+bool PageTableIterator::next()
+{
+    if (_done)
+        return false;
+
+    // Advance past the mapping found last
+    if (_size && !advance())
+        return false;
+
+    while (true) {
+        quint64 table = _root, entry = 0;
+        int level = 0;
+        bool present = false;
+
+        _entries.reset();
+
+        for (; level < _levels; ++level) {
+            if (!readEntry(level, table, &entry)) {
+                _entries.*_fields[level] = PADDR_ERROR;
+                break;
+            }
+            _entries.*_fields[level] = entry;
+
+            if (!(entry & _PAGE_PRESENT))
+                break;
+
+            // Last level or large page?
+            bool large = false;
+            for (const int* l = _largeLevels; *l >= 0; ++l)
+                if (*l == level && (entry & _PAGE_PSE))
+                    large = true;
+
+            if (large || level == _levels - 1) {
+                present = true;
+                break;
+            }
+
+            table = entry & _physMask;
+        }
+
+        if (level >= _levels)
+            level = _levels - 1;
+
+        _size = 1ULL << _shifts[level];
+        _addr = _next & ~(_size - 1);
+        _paddr = present ? ((entry & _physMask) & ~(_size - 1)) : PADDR_ERROR;
+
+        if (present || _includeNonPresent)
+            return true;
+
+        if (!advance())
+            return false;
+    }
+}
+
+
 void PageTableEntries::reset()
 {
     pgd = pud = pmd = pte = 0;
@@ -1218,7 +1439,7 @@ bool PageTableEntries::isSupervisor() const
     }
 
     // Pte needs to be checked for all modes if we reach this point
-    return !(pte && VirtualMemory::Supervisor);
+    return !(pte & VirtualMemory::Supervisor);
 }
 
 bool PageTableEntries::isWriteable() const
@@ -1268,7 +1489,7 @@ bool PageTableEntries::isWriteable() const
     }
 
     // Pte needs to be checked for all modes if we reach this point
-    return (pte && VirtualMemory::ReadWrite);
+    return (pte & VirtualMemory::ReadWrite);
 }
 
 quint64 PageTableEntries::nextPageOffset(const MemSpecs &specs) const
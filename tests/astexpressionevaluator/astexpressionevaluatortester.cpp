@@ -7,6 +7,7 @@
 #include <insight/memspecs.h>
 #include <insight/symfactory.h>
 #include <insight/astexpressionevaluator.h>
+#include <insight/expressionprogram.h>
 #include <insight/kernelsymbolparser.h>
 #include <insight/kernelsourcetypeevaluator.h>
 #include <insight/kernelsymbols.h>
@@ -213,6 +214,7 @@ public:
         : ASTWalker(ast), _expr(eval, factory) {}
 
     ExpressionResult result;
+    ExpressionResult programResult;
 
 protected:
     void afterChildren(const ASTNode *node, int flags)
@@ -232,8 +234,10 @@ protected:
                         node->u.initializer.assignment_expression,
                         ptsTo);
 
-        if (e)
+        if (e) {
             result = e->result();
+            programResult = ExpressionProgram(e).result();
+        }
     }
 
 private:
@@ -368,6 +372,14 @@ enum ExpectFail {
 			if (expectFail & efSize) \
 				QEXPECT_FAIL("", "Expected wrong size", Continue); \
 			QCOMPARE((int)_tester->result.size, resultSize); \
+		\
+			/* The compiled expression must yield the very same result */ \
+			QCOMPARE((int)_tester->programResult.resultType, \
+					 (int)_tester->result.resultType); \
+			QCOMPARE((int)_tester->programResult.size, \
+					 (int)_tester->result.size); \
+			QCOMPARE(_tester->programResult.result.ui64, \
+					 _tester->result.result.ui64); \
 		\
 			if (_tester->result.resultType == erConstant) { \
 				if (expectFail & efResult) \
@@ -0,0 +1,197 @@
+#include "syntheticdump.h"
+#include <string.h>
+
+// Page table entry flags of x86_64
+#define PTE_PRESENT   0x1ULL
+#define PTE_RW        0x2ULL
+#define PTE_USER      0x4ULL
+#define PTE_PSE       0x80ULL
+#define PTE_NX        0x8000000000000000ULL
+#define PTE_ADDR_MASK 0x000ffffffffff000ULL
+
+#define PTRS_PER_TABLE 512
+
+const quint64 SyntheticDump::pageOffset;
+const quint64 SyntheticDump::vmallocStart;
+const quint64 SyntheticDump::vmallocEnd;
+const quint64 SyntheticDump::startKernelMap;
+const quint64 SyntheticDump::kernelText;
+const quint64 SyntheticDump::modulesVaddr;
+const quint64 SyntheticDump::modulesEnd;
+const quint64 SyntheticDump::vsyscallPage;
+const quint64 SyntheticDump::pageSize;
+const quint64 SyntheticDump::largePageSize;
+
+
+static inline int tableIndex(quint64 address, int shift)
+{
+    return (address >> shift) & (PTRS_PER_TABLE - 1);
+}
+
+
+SyntheticDump::SyntheticDump()
+{
+    // Keep the first frame unused, as a physical address of 0 is suspicious
+    _image.fill(0, pageSize);
+    _pml4 = allocFrame(pageSize, pageSize);
+}
+
+
+MemSpecs SyntheticDump::specs() const
+{
+    MemSpecs specs;
+    specs.arch = MemSpecs::ar_x86_64;
+    specs.sizeofLong = 8;
+    specs.sizeofPointer = 8;
+    specs.pageOffset = pageOffset;
+    specs.vmallocStart = vmallocStart;
+    specs.vmallocEnd = vmallocEnd;
+    specs.modulesVaddr = modulesVaddr;
+    specs.modulesEnd = modulesEnd;
+    specs.startKernelMap = startKernelMap;
+    // The kernel refers to its page tables through the kernel mapping
+    specs.initLevel4Pgt = startKernelMap + _pml4;
+    return specs;
+}
+
+
+quint64 SyntheticDump::allocFrame(quint64 size, quint64 align)
+{
+    quint64 addr = (_image.size() + align - 1) & ~(align - 1);
+    _image.append(QByteArray((int)(addr + size - _image.size()), 0));
+    return addr;
+}
+
+
+quint64 SyntheticDump::entry(quint64 table, int index) const
+{
+    quint64 value;
+    memcpy(&value, _image.constData() + table + index * 8, sizeof(value));
+    return value;
+}
+
+
+void SyntheticDump::setEntry(quint64 table, int index, quint64 value)
+{
+    memcpy(_image.data() + table + index * 8, &value, sizeof(value));
+}
+
+
+quint64 SyntheticDump::subTable(quint64 table, int index, bool user)
+{
+    quint64 e = entry(table, index);
+    if (!(e & PTE_PRESENT)) {
+        e = allocFrame(pageSize, pageSize) | PTE_PRESENT | PTE_RW;
+        setEntry(table, index, e);
+    }
+    // User-land access requires the flag on every level
+    if (user && !(e & PTE_USER))
+        setEntry(table, index, e | PTE_USER);
+
+    return e & PTE_ADDR_MASK;
+}
+
+
+void SyntheticDump::fill(quint64 physAddress, quint64 size, quint64 seed)
+{
+    // Something that looks random enough to produce distinct digests
+    quint64 x = seed ^ 0x9e3779b97f4a7c15ULL;
+    char* p = _image.data() + physAddress;
+    for (quint64 i = 0; i < size; i += 8) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        memcpy(p + i, &x, sizeof(x));
+    }
+}
+
+
+const SyntheticDump::Page& SyntheticDump::mapPage(quint64 address,
+                                                  PageKind kind,
+                                                  bool executable, bool user)
+{
+    quint64 pdpt = subTable(_pml4, tableIndex(address, 39), user);
+    quint64 pd = subTable(pdpt, tableIndex(address, 30), user);
+    quint64 pt = subTable(pd, tableIndex(address, 21), user);
+
+    Page page;
+    page.address = address;
+    page.physAddress = allocFrame(pageSize, pageSize);
+    page.size = pageSize;
+    page.kind = kind;
+    page.executable = executable;
+    page.supervisor = !user;
+
+    fill(page.physAddress, page.size, address);
+
+    quint64 e = page.physAddress | PTE_PRESENT | PTE_RW;
+    if (user)
+        e |= PTE_USER;
+    if (!executable)
+        e |= PTE_NX;
+    setEntry(pt, tableIndex(address, 12), e);
+
+    _pages.append(page);
+    return _pages.last();
+}
+
+
+void SyntheticDump::mapPages(quint64 address, int count, PageKind kind,
+                             bool executable)
+{
+    for (int i = 0; i < count; ++i)
+        mapPage(address + i * pageSize, kind, executable);
+}
+
+
+const SyntheticDump::Page& SyntheticDump::mapLargePage(quint64 address,
+                                                       PageKind kind,
+                                                       bool executable)
+{
+    quint64 pdpt = subTable(_pml4, tableIndex(address, 39), false);
+    quint64 pd = subTable(pdpt, tableIndex(address, 30), false);
+
+    Page page;
+    page.address = address;
+    page.physAddress = allocFrame(largePageSize, largePageSize);
+    page.size = largePageSize;
+    page.kind = kind;
+    page.executable = executable;
+    page.supervisor = true;
+
+    fill(page.physAddress, page.size, address);
+
+    quint64 e = page.physAddress | PTE_PRESENT | PTE_RW | PTE_PSE;
+    if (!executable)
+        e |= PTE_NX;
+    setEntry(pd, tableIndex(address, 21), e);
+
+    _pages.append(page);
+    return _pages.last();
+}
+
+
+const SyntheticDump::Page* SyntheticDump::findPage(quint64 address) const
+{
+    for (int i = 0; i < _pages.size(); ++i)
+        if (_pages[i].address == address)
+            return &_pages[i];
+    return 0;
+}
+
+
+void SyntheticDump::patch(quint64 address, quint64 offset,
+                          const QByteArray &bytes)
+{
+    const Page* page = findPage(address);
+    if (page && offset + bytes.size() <= page->size)
+        memcpy(_image.data() + page->physAddress + offset, bytes.constData(),
+               bytes.size());
+}
+
+
+QByteArray SyntheticDump::content(quint64 address) const
+{
+    const Page* page = findPage(address);
+    return page ? _image.mid(page->physAddress, page->size) : QByteArray();
+}
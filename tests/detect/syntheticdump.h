@@ -0,0 +1,132 @@
+#ifndef SYNTHETICDUMP_H
+#define SYNTHETICDUMP_H
+
+#include <QByteArray>
+#include <QList>
+#include <insight/memspecs.h>
+
+/**
+ * This class builds the physical memory image of a synthetic x86_64 guest.
+ * Pages are mapped through four-level page tables as the Linux kernel does,
+ * so the image can be read with VirtualMemory and PageTableIterator like a
+ * real memory dump. The content of every page is a deterministic byte
+ * pattern derived from its virtual address.
+ */
+class SyntheticDump
+{
+public:
+    // Kernel address space layout of x86_64 Linux
+    static const quint64 pageOffset = 0xffff880000000000ULL;
+    static const quint64 vmallocStart = 0xffffc90000000000ULL;
+    static const quint64 vmallocEnd = 0xffffe8ffffffffffULL;
+    static const quint64 startKernelMap = 0xffffffff80000000ULL;
+    static const quint64 kernelText = 0xffffffff81000000ULL;
+    static const quint64 modulesVaddr = 0xffffffffa0000000ULL;
+    static const quint64 modulesEnd = 0xffffffffff000000ULL;
+    static const quint64 vsyscallPage = 0xffffffffff600000ULL;
+
+    static const quint64 pageSize = 0x1000ULL;
+    static const quint64 largePageSize = 0x200000ULL;
+
+    /// Kind of a mapped page
+    enum PageKind {
+        pkKernelCode,
+        pkKernelData,
+        pkModuleCode,
+        pkModuleData,
+        pkVmapCode,
+        pkLazyCode,
+        pkHiddenCode,
+        pkUserCode
+    };
+
+    /// A page that has been mapped
+    struct Page
+    {
+        quint64 address;      ///< virtual address
+        quint64 physAddress;  ///< physical address
+        quint64 size;         ///< size in bytes
+        PageKind kind;
+        bool executable;
+        bool supervisor;
+
+        /**
+         * Returns \c true if Detect considers this page, i.e., if it is an
+         * executable supervisor page.
+         */
+        inline bool scanned() const { return executable && supervisor; }
+    };
+
+    /**
+     * Constructor, creates an image that contains only the top-level page
+     * table.
+     */
+    SyntheticDump();
+
+    /**
+     * Returns memory specifications that match the image.
+     */
+    MemSpecs specs() const;
+
+    /**
+     * Maps a 4 kB page at virtual address \a address.
+     * @param address the page-aligned virtual address
+     * @param kind what the page stands for
+     * @param executable if \c false, the NX bit is set
+     * @param user if \c true, the page and all page tables above it are
+     * accessible from user-land
+     * @return the mapped page
+     */
+    const Page& mapPage(quint64 address, PageKind kind, bool executable,
+                        bool user = false);
+
+    /**
+     * Maps \a count consecutive 4 kB pages, starting at \a address.
+     * \sa mapPage()
+     */
+    void mapPages(quint64 address, int count, PageKind kind, bool executable);
+
+    /**
+     * Maps a 2 MB page at virtual address \a address.
+     * @param address the virtual address, aligned to 2 MB
+     * @param kind what the page stands for
+     * @param executable if \c false, the NX bit is set
+     * @return the mapped page
+     */
+    const Page& mapLargePage(quint64 address, PageKind kind, bool executable);
+
+    /**
+     * Overwrites the content of the page at virtual address \a address at
+     * offset \a offset with \a bytes, as malware would do.
+     */
+    void patch(quint64 address, quint64 offset, const QByteArray& bytes);
+
+    /**
+     * Returns the current content of the page at \a address.
+     */
+    QByteArray content(quint64 address) const;
+
+    /**
+     * Returns all mapped pages in the order they were mapped.
+     */
+    inline const QList<Page>& pages() const { return _pages; }
+
+    /**
+     * Returns the physical memory image.
+     */
+    inline QByteArray& image() { return _image; }
+
+private:
+    quint64 allocFrame(quint64 size, quint64 align);
+    quint64 entry(quint64 table, int index) const;
+    void setEntry(quint64 table, int index, quint64 value);
+    quint64 subTable(quint64 table, int index, bool user);
+    void fill(quint64 physAddress, quint64 size, quint64 seed);
+    const Page* findPage(quint64 address) const;
+
+    QByteArray _image;
+    quint64 _pml4;
+    QList<Page> _pages;
+};
+
+#endif // SYNTHETICDUMP_H
@@ -0,0 +1,495 @@
+#include <QString>
+#include <QtTest>
+#include <QBuffer>
+#include <QMap>
+#include <insight/detect.h>
+#include <insight/kernelsymbols.h>
+#include <insight/moduleindex.h>
+#include <insight/memorymap.h>
+#include <insight/memorymapnode.h>
+#include <insight/funcpointer.h>
+#include <insight/multithreading.h>
+#include <insight/virtualmemory.h>
+#include <insight/pagedigest.h>
+#include "syntheticdump.h"
+
+#define safe_delete(x) \
+    do { if ((x)) { delete (x); (x) = 0; } } while (0)
+
+typedef QMultiHash<quint64, Detect::ExecutablePage> PageHash;
+
+
+/**
+ * Tests the page scan and classification of Detect::hiddenCode() against
+ * synthetic x86_64 dumps with known content. The loaded modules and the vmap
+ * areas are passed to Detect::setSnapshot() instead of being read from the
+ * kernel's lists. Verifying the pages against the kernel and module images
+ * needs the debugging symbols and binaries of a real kernel and is therefore
+ * not covered. The function pointers are verified for nodes of an otherwise
+ * empty memory map.
+ */
+class DetectTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    DetectTest();
+
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void pageTableEntryFlags();
+    void scanExecutablePages();
+    void classifyPages();
+    void digests();
+    void detectModifications();
+    void multiThreadedScan();
+    void unreadableFunctionPointers_data();
+    void unreadableFunctionPointers();
+
+    void benchmarkScan();
+
+private:
+    void buildDump();
+    void openDump();
+    QMap<quint64, quint64> expectedPages() const;
+    void corrupt(quint64 address, quint64 offset, int length);
+    Detect::ScanResult scan();
+
+    SyntheticDump* _dump;
+    QBuffer* _buffer;
+    VirtualMemory* _vmem;
+    KernelSymbols* _symbols;
+    QList<ModuleInfo> _modules;
+    QList<Detect::VmapArea> _vmapAreas;
+};
+
+
+// Detect skips the direct mapping of the physical memory on x86_64
+static const quint64 scanBegin = 0xffffc7ffffffffffULL + 1;
+
+// End of the kernel text and of the executable kernel data
+static const quint64 kernelTextEnd =
+        SyntheticDump::kernelText + 2 * SyntheticDump::largePageSize;
+static const quint64 kernelDataEnd =
+        kernelTextEnd + 64 * SyntheticDump::pageSize;
+
+// Layout of the core region of each module
+static const quint64 moduleCoreSize = 16 * SyntheticDump::pageSize;
+static const quint64 moduleTextSize = 8 * SyntheticDump::pageSize;
+
+
+DetectTest::DetectTest()
+    : _dump(0), _buffer(0), _vmem(0), _symbols(0)
+{
+}
+
+
+void DetectTest::init()
+{
+    buildDump();
+    openDump();
+}
+
+
+void DetectTest::cleanup()
+{
+    safe_delete(_symbols);
+    safe_delete(_vmem);
+    safe_delete(_buffer);
+    safe_delete(_dump);
+    _modules.clear();
+    _vmapAreas.clear();
+}
+
+
+void DetectTest::buildDump()
+{
+    typedef SyntheticDump SD;
+    _dump = new SyntheticDump();
+
+    // Kernel text with a large page, followed by non-executable data
+    _dump->mapPages(SD::kernelText, 256, SD::pkKernelCode, true);
+    _dump->mapLargePage(SD::kernelText + SD::largePageSize, SD::pkKernelCode, true);
+    _dump->mapPages(kernelTextEnd, 64, SD::pkKernelData, false);
+
+    // Three modules with code and data in their core regions. Modules are
+    // allocated from vmap areas.
+    for (int i = 0; i < 3; ++i) {
+        ModuleInfo mod;
+        mod.name = QString("mod%1").arg(i);
+        mod.core = SD::modulesVaddr + i * 0x10000;
+        mod.coreSize = moduleCoreSize;
+        mod.coreTextSize = moduleTextSize;
+        _modules.append(mod);
+        _vmapAreas.append(Detect::VmapArea(mod.core, mod.core + mod.coreSize));
+
+        _dump->mapPages(mod.core, 8, SD::pkModuleCode, true);
+        _dump->mapPages(mod.core + moduleTextSize, 4, SD::pkModuleData, false);
+    }
+
+    // An executable page within the core data of a module has no reference
+    // image, so it is only covered by the vmap area
+    _dump->mapPage(SD::modulesVaddr + 12 * SD::pageSize, SD::pkVmapCode, true);
+
+    // Executable pages in the vmalloc area that do not belong to anything
+    _dump->mapPages(SD::vmallocStart + 0x100000, 2, SD::pkHiddenCode, true);
+
+    // Pages in vmap areas, the last ones are not yet unmapped
+    _dump->mapPages(SD::vmallocStart + 0x200000, 16, SD::pkKernelData, false);
+    _vmapAreas.append(Detect::VmapArea(SD::vmallocStart + 0x200000,
+                                       SD::vmallocStart + 0x210000));
+    _dump->mapPages(SD::vmallocStart + 0x300000, 4, SD::pkVmapCode, true);
+    _vmapAreas.append(Detect::VmapArea(SD::vmallocStart + 0x300000,
+                                       SD::vmallocStart + 0x304000));
+    _dump->mapPages(SD::vmallocStart + 0x400000, 2, SD::pkLazyCode, true);
+    _vmapAreas.append(Detect::VmapArea(SD::vmallocStart + 0x400000,
+                                       SD::vmallocStart + 0x402000, 0x1));
+
+    // The vsyscall page is user-accessible, its neighbor is not although it
+    // shares the page tables
+    _dump->mapPage(SD::vsyscallPage, SD::pkUserCode, true, true);
+    _dump->mapPage(SD::vsyscallPage + SD::pageSize, SD::pkHiddenCode, true);
+
+    // The direct mapping is not scanned
+    _dump->mapPages(SD::pageOffset + 0x1000000, 4, SD::pkKernelCode, true);
+}
+
+
+void DetectTest::openDump()
+{
+    MemSpecs specs = _dump->specs();
+    _buffer = new QBuffer(&_dump->image());
+    _vmem = new VirtualMemory(specs, _buffer, 0);
+    QVERIFY(_vmem->open(QIODevice::ReadOnly));
+
+    // Detect takes the kernel's regions from the System.map
+    specs.systemMap.insert("_text", SystemMapEntry(SyntheticDump::kernelText, 'T'));
+    specs.systemMap.insert("_etext", SystemMapEntry(kernelTextEnd, 'T'));
+    specs.systemMap.insert("__bss_stop", SystemMapEntry(kernelDataEnd, 'B'));
+    specs.systemMap.insert("VDSO64_PRELINK",
+                           SystemMapEntry(SyntheticDump::vsyscallPage, 'A'));
+
+    _symbols = new KernelSymbols();
+    _symbols->setMemSpecs(specs);
+}
+
+
+QMap<quint64, quint64> DetectTest::expectedPages() const
+{
+    QMap<quint64, quint64> ret;
+    for (int i = 0; i < _dump->pages().size(); ++i) {
+        const SyntheticDump::Page& page = _dump->pages().at(i);
+        if (page.scanned() && page.address >= scanBegin)
+            ret.insert(page.address, page.size);
+    }
+    return ret;
+}
+
+
+void DetectTest::corrupt(quint64 address, quint64 offset, int length)
+{
+    // Invert the bytes, so they differ for sure
+    QByteArray bytes = _dump->content(address).mid(offset, length);
+    for (int i = 0; i < bytes.size(); ++i)
+        bytes[i] = ~bytes[i];
+    _dump->patch(address, offset, bytes);
+}
+
+
+/**
+ * Scans the dump with Detect, using the modules and vmap areas of the dump.
+ */
+Detect::ScanResult DetectTest::scan()
+{
+    ModuleIndex modules;
+    modules.build(_modules, _vmem);
+
+    Detect detect(*_symbols);
+    detect.setSnapshot(modules, _vmapAreas);
+
+    Detect::ScanResult res;
+    detect.scanAddressSpace(_vmem, &res);
+    return res;
+}
+
+
+void DetectTest::pageTableEntryFlags()
+{
+    typedef VirtualMemory VM;
+
+    // Upper levels of a 4-level walk that allow user access and writes
+    PageTableEntries e;
+    e.pgd = 0x1000 | VM::Present | VM::ReadWrite | VM::Supervisor;
+    e.pud = 0x2000 | VM::Present | VM::ReadWrite | VM::Supervisor;
+    e.pmd = 0x3000 | VM::Present | VM::ReadWrite | VM::Supervisor;
+
+    // The flags of the pte decide for a read-only supervisor page
+    e.pte = 0x4000 | VM::Present;
+    QVERIFY(e.isPresent());
+    QVERIFY(e.isSupervisor());
+    QVERIFY(!e.isWriteable());
+
+    // ... and for a writeable user page
+    e.pte = 0x4000 | VM::Present | VM::ReadWrite | VM::Supervisor;
+    QVERIFY(!e.isSupervisor());
+    QVERIFY(e.isWriteable());
+
+    // Any level can deny writes
+    e.pmd &= ~(quint64)VM::ReadWrite;
+    QVERIFY(!e.isWriteable());
+}
+
+
+void DetectTest::scanExecutablePages()
+{
+    Detect::ScanResult res = scan();
+    QVERIFY(!res.readError);
+
+    // Every executable supervisor page is either classified or hidden
+    QMap<quint64, quint64> sizes;
+    for (PageHash::const_iterator it = res.hashes.constBegin();
+         it != res.hashes.constEnd(); ++it)
+        sizes.insert(it.key(), it.value().size);
+    QMap<quint64, Detect::HiddenPage>::const_iterator hit;
+    for (hit = res.hiddenPages.constBegin(); hit != res.hiddenPages.constEnd();
+         ++hit)
+    {
+        QVERIFY(!sizes.contains(hit.key()));
+        sizes.insert(hit.key(), hit.value().size);
+    }
+
+    QCOMPARE(sizes, expectedPages());
+    QCOMPARE(res.executeable_pages, (quint64)sizes.size());
+
+    // Kernel data, module data and vmalloc data
+    QCOMPARE(res.nonexecutable_pages, (quint64)(64 + 3 * 4 + 16));
+    // The vsyscall page
+    QCOMPARE(res.nonsupervisor_pages, (quint64)1);
+    QVERIFY(sizes.contains(SyntheticDump::vsyscallPage + SyntheticDump::pageSize));
+    QVERIFY(!sizes.contains(SyntheticDump::vsyscallPage));
+}
+
+
+void DetectTest::classifyPages()
+{
+    typedef SyntheticDump SD;
+    Detect::ScanResult res = scan();
+    QVERIFY(!res.readError);
+
+    QCOMPARE(res.hidden_pages, (quint64)3);
+    QCOMPARE(res.vmap_pages, (quint64)5);
+    QCOMPARE(res.lazy_pages, (quint64)2);
+    QCOMPARE((quint64)res.hiddenPages.size(), res.hidden_pages);
+
+    int hidden = 0;
+    for (int i = 0; i < _dump->pages().size(); ++i) {
+        const SD::Page& page = _dump->pages().at(i);
+        if (!page.scanned() || page.address < scanBegin)
+            continue;
+
+        if (page.kind == SD::pkHiddenCode) {
+            QVERIFY(res.hiddenPages.contains(page.address));
+            QVERIFY(!res.hashes.contains(page.address));
+            QVERIFY(res.hiddenPages[page.address].ptEntries.isSupervisor());
+            ++hidden;
+            continue;
+        }
+
+        QVERIFY(!res.hiddenPages.contains(page.address));
+        QCOMPARE(res.hashes.count(page.address), 1);
+        const Detect::ExecutablePage& ep = res.hashes.value(page.address);
+
+        switch (page.kind) {
+        case SD::pkKernelCode:
+            QCOMPARE((int)ep.type, (int)Detect::KERNEL_CODE);
+            break;
+        case SD::pkModuleCode:
+            QCOMPARE((int)ep.type, (int)Detect::MODULE);
+            QCOMPARE(ep.module, QString("mod%1").arg(
+                         (page.address - SD::modulesVaddr) / 0x10000));
+            break;
+        case SD::pkVmapCode:
+            QCOMPARE((int)ep.type, (int)Detect::VMAP);
+            break;
+        case SD::pkLazyCode:
+            QCOMPARE((int)ep.type, (int)Detect::VMAP_LAZY);
+            break;
+        default:
+            QFAIL(qPrintable(QString("Unexpected page @ 0x%1")
+                             .arg(page.address, 0, 16)));
+        }
+        QCOMPARE(ep.physAddress, page.physAddress);
+    }
+    QCOMPARE(hidden, res.hiddenPages.size());
+}
+
+
+void DetectTest::digests()
+{
+    Detect::ScanResult res = scan();
+
+    QVERIFY(!res.hashes.isEmpty());
+    for (PageHash::const_iterator it = res.hashes.constBegin();
+         it != res.hashes.constEnd(); ++it)
+    {
+        QCOMPARE(it.value().hash, PageDigest::hash(_dump->content(it.key())));
+    }
+}
+
+
+void DetectTest::detectModifications()
+{
+    typedef SyntheticDump SD;
+    PageHash before = scan().hashes;
+
+    // Known modifications: an inline hook in the kernel text, a patched
+    // jump in a module and the last byte of the large page
+    QMap<quint64, quint64> modified;
+    modified.insert(SD::kernelText + 10 * SD::pageSize, 0x123);
+    modified.insert(SD::modulesVaddr + 0x10000 + 3 * SD::pageSize, 0xff0);
+    modified.insert(SD::kernelText + SD::largePageSize, SD::largePageSize - 1);
+
+    QMap<quint64, QByteArray> original;
+    QMap<quint64, quint64>::const_iterator mod;
+    for (mod = modified.constBegin(); mod != modified.constEnd(); ++mod) {
+        original.insert(mod.key(), _dump->content(mod.key()));
+        corrupt(mod.key(), mod.value(), mod.value() == 0xff0 ? 5 : 1);
+    }
+
+    PageHash after = scan().hashes;
+    QList<quint64> keysBefore = before.keys(), keysAfter = after.keys();
+    qSort(keysBefore);
+    qSort(keysAfter);
+    QCOMPARE(keysAfter, keysBefore);
+
+    QList<quint64> changed;
+    for (PageHash::const_iterator it = after.constBegin();
+         it != after.constEnd(); ++it)
+    {
+        if (it.value().hash != before.value(it.key()).hash)
+            changed.append(it.key());
+    }
+    qSort(changed);
+    QCOMPARE(changed, modified.keys());
+
+    // The first difference is where the page was modified
+    for (mod = modified.constBegin(); mod != modified.constEnd(); ++mod) {
+        const QByteArray& a = original[mod.key()];
+        const QByteArray b = _dump->content(mod.key());
+        QCOMPARE((quint64)PageDigest::firstDifference(a.constData(), b.constData(),
+                                                      0, a.size()),
+                 mod.value());
+    }
+}
+
+
+void DetectTest::multiThreadedScan()
+{
+    // The scanner threads read with thread-safety enabled and merge their
+    // results, which must not change them
+    const int maxThreads = MultiThreading::maxThreads();
+    MultiThreading::setMaxThreads(1);
+    Detect::ScanResult single = scan();
+    MultiThreading::setMaxThreads(8);
+    Detect::ScanResult parallel = scan();
+    MultiThreading::setMaxThreads(maxThreads);
+
+    QCOMPARE(parallel.executeable_pages, single.executeable_pages);
+    QCOMPARE(parallel.nonexecutable_pages, single.nonexecutable_pages);
+    QCOMPARE(parallel.nonsupervisor_pages, single.nonsupervisor_pages);
+    QCOMPARE(parallel.hidden_pages, single.hidden_pages);
+    QCOMPARE(parallel.vmap_pages, single.vmap_pages);
+    QCOMPARE(parallel.lazy_pages, single.lazy_pages);
+    QCOMPARE(parallel.hiddenPages.keys(), single.hiddenPages.keys());
+
+    QCOMPARE(parallel.hashes.size(), single.hashes.size());
+    for (PageHash::const_iterator it = single.hashes.constBegin();
+         it != single.hashes.constEnd(); ++it)
+    {
+        QVERIFY(parallel.hashes.contains(it.key()));
+        QCOMPARE(parallel.hashes.value(it.key()).hash, it.value().hash);
+        QCOMPARE((int)parallel.hashes.value(it.key()).type, (int)it.value().type);
+    }
+}
+
+
+void DetectTest::unreadableFunctionPointers_data()
+{
+    QTest::addColumn<int>("threads");
+
+    QTest::newRow("single") << 1;
+    QTest::newRow("parallel") << 4;
+}
+
+
+void DetectTest::unreadableFunctionPointers()
+{
+    typedef SyntheticDump SD;
+    QFETCH(int, threads);
+
+    // Six null pointers in the kernel data, followed by two pointers in the
+    // vmalloc area that is not mapped
+    const int readable = 6, unreadable = 2;
+    _dump->patch(kernelTextEnd, 0, QByteArray(readable * 8, 0));
+
+    ModuleIndex modules;
+    modules.build(_modules, _vmem);
+    Detect detect(*_symbols);
+    detect.setSnapshot(modules, _vmapAreas);
+
+    MemoryMap map(_symbols, _vmem);
+    FuncPointer type(_symbols);
+    QList<MemoryMapNode*> nodes;
+    QList<FuncPointersInNode> funcPointers;
+    for (int i = 0; i < readable + unreadable; ++i) {
+        quint64 addr = (i < readable) ?
+                    kernelTextEnd + i * 8 :
+                    SD::vmallocStart + 0x800000 + i * 8;
+        nodes.append(new MemoryMapNode(&map, QString("fp%1").arg(i), addr,
+                                       &type, -1));
+        funcPointers.append(FuncPointersInNode(nodes.last(), 0));
+    }
+
+    // Read errors must not escape the threads
+    const int maxThreads = MultiThreading::maxThreads();
+    MultiThreading::setMaxThreads(threads);
+    Detect::FunctionPointerStats stats =
+            detect.checkFunctionPointers(&map, funcPointers);
+    MultiThreading::setMaxThreads(maxThreads);
+    qDeleteAll(nodes);
+
+    QCOMPARE(stats.total, (quint64)(readable + unreadable));
+    QCOMPARE(stats.defaultValue, (quint64)readable);
+    QCOMPARE(stats.unreadable, (quint64)unreadable);
+}
+
+
+void DetectTest::benchmarkScan()
+{
+    // Replace the default dump by one with 64 MB of kernel text
+    cleanup();
+    _dump = new SyntheticDump();
+    _dump->mapPages(SyntheticDump::kernelText, 16384,
+                    SyntheticDump::pkKernelCode, true);
+    openDump();
+
+    Detect::ScanResult res;
+
+    QTime timer;
+    timer.start();
+    res = scan();
+    int ms = qMax(timer.elapsed(), 1);
+    QCOMPARE(res.executeable_pages, (quint64)16384);
+    qDebug("Scanned %llu executable pages in %d ms (%.0f pages/s)",
+           res.executeable_pages, ms, res.executeable_pages * 1000.0 / ms);
+
+    QBENCHMARK {
+        res = scan();
+    }
+}
+
+QTEST_MAIN(DetectTest)
+
+#include "tst_detecttest.moc"
@@ -0,0 +1,159 @@
+#include <QString>
+#include <QtTest>
+#include <QBuffer>
+#include <QScriptEngine>
+#include <insight/memspecs.h>
+#include <insight/kernelsymbols.h>
+#include <insight/numeric.h>
+#include <insight/virtualmemory.h>
+#include <insight/instance.h>
+#include <insight/instanceclass.h>
+#include <string.h>
+
+#define safe_delete(x) \
+    do { if ((x)) { delete (x); (x) = 0; } } while (0)
+
+// The memory image is accessed through the direct mapping
+static const quint64 pageOffset = 0xffff880000000000ULL;
+static const int imageSize = 0x1000;
+
+
+/**
+ * Tests the bulk accessors of InstancePrototype as they are called from
+ * scripts, on a memory image with known content.
+ */
+class InstancePrototypeTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    InstancePrototypeTest();
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void readUInt32Array();
+    void readUInt64Array();
+    void readUnmapped_data();
+    void readUnmapped();
+
+private:
+    QScriptValue eval(quint64 address, const QString& code);
+
+    KernelSymbols* _symbols;
+    UInt32* _type;
+    QByteArray _image;
+    QBuffer* _buffer;
+    VirtualMemory* _vmem;
+    QScriptEngine* _engine;
+    InstanceClass* _instClass;
+};
+
+
+InstancePrototypeTest::InstancePrototypeTest()
+    : _symbols(0), _type(0), _buffer(0), _vmem(0), _engine(0), _instClass(0)
+{
+}
+
+
+void InstancePrototypeTest::initTestCase()
+{
+    MemSpecs specs;
+    specs.arch = MemSpecs::ar_x86_64;
+    specs.sizeofPointer = 8;
+    specs.sizeofLong = 8;
+    specs.pageOffset = pageOffset;
+    specs.vmallocStart = 0xffffc90000000000ULL;
+    specs.vmallocEnd = 0xffffe8ffffffffffULL;
+    specs.startKernelMap = 0xffffffff80000000ULL;
+    specs.modulesVaddr = 0xffffffffa0000000ULL;
+    specs.modulesEnd = 0xffffffffff000000ULL;
+
+    _symbols = new KernelSymbols();
+    _symbols->setMemSpecs(specs);
+    _type = new UInt32(_symbols);
+
+    // The image holds the numbers 0, 1, 2, ... as 32-bit values
+    _image.resize(imageSize);
+    for (int i = 0; i < imageSize / 4; ++i) {
+        quint32 value = i;
+        memcpy(_image.data() + i * 4, &value, sizeof(value));
+    }
+    _buffer = new QBuffer(&_image);
+    _vmem = new VirtualMemory(specs, _buffer, 0);
+    QVERIFY(_vmem->open(QIODevice::ReadOnly));
+
+    _engine = new QScriptEngine();
+    _instClass = new InstanceClass(_symbols, _engine, ksNone);
+}
+
+
+void InstancePrototypeTest::cleanupTestCase()
+{
+    safe_delete(_engine);
+    safe_delete(_instClass);
+    safe_delete(_vmem);
+    safe_delete(_buffer);
+    safe_delete(_type);
+    safe_delete(_symbols);
+}
+
+
+QScriptValue InstancePrototypeTest::eval(quint64 address, const QString &code)
+{
+    Instance inst(address, _type, _vmem);
+    _engine->globalObject().setProperty("inst", _instClass->newInstance(inst));
+    return _engine->evaluate(code);
+}
+
+
+void InstancePrototypeTest::readUInt32Array()
+{
+    QScriptValue ret = eval(pageOffset + 0x10, "inst.ReadUInt32Array(4)");
+    QVERIFY(!_engine->hasUncaughtException());
+    QVERIFY(ret.isArray());
+    QCOMPARE(ret.property("length").toInt32(), 4);
+    for (int i = 0; i < 4; ++i)
+        QCOMPARE(ret.property(i).toUInt32(), (quint32)(4 + i));
+}
+
+
+void InstancePrototypeTest::readUInt64Array()
+{
+    QScriptValue ret = eval(pageOffset + 0x10, "inst.ReadUInt64Array(2)");
+    QVERIFY(!_engine->hasUncaughtException());
+    QVERIFY(ret.isArray());
+    QCOMPARE(ret.property("length").toInt32(), 2);
+}
+
+
+void InstancePrototypeTest::readUnmapped_data()
+{
+    QTest::addColumn<QString>("code");
+
+    QTest::newRow("uint32") << "inst.ReadUInt32Array(4)";
+    QTest::newRow("uint64") << "inst.ReadUInt64Array(4)";
+}
+
+
+void InstancePrototypeTest::readUnmapped()
+{
+    QFETCH(QString, code);
+
+    // Reading beyond the end of the image must raise a script error instead
+    // of an exception that escapes the script engine
+    QScriptValue ret = eval(pageOffset + 0x100000, code);
+    QVERIFY(_engine->hasUncaughtException());
+    QVERIFY(ret.isError());
+    _engine->clearExceptions();
+
+    // The engine remains usable afterwards
+    ret = eval(pageOffset, "inst.ReadUInt32Array(1)[0]");
+    QVERIFY(!_engine->hasUncaughtException());
+    QCOMPARE(ret.toUInt32(), 0U);
+}
+
+QTEST_MAIN(InstancePrototypeTest)
+
+#include "tst_instanceprototypetest.moc"
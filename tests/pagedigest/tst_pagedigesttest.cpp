@@ -0,0 +1,159 @@
+#include <QString>
+#include <QtTest>
+#include <QCryptographicHash>
+#include <insight/pagedigest.h>
+
+#define PAGE_SIZE 4096
+
+class PageDigestTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    PageDigestTest();
+
+private Q_SLOTS:
+    void xxHash64_data();
+    void xxHash64();
+    void incremental();
+    void sha1();
+    void defaultAlgorithm();
+    void firstDifference();
+
+    void benchmarkXxHash64();
+    void benchmarkSha1();
+    void benchmarkFirstDifference();
+
+private:
+    QByteArray _page;
+    QByteArray _bigBuf;
+};
+
+
+PageDigestTest::PageDigestTest()
+{
+    _page.resize(PAGE_SIZE + 13);
+    for (int i = 0; i < _page.size(); ++i)
+        _page[i] = (char)(i * 7 + 3);
+
+    // 64 MB of data for the throughput benchmarks
+    _bigBuf.fill(0x5a, 64 << 20);
+}
+
+
+void PageDigestTest::xxHash64_data()
+{
+    QTest::addColumn<QByteArray>("data");
+    QTest::addColumn<QString>("digest");
+
+    // Reference values of the canonical XXH64 implementation, seed 0
+    QTest::newRow("empty") << QByteArray() << "ef46db3751d8e999";
+    QTest::newRow("abc") << QByteArray("abc") << "44bc2cf5ad770999";
+    QTest::newRow("page") << _page << "28ef467bb8225886";
+}
+
+
+void PageDigestTest::xxHash64()
+{
+    QFETCH(QByteArray, data);
+    QFETCH(QString, digest);
+
+    QByteArray result = PageDigest::hash(data, PageDigest::daXxHash64);
+    QCOMPARE(result.size(), PageDigest::digestSize(PageDigest::daXxHash64));
+    QCOMPARE(QString(result.toHex()), digest);
+}
+
+
+void PageDigestTest::incremental()
+{
+    const QByteArray expected = PageDigest::hash(_page, PageDigest::daXxHash64);
+
+    // Feed the data in chunks that do not align with the 32 byte stripes
+    for (int chunk = 1; chunk <= 67; chunk += 11) {
+        PageDigest d(PageDigest::daXxHash64);
+        for (int i = 0; i < _page.size(); i += chunk)
+            d.addData(_page.constData() + i, qMin(chunk, _page.size() - i));
+        QCOMPARE(d.result(), expected);
+
+        d.reset();
+        d.addData(_page);
+        QCOMPARE(d.result(), expected);
+    }
+}
+
+
+void PageDigestTest::sha1()
+{
+    QByteArray result = PageDigest::hash(_page, PageDigest::daSha1);
+    QCOMPARE(result.size(), PageDigest::digestSize(PageDigest::daSha1));
+    QCOMPARE(result, QCryptographicHash::hash(_page, QCryptographicHash::Sha1));
+}
+
+
+void PageDigestTest::defaultAlgorithm()
+{
+    // The integrity checks rely on a digest that cannot be forged
+    QCOMPARE((int)PageDigest::defaultAlgorithm(), (int)PageDigest::daSha1);
+    PageDigest d;
+    QCOMPARE((int)d.algorithm(), (int)PageDigest::daSha1);
+    QCOMPARE(PageDigest::hash(_page), PageDigest::hash(_page, PageDigest::daSha1));
+}
+
+
+void PageDigestTest::firstDifference()
+{
+    QByteArray other(_page);
+    const int size = _page.size();
+
+    QCOMPARE(PageDigest::firstDifference(_page.constData(), other.constData(),
+                                         0, size), size);
+
+    for (int pos = 0; pos < size; pos += 509) {
+        other = _page;
+        other[pos] = ~other[pos];
+        QCOMPARE(PageDigest::firstDifference(_page.constData(),
+                                             other.constData(), 0, size), pos);
+        QCOMPARE(PageDigest::firstDifference(_page.constData(),
+                                             other.constData(), pos + 1, size),
+                 size);
+    }
+}
+
+
+// Every benchmark iteration processes 64 MB on one core, so the throughput
+// in GB/s is 62.5 divided by the reported msecs per iteration.
+void PageDigestTest::benchmarkXxHash64()
+{
+    QBENCHMARK {
+        PageDigest d(PageDigest::daXxHash64);
+        for (int i = 0; i < _bigBuf.size(); i += PAGE_SIZE)
+            d.addData(_bigBuf.constData() + i, PAGE_SIZE);
+        d.result();
+    }
+}
+
+
+void PageDigestTest::benchmarkSha1()
+{
+    QBENCHMARK {
+        PageDigest d(PageDigest::daSha1);
+        for (int i = 0; i < _bigBuf.size(); i += PAGE_SIZE)
+            d.addData(_bigBuf.constData() + i, PAGE_SIZE);
+        d.result();
+    }
+}
+
+
+void PageDigestTest::benchmarkFirstDifference()
+{
+    QByteArray other(_bigBuf);
+    other[other.size() - 1] = 0;
+    QBENCHMARK {
+        PageDigest::firstDifference(_bigBuf.constData(), other.constData(), 0,
+                                    _bigBuf.size());
+    }
+}
+
+QTEST_MAIN(PageDigestTest)
+
+#include "tst_pagedigesttest.moc"
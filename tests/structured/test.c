@@ -0,0 +1,43 @@
+struct list_head {
+	struct list_head *next, *prev;
+};
+
+struct sched_entity {
+	unsigned long load;
+	struct list_head group_node;
+	unsigned int on_rq;
+};
+
+struct signal_struct {
+	int nr_threads;
+	struct list_head thread_head;
+};
+
+struct task_struct {
+	long state;
+	void *stack;
+	struct sched_entity se;
+	union {
+		unsigned long flags;
+		struct {
+			int prio;
+			int static_prio;
+			union {
+				struct list_head tasks;
+				struct {
+					int pid;
+					int tgid;
+				};
+			};
+		};
+	};
+	struct signal_struct *signal;
+	char comm[16];
+};
+
+struct task_struct init_task;
+
+int main(int argc, char** argv)
+{
+	return init_task.pid;
+}
@@ -0,0 +1,476 @@
+#include <QString>
+#include <QtTest>
+#include <insight/memspecs.h>
+#include <insight/symfactory.h>
+#include <insight/kernelsymbolparser.h>
+#include <insight/variable.h>
+#include <insight/structured.h>
+#include <insight/kernelsymbols.h>
+
+#define safe_delete(x) \
+    do { if ((x)) { delete (x); (x) = 0; } } while (0)
+
+// Created with the following command:
+// gcc -gdwarf-2 -gstrict-dwarf -o test test.c && objdump -W test | grep '^\s*<' | grep -v 'DW_AT_decl_column\|Abbrev Number: 0$' | sed 's/^.*$/"\0\\n"/'
+const char* objdump =
+        " <0><b>: Abbrev Number: 1 (DW_TAG_compile_unit)\n"
+        "    <c>   DW_AT_producer    : (indirect string, offset: 0x12): GNU C17 12.2.0 -mtune=generic -march=x86-64 -gdwarf-2 -gstrict-dwarf -O0 -fasynchronous-unwind-tables\n"
+        "    <10>   DW_AT_language    : 1 (ANSI C)\n"
+        "    <11>   DW_AT_name        : (indirect string, offset: 0xf1): test.c\n"
+        "    <15>   DW_AT_comp_dir    : (indirect string, offset: 0x89): /tmp/insight-vmi/tests/structured\n"
+        "    <19>   DW_AT_low_pc      : 0x1129\n"
+        "    <21>   DW_AT_high_pc     : 0x113c\n"
+        "    <29>   DW_AT_stmt_list   : 0\n"
+        " <1><2d>: Abbrev Number: 2 (DW_TAG_structure_type)\n"
+        "    <2e>   DW_AT_name        : (indirect string, offset: 0x13a): list_head\n"
+        "    <32>   DW_AT_byte_size   : 16\n"
+        "    <33>   DW_AT_decl_file   : 1\n"
+        "    <34>   DW_AT_decl_line   : 1\n"
+        "    <36>   DW_AT_sibling     : <0x59>\n"
+        " <2><3a>: Abbrev Number: 3 (DW_TAG_member)\n"
+        "    <3b>   DW_AT_name        : (indirect string, offset: 0x15a): next\n"
+        "    <3f>   DW_AT_decl_file   : 1\n"
+        "    <40>   DW_AT_decl_line   : 2\n"
+        "    <42>   DW_AT_type        : <0x59>\n"
+        "    <46>   DW_AT_data_member_location: 2 byte block: 23 0  (DW_OP_plus_uconst: 0)\n"
+        " <2><49>: Abbrev Number: 3 (DW_TAG_member)\n"
+        "    <4a>   DW_AT_name        : (indirect string, offset: 0x144): prev\n"
+        "    <4e>   DW_AT_decl_file   : 1\n"
+        "    <4f>   DW_AT_decl_line   : 2\n"
+        "    <51>   DW_AT_type        : <0x59>\n"
+        "    <55>   DW_AT_data_member_location: 2 byte block: 23 8  (DW_OP_plus_uconst: 8)\n"
+        " <1><59>: Abbrev Number: 4 (DW_TAG_pointer_type)\n"
+        "    <5a>   DW_AT_byte_size   : 8\n"
+        "    <5b>   DW_AT_type        : <0x2d>\n"
+        " <1><5f>: Abbrev Number: 2 (DW_TAG_structure_type)\n"
+        "    <60>   DW_AT_name        : (indirect string, offset: 0xe4): sched_entity\n"
+        "    <64>   DW_AT_byte_size   : 32\n"
+        "    <65>   DW_AT_decl_file   : 1\n"
+        "    <66>   DW_AT_decl_line   : 5\n"
+        "    <68>   DW_AT_sibling     : <0x9a>\n"
+        " <2><6c>: Abbrev Number: 3 (DW_TAG_member)\n"
+        "    <6d>   DW_AT_name        : (indirect string, offset: 0xa5): load\n"
+        "    <71>   DW_AT_decl_file   : 1\n"
+        "    <72>   DW_AT_decl_line   : 6\n"
+        "    <74>   DW_AT_type        : <0x9a>\n"
+        "    <78>   DW_AT_data_member_location: 2 byte block: 23 0  (DW_OP_plus_uconst: 0)\n"
+        " <2><7b>: Abbrev Number: 3 (DW_TAG_member)\n"
+        "    <7c>   DW_AT_name        : (indirect string, offset: 0x78): group_node\n"
+        "    <80>   DW_AT_decl_file   : 1\n"
+        "    <81>   DW_AT_decl_line   : 7\n"
+        "    <83>   DW_AT_type        : <0x2d>\n"
+        "    <87>   DW_AT_data_member_location: 2 byte block: 23 8  (DW_OP_plus_uconst: 8)\n"
+        " <2><8a>: Abbrev Number: 3 (DW_TAG_member)\n"
+        "    <8b>   DW_AT_name        : (indirect string, offset: 0xaa): on_rq\n"
+        "    <8f>   DW_AT_decl_file   : 1\n"
+        "    <90>   DW_AT_decl_line   : 8\n"
+        "    <92>   DW_AT_type        : <0xa1>\n"
+        "    <96>   DW_AT_data_member_location: 2 byte block: 23 18  (DW_OP_plus_uconst: 24)\n"
+        " <1><9a>: Abbrev Number: 5 (DW_TAG_base_type)\n"
+        "    <9b>   DW_AT_byte_size   : 8\n"
+        "    <9c>   DW_AT_encoding    : 7 (unsigned)\n"
+        "    <9d>   DW_AT_name        : (indirect string, offset: 0x101): long unsigned int\n"
+        " <1><a1>: Abbrev Number: 5 (DW_TAG_base_type)\n"
+        "    <a2>   DW_AT_byte_size   : 4\n"
+        "    <a3>   DW_AT_encoding    : 7 (unsigned)\n"
+        "    <a4>   DW_AT_name        : (indirect string, offset: 0x106): unsigned int\n"
+        " <1><a8>: Abbrev Number: 2 (DW_TAG_structure_type)\n"
+        "    <a9>   DW_AT_name        : (indirect string, offset: 0xd6): signal_struct\n"
+        "    <ad>   DW_AT_byte_size   : 24\n"
+        "    <ae>   DW_AT_decl_file   : 1\n"
+        "    <af>   DW_AT_decl_line   : 11\n"
+        "    <b1>   DW_AT_sibling     : <0xd4>\n"
+        " <2><b5>: Abbrev Number: 3 (DW_TAG_member)\n"
+        "    <b6>   DW_AT_name        : (indirect string, offset: 0x124): nr_threads\n"
+        "    <ba>   DW_AT_decl_file   : 1\n"
+        "    <bb>   DW_AT_decl_line   : 12\n"
+        "    <bd>   DW_AT_type        : <0xd4>\n"
+        "    <c1>   DW_AT_data_member_location: 2 byte block: 23 0  (DW_OP_plus_uconst: 0)\n"
+        " <2><c4>: Abbrev Number: 3 (DW_TAG_member)\n"
+        "    <c5>   DW_AT_name        : (indirect string, offset: 0x113): thread_head\n"
+        "    <c9>   DW_AT_decl_file   : 1\n"
+        "    <ca>   DW_AT_decl_line   : 13\n"
+        "    <cc>   DW_AT_type        : <0x2d>\n"
+        "    <d0>   DW_AT_data_member_location: 2 byte block: 23 8  (DW_OP_plus_uconst: 8)\n"
+        " <1><d4>: Abbrev Number: 6 (DW_TAG_base_type)\n"
+        "    <d5>   DW_AT_byte_size   : 4\n"
+        "    <d6>   DW_AT_encoding    : 5 (signed)\n"
+        "    <d7>   DW_AT_name        : int\n"
+        " <1><db>: Abbrev Number: 7 (DW_TAG_structure_type)\n"
+        "    <dc>   DW_AT_byte_size   : 8\n"
+        "    <dd>   DW_AT_decl_file   : 1\n"
+        "    <de>   DW_AT_decl_line   : 27\n"
+        "    <e0>   DW_AT_sibling     : <0x103>\n"
+        " <2><e4>: Abbrev Number: 8 (DW_TAG_member)\n"
+        "    <e5>   DW_AT_name        : pid\n"
+        "    <e9>   DW_AT_decl_file   : 1\n"
+        "    <ea>   DW_AT_decl_line   : 28\n"
+        "    <ec>   DW_AT_type        : <0xd4>\n"
+        "    <f0>   DW_AT_data_member_location: 2 byte block: 23 0  (DW_OP_plus_uconst: 0)\n"
+        " <2><f3>: Abbrev Number: 3 (DW_TAG_member)\n"
+        "    <f4>   DW_AT_name        : (indirect string, offset: 0x12f): tgid\n"
+        "    <f8>   DW_AT_decl_file   : 1\n"
+        "    <f9>   DW_AT_decl_line   : 29\n"
+        "    <fb>   DW_AT_type        : <0xd4>\n"
+        "    <ff>   DW_AT_data_member_location: 2 byte block: 23 4  (DW_OP_plus_uconst: 4)\n"
+        " <1><103>: Abbrev Number: 9 (DW_TAG_union_type)\n"
+        "    <104>   DW_AT_byte_size   : 16\n"
+        "    <105>   DW_AT_decl_file   : 1\n"
+        "    <106>   DW_AT_decl_line   : 25\n"
+        "    <108>   DW_AT_sibling     : <0x11e>\n"
+        " <2><10c>: Abbrev Number: 10 (DW_TAG_member)\n"
+        "    <10d>   DW_AT_name        : (indirect string, offset: 0xb0): tasks\n"
+        "    <111>   DW_AT_decl_file   : 1\n"
+        "    <112>   DW_AT_decl_line   : 26\n"
+        "    <114>   DW_AT_type        : <0x2d>\n"
+        " <2><118>: Abbrev Number: 11 (DW_TAG_member)\n"
+        "    <119>   DW_AT_type        : <0xdb>\n"
+        " <1><11e>: Abbrev Number: 7 (DW_TAG_structure_type)\n"
+        "    <11f>   DW_AT_byte_size   : 24\n"
+        "    <120>   DW_AT_decl_file   : 1\n"
+        "    <121>   DW_AT_decl_line   : 22\n"
+        "    <123>   DW_AT_sibling     : <0x14e>\n"
+        " <2><127>: Abbrev Number: 3 (DW_TAG_member)\n"
+        "    <128>   DW_AT_name        : (indirect string, offset: 0xbd): prio\n"
+        "    <12c>   DW_AT_decl_file   : 1\n"
+        "    <12d>   DW_AT_decl_line   : 23\n"
+        "    <12f>   DW_AT_type        : <0xd4>\n"
+        "    <133>   DW_AT_data_member_location: 2 byte block: 23 0  (DW_OP_plus_uconst: 0)\n"
+        " <2><136>: Abbrev Number: 3 (DW_TAG_member)\n"
+        "    <137>   DW_AT_name        : (indirect string, offset: 0xb6): static_prio\n"
+        "    <13b>   DW_AT_decl_file   : 1\n"
+        "    <13c>   DW_AT_decl_line   : 24\n"
+        "    <13e>   DW_AT_type        : <0xd4>\n"
+        "    <142>   DW_AT_data_member_location: 2 byte block: 23 4  (DW_OP_plus_uconst: 4)\n"
+        " <2><145>: Abbrev Number: 12 (DW_TAG_member)\n"
+        "    <146>   DW_AT_type        : <0x103>\n"
+        "    <14a>   DW_AT_data_member_location: 2 byte block: 23 8  (DW_OP_plus_uconst: 8)\n"
+        " <1><14e>: Abbrev Number: 9 (DW_TAG_union_type)\n"
+        "    <14f>   DW_AT_byte_size   : 24\n"
+        "    <150>   DW_AT_decl_file   : 1\n"
+        "    <151>   DW_AT_decl_line   : 20\n"
+        "    <153>   DW_AT_sibling     : <0x169>\n"
+        " <2><157>: Abbrev Number: 10 (DW_TAG_member)\n"
+        "    <158>   DW_AT_name        : (indirect string, offset: 0x5): flags\n"
+        "    <15c>   DW_AT_decl_file   : 1\n"
+        "    <15d>   DW_AT_decl_line   : 21\n"
+        "    <15f>   DW_AT_type        : <0x9a>\n"
+        " <2><163>: Abbrev Number: 11 (DW_TAG_member)\n"
+        "    <164>   DW_AT_type        : <0x11e>\n"
+        " <1><169>: Abbrev Number: 2 (DW_TAG_structure_type)\n"
+        "    <16a>   DW_AT_name        : (indirect string, offset: 0x149): task_struct\n"
+        "    <16e>   DW_AT_byte_size   : 96\n"
+        "    <16f>   DW_AT_decl_file   : 1\n"
+        "    <170>   DW_AT_decl_line   : 16\n"
+        "    <172>   DW_AT_sibling     : <0x1c9>\n"
+        " <2><176>: Abbrev Number: 3 (DW_TAG_member)\n"
+        "    <177>   DW_AT_name        : (indirect string, offset: 0x134): state\n"
+        "    <17b>   DW_AT_decl_file   : 1\n"
+        "    <17c>   DW_AT_decl_line   : 17\n"
+        "    <17e>   DW_AT_type        : <0x1c9>\n"
+        "    <182>   DW_AT_data_member_location: 2 byte block: 23 0  (DW_OP_plus_uconst: 0)\n"
+        " <2><185>: Abbrev Number: 3 (DW_TAG_member)\n"
+        "    <186>   DW_AT_name        : (indirect string, offset: 0x83): stack\n"
+        "    <18a>   DW_AT_decl_file   : 1\n"
+        "    <18b>   DW_AT_decl_line   : 18\n"
+        "    <18d>   DW_AT_type        : <0x1d0>\n"
+        "    <191>   DW_AT_data_member_location: 2 byte block: 23 8  (DW_OP_plus_uconst: 8)\n"
+        " <2><194>: Abbrev Number: 8 (DW_TAG_member)\n"
+        "    <195>   DW_AT_name        : se\n"
+        "    <198>   DW_AT_decl_file   : 1\n"
+        "    <199>   DW_AT_decl_line   : 19\n"
+        "    <19b>   DW_AT_type        : <0x5f>\n"
+        "    <19f>   DW_AT_data_member_location: 2 byte block: 23 10  (DW_OP_plus_uconst: 16)\n"
+        " <2><1a2>: Abbrev Number: 12 (DW_TAG_member)\n"
+        "    <1a3>   DW_AT_type        : <0x14e>\n"
+        "    <1a7>   DW_AT_data_member_location: 2 byte block: 23 30  (DW_OP_plus_uconst: 48)\n"
+        " <2><1aa>: Abbrev Number: 3 (DW_TAG_member)\n"
+        "    <1ab>   DW_AT_name        : (indirect string, offset: 0xb): signal\n"
+        "    <1af>   DW_AT_decl_file   : 1\n"
+        "    <1b0>   DW_AT_decl_line   : 34\n"
+        "    <1b2>   DW_AT_type        : <0x1d2>\n"
+        "    <1b6>   DW_AT_data_member_location: 2 byte block: 23 48  (DW_OP_plus_uconst: 72)\n"
+        " <2><1b9>: Abbrev Number: 3 (DW_TAG_member)\n"
+        "    <1ba>   DW_AT_name        : (indirect string, offset: 0): comm\n"
+        "    <1be>   DW_AT_decl_file   : 1\n"
+        "    <1bf>   DW_AT_decl_line   : 35\n"
+        "    <1c1>   DW_AT_type        : <0x1d8>\n"
+        "    <1c5>   DW_AT_data_member_location: 2 byte block: 23 50  (DW_OP_plus_uconst: 80)\n"
+        " <1><1c9>: Abbrev Number: 5 (DW_TAG_base_type)\n"
+        "    <1ca>   DW_AT_byte_size   : 8\n"
+        "    <1cb>   DW_AT_encoding    : 5 (signed)\n"
+        "    <1cc>   DW_AT_name        : (indirect string, offset: 0xf8): long int\n"
+        " <1><1d0>: Abbrev Number: 13 (DW_TAG_pointer_type)\n"
+        "    <1d1>   DW_AT_byte_size   : 8\n"
+        " <1><1d2>: Abbrev Number: 4 (DW_TAG_pointer_type)\n"
+        "    <1d3>   DW_AT_byte_size   : 8\n"
+        "    <1d4>   DW_AT_type        : <0xa8>\n"
+        " <1><1d8>: Abbrev Number: 14 (DW_TAG_array_type)\n"
+        "    <1d9>   DW_AT_type        : <0x1e8>\n"
+        "    <1dd>   DW_AT_sibling     : <0x1e8>\n"
+        " <2><1e1>: Abbrev Number: 15 (DW_TAG_subrange_type)\n"
+        "    <1e2>   DW_AT_type        : <0x9a>\n"
+        "    <1e6>   DW_AT_upper_bound : 15\n"
+        " <1><1e8>: Abbrev Number: 5 (DW_TAG_base_type)\n"
+        "    <1e9>   DW_AT_byte_size   : 1\n"
+        "    <1ea>   DW_AT_encoding    : 6 (signed char)\n"
+        "    <1eb>   DW_AT_name        : (indirect string, offset: 0x155): char\n"
+        " <1><1ef>: Abbrev Number: 16 (DW_TAG_variable)\n"
+        "    <1f0>   DW_AT_name        : (indirect string, offset: 0xc7): init_task\n"
+        "    <1f4>   DW_AT_decl_file   : 1\n"
+        "    <1f5>   DW_AT_decl_line   : 38\n"
+        "    <1f7>   DW_AT_type        : <0x169>\n"
+        "    <1fb>   DW_AT_external    : 1\n"
+        "    <1fc>   DW_AT_location    : 9 byte block: 3 40 40 0 0 0 0 0 0  (DW_OP_addr: 4040)\n"
+        " <1><206>: Abbrev Number: 17 (DW_TAG_subprogram)\n"
+        "    <207>   DW_AT_external    : 1\n"
+        "    <208>   DW_AT_name        : (indirect string, offset: 0xd1): main\n"
+        "    <20c>   DW_AT_decl_file   : 1\n"
+        "    <20d>   DW_AT_decl_line   : 40\n"
+        "    <20f>   DW_AT_prototyped  : 1\n"
+        "    <210>   DW_AT_type        : <0xd4>\n"
+        "    <214>   DW_AT_low_pc      : 0x1129\n"
+        "    <21c>   DW_AT_high_pc     : 0x113c\n"
+        "    <224>   DW_AT_frame_base  : 0 (location list)\n"
+        "    <228>   DW_AT_sibling     : <0x24b>\n"
+        " <2><22c>: Abbrev Number: 18 (DW_TAG_formal_parameter)\n"
+        "    <22d>   DW_AT_name        : (indirect string, offset: 0x11f): argc\n"
+        "    <231>   DW_AT_decl_file   : 1\n"
+        "    <232>   DW_AT_decl_line   : 40\n"
+        "    <234>   DW_AT_type        : <0xd4>\n"
+        "    <238>   DW_AT_location    : 2 byte block: 91 6c  (DW_OP_fbreg: -20)\n"
+        " <2><23b>: Abbrev Number: 18 (DW_TAG_formal_parameter)\n"
+        "    <23c>   DW_AT_name        : (indirect string, offset: 0xc2): argv\n"
+        "    <240>   DW_AT_decl_file   : 1\n"
+        "    <241>   DW_AT_decl_line   : 40\n"
+        "    <243>   DW_AT_type        : <0x24b>\n"
+        "    <247>   DW_AT_location    : 2 byte block: 91 60  (DW_OP_fbreg: -32)\n"
+        " <1><24b>: Abbrev Number: 4 (DW_TAG_pointer_type)\n"
+        "    <24c>   DW_AT_byte_size   : 8\n"
+        "    <24d>   DW_AT_type        : <0x251>\n"
+        " <1><251>: Abbrev Number: 4 (DW_TAG_pointer_type)\n"
+        "    <252>   DW_AT_byte_size   : 8\n"
+        "    <253>   DW_AT_type        : <0x1e8>\n";
+
+
+class StructuredTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    StructuredTest();
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void memberLocal();
+    void memberFlattened();
+    void memberChain();
+    void memberOffset();
+    void memberAtOffset();
+    void memberIndexUpdated();
+
+    void benchmarkMemberChain();
+    void benchmarkMemberOffset();
+    void benchmarkDeepChain();
+
+private:
+    KernelSymbols* _symbols;
+    const Structured* _task;
+    const Structured* _se;
+    const Structured* _list;
+};
+
+
+StructuredTest::StructuredTest()
+    : _symbols(0), _task(0), _se(0), _list(0)
+{
+}
+
+
+void StructuredTest::initTestCase()
+{
+    MemSpecs specs;
+    specs.arch = MemSpecs::ar_x86_64;
+    specs.sizeofPointer = 8;
+    specs.sizeofLong = 8;
+
+    _symbols = new KernelSymbols();
+    _symbols->setMemSpecs(specs);
+
+    // Create device from object dump above
+    QByteArray ba(objdump);
+    QBuffer buf(&ba);
+    buf.open(QIODevice::ReadOnly);
+
+    // Parse the object dump
+    KernelSymbolParser parser(_symbols);
+    parser.parse(&buf);
+
+    const SymFactory& factory = _symbols->factory();
+    const Variable* init_task = factory.findVarByName("init_task");
+    QVERIFY(init_task != 0);
+    _task = dynamic_cast<const Structured*>(init_task->refType());
+    _se = dynamic_cast<const Structured*>(
+                factory.findBaseTypeByName("sched_entity"));
+    _list = dynamic_cast<const Structured*>(
+                factory.findBaseTypeByName("list_head"));
+    QVERIFY(_task != 0);
+    QVERIFY(_se != 0);
+    QVERIFY(_list != 0);
+}
+
+
+void StructuredTest::cleanupTestCase()
+{
+    safe_delete(_symbols);
+}
+
+
+void StructuredTest::memberLocal()
+{
+    QVERIFY(_task->memberExists("state", false));
+    QVERIFY(_task->memberExists("comm", false));
+    QVERIFY(!_task->memberExists("not_existing"));
+
+    const StructuredMember* m = _task->member("signal", false);
+    QVERIFY(m != 0);
+    QCOMPARE(m->name(), QString("signal"));
+    QVERIFY(m->belongsTo() == _task);
+}
+
+
+void StructuredTest::memberFlattened()
+{
+    // Members of anonymous structs/unions are only found recursively
+    QVERIFY(!_task->memberExists("pid", false));
+    QVERIFY(_task->memberExists("pid", true));
+
+    const char* names[] = { "flags", "prio", "static_prio", "tasks", "pid",
+                            "tgid" };
+    for (int i = 0; i < 6; ++i) {
+        const StructuredMember* m = _task->member(names[i]);
+        QVERIFY(m != 0);
+        QCOMPARE(m->name(), QString(names[i]));
+        QVERIFY(m->belongsTo() != _task);
+    }
+}
+
+
+void StructuredTest::memberChain()
+{
+    ConstMemberList chain = _task->memberChain("pid");
+    // union -> struct -> union -> struct -> pid
+    QCOMPARE(chain.size(), 5);
+    QVERIFY(chain.first()->belongsTo() == _task);
+    QCOMPARE(chain.last()->name(), QString("pid"));
+    for (int i = 0; i + 1 < chain.size(); ++i)
+        QVERIFY(chain[i]->name().isEmpty());
+
+    QCOMPARE(_task->memberChain("flags").size(), 2);
+    QCOMPARE(_task->memberChain("se").size(), 1);
+    QVERIFY(_task->memberChain("not_existing").isEmpty());
+}
+
+
+void StructuredTest::memberOffset()
+{
+    QCOMPARE(_task->memberOffset("state"), 0);
+    QCOMPARE(_task->memberOffset("se"), 16);
+    QCOMPARE(_task->memberOffset("flags"), 48);
+    QCOMPARE(_task->memberOffset("static_prio"), 52);
+    QCOMPARE(_task->memberOffset("tasks"), 56);
+    QCOMPARE(_task->memberOffset("pid"), 56);
+    QCOMPARE(_task->memberOffset("tgid"), 60);
+    QCOMPARE(_task->memberOffset("signal"), 72);
+    QCOMPARE(_task->memberOffset("comm"), 80);
+    QCOMPARE(_task->memberOffset("pid", false), -1);
+    QCOMPARE(_task->memberOffset("not_existing"), -1);
+}
+
+
+void StructuredTest::memberAtOffset()
+{
+    QCOMPARE(_task->memberAtOffset(0, true), _task->member("state"));
+    QCOMPARE(_task->memberAtOffset(16, true), _task->member("se"));
+    QCOMPARE(_task->memberAtOffset(72, true), _task->member("signal"));
+    QCOMPARE(_task->memberAtOffset(80, true), _task->member("comm"));
+
+    // Offsets within a member
+    QVERIFY(_task->memberAtOffset(20, true) == 0);
+    QCOMPARE(_task->memberAtOffset(20, false), _task->member("se"));
+    QCOMPARE(_task->memberAtOffset(85, false), _task->member("comm"));
+
+    // Offsets beyond the struct
+    QVERIFY(_task->memberAtOffset(_task->size(), false) == 0);
+}
+
+
+void StructuredTest::memberIndexUpdated()
+{
+    // The anonymous union that holds "flags"
+    const int anonId = _task->memberChain("flags").first()->refTypeId();
+
+    // An anonymous member whose type is not resolved yet
+    Struct s(_symbols);
+    StructuredMember* anon = new StructuredMember(_symbols);
+    anon->setRefTypeId(0x7ffffff0);
+    s.addMember(anon);
+    QVERIFY(!s.memberExists("flags"));
+
+    // Once its type is found, the members of that type are found as well
+    anon->setRefTypeId(anonId);
+    QVERIFY(s.memberExists("flags"));
+    QCOMPARE(s.memberChain("flags").size(), 2);
+    QCOMPARE(s.memberChain("pid").size(), 5);
+
+    // Added members are found right away
+    StructuredMember* m = new StructuredMember(_symbols);
+    m->setName("extra");
+    m->setOffset(32);
+    m->setRefTypeId(anonId);
+    s.addMember(m);
+    QVERIFY(s.memberExists("extra", false));
+    QCOMPARE(s.memberOffset("extra"), 32);
+}
+
+
+void StructuredTest::benchmarkMemberChain()
+{
+    QBENCHMARK {
+        _task->memberChain("pid");
+        _task->memberChain("tgid");
+        _task->memberChain("tasks");
+        _task->memberChain("comm");
+    }
+}
+
+
+void StructuredTest::benchmarkMemberOffset()
+{
+    QBENCHMARK {
+        _task->memberOffset("pid");
+        _task->memberOffset("static_prio");
+        _task->memberOffset("signal");
+        _task->memberAtOffset(56, false);
+    }
+}
+
+
+void StructuredTest::benchmarkDeepChain()
+{
+    // Resolve "se.group_node.next" like Instance::member() does
+    QBENCHMARK {
+        const StructuredMember* se = _task->member("se");
+        const Structured* s = static_cast<const Structured*>(se->refType());
+        const StructuredMember* gn = s->member("group_node");
+        s = static_cast<const Structured*>(gn->refType());
+        const StructuredMember* next = s->member("next");
+        QVERIFY(next != 0);
+    }
+}
+
+QTEST_MAIN(StructuredTest)
+
+#include "tst_structuredtest.moc"
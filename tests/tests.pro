@@ -1,10 +1,15 @@
 SUBDIRS += \
     asttypeevaluator \
     astexpressionevaluator \
+    detect \
     devicemuxer \
+    instanceprototype \
     memoryrangetree \
     osfilter \
+    pagedigest \
     priorityqueue \
-    typefilter
+    structured \
+    typefilter \
+    typerule
 TEMPLATE = subdirs
 CONFIG += debug_and_release
@@ -7,6 +7,7 @@
 #include <insight/basetype.h>
 #include <insight/typefilter.h>
 #include <insight/kernelsymbols.h>
+#include <insight/stringatoms.h>
 
 #define safe_delete(x) \
     do { if ((x)) { delete (x); (x) = 0; } } while (0)
@@ -240,6 +241,8 @@ private Q_SLOTS:
     void setSize();
     void setMembers();
 
+    void nameMatcher();
+
 private:
     KernelSymbols* _symbols;
     const Variable* var_a;
@@ -992,6 +995,71 @@ void TypeFilterTest::setMembers()
 }
 
 
+void TypeFilterTest::nameMatcher()
+{
+    const char* names[] = {
+        "", "a", "A", "ab", "abc", "task_struct", "TASK_STRUCT", "list_head",
+        "nested_struct", "x_list_head_y", "aaa", "aXa", 0
+    };
+
+    NameMatcher m;
+    QRegExp rx;
+
+    // The compiled wildcard matcher must behave exactly like QRegExp
+#define TEST_NAME_MATCHER(p, s, qs) \
+    rx = QRegExp(p, (s) == Filter::psWildcard ? Qt::CaseInsensitive : \
+                                                Qt::CaseSensitive, (qs)); \
+    m.compile(p, (s), rx); \
+    for (int i = 0; names[i]; ++i) { \
+        bool exp = ((s) == Filter::psWildcard) ? rx.exactMatch(names[i]) : \
+                                                 rx.indexIn(names[i]) >= 0; \
+        QVERIFY2(m.match(names[i]) == exp, \
+                 qPrintable(QString("pattern: %1, name: %2").arg(p).arg(names[i]))); \
+    }
+
+    TEST_NAME_MATCHER("*", Filter::psWildcard, QRegExp::WildcardUnix);
+    TEST_NAME_MATCHER("a*", Filter::psWildcard, QRegExp::WildcardUnix);
+    TEST_NAME_MATCHER("*a", Filter::psWildcard, QRegExp::WildcardUnix);
+    TEST_NAME_MATCHER("a*a", Filter::psWildcard, QRegExp::WildcardUnix);
+    TEST_NAME_MATCHER("?", Filter::psWildcard, QRegExp::WildcardUnix);
+    TEST_NAME_MATCHER("a?a", Filter::psWildcard, QRegExp::WildcardUnix);
+    TEST_NAME_MATCHER("*list*", Filter::psWildcard, QRegExp::WildcardUnix);
+    TEST_NAME_MATCHER("*_*_*", Filter::psWildcard, QRegExp::WildcardUnix);
+    TEST_NAME_MATCHER("task_*", Filter::psWildcard, QRegExp::WildcardUnix);
+    TEST_NAME_MATCHER("**a**b*", Filter::psWildcard, QRegExp::WildcardUnix);
+    TEST_NAME_MATCHER("[at]*", Filter::psWildcard, QRegExp::WildcardUnix);
+
+    TEST_NAME_MATCHER("list", Filter::psRegExp, QRegExp::RegExp);
+    TEST_NAME_MATCHER("task_struct", Filter::psRegExp, QRegExp::RegExp);
+    TEST_NAME_MATCHER("^a", Filter::psRegExp, QRegExp::RegExp);
+    TEST_NAME_MATCHER("b$", Filter::psRegExp, QRegExp::RegExp);
+    TEST_NAME_MATCHER("a.a", Filter::psRegExp, QRegExp::RegExp);
+    TEST_NAME_MATCHER("^$", Filter::psRegExp, QRegExp::RegExp);
+
+    // Literal matches are case-insensitive
+    m.compile("Task_Struct", Filter::psLiteral, QRegExp());
+    QVERIFY(m.match("task_struct"));
+    QVERIFY(m.match("TASK_STRUCT"));
+    QVERIFY(!m.match("task_struc"));
+
+    // Compiling filters must not add names to the global atom table
+    const int atoms = StringAtoms::count();
+    m.compile("no_such_type_name", Filter::psLiteral, QRegExp());
+    QVERIFY(m.match("No_Such_Type_Name"));
+    TypeFilter tf;
+    tf.setTypeName("another_unknown_name");
+    tf.setTypeName("unknown_*", Filter::psWildcard);
+    VariableFilter vf;
+    vf.setVarName("unknown_variable_name");
+    vf.setVarName("unknown.*", Filter::psRegExp);
+    QCOMPARE(StringAtoms::count(), atoms);
+
+    m.clear();
+    for (int i = 0; names[i]; ++i)
+        QVERIFY(m.match(names[i]));
+}
+
+
 QTEST_MAIN(TypeFilterTest)
 
 #include "tst_typefiltertest.moc"
@@ -0,0 +1,34 @@
+struct list_head {
+	struct list_head *next, *prev;
+};
+
+struct hlist_node {
+	struct hlist_node *next, **pprev;
+};
+
+struct task_struct {
+	int pid;
+	struct list_head tasks;
+	struct hlist_node pid_link;
+};
+
+struct event_common {
+	unsigned short type;
+};
+
+struct event {
+	struct event_common common;
+	union {
+		int number;
+		char name[8];
+		void *ptr;
+	} data;
+};
+
+struct task_struct init_task;
+struct event last_event;
+
+int main(int argc, char** argv)
+{
+	return init_task.pid + last_event.data.number;
+}
@@ -0,0 +1,611 @@
+#include <QString>
+#include <QtTest>
+#include <QBuffer>
+#include <insight/memspecs.h>
+#include <insight/symfactory.h>
+#include <insight/kernelsymbolparser.h>
+#include <insight/kernelsymbols.h>
+#include <insight/structured.h>
+#include <insight/structuredmember.h>
+#include <insight/virtualmemory.h>
+#include <insight/instance.h>
+#include <insight/typerule.h>
+#include <insight/typeruleengine.h>
+#include <insight/typefilter.h>
+#include <insight/typeruleexception.h>
+#include <string.h>
+
+#define safe_delete(x) \
+    do { if ((x)) { delete (x); (x) = 0; } } while (0)
+
+// Created with the following command:
+// gcc -gdwarf-2 -gstrict-dwarf -O0 -o test test.c && objdump -W test | grep '^\s*<' | grep -v 'DW_AT_decl_column\|Abbrev Number: 0$' | sed 's/^.*$/"\0\\n"/'
+const char* objdump =
+        " <0><b>: Abbrev Number: 1 (DW_TAG_compile_unit)\n"
+        "    <c>   DW_AT_producer    : (indirect string, offset: 0x42): GNU C17 12.2.0 -mtune=generic -march=x86-64 -gdwarf-2 -gstrict-dwarf -O0 -fasynchronous-unwind-tables\n"
+        "    <10>   DW_AT_language    : 1 (ANSI C)\n"
+        "    <11>   DW_AT_name        : (indirect string, offset: 0xe6): test.c\n"
+        "    <15>   DW_AT_comp_dir    : (indirect string, offset: 0x18): /tmp/insight-vmi/tests/typerule\n"
+        "    <19>   DW_AT_low_pc      : 0x1129\n"
+        "    <21>   DW_AT_high_pc     : 0x1144\n"
+        "    <29>   DW_AT_stmt_list   : 0\n"
+        " <1><2d>: Abbrev Number: 2 (DW_TAG_structure_type)\n"
+        "    <2e>   DW_AT_name        : (indirect string, offset: 0x11f): list_head\n"
+        "    <32>   DW_AT_byte_size   : 16\n"
+        "    <33>   DW_AT_decl_file   : 1\n"
+        "    <34>   DW_AT_decl_line   : 1\n"
+        "    <36>   DW_AT_sibling     : <0x59>\n"
+        " <2><3a>: Abbrev Number: 3 (DW_TAG_member)\n"
+        "    <3b>   DW_AT_name        : (indirect string, offset: 0x134): next\n"
+        "    <3f>   DW_AT_decl_file   : 1\n"
+        "    <40>   DW_AT_decl_line   : 2\n"
+        "    <42>   DW_AT_type        : <0x59>\n"
+        "    <46>   DW_AT_data_member_location: 2 byte block: 23 0  (DW_OP_plus_uconst: 0)\n"
+        " <2><49>: Abbrev Number: 3 (DW_TAG_member)\n"
+        "    <4a>   DW_AT_name        : (indirect string, offset: 0xee): prev\n"
+        "    <4e>   DW_AT_decl_file   : 1\n"
+        "    <4f>   DW_AT_decl_line   : 2\n"
+        "    <51>   DW_AT_type        : <0x59>\n"
+        "    <55>   DW_AT_data_member_location: 2 byte block: 23 8  (DW_OP_plus_uconst: 8)\n"
+        " <1><59>: Abbrev Number: 4 (DW_TAG_pointer_type)\n"
+        "    <5a>   DW_AT_byte_size   : 8\n"
+        "    <5b>   DW_AT_type        : <0x2d>\n"
+        " <1><5f>: Abbrev Number: 2 (DW_TAG_structure_type)\n"
+        "    <60>   DW_AT_name        : (indirect string, offset: 0x114): hlist_node\n"
+        "    <64>   DW_AT_byte_size   : 16\n"
+        "    <65>   DW_AT_decl_file   : 1\n"
+        "    <66>   DW_AT_decl_line   : 5\n"
+        "    <68>   DW_AT_sibling     : <0x8b>\n"
+        " <2><6c>: Abbrev Number: 3 (DW_TAG_member)\n"
+        "    <6d>   DW_AT_name        : (indirect string, offset: 0x134): next\n"
+        "    <71>   DW_AT_decl_file   : 1\n"
+        "    <72>   DW_AT_decl_line   : 6\n"
+        "    <74>   DW_AT_type        : <0x8b>\n"
+        "    <78>   DW_AT_data_member_location: 2 byte block: 23 0  (DW_OP_plus_uconst: 0)\n"
+        " <2><7b>: Abbrev Number: 3 (DW_TAG_member)\n"
+        "    <7c>   DW_AT_name        : (indirect string, offset: 0xed): pprev\n"
+        "    <80>   DW_AT_decl_file   : 1\n"
+        "    <81>   DW_AT_decl_line   : 6\n"
+        "    <83>   DW_AT_type        : <0x91>\n"
+        "    <87>   DW_AT_data_member_location: 2 byte block: 23 8  (DW_OP_plus_uconst: 8)\n"
+        " <1><8b>: Abbrev Number: 4 (DW_TAG_pointer_type)\n"
+        "    <8c>   DW_AT_byte_size   : 8\n"
+        "    <8d>   DW_AT_type        : <0x5f>\n"
+        " <1><91>: Abbrev Number: 4 (DW_TAG_pointer_type)\n"
+        "    <92>   DW_AT_byte_size   : 8\n"
+        "    <93>   DW_AT_type        : <0x8b>\n"
+        " <1><97>: Abbrev Number: 2 (DW_TAG_structure_type)\n"
+        "    <98>   DW_AT_name        : (indirect string, offset: 0xa8): task_struct\n"
+        "    <9c>   DW_AT_byte_size   : 40\n"
+        "    <9d>   DW_AT_decl_file   : 1\n"
+        "    <9e>   DW_AT_decl_line   : 9\n"
+        "    <a0>   DW_AT_sibling     : <0xd2>\n"
+        " <2><a4>: Abbrev Number: 5 (DW_TAG_member)\n"
+        "    <a5>   DW_AT_name        : pid\n"
+        "    <a9>   DW_AT_decl_file   : 1\n"
+        "    <aa>   DW_AT_decl_line   : 10\n"
+        "    <ac>   DW_AT_type        : <0xd2>\n"
+        "    <b0>   DW_AT_data_member_location: 2 byte block: 23 0  (DW_OP_plus_uconst: 0)\n"
+        " <2><b3>: Abbrev Number: 3 (DW_TAG_member)\n"
+        "    <b4>   DW_AT_name        : (indirect string, offset: 0x105): tasks\n"
+        "    <b8>   DW_AT_decl_file   : 1\n"
+        "    <b9>   DW_AT_decl_line   : 11\n"
+        "    <bb>   DW_AT_type        : <0x2d>\n"
+        "    <bf>   DW_AT_data_member_location: 2 byte block: 23 8  (DW_OP_plus_uconst: 8)\n"
+        " <2><c2>: Abbrev Number: 3 (DW_TAG_member)\n"
+        "    <c3>   DW_AT_name        : (indirect string, offset: 0x10b): pid_link\n"
+        "    <c7>   DW_AT_decl_file   : 1\n"
+        "    <c8>   DW_AT_decl_line   : 12\n"
+        "    <ca>   DW_AT_type        : <0x5f>\n"
+        "    <ce>   DW_AT_data_member_location: 2 byte block: 23 18  (DW_OP_plus_uconst: 24)\n"
+        " <1><d2>: Abbrev Number: 6 (DW_TAG_base_type)\n"
+        "    <d3>   DW_AT_byte_size   : 4\n"
+        "    <d4>   DW_AT_encoding    : 5 (signed)\n"
+        "    <d5>   DW_AT_name        : int\n"
+        " <1><d9>: Abbrev Number: 2 (DW_TAG_structure_type)\n"
+        "    <da>   DW_AT_name        : (indirect string, offset: 0xf8): event_common\n"
+        "    <de>   DW_AT_byte_size   : 2\n"
+        "    <df>   DW_AT_decl_file   : 1\n"
+        "    <e0>   DW_AT_decl_line   : 15\n"
+        "    <e2>   DW_AT_sibling     : <0xf6>\n"
+        " <2><e6>: Abbrev Number: 3 (DW_TAG_member)\n"
+        "    <e7>   DW_AT_name        : (indirect string, offset: 0x13): type\n"
+        "    <eb>   DW_AT_decl_file   : 1\n"
+        "    <ec>   DW_AT_decl_line   : 16\n"
+        "    <ee>   DW_AT_type        : <0xf6>\n"
+        "    <f2>   DW_AT_data_member_location: 2 byte block: 23 0  (DW_OP_plus_uconst: 0)\n"
+        " <1><f6>: Abbrev Number: 7 (DW_TAG_base_type)\n"
+        "    <f7>   DW_AT_byte_size   : 2\n"
+        "    <f8>   DW_AT_encoding    : 7 (unsigned)\n"
+        "    <f9>   DW_AT_name        : (indirect string, offset: 0): short unsigned int\n"
+        " <1><fd>: Abbrev Number: 8 (DW_TAG_union_type)\n"
+        "    <fe>   DW_AT_byte_size   : 8\n"
+        "    <ff>   DW_AT_decl_file   : 1\n"
+        "    <100>   DW_AT_decl_line   : 21\n"
+        "    <102>   DW_AT_sibling     : <0x12b>\n"
+        " <2><106>: Abbrev Number: 9 (DW_TAG_member)\n"
+        "    <107>   DW_AT_name        : (indirect string, offset: 0xcb): number\n"
+        "    <10b>   DW_AT_decl_file   : 1\n"
+        "    <10c>   DW_AT_decl_line   : 22\n"
+        "    <10e>   DW_AT_type        : <0xd2>\n"
+        " <2><112>: Abbrev Number: 9 (DW_TAG_member)\n"
+        "    <113>   DW_AT_name        : (indirect string, offset: 0xc6): name\n"
+        "    <117>   DW_AT_decl_file   : 1\n"
+        "    <118>   DW_AT_decl_line   : 23\n"
+        "    <11a>   DW_AT_type        : <0x12b>\n"
+        " <2><11e>: Abbrev Number: 10 (DW_TAG_member)\n"
+        "    <11f>   DW_AT_name        : ptr\n"
+        "    <123>   DW_AT_decl_file   : 1\n"
+        "    <124>   DW_AT_decl_line   : 24\n"
+        "    <126>   DW_AT_type        : <0x149>\n"
+        " <1><12b>: Abbrev Number: 11 (DW_TAG_array_type)\n"
+        "    <12c>   DW_AT_type        : <0x142>\n"
+        "    <130>   DW_AT_sibling     : <0x13b>\n"
+        " <2><134>: Abbrev Number: 12 (DW_TAG_subrange_type)\n"
+        "    <135>   DW_AT_type        : <0x13b>\n"
+        "    <139>   DW_AT_upper_bound : 7\n"
+        " <1><13b>: Abbrev Number: 7 (DW_TAG_base_type)\n"
+        "    <13c>   DW_AT_byte_size   : 8\n"
+        "    <13d>   DW_AT_encoding    : 7 (unsigned)\n"
+        "    <13e>   DW_AT_name        : (indirect string, offset: 0xb4): long unsigned int\n"
+        " <1><142>: Abbrev Number: 7 (DW_TAG_base_type)\n"
+        "    <143>   DW_AT_byte_size   : 1\n"
+        "    <144>   DW_AT_encoding    : 6 (signed char)\n"
+        "    <145>   DW_AT_name        : (indirect string, offset: 0xe1): char\n"
+        " <1><149>: Abbrev Number: 13 (DW_TAG_pointer_type)\n"
+        "    <14a>   DW_AT_byte_size   : 8\n"
+        " <1><14b>: Abbrev Number: 2 (DW_TAG_structure_type)\n"
+        "    <14c>   DW_AT_name        : (indirect string, offset: 0x12e): event\n"
+        "    <150>   DW_AT_byte_size   : 16\n"
+        "    <151>   DW_AT_decl_file   : 1\n"
+        "    <152>   DW_AT_decl_line   : 19\n"
+        "    <154>   DW_AT_sibling     : <0x177>\n"
+        " <2><158>: Abbrev Number: 3 (DW_TAG_member)\n"
+        "    <159>   DW_AT_name        : (indirect string, offset: 0xfe): common\n"
+        "    <15d>   DW_AT_decl_file   : 1\n"
+        "    <15e>   DW_AT_decl_line   : 20\n"
+        "    <160>   DW_AT_type        : <0xd9>\n"
+        "    <164>   DW_AT_data_member_location: 2 byte block: 23 0  (DW_OP_plus_uconst: 0)\n"
+        " <2><167>: Abbrev Number: 3 (DW_TAG_member)\n"
+        "    <168>   DW_AT_name        : (indirect string, offset: 0x38): data\n"
+        "    <16c>   DW_AT_decl_file   : 1\n"
+        "    <16d>   DW_AT_decl_line   : 25\n"
+        "    <16f>   DW_AT_type        : <0xfd>\n"
+        "    <173>   DW_AT_data_member_location: 2 byte block: 23 8  (DW_OP_plus_uconst: 8)\n"
+        " <1><177>: Abbrev Number: 14 (DW_TAG_variable)\n"
+        "    <178>   DW_AT_name        : (indirect string, offset: 0xd7): init_task\n"
+        "    <17c>   DW_AT_decl_file   : 1\n"
+        "    <17d>   DW_AT_decl_line   : 28\n"
+        "    <17f>   DW_AT_type        : <0x97>\n"
+        "    <183>   DW_AT_external    : 1\n"
+        "    <184>   DW_AT_location    : 9 byte block: 3 40 40 0 0 0 0 0 0  (DW_OP_addr: 4040)\n"
+        " <1><18e>: Abbrev Number: 14 (DW_TAG_variable)\n"
+        "    <18f>   DW_AT_name        : (indirect string, offset: 0x129): last_event\n"
+        "    <193>   DW_AT_decl_file   : 1\n"
+        "    <194>   DW_AT_decl_line   : 29\n"
+        "    <196>   DW_AT_type        : <0x14b>\n"
+        "    <19a>   DW_AT_external    : 1\n"
+        "    <19b>   DW_AT_location    : 9 byte block: 3 70 40 0 0 0 0 0 0  (DW_OP_addr: 4070)\n"
+        " <1><1a5>: Abbrev Number: 15 (DW_TAG_subprogram)\n"
+        "    <1a6>   DW_AT_external    : 1\n"
+        "    <1a7>   DW_AT_name        : (indirect string, offset: 0x3d): main\n"
+        "    <1ab>   DW_AT_decl_file   : 1\n"
+        "    <1ac>   DW_AT_decl_line   : 31\n"
+        "    <1ae>   DW_AT_prototyped  : 1\n"
+        "    <1af>   DW_AT_type        : <0xd2>\n"
+        "    <1b3>   DW_AT_low_pc      : 0x1129\n"
+        "    <1bb>   DW_AT_high_pc     : 0x1144\n"
+        "    <1c3>   DW_AT_frame_base  : 0 (location list)\n"
+        "    <1c7>   DW_AT_sibling     : <0x1ea>\n"
+        " <2><1cb>: Abbrev Number: 16 (DW_TAG_formal_parameter)\n"
+        "    <1cc>   DW_AT_name        : (indirect string, offset: 0xf3): argc\n"
+        "    <1d0>   DW_AT_decl_file   : 1\n"
+        "    <1d1>   DW_AT_decl_line   : 31\n"
+        "    <1d3>   DW_AT_type        : <0xd2>\n"
+        "    <1d7>   DW_AT_location    : 2 byte block: 91 6c  (DW_OP_fbreg: -20)\n"
+        " <2><1da>: Abbrev Number: 16 (DW_TAG_formal_parameter)\n"
+        "    <1db>   DW_AT_name        : (indirect string, offset: 0xd2): argv\n"
+        "    <1df>   DW_AT_decl_file   : 1\n"
+        "    <1e0>   DW_AT_decl_line   : 31\n"
+        "    <1e2>   DW_AT_type        : <0x1ea>\n"
+        "    <1e6>   DW_AT_location    : 2 byte block: 91 60  (DW_OP_fbreg: -32)\n"
+        " <1><1ea>: Abbrev Number: 4 (DW_TAG_pointer_type)\n"
+        "    <1eb>   DW_AT_byte_size   : 8\n"
+        "    <1ec>   DW_AT_type        : <0x1f0>\n"
+        " <1><1f0>: Abbrev Number: 4 (DW_TAG_pointer_type)\n"
+        "    <1f1>   DW_AT_byte_size   : 8\n"
+        "    <1f2>   DW_AT_type        : <0x142>\n";
+
+
+// The memory image is accessed through the direct mapping
+static const quint64 pageOffset = 0xffff880000000000ULL;
+
+// Physical addresses of the objects within the memory image
+static const quint64 taskA = 0x100;
+static const quint64 taskB = 0x200;
+static const quint64 taskC = 0x300;
+static const quint64 event1 = 0x400;
+static const quint64 event2 = 0x420;
+static const quint64 event7 = 0x440;
+
+// Offsets within the types of test.c
+static const quint64 tasksOffset = 8;
+static const quint64 pidLinkOffset = 24;
+
+
+/**
+ * Tests the checks and the evaluation of the native list entry and
+ * discriminant actions of type rules, and the matching of rules by the
+ * TypeRuleEngine, on the types of test.c, read from a memory image with known
+ * content.
+ */
+class TypeRuleTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    TypeRuleTest();
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void checkListEntry();
+    void checkDiscriminant();
+    void evaluateListEntry();
+    void evaluateHListEntry();
+    void evaluateDiscriminant();
+    void matchDefersBelowHigherPriority();
+
+private:
+    void buildImage();
+    void setPointer(quint64 physAddress, quint64 value);
+    void setShort(quint64 physAddress, quint16 value);
+    TypeRule* newRule(TypeRuleAction* action, const QStringList& members,
+                      const QString& typeName = QString()) const;
+    bool checkFails(TypeRule* rule);
+    Instance instance(quint64 physAddress, const BaseType* type);
+
+    KernelSymbols* _symbols;
+    QByteArray _image;
+    QBuffer* _buffer;
+    VirtualMemory* _vmem;
+    const Structured* _task;
+    const Structured* _event;
+    ConstMemberList _tasksNext;
+    ConstMemberList _tasksPrev;
+    ConstMemberList _pidLinkNext;
+    ConstMemberList _pidLinkPprev;
+    ConstMemberList _dataNumber;
+    ConstMemberList _dataName;
+    ConstMemberList _dataPtr;
+};
+
+
+TypeRuleTest::TypeRuleTest()
+    : _symbols(0), _buffer(0), _vmem(0), _task(0), _event(0)
+{
+}
+
+
+void TypeRuleTest::initTestCase()
+{
+    MemSpecs specs;
+    specs.arch = MemSpecs::ar_x86_64;
+    specs.sizeofPointer = 8;
+    specs.sizeofLong = 8;
+    specs.pageOffset = pageOffset;
+    specs.vmallocStart = 0xffffc90000000000ULL;
+    specs.vmallocEnd = 0xffffe8ffffffffffULL;
+    specs.startKernelMap = 0xffffffff80000000ULL;
+    specs.modulesVaddr = 0xffffffffa0000000ULL;
+    specs.modulesEnd = 0xffffffffff000000ULL;
+
+    _symbols = new KernelSymbols();
+    _symbols->setMemSpecs(specs);
+
+    // Create device from object dump above
+    QByteArray ba(objdump);
+    QBuffer buf(&ba);
+    buf.open(QIODevice::ReadOnly);
+
+    // Parse the object dump
+    KernelSymbolParser parser(_symbols);
+    parser.parse(&buf);
+
+    const SymFactory& factory = _symbols->factory();
+    _task = dynamic_cast<const Structured*>(
+                factory.findBaseTypeByName("task_struct"));
+    _event = dynamic_cast<const Structured*>(
+                factory.findBaseTypeByName("event"));
+    QVERIFY(_task != 0);
+    QVERIFY(_event != 0);
+    QCOMPARE(_task->memberOffset("tasks"), (int)tasksOffset);
+    QCOMPARE(_task->memberOffset("pid_link"), (int)pidLinkOffset);
+
+    // The member chains accessed from the instances
+    const StructuredMember* tasks = _task->member("tasks");
+    const StructuredMember* pidLink = _task->member("pid_link");
+    const StructuredMember* data = _event->member("data");
+    const Structured* list = dynamic_cast<const Structured*>(tasks->refType());
+    const Structured* hlist = dynamic_cast<const Structured*>(pidLink->refType());
+    const Structured* u = dynamic_cast<const Structured*>(data->refType());
+    QVERIFY(list != 0);
+    QVERIFY(hlist != 0);
+    QVERIFY(u != 0);
+
+    _tasksNext << tasks << list->member("next");
+    _tasksPrev << tasks << list->member("prev");
+    _pidLinkNext << pidLink << hlist->member("next");
+    _pidLinkPprev << pidLink << hlist->member("pprev");
+    _dataNumber << data << u->member("number");
+    _dataName << data << u->member("name");
+    _dataPtr << data << u->member("ptr");
+
+    buildImage();
+    _buffer = new QBuffer(&_image);
+    _vmem = new VirtualMemory(specs, _buffer, 0);
+    QVERIFY(_vmem->open(QIODevice::ReadOnly));
+}
+
+
+void TypeRuleTest::cleanupTestCase()
+{
+    safe_delete(_vmem);
+    safe_delete(_buffer);
+    safe_delete(_symbols);
+}
+
+
+void TypeRuleTest::buildImage()
+{
+    _image.fill(0, 0x1000);
+
+    // Task A is followed by task B in both lists, task C ends both lists
+    setPointer(taskA + tasksOffset, pageOffset + taskB + tasksOffset);
+    setPointer(taskA + tasksOffset + 8, pageOffset + taskC + tasksOffset);
+    setPointer(taskA + pidLinkOffset, pageOffset + taskB + pidLinkOffset);
+    setPointer(taskA + pidLinkOffset + 8, pageOffset + taskC + pidLinkOffset);
+    setPointer(taskB + tasksOffset, pageOffset + taskC + tasksOffset);
+    setPointer(taskB + pidLinkOffset, pageOffset + taskC + pidLinkOffset);
+
+    // Events with the types 1, 2 and 7
+    setShort(event1, 1);
+    setShort(event2, 2);
+    setShort(event7, 7);
+}
+
+
+void TypeRuleTest::setPointer(quint64 physAddress, quint64 value)
+{
+    memcpy(_image.data() + physAddress, &value, sizeof(value));
+}
+
+
+void TypeRuleTest::setShort(quint64 physAddress, quint16 value)
+{
+    memcpy(_image.data() + physAddress, &value, sizeof(value));
+}
+
+
+TypeRule* TypeRuleTest::newRule(TypeRuleAction *action,
+                                const QStringList &members,
+                                const QString &typeName) const
+{
+    TypeRule* rule = new TypeRule();
+    InstanceFilter* filter = new InstanceFilter();
+    if (!typeName.isEmpty())
+        filter->setTypeName(typeName);
+    foreach (const QString& m, members)
+        filter->appendMember(m);
+    rule->setFilter(filter);
+    rule->setAction(action);
+    return rule;
+}
+
+
+bool TypeRuleTest::checkFails(TypeRule *rule)
+{
+    bool failed = false;
+    try {
+        rule->action()->check("test.xml", rule, &_symbols->factory());
+    }
+    catch (TypeRuleException&) {
+        failed = true;
+    }
+    delete rule;
+    return failed;
+}
+
+
+Instance TypeRuleTest::instance(quint64 physAddress, const BaseType *type)
+{
+    return Instance(pageOffset + physAddress, type, _vmem);
+}
+
+
+void TypeRuleTest::checkListEntry()
+{
+    // The filter must specify the members to follow
+    QVERIFY(checkFails(newRule(new ListEntryAction(), QStringList())));
+    QVERIFY(checkFails(newRule(new ListEntryAction(true), QStringList())));
+
+    QVERIFY(!checkFails(newRule(new ListEntryAction(),
+                                QStringList() << "tasks" << "next")));
+    QVERIFY(!checkFails(newRule(new ListEntryAction(true),
+                                QStringList() << "pid_link" << "next")));
+}
+
+
+void TypeRuleTest::checkDiscriminant()
+{
+    DiscriminantAction* a;
+
+    // Rules without members
+    a = new DiscriminantAction();
+    a->setDiscriminantStr("common.type");
+    a->addCase(1, "number");
+    QVERIFY(checkFails(newRule(a, QStringList())));
+
+    // Rules without cases
+    a = new DiscriminantAction();
+    a->setDiscriminantStr("common.type");
+    QVERIFY(checkFails(newRule(a, QStringList() << "data" << "*")));
+
+    // Invalid discriminant
+    a = new DiscriminantAction();
+    a->setDiscriminantStr("common..type");
+    a->addCase(1, "number");
+    QVERIFY(checkFails(newRule(a, QStringList() << "data" << "*")));
+
+    // Valid rules, with cases or defaults only
+    a = new DiscriminantAction();
+    a->setDiscriminantStr(" common . type ");
+    a->addCase(1, "number");
+    QVERIFY(!checkFails(newRule(a, QStringList() << "data" << "*")));
+
+    a = new DiscriminantAction();
+    a->setDiscriminantStr("common.type");
+    a->addDefault("ptr");
+    QVERIFY(!checkFails(newRule(a, QStringList() << "data" << "*")));
+}
+
+
+void TypeRuleTest::evaluateListEntry()
+{
+    ListEntryAction a;
+    bool matched;
+    Instance inst = instance(taskA, _task);
+
+    // The next task embeds the list node that task A points to
+    Instance next = a.evaluate(&inst, _tasksNext, 0, &matched);
+    QVERIFY(matched);
+    QVERIFY(next.isValid());
+    QCOMPARE((quint64)next.address(), pageOffset + taskB);
+    QVERIFY(next.type() == _task);
+
+    // The previous pointer can be followed as well
+    Instance prev = a.evaluate(&inst, _tasksPrev, 0, &matched);
+    QVERIFY(matched);
+    QCOMPARE((quint64)prev.address(), pageOffset + taskC);
+
+    // Empty lists fall back to the default handler
+    inst = instance(taskC, _task);
+    next = a.evaluate(&inst, _tasksNext, 0, &matched);
+    QVERIFY(!matched);
+    QVERIFY(!next.isValid());
+
+    // Nothing to follow without members
+    next = a.evaluate(&inst, ConstMemberList(), 0, &matched);
+    QVERIFY(!next.isValid());
+}
+
+
+void TypeRuleTest::evaluateHListEntry()
+{
+    ListEntryAction a(true);
+    bool matched;
+    Instance inst = instance(taskA, _task);
+
+    Instance next = a.evaluate(&inst, _pidLinkNext, 0, &matched);
+    QVERIFY(matched);
+    QCOMPARE((quint64)next.address(), pageOffset + taskB);
+    QVERIFY(next.type() == _task);
+
+    inst = instance(taskB, _task);
+    next = a.evaluate(&inst, _pidLinkNext, 0, &matched);
+    QVERIFY(matched);
+    QCOMPARE((quint64)next.address(), pageOffset + taskC);
+
+    // The pprev member does not point to a node
+    inst = instance(taskA, _task);
+    next = a.evaluate(&inst, _pidLinkPprev, 0, &matched);
+    QVERIFY(!matched);
+    QVERIFY(!next.isValid());
+}
+
+
+void TypeRuleTest::evaluateDiscriminant()
+{
+    DiscriminantAction* a = new DiscriminantAction();
+    a->setDiscriminantStr("common.type");
+    a->addCase(1, "number");
+    a->addCase(2, "name");
+    a->addCase(2, "ptr");
+    a->addDefault("ptr");
+    TypeRule* rule = newRule(a, QStringList() << "data" << "*");
+    // Prepares the path to the discriminant
+    QVERIFY(a->check("test.xml", rule, &_symbols->factory()));
+
+    const ConstMemberList* members[] = { &_dataNumber, &_dataName, &_dataPtr };
+    // Valid members per event: number, name, ptr
+    const quint64 events[] = { event1, event2, event7 };
+    const bool valid[3][3] = {
+        { true, false, false },   // type 1
+        { false, true, true },    // type 2
+        { false, false, true }    // type 7, default
+    };
+
+    for (int e = 0; e < 3; ++e) {
+        Instance inst = instance(events[e], _event);
+        for (int m = 0; m < 3; ++m) {
+            bool matched;
+            Instance ret = a->evaluate(&inst, *members[m], 0, &matched);
+            // Valid members are left to the default handler
+            QVERIFY2(matched != valid[e][m],
+                     qPrintable(QString("event: %1, member: %2")
+                                .arg(e).arg(members[m]->last()->name())));
+            QVERIFY(!ret.isValid());
+        }
+    }
+
+    delete rule;
+}
+
+
+void TypeRuleTest::matchDefersBelowHigherPriority()
+{
+    TypeRuleEngine& engine = _symbols->ruleEngine();
+
+    // A rule for "tasks.next" and a lower priority rule for a longer path
+    TypeRule* high = newRule(new ListEntryAction(),
+                             QStringList() << "tasks" << "next",
+                             "task_struct");
+    TypeRule* low = newRule(new ListEntryAction(),
+                            QStringList() << "tasks" << "next" << "prev",
+                            "task_struct");
+    high->setPriority(10);
+    low->setPriority(1);
+    engine.appendRule(high, 0);
+    engine.appendRule(low, 0);
+    engine.checkRules();
+    QCOMPARE(engine.activeRules().size(), 2);
+
+    // The higher priority rule matches, but the caller must still learn that
+    // the other rule might match with further members given
+    Instance inst = instance(taskA, _task);
+    Instance* newInst = 0;
+    int prio = 0;
+    int ret = engine.match(&inst, _tasksNext, &newInst, &prio);
+    QVERIFY(ret & TypeRuleEngine::mrMatch);
+    QVERIFY(ret & TypeRuleEngine::mrDefer);
+    QVERIFY(!(ret & TypeRuleEngine::mrAmbiguous));
+    QCOMPARE(prio, 10);
+    QVERIFY(newInst != 0);
+    QCOMPARE((quint64)newInst->address(), pageOffset + taskB);
+    delete newInst;
+
+    // Without the longer path, nothing defers
+    engine.setInactive(low);
+    newInst = 0;
+    ret = engine.match(&inst, _tasksNext, &newInst, &prio);
+    QVERIFY(ret & TypeRuleEngine::mrMatch);
+    QVERIFY(!(ret & TypeRuleEngine::mrDefer));
+    delete newInst;
+
+    engine.clear();
+}
+
+QTEST_MAIN(TypeRuleTest)
+
+#include "tst_typeruletest.moc"